@@ -0,0 +1,113 @@
+#pragma once
+
+// Host replacement of the ESP32 Arduino core, see NativeHal.h for the simulated hardware state
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <functional>
+#include <arpa/inet.h>
+
+#include "binary.h"
+#include "WString.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+#include "esp_sleep.h"
+#include "esp_log.h"
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x02
+#define PULLUP 0x04
+#define INPUT_PULLUP 0x05
+#define PULLDOWN 0x08
+#define INPUT_PULLDOWN 0x09
+
+#define PI 3.1415926535897932384626433832795
+
+#include "esp_attr.h"
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef uint16_t word;
+
+using std::min;
+using std::max;
+
+#define _min(a, b) ((a) < (b) ? (a) : (b))
+#define _max(a, b) ((a) > (b) ? (a) : (b))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef enum {
+    GPIO_NUM_0 = 0, GPIO_NUM_1, GPIO_NUM_2, GPIO_NUM_3, GPIO_NUM_4, GPIO_NUM_5, GPIO_NUM_6, GPIO_NUM_7,
+    GPIO_NUM_8, GPIO_NUM_9, GPIO_NUM_10, GPIO_NUM_11, GPIO_NUM_12, GPIO_NUM_13, GPIO_NUM_14, GPIO_NUM_15,
+    GPIO_NUM_16, GPIO_NUM_17, GPIO_NUM_18, GPIO_NUM_19, GPIO_NUM_20, GPIO_NUM_21, GPIO_NUM_22, GPIO_NUM_23,
+    GPIO_NUM_24, GPIO_NUM_25, GPIO_NUM_26, GPIO_NUM_27, GPIO_NUM_28, GPIO_NUM_29, GPIO_NUM_30, GPIO_NUM_31,
+    GPIO_NUM_32, GPIO_NUM_33, GPIO_NUM_34, GPIO_NUM_35, GPIO_NUM_36, GPIO_NUM_37, GPIO_NUM_38, GPIO_NUM_39,
+    GPIO_NUM_MAX
+} gpio_num_t;
+
+typedef enum {
+    ADC_0db,
+    ADC_2_5db,
+    ADC_6db,
+    ADC_11db
+} adc_attenuation_t;
+
+// timing
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// hardware timers (80MHz APB clock divided by the divider)
+typedef struct hw_timer_s hw_timer_t;
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool countUp);
+void timerEnd(hw_timer_t *timer);
+void timerAttachInterrupt(hw_timer_t *timer, void (*fn)(void), bool edge);
+void timerDetachInterrupt(hw_timer_t *timer);
+void timerWrite(hw_timer_t *timer, uint64_t val);
+uint64_t timerRead(hw_timer_t *timer);
+void timerAlarmWrite(hw_timer_t *timer, uint64_t alarmValue, bool autoreload);
+void timerAlarmEnable(hw_timer_t *timer);
+void timerAlarmDisable(hw_timer_t *timer);
+bool timerAlarmEnabled(hw_timer_t *timer);
+
+// GPIO
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+// ADC
+uint16_t analogRead(uint8_t pin);
+void analogReadResolution(uint8_t bits);
+void analogSetAttenuation(adc_attenuation_t attenuation);
+void analogSetCycles(uint8_t cycles);
+void analogSetSamples(uint8_t samples);
+
+// touch
+uint16_t touchRead(uint8_t pin);
+void touchAttachInterrupt(uint8_t pin, void (*userFunc)(void), uint16_t threshold);
+void detachInterrupt(uint8_t pin);
+
+// random
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+// bluetooth controller
+bool btStart();
+bool btStop();
+
+class EspClass {
+    public:
+        void restart();
+        uint32_t getFreeHeap();
+        uint64_t getEfuseMac();
+};
+
+extern EspClass ESP;
@@ -0,0 +1,82 @@
+#include "AsyncTCP.h"
+#include <algorithm>
+#include <cstring>
+
+bool AsyncClient::reachable = false;
+std::vector<AsyncClient*> AsyncClient::clients;
+
+AsyncClient::AsyncClient(void* arg) : arg(arg) {
+    clients.push_back(this);
+}
+
+AsyncClient::~AsyncClient() {
+    clients.erase(std::remove(clients.begin(), clients.end(), this), clients.end());
+}
+
+bool AsyncClient::connect(const char* host, uint16_t port) {
+    if (state != STATE_CLOSED) {
+        return false;
+    }
+    state = STATE_CONNECTING;
+    pendingEvents.push_back({reachable ? EVENT_CONNECTED : EVENT_DISCONNECTED, std::string()});
+    return true;
+}
+
+void AsyncClient::close(bool now) {
+    if (state != STATE_CLOSED) {
+        pendingEvents.push_back({EVENT_DISCONNECTED, std::string()});
+    }
+}
+
+size_t AsyncClient::write(const char* data) {
+    return write(data, strlen(data));
+}
+
+size_t AsyncClient::write(const char* data, size_t size, uint8_t apiflags) {
+    if (state != STATE_CONNECTED) {
+        return 0;
+    }
+    written.append(data, size);
+    return size;
+}
+
+void AsyncClient::receive(const char* data, size_t len) {
+    pendingEvents.push_back({EVENT_DATA, std::string(data, len)});
+}
+
+void AsyncClient::dispatchEvents() {
+    std::vector<AsyncClient*> all = clients;
+    for (AsyncClient* client : all) {
+        client->dispatch();
+    }
+}
+
+void AsyncClient::dispatch() {
+    std::vector<PendingEvent> events;
+    events.swap(pendingEvents);
+    for (auto &event : events) {
+        switch (event.type) {
+            case EVENT_CONNECTED:
+                if (state == STATE_CONNECTING) {
+                    state = STATE_CONNECTED;
+                    if (connectHandler) {
+                        connectHandler(arg, this);
+                    }
+                }
+                break;
+            case EVENT_DISCONNECTED:
+                if (state != STATE_CLOSED) {
+                    state = STATE_CLOSED;
+                    if (disconnectHandler) {
+                        disconnectHandler(arg, this);
+                    }
+                }
+                break;
+            case EVENT_DATA:
+                if (state == STATE_CONNECTED && dataHandler) {
+                    dataHandler(arg, this, (void *) event.data.data(), event.data.size());
+                }
+                break;
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+// Host replacement of AsyncTCP, connections are fake and driven from the host (test or simulator)
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+class AsyncClient;
+
+typedef std::function<void(void*, AsyncClient*)> AcConnectHandler;
+typedef std::function<void(void*, AsyncClient*, void *data, size_t len)> AcDataHandler;
+
+class AsyncClient {
+    public:
+        AsyncClient(void* arg = nullptr);
+        ~AsyncClient();
+
+        bool connect(const char* host, uint16_t port);
+        void close(bool now = false);
+        void stop() { close(false); }
+        bool connecting() { return state == STATE_CONNECTING; }
+        bool connected() { return state == STATE_CONNECTED; }
+
+        size_t write(const char* data);
+        size_t write(const char* data, size_t size, uint8_t apiflags = 0);
+
+        void onConnect(AcConnectHandler callback, void* arg = nullptr) { connectHandler = callback; }
+        void onDisconnect(AcConnectHandler callback, void* arg = nullptr) { disconnectHandler = callback; }
+        void onData(AcDataHandler callback, void* arg = nullptr) { dataHandler = callback; }
+
+        // host only
+        static void setReachable(bool reachable) { AsyncClient::reachable = reachable; }
+        static void dispatchEvents(); // deliver pending events of all clients, see NativeHal::processInterrupts()
+        void receive(const char* data, size_t len); // data from the remote side
+        const std::string& getWritten() const { return written; }
+        void clearWritten() { written.clear(); }
+
+    private:
+        enum State {
+            STATE_CLOSED,
+            STATE_CONNECTING,
+            STATE_CONNECTED
+        };
+        enum EventType {
+            EVENT_CONNECTED,
+            EVENT_DISCONNECTED,
+            EVENT_DATA
+        };
+        struct PendingEvent {
+            EventType type;
+            std::string data;
+        };
+
+        void dispatch();
+
+        State state = STATE_CLOSED;
+        std::vector<PendingEvent> pendingEvents;
+        std::string written;
+        void* arg;
+        AcConnectHandler connectHandler;
+        AcConnectHandler disconnectHandler;
+        AcDataHandler dataHandler;
+
+        static bool reachable;
+        static std::vector<AsyncClient*> clients;
+};
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "BLEDevice.h"
+
+// Client Characteristic Configuration descriptor
+class BLE2902 : public BLEDescriptor {
+};
@@ -0,0 +1,91 @@
+#include "BLEDevice.h"
+
+bool BLEDevice::initialized = false;
+BLEServer* BLEDevice::server = nullptr;
+BLEAdvertising* BLEDevice::advertising = nullptr;
+
+void BLECharacteristic::writeFromClient(const std::string& value) {
+    this->value = value;
+    if (callbacks != nullptr) {
+        callbacks->onWrite(this);
+    }
+}
+
+BLEService::~BLEService() {
+    for (auto &entry : characteristics) {
+        delete entry.second;
+    }
+}
+
+BLECharacteristic* BLEService::createCharacteristic(const char* uuid, uint32_t properties) {
+    BLECharacteristic* characteristic = new BLECharacteristic(uuid, properties);
+    characteristics[uuid] = characteristic;
+    return characteristic;
+}
+
+BLECharacteristic* BLEService::getCharacteristic(const char* uuid) {
+    auto found = characteristics.find(uuid);
+    return found != characteristics.end() ? found->second : nullptr;
+}
+
+BLEServer::~BLEServer() {
+    for (auto &entry : services) {
+        delete entry.second;
+    }
+}
+
+BLEService* BLEServer::createService(const char* uuid) {
+    BLEService* service = new BLEService(uuid);
+    services[uuid] = service;
+    return service;
+}
+
+BLEService* BLEServer::getServiceByUUID(const char* uuid) {
+    auto found = services.find(uuid);
+    return found != services.end() ? found->second : nullptr;
+}
+
+void BLEServer::disconnect(uint16_t connectionId) {
+    if (connected && connectionId == this->connectionId) {
+        connected = false;
+        if (callbacks != nullptr) {
+            callbacks->onDisconnect(this);
+        }
+    }
+}
+
+void BLEServer::startAdvertising() {
+    BLEDevice::getAdvertising()->start();
+}
+
+void BLEServer::connectClient() {
+    if (!connected) {
+        connected = true;
+        BLEDevice::getAdvertising()->stop();
+        if (callbacks != nullptr) {
+            callbacks->onConnect(this);
+        }
+    }
+}
+
+void BLEDevice::init(std::string deviceName) {
+    initialized = true;
+}
+
+void BLEDevice::deinit(bool releaseMemory) {
+    initialized = false;
+}
+
+BLEServer* BLEDevice::createServer() {
+    if (server == nullptr) {
+        server = new BLEServer();
+    }
+    return server;
+}
+
+BLEAdvertising* BLEDevice::getAdvertising() {
+    if (advertising == nullptr) {
+        advertising = new BLEAdvertising();
+    }
+    return advertising;
+}
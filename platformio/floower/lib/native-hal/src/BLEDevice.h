@@ -0,0 +1,127 @@
+#pragma once
+
+// Host replacement of the ESP32 BLE library, an in-memory GATT table without a radio
+
+#include <stdint.h>
+#include <stddef.h>
+#include <map>
+#include <string>
+
+class BLEServer;
+class BLECharacteristic;
+
+class BLEDescriptor {
+    public:
+        virtual ~BLEDescriptor() {}
+};
+
+class BLECharacteristicCallbacks {
+    public:
+        virtual ~BLECharacteristicCallbacks() {}
+        virtual void onRead(BLECharacteristic* characteristic) {}
+        virtual void onWrite(BLECharacteristic* characteristic) {}
+};
+
+class BLECharacteristic {
+    public:
+        static const uint32_t PROPERTY_READ = 1 << 0;
+        static const uint32_t PROPERTY_WRITE = 1 << 1;
+        static const uint32_t PROPERTY_NOTIFY = 1 << 2;
+        static const uint32_t PROPERTY_BROADCAST = 1 << 3;
+        static const uint32_t PROPERTY_INDICATE = 1 << 4;
+        static const uint32_t PROPERTY_WRITE_NR = 1 << 5;
+
+        BLECharacteristic(const char* uuid, uint32_t properties) : uuid(uuid), properties(properties) {}
+
+        void setCallbacks(BLECharacteristicCallbacks* callbacks) { this->callbacks = callbacks; }
+        void addDescriptor(BLEDescriptor* descriptor) { this->descriptor = descriptor; }
+        void setValue(uint8_t* data, size_t size) { value.assign((const char*) data, size); }
+        void setValue(std::string value) { this->value = value; }
+        void setValue(const char* value) { this->value = value; }
+        std::string getValue() { return value; }
+        void notify(bool is_notification = true) { notifyCount++; }
+        void indicate() { notifyCount++; }
+
+        // host only: emulate a write from the connected client
+        void writeFromClient(const std::string& value);
+        uint32_t getNotifyCount() const { return notifyCount; }
+
+    private:
+        std::string uuid;
+        uint32_t properties;
+        std::string value;
+        BLECharacteristicCallbacks* callbacks = nullptr;
+        BLEDescriptor* descriptor = nullptr;
+        uint32_t notifyCount = 0;
+};
+
+class BLEService {
+    public:
+        BLEService(const char* uuid) : uuid(uuid) {}
+        ~BLEService();
+        BLECharacteristic* createCharacteristic(const char* uuid, uint32_t properties);
+        BLECharacteristic* getCharacteristic(const char* uuid);
+        void start() { started = true; }
+        void stop() { started = false; }
+
+    private:
+        std::string uuid;
+        std::map<std::string, BLECharacteristic*> characteristics;
+        bool started = false;
+};
+
+class BLEServerCallbacks {
+    public:
+        virtual ~BLEServerCallbacks() {}
+        virtual void onConnect(BLEServer* server) {}
+        virtual void onDisconnect(BLEServer* server) {}
+};
+
+class BLEServer {
+    public:
+        ~BLEServer();
+        void setCallbacks(BLEServerCallbacks* callbacks) { this->callbacks = callbacks; }
+        BLEService* createService(const char* uuid);
+        BLEService* getServiceByUUID(const char* uuid);
+        uint16_t getConnId() { return connectionId; }
+        uint32_t getConnectedCount() { return connected ? 1 : 0; }
+        void disconnect(uint16_t connectionId);
+        void startAdvertising();
+
+        // host only: emulate a client connection
+        void connectClient();
+        void disconnectClient() { disconnect(connectionId); }
+
+    private:
+        BLEServerCallbacks* callbacks = nullptr;
+        std::map<std::string, BLEService*> services;
+        uint16_t connectionId = 0;
+        bool connected = false;
+};
+
+class BLEAdvertising {
+    public:
+        void addServiceUUID(const char* uuid) {}
+        void setScanResponse(bool scanResponse) {}
+        void setMinPreferred(uint16_t value) {}
+        void start() { advertising = true; }
+        void stop() { advertising = false; }
+        bool isAdvertising() const { return advertising; }
+
+    private:
+        bool advertising = false;
+};
+
+class BLEDevice {
+    public:
+        static void init(std::string deviceName);
+        static void deinit(bool releaseMemory = false);
+        static BLEServer* createServer();
+        static BLEAdvertising* getAdvertising();
+        static bool getInitialized() { return initialized; }
+
+    private:
+        static bool initialized;
+        static BLEServer* server;
+        static BLEAdvertising* advertising;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// emulated EEPROM backed by RAM, the content survives simulated deep sleep but not NativeHal::reset()
+class EEPROMClass {
+    public:
+        bool begin(size_t size);
+        void end() {}
+        uint8_t read(int address);
+        void write(int address, uint8_t value);
+        bool commit();
+        size_t length() { return data.size(); }
+        uint8_t* getDataPtr() { return data.data(); }
+
+        // host only
+        void clear();
+        uint32_t getCommitCount() { return commitCount; }
+
+    private:
+        std::vector<uint8_t> data;
+        uint32_t commitCount = 0;
+};
+
+extern EEPROMClass EEPROM;
@@ -0,0 +1,18 @@
+#include "ESP32Servo.h"
+
+int Servo::attach(int pin, int min, int max) {
+    this->pin = pin;
+    this->min = min;
+    this->max = max;
+    return 1;
+}
+
+void Servo::write(int value) {
+    if (value < 200) { // treat as angle, same as the device library
+        angle = value < 0 ? 0 : (value > 180 ? 180 : value);
+        ticks = min + (max - min) * angle / 180;
+    }
+    else {
+        writeMicroseconds(value);
+    }
+}
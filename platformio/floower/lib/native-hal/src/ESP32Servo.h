@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+
+// Host replacement of madhephaestus/ESP32Servo, keeps the last commanded position
+class Servo {
+    public:
+        void setPeriodHertz(int hertz) { periodHertz = hertz; }
+        int attach(int pin) { return attach(pin, 544, 2400); }
+        int attach(int pin, int min, int max);
+        void detach() { pin = -1; }
+        bool attached() const { return pin >= 0; }
+        void write(int value);
+        void writeMicroseconds(int value) { ticks = value; }
+        int read() const { return angle; }
+        int readMicroseconds() const { return ticks; }
+
+    private:
+        int pin = -1;
+        int min = 544;
+        int max = 2400;
+        int periodHertz = 50;
+        int angle = 0;
+        int ticks = 0;
+};
@@ -0,0 +1,90 @@
+#include "Arduino.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <vector>
+
+struct QueueDefinition {
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    std::vector<uint8_t> items;
+    UBaseType_t head = 0;
+    UBaseType_t count = 0;
+};
+
+struct SemaphoreDefinition {
+    bool taken = false;
+};
+
+// queues
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    QueueHandle_t queue = new QueueDefinition();
+    queue->length = length;
+    queue->itemSize = itemSize;
+    queue->items.resize(length * itemSize);
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticksToWait) {
+    if (queue->count == queue->length) {
+        return pdFALSE; // nobody else could empty it while waiting
+    }
+    UBaseType_t tail = (queue->head + queue->count) % queue->length;
+    memcpy(&queue->items[tail * queue->itemSize], item, queue->itemSize);
+    queue->count++;
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *buffer, TickType_t ticksToWait) {
+    if (xQueuePeek(queue, buffer, ticksToWait) != pdTRUE) {
+        return pdFALSE;
+    }
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    return pdTRUE;
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *buffer, TickType_t ticksToWait) {
+    if (queue->count == 0) {
+        if (ticksToWait != portMAX_DELAY) {
+            delay(ticksToWait * portTICK_PERIOD_MS); // nothing could arrive while waiting
+        }
+        return pdFALSE;
+    }
+    memcpy(buffer, &queue->items[queue->head * queue->itemSize], queue->itemSize);
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    return queue->count;
+}
+
+// mutexes
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new SemaphoreDefinition();
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait) {
+    if (semaphore->taken) {
+        return pdFALSE; // not recursive, nobody else could give it while waiting
+    }
+    semaphore->taken = true;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    if (!semaphore->taken) {
+        return pdFALSE;
+    }
+    semaphore->taken = false;
+    return pdTRUE;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <deque>
+#include "Stream.h"
+
+#define SERIAL_8N1 0x800001c
+
+// UART on host: Serial writes to stdout, other ports loop through a peer Stream (e.g. a simulated driver)
+class HardwareSerial : public Stream {
+    public:
+        HardwareSerial(uint8_t uartNum) : uartNum(uartNum) {}
+
+        void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1);
+        void end() { baudRate = 0; }
+        unsigned long baud() { return baudRate; }
+
+        int available();
+        int read();
+        int peek();
+        size_t write(uint8_t c);
+        size_t write(const uint8_t *buffer, size_t size) { return Print::write(buffer, size); }
+        using Print::write;
+        operator bool() const { return true; }
+
+        // host only: connect a device at the other end of the line
+        void attach(Stream *peer) { this->peer = peer; }
+        // host only: feed bytes as if they arrived from the other end (used for Serial console input)
+        void inject(const char *data);
+
+    private:
+        uint8_t uartNum;
+        unsigned long baudRate = 0;
+        Stream *peer = nullptr;
+        std::deque<uint8_t> rxBuffer;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "WString.h"
+
+class MD5Builder {
+    public:
+        void begin();
+        void add(const uint8_t *data, uint16_t len);
+        void add(const char *data) { add((const uint8_t *) data, strlen(data)); }
+        void add(String data) { add(data.c_str()); }
+        void calculate();
+        void getBytes(uint8_t *output);
+        String toString();
+
+    private:
+        void transform(const uint8_t block[64]);
+
+        uint32_t state[4];
+        uint64_t count;
+        uint8_t buffer[64];
+        uint8_t digest[16];
+};
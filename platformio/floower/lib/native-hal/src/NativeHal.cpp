@@ -0,0 +1,704 @@
+#include "NativeHal.h"
+#include "EEPROM.h"
+#include "esp_task_wdt.h"
+#include "esp_adc_cal.h"
+#include "esp_partition.h"
+#include "WiFi.h"
+#include "AsyncTCP.h"
+#include <cstdio>
+
+#define PINS_COUNT GPIO_NUM_MAX
+#define TIMERS_COUNT 4
+#define APB_CLOCK_MHZ 80
+#define TOUCH_DEFAULT_VALUE 70
+#define BOOT_TIME_US 30000 // setup() starts roughly 30ms after reset on the device
+#define CLOCK_READ_COST_US 1 // every clock read takes some time, so busy-waits on millis() terminate
+#define ADC_READ_COST_US 10 // single conversion of the SAR ADC
+#define FLASH_READ_COST_US 10 // command and address of a SPI flash read
+#define FLASH_READ_BYTES_PER_US 10 // 40MHz dual I/O
+#define FLASH_PARTITION_ADDRESS 0x3D0000 // spiffs of min_spiffs.csv
+#define FLASH_PARTITION_SIZE 0x20000
+#define ADC_FULL_SCALE_MV 3705 // 12bit reading at 11dB attenuation, what the eFuse calibration of a typical chip gives
+
+struct PinState {
+    uint8_t mode = INPUT;
+    uint8_t output = LOW;
+    uint8_t input = LOW;
+    uint32_t risingEdges = 0;
+    bool recordRisingEdges = false;
+    std::vector<uint64_t> risingEdgeTimes;
+    uint16_t analog = 0;
+    uint16_t analogNoise = 0; // +- raw counts added to every reading
+    uint16_t touch = TOUCH_DEFAULT_VALUE;
+    uint16_t touchThreshold = 0;
+    void (*touchISR)(void) = nullptr;
+};
+
+struct hw_timer_s {
+    bool started = false;
+    uint16_t divider = 1;
+    void (*isr)(void) = nullptr;
+    uint64_t counterStartTime = 0; // virtual time when the counter was zero
+    uint64_t alarmValue = 0;
+    bool autoreload = false;
+    bool alarmEnabled = false;
+};
+
+static struct HalState {
+    uint64_t clockMicros = BOOT_TIME_US;
+    bool inInterrupt = false;
+    PinState pins[PINS_COUNT];
+    hw_timer_t timers[TIMERS_COUNT];
+    esp_sleep_wakeup_cause_t wakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+    uint32_t deepSleepCount = 0;
+    unsigned long deepSleepTime = 0;
+    uint64_t timerWakeupMicros = 0; // 0 when disabled
+    bool touchpadWakeup = false;
+    uint32_t lightSleepCount = 0;
+    uint64_t lightSleepMicros = 0;
+    uint32_t restartCount = 0;
+    uint32_t watchdogResetCount = 0;
+    uint32_t randomState = 1;
+    uint32_t noiseState = 1; // apart from random() so the noise does not change the simulation
+} hal;
+
+static struct FlashState {
+    std::vector<uint8_t> data; // allocated on the first access
+    std::vector<uint32_t> sectorEraseCounts;
+    uint32_t eraseCount = 0;
+    int32_t writeBudget = -1;
+} flash;
+
+static const esp_partition_t flashPartition = {ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, FLASH_PARTITION_ADDRESS, FLASH_PARTITION_SIZE, "spiffs", false};
+
+static uint32_t xorshift(uint32_t &state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+EspClass ESP;
+EEPROMClass EEPROM;
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+HardwareSerial Serial2(2);
+
+// NativeHal
+
+// RTC_DATA_ATTR variables, the linker provides the bounds when there are some
+extern uint8_t __start_rtc_data[] __attribute__((weak));
+extern uint8_t __stop_rtc_data[] __attribute__((weak));
+
+static void clearRtcMemory() {
+    if (__start_rtc_data != nullptr) {
+        memset(__start_rtc_data, 0, __stop_rtc_data - __start_rtc_data);
+    }
+}
+
+void NativeHal::reset() {
+    hal = HalState();
+    clearRtcMemory();
+    flash = FlashState();
+    EEPROM.clear();
+    WiFi = WiFiClass();
+    AsyncClient::setReachable(false);
+}
+
+void NativeHal::processInterrupts() {
+    for (uint8_t pin = 0; pin < PINS_COUNT; pin++) {
+        PinState &state = hal.pins[pin];
+        if (state.touchISR != nullptr && state.touch < state.touchThreshold) {
+            state.touchISR();
+        }
+    }
+    WiFi.dispatchEvents();
+    AsyncClient::dispatchEvents();
+}
+
+void NativeHal::setDigitalInput(uint8_t pin, uint8_t value) {
+    if (pin < PINS_COUNT) {
+        hal.pins[pin].input = value;
+    }
+}
+
+uint8_t NativeHal::getDigitalOutput(uint8_t pin) {
+    return pin < PINS_COUNT ? hal.pins[pin].output : LOW;
+}
+
+uint8_t NativeHal::getPinMode(uint8_t pin) {
+    return pin < PINS_COUNT ? hal.pins[pin].mode : 0;
+}
+
+uint32_t NativeHal::getRisingEdges(uint8_t pin) {
+    return pin < PINS_COUNT ? hal.pins[pin].risingEdges : 0;
+}
+
+void NativeHal::recordRisingEdges(uint8_t pin) {
+    if (pin < PINS_COUNT) {
+        hal.pins[pin].recordRisingEdges = true;
+        hal.pins[pin].risingEdgeTimes.clear();
+    }
+}
+
+const std::vector<uint64_t>& NativeHal::getRisingEdgeTimes(uint8_t pin) {
+    static const std::vector<uint64_t> none;
+    return pin < PINS_COUNT ? hal.pins[pin].risingEdgeTimes : none;
+}
+
+void NativeHal::setAnalogInput(uint8_t pin, uint16_t value) {
+    if (pin < PINS_COUNT) {
+        hal.pins[pin].analog = value;
+    }
+}
+
+void NativeHal::setAnalogNoise(uint8_t pin, uint16_t amplitude) {
+    if (pin < PINS_COUNT) {
+        hal.pins[pin].analogNoise = amplitude;
+    }
+}
+
+void NativeHal::setTouchInput(uint8_t pin, uint16_t value) {
+    if (pin < PINS_COUNT) {
+        hal.pins[pin].touch = value;
+    }
+}
+
+uint16_t NativeHal::getTouchThreshold(uint8_t pin) {
+    return pin < PINS_COUNT ? hal.pins[pin].touchThreshold : 0;
+}
+
+void NativeHal::setWakeupCause(esp_sleep_wakeup_cause_t cause) {
+    hal.wakeupCause = cause;
+}
+
+uint32_t NativeHal::getDeepSleepCount() {
+    return hal.deepSleepCount;
+}
+
+unsigned long NativeHal::getDeepSleepTime() {
+    return hal.deepSleepTime;
+}
+
+uint32_t NativeHal::getLightSleepCount() {
+    return hal.lightSleepCount;
+}
+
+unsigned long NativeHal::getLightSleepTime() {
+    return hal.lightSleepMicros / 1000;
+}
+
+uint32_t NativeHal::getRestartCount() {
+    return hal.restartCount;
+}
+
+uint32_t NativeHal::getWatchdogResetCount() {
+    return hal.watchdogResetCount;
+}
+
+uint32_t NativeHal::getFlashEraseCount() {
+    return flash.eraseCount;
+}
+
+uint32_t NativeHal::getFlashSectorEraseCount(uint32_t offset) {
+    uint32_t sector = offset / SPI_FLASH_SEC_SIZE;
+    return sector < flash.sectorEraseCounts.size() ? flash.sectorEraseCounts[sector] : 0;
+}
+
+void NativeHal::setFlashWriteBudget(int32_t bytes) {
+    flash.writeBudget = bytes;
+}
+
+uint64_t NativeHal::getClockMicros() {
+    return hal.clockMicros;
+}
+
+static uint64_t timerAlarmTime(hw_timer_t *timer) {
+    uint64_t alarmMicros = timer->alarmValue * timer->divider / APB_CLOCK_MHZ;
+    return timer->counterStartTime + _max(alarmMicros, 1ULL);
+}
+
+static hw_timer_t* nextTimerAlarm(uint64_t until) {
+    hw_timer_t *next = nullptr;
+    for (uint8_t i = 0; i < TIMERS_COUNT; i++) {
+        hw_timer_t *timer = &hal.timers[i];
+        if (timer->started && timer->alarmEnabled && timerAlarmTime(timer) <= until) {
+            if (next == nullptr || timerAlarmTime(timer) < timerAlarmTime(next)) {
+                next = timer;
+            }
+        }
+    }
+    return next;
+}
+
+// move the virtual clock forward, firing timer alarms exactly at their time on the way
+static void advanceClockTo(uint64_t time) {
+    if (!hal.inInterrupt) {
+        hw_timer_t *timer;
+        while ((timer = nextTimerAlarm(time)) != nullptr) {
+            uint64_t alarmTime = timerAlarmTime(timer);
+            if (hal.clockMicros < alarmTime) {
+                hal.clockMicros = alarmTime;
+            }
+            if (timer->autoreload) {
+                timer->counterStartTime = alarmTime;
+            }
+            else {
+                timer->alarmEnabled = false;
+            }
+            if (timer->isr != nullptr) {
+                hal.inInterrupt = true;
+                timer->isr();
+                hal.inInterrupt = false;
+            }
+        }
+    }
+    if (hal.clockMicros < time) {
+        hal.clockMicros = time;
+    }
+}
+
+void NativeHal::advanceClock(uint64_t micros) {
+    advanceClockTo(hal.clockMicros + micros);
+}
+
+unsigned long NativeHal::simulate(std::function<void()> loop, unsigned long durationMs, uint32_t tickMicros) {
+    uint64_t startTime = hal.clockMicros;
+    uint64_t endTime = startTime + durationMs * 1000ULL;
+    uint32_t deepSleepCount = hal.deepSleepCount;
+
+    while (hal.clockMicros < endTime && hal.deepSleepCount == deepSleepCount) {
+        uint64_t tickStartTime = hal.clockMicros;
+        loop();
+        processInterrupts();
+        advanceClockTo(tickStartTime + tickMicros); // in case loop() was faster than the tick
+    }
+    return (hal.clockMicros - startTime) / 1000;
+}
+
+// timing, virtual clock
+
+unsigned long millis() {
+    advanceClockTo(hal.clockMicros + CLOCK_READ_COST_US);
+    return hal.clockMicros / 1000;
+}
+
+unsigned long micros() {
+    advanceClockTo(hal.clockMicros + CLOCK_READ_COST_US);
+    return hal.clockMicros;
+}
+
+void delay(uint32_t ms) {
+    advanceClockTo(hal.clockMicros + ms * 1000ULL);
+}
+
+void delayMicroseconds(uint32_t us) {
+    advanceClockTo(hal.clockMicros + us);
+}
+
+// hardware timers
+
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool countUp) {
+    if (num >= TIMERS_COUNT) {
+        return nullptr;
+    }
+    hw_timer_t *timer = &hal.timers[num];
+    *timer = hw_timer_t();
+    timer->started = true;
+    timer->divider = divider;
+    timer->counterStartTime = hal.clockMicros;
+    return timer;
+}
+
+void timerEnd(hw_timer_t *timer) {
+    *timer = hw_timer_t();
+}
+
+void timerAttachInterrupt(hw_timer_t *timer, void (*fn)(void), bool edge) {
+    timer->isr = fn;
+}
+
+void timerDetachInterrupt(hw_timer_t *timer) {
+    timer->isr = nullptr;
+}
+
+void timerWrite(hw_timer_t *timer, uint64_t val) {
+    timer->counterStartTime = hal.clockMicros - val * timer->divider / APB_CLOCK_MHZ;
+}
+
+uint64_t timerRead(hw_timer_t *timer) {
+    return (hal.clockMicros - timer->counterStartTime) * APB_CLOCK_MHZ / timer->divider;
+}
+
+void timerAlarmWrite(hw_timer_t *timer, uint64_t alarmValue, bool autoreload) {
+    timer->alarmValue = alarmValue;
+    timer->autoreload = autoreload;
+}
+
+void timerAlarmEnable(hw_timer_t *timer) {
+    timer->alarmEnabled = true;
+}
+
+void timerAlarmDisable(hw_timer_t *timer) {
+    timer->alarmEnabled = false;
+}
+
+bool timerAlarmEnabled(hw_timer_t *timer) {
+    return timer->alarmEnabled;
+}
+
+// GPIO
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < PINS_COUNT) {
+        hal.pins[pin].mode = mode;
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin < PINS_COUNT) {
+        PinState &state = hal.pins[pin];
+        if (state.output == LOW && val != LOW) {
+            state.risingEdges++;
+            if (state.recordRisingEdges) {
+                state.risingEdgeTimes.push_back(hal.clockMicros);
+            }
+        }
+        state.output = val != LOW ? HIGH : LOW;
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    if (pin >= PINS_COUNT) {
+        return LOW;
+    }
+    PinState &state = hal.pins[pin];
+    return (state.mode & OUTPUT) ? state.output : state.input;
+}
+
+// ADC
+
+uint16_t analogRead(uint8_t pin) {
+    if (pin >= PINS_COUNT) {
+        return 0;
+    }
+    PinState &state = hal.pins[pin];
+    advanceClockTo(hal.clockMicros + ADC_READ_COST_US);
+    if (state.analogNoise == 0 || state.analog == 0) {
+        return state.analog;
+    }
+    int32_t noise = (int32_t) (xorshift(hal.noiseState) % (2 * state.analogNoise + 1)) - state.analogNoise;
+    return _min(_max((int32_t) state.analog + noise, 0), 4095);
+}
+
+void analogReadResolution(uint8_t bits) {
+}
+
+void analogSetAttenuation(adc_attenuation_t attenuation) {
+}
+
+void analogSetCycles(uint8_t cycles) {
+}
+
+void analogSetSamples(uint8_t samples) {
+}
+
+// touch
+
+uint16_t touchRead(uint8_t pin) {
+    return pin < PINS_COUNT ? hal.pins[pin].touch : 0;
+}
+
+void touchAttachInterrupt(uint8_t pin, void (*userFunc)(void), uint16_t threshold) {
+    if (pin < PINS_COUNT) {
+        hal.pins[pin].touchISR = userFunc;
+        hal.pins[pin].touchThreshold = threshold;
+    }
+}
+
+void detachInterrupt(uint8_t pin) {
+    if (pin < PINS_COUNT) {
+        hal.pins[pin].touchISR = nullptr;
+    }
+}
+
+// ADC calibration, linear on host
+
+esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t unit, adc_atten_t atten, adc_bits_width_t width, uint32_t defaultVref, esp_adc_cal_characteristics_t *chars) {
+    chars->adc_num = unit;
+    chars->atten = atten;
+    chars->bit_width = width;
+    chars->coeff_a = ADC_FULL_SCALE_MV;
+    chars->coeff_b = 0;
+    chars->vref = defaultVref;
+    return ESP_ADC_CAL_VAL_EFUSE_VREF;
+}
+
+uint32_t esp_adc_cal_raw_to_voltage(uint32_t raw, const esp_adc_cal_characteristics_t *chars) {
+    return (raw * chars->coeff_a + 2047) / 4095 + chars->coeff_b;
+}
+
+// random, deterministic on host to make simulations reproducible
+
+long random(long howbig) {
+    if (howbig <= 0) {
+        return 0;
+    }
+    return xorshift(hal.randomState) % howbig;
+}
+
+long random(long howsmall, long howbig) {
+    if (howsmall >= howbig) {
+        return howsmall;
+    }
+    return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned long seed) {
+    if (seed != 0) {
+        hal.randomState = seed;
+    }
+}
+
+// bluetooth controller
+
+bool btStart() {
+    return true;
+}
+
+bool btStop() {
+    return true;
+}
+
+// ESP
+
+void EspClass::restart() {
+    hal.restartCount++;
+    clearRtcMemory();
+}
+
+uint32_t EspClass::getFreeHeap() {
+    return 320 * 1024;
+}
+
+uint64_t EspClass::getEfuseMac() {
+    return 0x0000AABBCCDDEEFF;
+}
+
+// sleep
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() {
+    return hal.wakeupCause;
+}
+
+esp_err_t esp_sleep_enable_ext1_wakeup(uint64_t mask, esp_sleep_ext1_wakeup_mode_t mode) {
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_touchpad_wakeup() {
+    hal.touchpadWakeup = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t timeInUs) {
+    hal.timerWakeupMicros = timeInUs;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t source) {
+    if (source == ESP_SLEEP_WAKEUP_TIMER || source == ESP_SLEEP_WAKEUP_ALL) {
+        hal.timerWakeupMicros = 0;
+    }
+    if (source == ESP_SLEEP_WAKEUP_TOUCHPAD || source == ESP_SLEEP_WAKEUP_ALL) {
+        hal.touchpadWakeup = false;
+    }
+    return ESP_OK;
+}
+
+void esp_deep_sleep_start() {
+    hal.deepSleepCount++;
+    hal.deepSleepTime = hal.clockMicros / 1000;
+    hal.wakeupCause = hal.timerWakeupMicros > 0 ? ESP_SLEEP_WAKEUP_TIMER : ESP_SLEEP_WAKEUP_UNDEFINED; // touch is up to the test
+}
+
+static bool isTouched() {
+    for (uint8_t pin = 0; pin < PINS_COUNT; pin++) {
+        PinState &state = hal.pins[pin];
+        if (state.touchISR != nullptr && state.touch < state.touchThreshold) {
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t esp_light_sleep_start() {
+    uint64_t sleepStart = hal.clockMicros;
+    hal.lightSleepCount++;
+    if (hal.touchpadWakeup && isTouched()) {
+        hal.wakeupCause = ESP_SLEEP_WAKEUP_TOUCHPAD;
+    }
+    else if (hal.timerWakeupMicros > 0) {
+        advanceClockTo(sleepStart + hal.timerWakeupMicros);
+        hal.wakeupCause = ESP_SLEEP_WAKEUP_TIMER;
+    }
+    else {
+        return ESP_ERR_INVALID_STATE; // would never wake up
+    }
+    hal.lightSleepMicros += hal.clockMicros - sleepStart;
+    return ESP_OK;
+}
+
+// task watchdog
+
+esp_err_t esp_task_wdt_init(uint32_t timeout, bool panic) {
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_add(TaskHandle_t handle) {
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_reset() {
+    hal.watchdogResetCount++;
+    return ESP_OK;
+}
+
+// flash partition
+
+static void flashInit() {
+    if (flash.data.empty()) {
+        flash.data.resize(FLASH_PARTITION_SIZE, 0xFF);
+        flash.sectorEraseCounts.resize(FLASH_PARTITION_SIZE / SPI_FLASH_SEC_SIZE, 0);
+    }
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label) {
+    if (type != flashPartition.type || (subtype != flashPartition.subtype && subtype != ESP_PARTITION_SUBTYPE_ANY)) {
+        return nullptr;
+    }
+    if (label != nullptr && strcmp(label, flashPartition.label) != 0) {
+        return nullptr;
+    }
+    return &flashPartition;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size) {
+    if (partition != &flashPartition || src_offset + size > partition->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    flashInit();
+    memcpy(dst, flash.data.data() + src_offset, size);
+    advanceClockTo(hal.clockMicros + FLASH_READ_COST_US + size / FLASH_READ_BYTES_PER_US);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size) {
+    if (partition != &flashPartition || dst_offset + size > partition->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    flashInit();
+    const uint8_t *bytes = (const uint8_t*) src;
+    for (size_t i = 0; i < size; i++) {
+        if (flash.writeBudget == 0) {
+            return ESP_OK; // power lost, the device does not know
+        }
+        if (flash.writeBudget > 0) {
+            flash.writeBudget--;
+        }
+        flash.data[dst_offset + i] &= bytes[i]; // NOR flash only clears bits
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    if (partition != &flashPartition || offset + size > partition->size || offset % SPI_FLASH_SEC_SIZE != 0 || size % SPI_FLASH_SEC_SIZE != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    flashInit();
+    if (flash.writeBudget == 0) {
+        return ESP_OK;
+    }
+    memset(flash.data.data() + offset, 0xFF, size);
+    for (size_t sector = offset / SPI_FLASH_SEC_SIZE; sector < (offset + size) / SPI_FLASH_SEC_SIZE; sector++) {
+        flash.sectorEraseCounts[sector]++;
+        flash.eraseCount++;
+    }
+    return ESP_OK;
+}
+
+// EEPROM
+
+bool EEPROMClass::begin(size_t size) {
+    if (data.size() < size) {
+        data.resize(size, 0xFF); // erased flash
+    }
+    return true;
+}
+
+uint8_t EEPROMClass::read(int address) {
+    if (address < 0 || (size_t) address >= data.size()) {
+        return 0;
+    }
+    return data[address];
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+    if (address >= 0 && (size_t) address < data.size()) {
+        data[address] = value;
+    }
+}
+
+bool EEPROMClass::commit() {
+    commitCount++;
+    return true;
+}
+
+void EEPROMClass::clear() {
+    data.clear();
+    commitCount = 0;
+}
+
+// UART
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rxPin, int8_t txPin) {
+    baudRate = baud;
+}
+
+int HardwareSerial::available() {
+    if (!rxBuffer.empty()) {
+        return rxBuffer.size();
+    }
+    return peer != nullptr ? peer->available() : 0;
+}
+
+int HardwareSerial::read() {
+    if (!rxBuffer.empty()) {
+        uint8_t c = rxBuffer.front();
+        rxBuffer.pop_front();
+        return c;
+    }
+    return peer != nullptr ? peer->read() : -1;
+}
+
+int HardwareSerial::peek() {
+    if (!rxBuffer.empty()) {
+        return rxBuffer.front();
+    }
+    return peer != nullptr ? peer->peek() : -1;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    if (peer != nullptr) {
+        return peer->write(c);
+    }
+    if (uartNum == 0) {
+        putchar(c);
+    }
+    return 1;
+}
+
+void HardwareSerial::inject(const char *data) {
+    while (*data) {
+        rxBuffer.push_back(*data++);
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Arduino.h"
+#include <functional>
+#include <vector>
+
+// Simulated hardware state of the native (host) build. Tests and the host simulator use this
+// to feed inputs (ADC, touch, digital pins) and to observe outputs (pins, step pulses, sleep).
+class NativeHal {
+    public:
+        // reset all the simulated peripherals to power-on state (EEPROM and RTC memory included)
+        static void reset();
+
+        // deliver pending interrupts and radio events, call it once per loop() like the RTOS would
+        static void processInterrupts();
+
+        // virtual clock behind millis()/micros(), it never follows the wall clock so simulations
+        // are deterministic; it moves forward by delay(), advanceClock() and slightly by every clock read,
+        // hardware timer alarms fire exactly at their time while the clock moves
+        static uint64_t getClockMicros();
+        static void advanceClock(uint64_t micros);
+
+        // run loop() for the given virtual time, every iteration takes at least tickMicros (the loop period)
+        // stops earlier when the device enters deep sleep, returns the simulated time in ms
+        static unsigned long simulate(std::function<void()> loop, unsigned long durationMs, uint32_t tickMicros = 1000);
+
+        // GPIO
+        static void setDigitalInput(uint8_t pin, uint8_t value);
+        static uint8_t getDigitalOutput(uint8_t pin);
+        static uint8_t getPinMode(uint8_t pin);
+        static uint32_t getRisingEdges(uint8_t pin);
+        static void recordRisingEdges(uint8_t pin); // start recording the time (us) of every rising edge
+        static const std::vector<uint64_t>& getRisingEdgeTimes(uint8_t pin);
+
+        // ADC (raw 12bit values)
+        static void setAnalogInput(uint8_t pin, uint16_t value);
+        static void setAnalogNoise(uint8_t pin, uint16_t amplitude); // uniform +- raw counts on every read
+
+        // touch pads, lower value means touched (device default when not touched is around 70)
+        static void setTouchInput(uint8_t pin, uint16_t value);
+        static uint16_t getTouchThreshold(uint8_t pin);
+
+        // power management
+        static void setWakeupCause(esp_sleep_wakeup_cause_t cause);
+        static uint32_t getDeepSleepCount();
+        static unsigned long getDeepSleepTime(); // millis() when the device last entered deep sleep
+        static uint32_t getLightSleepCount();
+        static unsigned long getLightSleepTime(); // total ms spent in light sleep
+        static uint32_t getRestartCount();
+        static uint32_t getWatchdogResetCount();
+
+        // flash of the data partition, survives deep sleep and restart but not reset()
+        static uint32_t getFlashEraseCount(); // sectors erased
+        static uint32_t getFlashSectorEraseCount(uint32_t offset); // erases of the sector at the partition offset
+        static void setFlashWriteBudget(int32_t bytes); // power is lost after the bytes are written, the rest is dropped, -1 unlimited
+};
@@ -0,0 +1,103 @@
+#include "NeoPixelAnimator.h"
+#include "Arduino.h"
+
+NeoPixelAnimator::NeoPixelAnimator(uint16_t countAnimations, uint16_t timeScale)
+        : countAnimations(countAnimations), animations(new AnimationContext[countAnimations]) {
+    setTimeScale(timeScale);
+    animationLastTick = millisNow();
+}
+
+NeoPixelAnimator::~NeoPixelAnimator() {
+    delete[] animations;
+}
+
+uint32_t NeoPixelAnimator::millisNow() {
+    return millis();
+}
+
+bool NeoPixelAnimator::NextAvailableAnimation(uint16_t* indexAvailable, uint16_t indexStart) {
+    if (indexStart >= countAnimations) {
+        indexStart = countAnimations - 1;
+    }
+    uint16_t next = indexStart;
+    do {
+        if (!IsAnimationActive(next)) {
+            if (indexAvailable != nullptr) {
+                *indexAvailable = next;
+            }
+            return true;
+        }
+        next = (next + 1) % countAnimations;
+    } while (next != indexStart);
+    return false;
+}
+
+void NeoPixelAnimator::StartAnimation(uint16_t indexAnimation, uint16_t duration, AnimUpdateCallback animUpdate) {
+    if (indexAnimation >= countAnimations || animUpdate == nullptr) {
+        return;
+    }
+
+    AnimationContext* anim = &animations[indexAnimation];
+    if (anim->remaining == 0) {
+        activeAnimations++;
+    }
+    if (duration == 0) {
+        duration = 1; // avoid zero duration
+    }
+    anim->duration = duration;
+    anim->remaining = duration;
+    anim->fnCallback = animUpdate;
+}
+
+void NeoPixelAnimator::StopAnimation(uint16_t indexAnimation) {
+    if (indexAnimation >= countAnimations) {
+        return;
+    }
+    if (IsAnimationActive(indexAnimation)) {
+        activeAnimations--;
+        animations[indexAnimation].remaining = 0;
+    }
+}
+
+void NeoPixelAnimator::StopAll() {
+    for (uint16_t i = 0; i < countAnimations; i++) {
+        animations[i].remaining = 0;
+    }
+    activeAnimations = 0;
+}
+
+void NeoPixelAnimator::UpdateAnimations() {
+    if (!running) {
+        return;
+    }
+
+    uint32_t currentTick = millisNow();
+    uint32_t delta = currentTick - animationLastTick;
+
+    if (delta >= timeScale) {
+        delta /= timeScale; // scale delta into animation time
+
+        for (uint16_t i = 0; i < countAnimations; i++) {
+            AnimationContext* anim = &animations[i];
+            AnimUpdateCallback fnUpdate = anim->fnCallback;
+            AnimationParam param;
+            param.index = i;
+
+            if (anim->remaining > delta) {
+                param.state = (anim->remaining == anim->duration) ? AnimationState_Started : AnimationState_Progress;
+                param.progress = anim->CurrentProgress();
+                fnUpdate(param);
+                anim->remaining -= delta;
+            }
+            else if (anim->remaining > 0) {
+                param.state = AnimationState_Completed;
+                param.progress = 1.0f;
+                activeAnimations--;
+                anim->remaining = 0;
+                fnUpdate(param);
+            }
+        }
+
+        animationLastTick = currentTick;
+    }
+}
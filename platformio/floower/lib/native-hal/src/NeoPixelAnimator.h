@@ -0,0 +1,105 @@
+#pragma once
+
+// Host replacement of makuna/NeoPixelBus NeoPixelAnimator, same timing semantics as the 2.6 release
+
+#include <stdint.h>
+#include <functional>
+
+enum AnimationState {
+    AnimationState_Started,
+    AnimationState_Progress,
+    AnimationState_Completed
+};
+
+struct AnimationParam {
+    float progress;
+    uint16_t index;
+    AnimationState state;
+};
+
+typedef std::function<void(const AnimationParam& param)> AnimUpdateCallback;
+
+#define NEO_MILLISECONDS 1
+#define NEO_CENTISECONDS 10
+#define NEO_DECISECONDS 100
+#define NEO_SECONDS 1000
+#define NEO_DECASECONDS 10000
+
+class NeoPixelAnimator {
+    public:
+        NeoPixelAnimator(uint16_t countAnimations, uint16_t timeScale = NEO_MILLISECONDS);
+        ~NeoPixelAnimator();
+
+        bool IsAnimating() const {
+            return activeAnimations > 0;
+        }
+
+        bool NextAvailableAnimation(uint16_t* indexAvailable, uint16_t indexStart = 0);
+        void StartAnimation(uint16_t indexAnimation, uint16_t duration, AnimUpdateCallback animUpdate);
+        void StopAnimation(uint16_t indexAnimation);
+        void StopAll();
+
+        void RestartAnimation(uint16_t indexAnimation) {
+            if (indexAnimation >= countAnimations || animations[indexAnimation].duration == 0) {
+                return;
+            }
+            StartAnimation(indexAnimation, animations[indexAnimation].duration, animations[indexAnimation].fnCallback);
+        }
+
+        bool IsAnimationActive(uint16_t indexAnimation) const {
+            if (indexAnimation >= countAnimations) {
+                return false;
+            }
+            return animations[indexAnimation].remaining != 0;
+        }
+
+        uint16_t AnimationDuration(uint16_t indexAnimation) {
+            if (indexAnimation >= countAnimations) {
+                return 0;
+            }
+            return animations[indexAnimation].duration;
+        }
+
+        void UpdateAnimations();
+
+        bool IsPaused() {
+            return !running;
+        }
+
+        void Pause() {
+            running = false;
+        }
+
+        void Resume() {
+            running = true;
+            animationLastTick = millisNow();
+        }
+
+        uint16_t getTimeScale() {
+            return timeScale;
+        }
+
+        void setTimeScale(uint16_t timeScale) {
+            this->timeScale = (timeScale < 1) ? 1 : (timeScale > 32768) ? 32768 : timeScale;
+        }
+
+    private:
+        struct AnimationContext {
+            uint16_t duration = 0;
+            uint16_t remaining = 0;
+            AnimUpdateCallback fnCallback;
+
+            float CurrentProgress() {
+                return (float) (duration - remaining) / (float) duration;
+            }
+        };
+
+        static uint32_t millisNow();
+
+        uint16_t countAnimations;
+        AnimationContext* animations;
+        uint32_t animationLastTick;
+        uint16_t activeAnimations = 0;
+        uint16_t timeScale;
+        bool running = true;
+};
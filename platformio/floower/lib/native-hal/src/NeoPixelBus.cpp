@@ -0,0 +1,83 @@
+#include "NeoPixelBus.h"
+
+RgbColor::RgbColor(const HsbColor& color) {
+    float r;
+    float g;
+    float b;
+    float h = color.H;
+    float s = color.S;
+    float v = color.B;
+
+    if (s == 0.0f) {
+        r = g = b = v; // achromatic or black
+    }
+    else {
+        if (h < 0.0f) {
+            h += 1.0f;
+        }
+        else if (h >= 1.0f) {
+            h -= 1.0f;
+        }
+        h *= 6.0f;
+        int i = (int) h;
+        float f = h - i;
+        float q = v * (1.0f - s * f);
+        float p = v * (1.0f - s);
+        float t = v * (1.0f - s * (1.0f - f));
+        switch (i) {
+            case 0: r = v; g = t; b = p; break;
+            case 1: r = q; g = v; b = p; break;
+            case 2: r = p; g = v; b = t; break;
+            case 3: r = p; g = q; b = v; break;
+            case 4: r = t; g = p; b = v; break;
+            default: r = v; g = p; b = q; break;
+        }
+    }
+
+    R = (uint8_t) (r * 255.0f);
+    G = (uint8_t) (g * 255.0f);
+    B = (uint8_t) (b * 255.0f);
+}
+
+uint8_t RgbColor::CalculateBrightness() const {
+    return (uint8_t) (((uint16_t) R + (uint16_t) G + (uint16_t) B) / 3);
+}
+
+RgbColor RgbColor::LinearBlend(const RgbColor& left, const RgbColor& right, float progress) {
+    return RgbColor(
+        left.R + ((right.R - left.R) * progress),
+        left.G + ((right.G - left.G) * progress),
+        left.B + ((right.B - left.B) * progress));
+}
+
+HsbColor::HsbColor(const RgbColor& color) {
+    float r = color.R / 255.0f;
+    float g = color.G / 255.0f;
+    float b = color.B / 255.0f;
+
+    float max = (r > g && r > b) ? r : (g > b) ? g : b;
+    float min = (r < g && r < b) ? r : (g < b) ? g : b;
+
+    float d = max - min;
+
+    float h = 0.0f;
+    float v = max;
+    float s = (v == 0.0f) ? 0 : (d / v);
+
+    if (d != 0.0f) {
+        if (r == max) {
+            h = (g - b) / d + (g < b ? 6.0f : 0.0f);
+        }
+        else if (g == max) {
+            h = (b - r) / d + 2.0f;
+        }
+        else {
+            h = (r - g) / d + 4.0f;
+        }
+        h /= 6.0f;
+    }
+
+    H = h;
+    S = s;
+    B = v;
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+// Host replacement of makuna/NeoPixelBus, color math follows the 2.6 release so animations render the same values
+
+#include <stdint.h>
+#include <vector>
+
+struct HsbColor;
+
+struct RgbColor {
+    RgbColor(uint8_t r, uint8_t g, uint8_t b) : R(r), G(g), B(b) {}
+    RgbColor(uint8_t brightness) : R(brightness), G(brightness), B(brightness) {}
+    RgbColor(const HsbColor& color);
+    RgbColor() : R(0), G(0), B(0) {}
+
+    bool operator==(const RgbColor& other) const { return R == other.R && G == other.G && B == other.B; }
+    bool operator!=(const RgbColor& other) const { return !(*this == other); }
+
+    uint8_t CalculateBrightness() const;
+
+    static RgbColor LinearBlend(const RgbColor& left, const RgbColor& right, float progress);
+
+    uint8_t R;
+    uint8_t G;
+    uint8_t B;
+};
+
+struct HsbColor {
+    HsbColor(float h, float s, float b) : H(h), S(s), B(b) {}
+    HsbColor(const RgbColor& color);
+    HsbColor() {}
+
+    template <typename T_NEOHUEBLEND> static HsbColor LinearBlend(const HsbColor& left, const HsbColor& right, float progress) {
+        return HsbColor(
+            T_NEOHUEBLEND::HueBlend(left.H, right.H, progress),
+            left.S + ((right.S - left.S) * progress),
+            left.B + ((right.B - left.B) * progress));
+    }
+
+    float H;
+    float S;
+    float B;
+};
+
+class NeoHueBlendBase {
+    protected:
+        static float FixWrap(float value) {
+            if (value < 0.0f) {
+                value += 1.0f;
+            }
+            else if (value > 1.0f) {
+                value -= 1.0f;
+            }
+            return value;
+        }
+};
+
+class NeoHueBlendShortestDistance : NeoHueBlendBase {
+    public:
+        static float HueBlend(float left, float right, float progress) {
+            float delta = right - left;
+            float base = left;
+            if (delta > 0.5f) {
+                base = right;
+                delta = 1.0f - delta;
+                progress = 1.0f - progress;
+            }
+            else if (delta < -0.5f) {
+                delta = 1.0f + delta;
+            }
+            return FixWrap(base + delta * progress);
+        }
+};
+
+class NeoHueBlendClockwiseDirection : NeoHueBlendBase {
+    public:
+        static float HueBlend(float left, float right, float progress) {
+            float delta = right - left;
+            float base = left;
+            if (delta < 0.0f) {
+                delta = 1.0f + delta;
+            }
+            return FixWrap(base + delta * progress);
+        }
+};
+
+class NeoEase {
+    public:
+        static float Linear(float unitValue) {
+            return unitValue;
+        }
+        static float QuadraticIn(float unitValue) {
+            return unitValue * unitValue;
+        }
+        static float QuadraticOut(float unitValue) {
+            return (-unitValue * (unitValue - 2.0f));
+        }
+        static float QuadraticInOut(float unitValue) {
+            unitValue *= 2.0f;
+            if (unitValue < 1.0f) {
+                return (0.5f * unitValue * unitValue);
+            }
+            unitValue -= 1.0f;
+            return (-0.5f * (unitValue * (unitValue - 2.0f) - 1.0f));
+        }
+        static float CubicIn(float unitValue) {
+            return (unitValue * unitValue * unitValue);
+        }
+        static float CubicOut(float unitValue) {
+            unitValue -= 1.0f;
+            return (unitValue * unitValue * unitValue + 1);
+        }
+        static float CubicInOut(float unitValue) {
+            unitValue *= 2.0f;
+            if (unitValue < 1.0f) {
+                return (0.5f * unitValue * unitValue * unitValue);
+            }
+            unitValue -= 2.0f;
+            return (0.5f * (unitValue * unitValue * unitValue + 2.0f));
+        }
+};
+
+// features and methods only carry the type information on host
+class NeoGrbFeature {
+    public:
+        typedef RgbColor ColorObject;
+        static const uint8_t PixelSize = 3;
+};
+
+class NeoEsp32I2s0800KbpsMethod {};
+class NeoEsp32I2s1800KbpsMethod {};
+
+template<typename T_COLOR_FEATURE, typename T_METHOD> class NeoPixelBus {
+    public:
+        NeoPixelBus(uint16_t countPixels, uint8_t pin) : pin(pin), pixels(countPixels) {}
+
+        void Begin() {
+            dirty = true;
+        }
+
+        void Show(bool maintainBufferConsistency = true) {
+            if (!dirty) {
+                return;
+            }
+            shown = pixels;
+            showCount++;
+            dirty = false;
+        }
+
+        bool CanShow() const {
+            return true;
+        }
+
+        bool IsDirty() const {
+            return dirty;
+        }
+
+        void Dirty() {
+            dirty = true;
+        }
+
+        void ResetDirty() {
+            dirty = false;
+        }
+
+        uint16_t PixelCount() const {
+            return pixels.size();
+        }
+
+        void SetPixelColor(uint16_t indexPixel, typename T_COLOR_FEATURE::ColorObject color) {
+            if (indexPixel < pixels.size()) {
+                pixels[indexPixel] = color;
+                dirty = true;
+            }
+        }
+
+        typename T_COLOR_FEATURE::ColorObject GetPixelColor(uint16_t indexPixel) const {
+            if (indexPixel < pixels.size()) {
+                return pixels[indexPixel];
+            }
+            return typename T_COLOR_FEATURE::ColorObject();
+        }
+
+        void ClearTo(typename T_COLOR_FEATURE::ColorObject color) {
+            for (auto &pixel : pixels) {
+                pixel = color;
+            }
+            dirty = true;
+        }
+
+        // host only, what was sent to the strip with the last Show()
+        typename T_COLOR_FEATURE::ColorObject GetShownPixelColor(uint16_t indexPixel) const {
+            if (indexPixel < shown.size()) {
+                return shown[indexPixel];
+            }
+            return typename T_COLOR_FEATURE::ColorObject();
+        }
+
+        uint32_t GetShowCount() const {
+            return showCount;
+        }
+
+    private:
+        const uint8_t pin;
+        std::vector<typename T_COLOR_FEATURE::ColorObject> pixels;
+        std::vector<typename T_COLOR_FEATURE::ColorObject> shown;
+        bool dirty = false;
+        uint32_t showCount = 0;
+};
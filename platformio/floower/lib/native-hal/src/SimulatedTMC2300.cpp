@@ -0,0 +1,208 @@
+#include "SimulatedTMC2300.h"
+#include "NativeHal.h"
+#include <algorithm>
+
+#define TMC_SYNC 0x05
+#define TMC_WRITE 0x80
+#define TMC_VERSION 0x40
+
+// registers (tmc2300-regs.h)
+#define REG_GCONF 0x00
+#define REG_GSTAT 0x01
+#define REG_IFCNT 0x02
+#define REG_IOIN 0x06
+#define REG_IHOLD_IRUN 0x10
+#define REG_TCOOLTHRS 0x14
+#define REG_SGTHRS 0x40
+#define REG_SG_VALUE 0x41
+#define REG_COOLCONF 0x42
+#define REG_CHOPCONF 0x6C
+#define REG_DRV_STATUS 0x6F
+
+// reset defaults
+#define GSTAT_RESET 0x01 // reset flag is set after power up
+#define CHOPCONF_RESET 0x13008001
+
+SimulatedTMC2300::SimulatedTMC2300(uint8_t address, uint32_t baud) : address(address), byteMicros((10000000 + baud - 1) / baud) {
+    registers[REG_GCONF] = 0;
+    registers[REG_GSTAT] = GSTAT_RESET;
+    registers[REG_IFCNT] = 0;
+    registers[REG_IOIN] = (uint32_t) TMC_VERSION << 24;
+    registers[REG_CHOPCONF] = CHOPCONF_RESET;
+    registers[REG_DRV_STATUS] = 0;
+    registers[REG_SG_VALUE] = 0;
+}
+
+int SimulatedTMC2300::available() {
+    uint64_t now = NativeHal::getClockMicros();
+    int count = 0;
+    for (auto &byte : rx) {
+        if (byte.first > now) {
+            break;
+        }
+        count++;
+    }
+    return count;
+}
+
+int SimulatedTMC2300::read() {
+    int c = peek();
+    if (c >= 0) {
+        rx.pop_front();
+    }
+    return c;
+}
+
+int SimulatedTMC2300::peek() {
+    if (rx.empty() || rx.front().first > NativeHal::getClockMicros()) {
+        return -1; // still on the wire
+    }
+    return rx.front().second;
+}
+
+size_t SimulatedTMC2300::write(uint8_t c) {
+    // the MCU sends bytes back to back, each one takes the wire for a byte time
+    uint64_t time = std::max(NativeHal::getClockMicros(), lineFreeTime) + byteMicros;
+    lineFreeTime = time;
+    rx.push_back({time, c}); // single wire, the MCU hears itself
+    receive(c, time);
+    return 1;
+}
+
+void SimulatedTMC2300::setReplyDelay(uint32_t micros) {
+    replyDelay = micros;
+}
+
+void SimulatedTMC2300::setDropRate(float probability) {
+    dropRate = probability;
+}
+
+void SimulatedTMC2300::setCorruptionRate(float probability) {
+    corruptionRate = probability;
+}
+
+void SimulatedTMC2300::setSeed(uint32_t seed) {
+    randomState = seed != 0 ? seed : 1;
+}
+
+uint32_t SimulatedTMC2300::getRegister(uint8_t address) {
+    auto it = registers.find(address);
+    return it != registers.end() ? it->second : 0;
+}
+
+void SimulatedTMC2300::setRegister(uint8_t address, uint32_t value) {
+    registers[address] = value;
+}
+
+uint32_t SimulatedTMC2300::getReadCount() {
+    return readCount;
+}
+
+uint32_t SimulatedTMC2300::getWriteCount() {
+    return writeCount;
+}
+
+uint32_t SimulatedTMC2300::getRejectedCount() {
+    return rejectedCount;
+}
+
+uint8_t SimulatedTMC2300::calcCRC(const uint8_t *datagram, uint8_t len) {
+    // CRC8 with polynomial x^8 + x^2 + x + 1, bytes processed LSB first
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < len; i++) {
+        uint8_t currentByte = datagram[i];
+        for (uint8_t j = 0; j < 8; j++) {
+            if ((crc >> 7) ^ (currentByte & 0x01)) {
+                crc = (crc << 1) ^ 0x07;
+            }
+            else {
+                crc = crc << 1;
+            }
+            currentByte >>= 1;
+        }
+    }
+    return crc;
+}
+
+void SimulatedTMC2300::receive(uint8_t c, uint64_t time) {
+    if (request.empty() && (c & 0x0F) != TMC_SYNC) {
+        return; // wait for the sync nibble
+    }
+    request.push_back(c);
+    bool write = request.size() > 2 && (request[2] & TMC_WRITE);
+    if (request.size() < (write ? 8u : 4u)) {
+        return;
+    }
+
+    uint8_t regAddr = request[2] & ~TMC_WRITE;
+    bool valid = calcCRC(request.data(), request.size() - 1) == request.back();
+    bool addressed = request[1] == address;
+    if (!valid) {
+        rejectedCount++;
+    }
+    else if (addressed && write) {
+        uint32_t value = (request[3] << 24) | (request[4] << 16) | (request[5] << 8) | request[6];
+        writeCount++;
+        switch (regAddr) {
+            case REG_GSTAT:
+                registers[REG_GSTAT] &= ~value; // write 1 to clear
+                break;
+            case REG_IFCNT:
+            case REG_IOIN:
+            case REG_SG_VALUE:
+            case REG_DRV_STATUS:
+                break; // read only
+            default:
+                registers[regAddr] = value;
+                break;
+        }
+        registers[REG_IFCNT] = (registers[REG_IFCNT] + 1) & 0xFF;
+    }
+    else if (addressed) {
+        readCount++;
+        reply(regAddr, time);
+    }
+    request.clear();
+}
+
+void SimulatedTMC2300::reply(uint8_t regAddr, uint64_t time) {
+    uint32_t value;
+    switch (regAddr) {
+        case REG_IHOLD_IRUN:
+        case REG_TCOOLTHRS:
+        case REG_SGTHRS:
+        case REG_COOLCONF:
+            value = 0; // write only
+            break;
+        default:
+            value = getRegister(regAddr);
+            break;
+    }
+
+    uint8_t datagram[] = {TMC_SYNC, 0xFF, regAddr, (uint8_t)(value >> 24), (uint8_t)(value >> 16), (uint8_t)(value >> 8), (uint8_t)value, 0};
+    datagram[7] = calcCRC(datagram, 7);
+    if (chance(corruptionRate)) {
+        datagram[3 + nextRandom() % 4] ^= 1 << (nextRandom() % 8);
+    }
+
+    time += replyDelay;
+    for (uint8_t c : datagram) {
+        time += byteMicros;
+        if (!chance(dropRate)) {
+            rx.push_back({time, c});
+        }
+    }
+    lineFreeTime = time;
+}
+
+bool SimulatedTMC2300::chance(float probability) {
+    return probability > 0 && (nextRandom() % 10000) < probability * 10000;
+}
+
+uint32_t SimulatedTMC2300::nextRandom() {
+    // xorshift, separate from random() so faults do not change the firmware behavior
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Stream.h"
+#include <deque>
+#include <map>
+#include <vector>
+
+// TMC2300 stepper driver at the other end of the single wire UART (attach to Serial1). Speaks the
+// datagram protocol (sync, address, CRC8, 0xFF-prefixed reply), echoes every byte like the shared
+// wire does and keeps the register file. Bytes travel in virtual time at the baud rate, the line can
+// be made unreliable to exercise timeouts and retries of the driver.
+class SimulatedTMC2300 : public Stream {
+    public:
+        SimulatedTMC2300(uint8_t address = 0, uint32_t baud = 500000);
+
+        int available();
+        int read();
+        int peek();
+        size_t write(uint8_t c);
+        using Print::write;
+
+        // line
+        void setReplyDelay(uint32_t micros); // driver processing before the reply (SENDDELAY)
+        void setDropRate(float probability); // chance a reply byte is lost
+        void setCorruptionRate(float probability); // chance a reply datagram has a flipped bit
+        void setSeed(uint32_t seed);
+
+        // register file, direct access to set up status registers (SG_VALUE, DRV_STATUS) and check configuration
+        uint32_t getRegister(uint8_t address);
+        void setRegister(uint8_t address, uint32_t value);
+
+        // statistics
+        uint32_t getReadCount(); // valid read requests
+        uint32_t getWriteCount(); // valid write requests
+        uint32_t getRejectedCount(); // requests ignored for CRC error
+
+        static uint8_t calcCRC(const uint8_t *datagram, uint8_t len);
+
+    private:
+        void receive(uint8_t c, uint64_t time);
+        void reply(uint8_t regAddr, uint64_t time);
+        bool chance(float probability);
+        uint32_t nextRandom();
+
+        uint8_t address;
+        uint32_t byteMicros; // 10 bits per byte (start, 8 data, stop)
+        uint32_t replyDelay = 16; // 8 bit times default SENDDELAY
+        float dropRate = 0;
+        float corruptionRate = 0;
+        uint32_t randomState = 1;
+
+        std::map<uint8_t, uint32_t> registers;
+        std::vector<uint8_t> request;
+        std::deque<std::pair<uint64_t, uint8_t>> rx; // bytes on the way to the MCU with time of arrival
+        uint64_t lineFreeTime = 0; // end of the byte on the wire
+        uint32_t readCount = 0;
+        uint32_t writeCount = 0;
+        uint32_t rejectedCount = 0;
+};
@@ -0,0 +1,59 @@
+#include "Stream.h"
+#include "Arduino.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::write(const char *str) {
+    if (str == nullptr) {
+        return 0;
+    }
+    return write((const uint8_t *) str, strlen(str));
+}
+
+size_t Print::printf(const char *format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length < 0) {
+        return 0;
+    }
+    return write((const uint8_t *) buffer, std::min((size_t) length, sizeof(buffer) - 1));
+}
+
+size_t Stream::readBytes(uint8_t *buffer, size_t length) {
+    size_t count = 0;
+    unsigned long start = millis();
+    while (count < length && millis() - start < timeout) {
+        int c = read();
+        if (c >= 0) {
+            buffer[count++] = (uint8_t) c;
+        }
+    }
+    return count;
+}
+
+String Stream::readStringUntil(char terminator) {
+    String out;
+    unsigned long start = millis();
+    while (millis() - start < timeout) {
+        int c = read();
+        if (c == terminator) {
+            break;
+        }
+        if (c >= 0) {
+            out += (char) c;
+        }
+    }
+    return out;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "WString.h"
+
+class Print {
+    public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t *buffer, size_t size);
+        size_t write(const char *str);
+        virtual void flush() {}
+
+        size_t print(const char *str) { return write(str); }
+        size_t print(const String &str) { return write(str.c_str()); }
+        size_t print(char c) { return write((uint8_t) c); }
+        size_t print(int value, int base = 10) { return print(String(value, base)); }
+        size_t print(unsigned int value, int base = 10) { return print(String(value, base)); }
+        size_t print(long value, int base = 10) { return print(String(value, base)); }
+        size_t print(unsigned long value, int base = 10) { return print(String(value, base)); }
+        size_t print(double value, int digits = 2) { return print(String(value, digits)); }
+
+        size_t println() { return write("\r\n"); }
+        template<typename T> size_t println(const T &value) { return print(value) + println(); }
+        template<typename T> size_t println(const T &value, int format) { return print(value, format) + println(); }
+        size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+    public:
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int peek() = 0;
+
+        void setTimeout(unsigned long timeout) { this->timeout = timeout; }
+        size_t readBytes(uint8_t *buffer, size_t length);
+        size_t readBytes(char *buffer, size_t length) { return readBytes((uint8_t *) buffer, length); }
+        String readStringUntil(char terminator);
+
+    protected:
+        unsigned long timeout = 1000;
+};
@@ -0,0 +1,38 @@
+#include "Update.h"
+
+UpdateClass Update;
+
+bool UpdateClass::begin(size_t size) {
+    if (size == 0 || size == UPDATE_SIZE_UNKNOWN) {
+        error = UPDATE_ERROR_SIZE;
+        return false;
+    }
+    this->size = size;
+    progress = 0;
+    error = UPDATE_ERROR_OK;
+    return true;
+}
+
+size_t UpdateClass::write(uint8_t *data, size_t len) {
+    if (size == 0) {
+        return 0;
+    }
+    if (progress + len > size) {
+        error = UPDATE_ERROR_SIZE;
+        return 0;
+    }
+    progress += len;
+    return len;
+}
+
+bool UpdateClass::end(bool evenIfRemaining) {
+    if (size == 0) {
+        return false;
+    }
+    if (!evenIfRemaining && progress != size) {
+        error = UPDATE_ERROR_ABORT;
+        size = 0;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+
+#define UPDATE_ERROR_OK 0
+#define UPDATE_ERROR_SIZE 4
+#define UPDATE_ERROR_ABORT 8
+
+// Host replacement of the ESP32 OTA Update class, counts the received image instead of flashing it
+class UpdateClass {
+    public:
+        bool begin(size_t size = UPDATE_SIZE_UNKNOWN);
+        size_t write(uint8_t *data, size_t len);
+        bool end(bool evenIfRemaining = false);
+        bool isFinished() { return size > 0 && progress == size; }
+        bool isRunning() { return size > 0; }
+        uint8_t getError() { return error; }
+        size_t getProgress() { return progress; }
+
+    private:
+        size_t size = 0;
+        size_t progress = 0;
+        uint8_t error = UPDATE_ERROR_OK;
+};
+
+extern UpdateClass Update;
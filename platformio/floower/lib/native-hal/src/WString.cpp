@@ -0,0 +1,193 @@
+#include "WString.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static std::string toBase(unsigned long value, unsigned char base) {
+    if (base < 2 || base > 36) {
+        base = 10;
+    }
+    std::string out;
+    do {
+        uint8_t digit = value % base;
+        out.insert(out.begin(), digit < 10 ? '0' + digit : 'a' + digit - 10);
+        value /= base;
+    } while (value > 0);
+    return out;
+}
+
+String::String(long value, unsigned char base) {
+    if (value < 0 && base == 10) {
+        this->value = "-" + toBase(-(unsigned long) value, base);
+    }
+    else {
+        this->value = toBase((unsigned long) value, base);
+    }
+}
+
+String::String(unsigned long value, unsigned char base) : value(toBase(value, base)) {
+}
+
+String::String(double value, unsigned char decimalPlaces) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, value);
+    this->value = buffer;
+}
+
+StringSumHelper& operator+(const StringSumHelper &lhs, const String &rhs) {
+    StringSumHelper &a = const_cast<StringSumHelper&>(lhs);
+    a.concat(rhs);
+    return a;
+}
+
+StringSumHelper& operator+(const StringSumHelper &lhs, const char *cstr) {
+    StringSumHelper &a = const_cast<StringSumHelper&>(lhs);
+    a.concat(cstr);
+    return a;
+}
+
+StringSumHelper& operator+(const StringSumHelper &lhs, char c) {
+    StringSumHelper &a = const_cast<StringSumHelper&>(lhs);
+    a.concat(c);
+    return a;
+}
+
+StringSumHelper& operator+(const StringSumHelper &lhs, int num) {
+    StringSumHelper &a = const_cast<StringSumHelper&>(lhs);
+    a.concat(num);
+    return a;
+}
+
+StringSumHelper& operator+(const StringSumHelper &lhs, unsigned int num) {
+    StringSumHelper &a = const_cast<StringSumHelper&>(lhs);
+    a.concat(num);
+    return a;
+}
+
+StringSumHelper& operator+(const StringSumHelper &lhs, long num) {
+    StringSumHelper &a = const_cast<StringSumHelper&>(lhs);
+    a.concat(num);
+    return a;
+}
+
+StringSumHelper& operator+(const StringSumHelper &lhs, unsigned long num) {
+    StringSumHelper &a = const_cast<StringSumHelper&>(lhs);
+    a.concat(num);
+    return a;
+}
+
+bool String::equalsIgnoreCase(const String &s) const {
+    if (value.length() != s.value.length()) {
+        return false;
+    }
+    for (size_t i = 0; i < value.length(); i++) {
+        if (tolower(value[i]) != tolower(s.value[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool String::endsWith(const String &suffix) const {
+    if (suffix.value.length() > value.length()) {
+        return false;
+    }
+    return value.compare(value.length() - suffix.value.length(), suffix.value.length(), suffix.value) == 0;
+}
+
+void String::getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index) const {
+    if (bufsize == 0 || buf == nullptr) {
+        return;
+    }
+    if (index >= value.length()) {
+        buf[0] = 0;
+        return;
+    }
+    unsigned int n = std::min((unsigned int) (value.length() - index), bufsize - 1);
+    memcpy(buf, value.data() + index, n);
+    buf[n] = 0;
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const {
+    size_t found = value.find(ch, fromIndex);
+    return found == std::string::npos ? -1 : found;
+}
+
+int String::indexOf(const String &str, unsigned int fromIndex) const {
+    size_t found = value.find(str.value, fromIndex);
+    return found == std::string::npos ? -1 : found;
+}
+
+int String::lastIndexOf(char ch) const {
+    size_t found = value.rfind(ch);
+    return found == std::string::npos ? -1 : found;
+}
+
+int String::lastIndexOf(const String &str) const {
+    size_t found = value.rfind(str.value);
+    return found == std::string::npos ? -1 : found;
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+    if (beginIndex > endIndex) {
+        std::swap(beginIndex, endIndex);
+    }
+    if (beginIndex >= value.length()) {
+        return String();
+    }
+    endIndex = std::min(endIndex, (unsigned int) value.length());
+    return String(value.substr(beginIndex, endIndex - beginIndex).c_str());
+}
+
+void String::replace(char find, char replace) {
+    std::replace(value.begin(), value.end(), find, replace);
+}
+
+void String::replace(const String &find, const String &replace) {
+    if (find.value.empty()) {
+        return;
+    }
+    size_t pos = 0;
+    while ((pos = value.find(find.value, pos)) != std::string::npos) {
+        value.replace(pos, find.value.length(), replace.value);
+        pos += replace.value.length();
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index < value.length()) {
+        value.erase(index, count);
+    }
+}
+
+void String::toLowerCase() {
+    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+}
+
+void String::toUpperCase() {
+    std::transform(value.begin(), value.end(), value.begin(), ::toupper);
+}
+
+void String::trim() {
+    size_t begin = value.find_first_not_of(" \t\r\n\f\v");
+    if (begin == std::string::npos) {
+        value.clear();
+        return;
+    }
+    size_t end = value.find_last_not_of(" \t\r\n\f\v");
+    value = value.substr(begin, end - begin + 1);
+}
+
+long String::toInt() const {
+    return atol(value.c_str());
+}
+
+float String::toFloat() const {
+    return atof(value.c_str());
+}
+
+double String::toDouble() const {
+    return atof(value.c_str());
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+// subset of the Arduino String API backed by std::string
+
+class StringSumHelper;
+
+class String {
+    public:
+        String() {}
+        String(const char *value) : value(value != nullptr ? value : "") {}
+        String(const String &value) : value(value.value) {}
+        explicit String(char c) : value(1, c) {}
+        explicit String(unsigned char value, unsigned char base = 10) : String((unsigned long) value, base) {}
+        explicit String(int value, unsigned char base = 10) : String((long) value, base) {}
+        explicit String(unsigned int value, unsigned char base = 10) : String((unsigned long) value, base) {}
+        explicit String(long value, unsigned char base = 10);
+        explicit String(unsigned long value, unsigned char base = 10);
+        explicit String(float value, unsigned char decimalPlaces = 2) : String((double) value, decimalPlaces) {}
+        explicit String(double value, unsigned char decimalPlaces = 2);
+
+        String& operator=(const String &rhs) { value = rhs.value; return *this; }
+        String& operator=(const char *rhs) { value = rhs != nullptr ? rhs : ""; return *this; }
+
+        bool reserve(unsigned int size) { value.reserve(size); return true; }
+        unsigned int length() const { return value.length(); }
+        bool isEmpty() const { return value.empty(); }
+        const char* c_str() const { return value.c_str(); }
+
+        bool concat(const String &str) { value += str.value; return true; }
+        bool concat(const char *cstr) { if (cstr != nullptr) value += cstr; return cstr != nullptr; }
+        bool concat(const char *cstr, unsigned int length) { value.append(cstr, length); return true; }
+        bool concat(char c) { value += c; return true; }
+        bool concat(unsigned char num) { return concat(String(num)); }
+        bool concat(int num) { return concat(String(num)); }
+        bool concat(unsigned int num) { return concat(String(num)); }
+        bool concat(long num) { return concat(String(num)); }
+        bool concat(unsigned long num) { return concat(String(num)); }
+        bool concat(float num) { return concat(String(num)); }
+        bool concat(double num) { return concat(String(num)); }
+
+        template<typename T> String& operator+=(const T &rhs) { concat(rhs); return *this; }
+
+        friend StringSumHelper& operator+(const StringSumHelper &lhs, const String &rhs);
+        friend StringSumHelper& operator+(const StringSumHelper &lhs, const char *cstr);
+        friend StringSumHelper& operator+(const StringSumHelper &lhs, char c);
+        friend StringSumHelper& operator+(const StringSumHelper &lhs, int num);
+        friend StringSumHelper& operator+(const StringSumHelper &lhs, unsigned int num);
+        friend StringSumHelper& operator+(const StringSumHelper &lhs, long num);
+        friend StringSumHelper& operator+(const StringSumHelper &lhs, unsigned long num);
+
+        int compareTo(const String &s) const { return value.compare(s.value); }
+        bool equals(const String &s) const { return value == s.value; }
+        bool equals(const char *cstr) const { return value == (cstr != nullptr ? cstr : ""); }
+        bool operator==(const String &rhs) const { return equals(rhs); }
+        bool operator==(const char *cstr) const { return equals(cstr); }
+        bool operator!=(const String &rhs) const { return !equals(rhs); }
+        bool operator!=(const char *cstr) const { return !equals(cstr); }
+        bool operator<(const String &rhs) const { return compareTo(rhs) < 0; }
+        bool equalsIgnoreCase(const String &s) const;
+        bool startsWith(const String &prefix) const { return value.compare(0, prefix.value.length(), prefix.value) == 0; }
+        bool endsWith(const String &suffix) const;
+
+        char charAt(unsigned int index) const { return index < value.length() ? value[index] : 0; }
+        void setCharAt(unsigned int index, char c) { if (index < value.length()) value[index] = c; }
+        char operator[](unsigned int index) const { return charAt(index); }
+        char& operator[](unsigned int index) { return value[index]; }
+        void getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index = 0) const;
+        void toCharArray(char *buf, unsigned int bufsize, unsigned int index = 0) const { getBytes((unsigned char *) buf, bufsize, index); }
+
+        int indexOf(char ch, unsigned int fromIndex = 0) const;
+        int indexOf(const String &str, unsigned int fromIndex = 0) const;
+        int lastIndexOf(char ch) const;
+        int lastIndexOf(const String &str) const;
+        String substring(unsigned int beginIndex) const { return substring(beginIndex, value.length()); }
+        String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+        void replace(char find, char replace);
+        void replace(const String &find, const String &replace);
+        void remove(unsigned int index) { remove(index, value.length()); }
+        void remove(unsigned int index, unsigned int count);
+        void toLowerCase();
+        void toUpperCase();
+        void trim();
+
+        long toInt() const;
+        float toFloat() const;
+        double toDouble() const;
+
+    private:
+        std::string value;
+};
+
+class StringSumHelper : public String {
+    public:
+        StringSumHelper(const String &s) : String(s) {}
+        StringSumHelper(const char *p) : String(p) {}
+        StringSumHelper(char c) : String(c) {}
+        StringSumHelper(int num) : String(num) {}
+        StringSumHelper(unsigned int num) : String(num) {}
+        StringSumHelper(long num) : String(num) {}
+        StringSumHelper(unsigned long num) : String(num) {}
+};
@@ -0,0 +1,98 @@
+#include "WiFi.h"
+#include "esp_wifi.h"
+
+#define WIFI_REASON_NO_AP_FOUND 201
+
+WiFiClass WiFi;
+
+bool WiFiClass::mode(wifi_mode_t mode) {
+    currentMode = mode;
+    return true;
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char *passphrase) {
+    this->ssid = ssid;
+    connectAttempts++;
+    if (currentMode == WIFI_OFF) {
+        currentMode = WIFI_STA;
+    }
+
+    WiFiEventInfo_t info = {};
+    if (!availableSsid.isEmpty() && this->ssid == availableSsid) {
+        currentStatus = WL_CONNECTED;
+        emit(ARDUINO_EVENT_WIFI_STA_CONNECTED, info);
+        emit(ARDUINO_EVENT_WIFI_STA_GOT_IP, info);
+    }
+    else {
+        currentStatus = WL_NO_SSID_AVAIL;
+        info.disconnected.reason = WIFI_REASON_NO_AP_FOUND;
+        emit(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, info);
+    }
+    return currentStatus;
+}
+
+bool WiFiClass::disconnect(bool wifioff) {
+    bool wasConnected = currentStatus == WL_CONNECTED;
+    currentStatus = WL_DISCONNECTED;
+    if (wifioff) {
+        currentMode = WIFI_OFF;
+    }
+    if (wasConnected) {
+        WiFiEventInfo_t info = {};
+        emit(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, info);
+    }
+    return true;
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventFuncCb callback, arduino_event_id_t event) {
+    wifi_event_id_t id = nextEventId++;
+    handlers.push_back({id, event, callback});
+    return id;
+}
+
+void WiFiClass::removeEvent(wifi_event_id_t id) {
+    for (auto it = handlers.begin(); it != handlers.end(); it++) {
+        if (it->id == id) {
+            handlers.erase(it);
+            return;
+        }
+    }
+}
+
+void WiFiClass::setNetworkAvailable(const char* ssid, bool available) {
+    availableSsid = available ? ssid : "";
+    if (!available && currentStatus == WL_CONNECTED && this->ssid == ssid) {
+        dropConnection(WIFI_REASON_NO_AP_FOUND);
+    }
+}
+
+void WiFiClass::dropConnection(uint8_t reason) {
+    if (currentStatus == WL_CONNECTED) {
+        currentStatus = WL_CONNECTION_LOST;
+        WiFiEventInfo_t info = {};
+        info.disconnected.reason = reason;
+        emit(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, info);
+    }
+}
+
+void WiFiClass::emit(arduino_event_id_t event, WiFiEventInfo_t info) {
+    pendingEvents.push_back({event, info});
+}
+
+void WiFiClass::dispatchEvents() {
+    std::vector<PendingEvent> events;
+    events.swap(pendingEvents); // handlers may emit new events
+    for (auto &pending : events) {
+        std::vector<EventHandler> listeners = handlers; // handlers may unregister themselves
+        for (auto &handler : listeners) {
+            if (handler.event == pending.event || handler.event == ARDUINO_EVENT_MAX) {
+                handler.callback(pending.event, pending.info);
+            }
+        }
+    }
+}
+
+esp_err_t esp_wifi_stop() {
+    WiFi.disconnect(true);
+    return ESP_OK;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+// Host replacement of the ESP32 WiFi library, connection state is driven from NativeHal
+
+#include <stdint.h>
+#include <functional>
+#include <vector>
+#include "Arduino.h"
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA,
+    WIFI_AP,
+    WIFI_AP_STA
+} wifi_mode_t;
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6,
+    WL_NO_SHIELD = 255
+} wl_status_t;
+
+typedef enum {
+    ARDUINO_EVENT_WIFI_READY = 0,
+    ARDUINO_EVENT_WIFI_STA_START,
+    ARDUINO_EVENT_WIFI_STA_STOP,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP,
+    ARDUINO_EVENT_WIFI_STA_LOST_IP,
+    ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+
+typedef struct {
+    uint8_t reason;
+} wifi_event_sta_disconnected_t;
+
+typedef union {
+    wifi_event_sta_disconnected_t disconnected;
+} arduino_event_info_t;
+
+typedef arduino_event_id_t WiFiEvent_t;
+typedef arduino_event_info_t WiFiEventInfo_t;
+typedef size_t wifi_event_id_t;
+typedef std::function<void(WiFiEvent_t event, WiFiEventInfo_t info)> WiFiEventFuncCb;
+
+class WiFiClass {
+    public:
+        bool mode(wifi_mode_t mode);
+        wl_status_t begin(const char* ssid, const char *passphrase = nullptr);
+        bool disconnect(bool wifioff = false);
+        wl_status_t status() { return currentStatus; }
+        bool isConnected() { return currentStatus == WL_CONNECTED; }
+        String SSID() { return ssid; }
+
+        wifi_event_id_t onEvent(WiFiEventFuncCb callback, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+        void removeEvent(wifi_event_id_t id);
+
+        // host only: play the access point, connect or drop the station
+        void setNetworkAvailable(const char* ssid, bool available);
+        void dropConnection(uint8_t reason);
+        uint32_t getConnectAttempts() { return connectAttempts; }
+        // host only: events are delivered asynchronously like from the WiFi task, see NativeHal::processInterrupts()
+        void dispatchEvents();
+
+    private:
+        struct EventHandler {
+            wifi_event_id_t id;
+            arduino_event_id_t event;
+            WiFiEventFuncCb callback;
+        };
+
+        struct PendingEvent {
+            arduino_event_id_t event;
+            WiFiEventInfo_t info;
+        };
+
+        void emit(arduino_event_id_t event, WiFiEventInfo_t info);
+
+        wifi_mode_t currentMode = WIFI_OFF;
+        wl_status_t currentStatus = WL_IDLE_STATUS;
+        String ssid;
+        String availableSsid;
+        std::vector<EventHandler> handlers;
+        std::vector<PendingEvent> pendingEvents;
+        wifi_event_id_t nextEventId = 1;
+        uint32_t connectAttempts = 0;
+};
+
+extern WiFiClass WiFi;
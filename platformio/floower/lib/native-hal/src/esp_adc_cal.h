@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+    ADC_UNIT_1 = 1,
+    ADC_UNIT_2 = 2
+} adc_unit_t;
+
+typedef enum {
+    ADC_ATTEN_DB_0 = 0,
+    ADC_ATTEN_DB_2_5 = 1,
+    ADC_ATTEN_DB_6 = 2,
+    ADC_ATTEN_DB_11 = 3
+} adc_atten_t;
+
+typedef enum {
+    ADC_WIDTH_BIT_9 = 0,
+    ADC_WIDTH_BIT_10 = 1,
+    ADC_WIDTH_BIT_11 = 2,
+    ADC_WIDTH_BIT_12 = 3
+} adc_bits_width_t;
+
+typedef enum {
+    ESP_ADC_CAL_VAL_EFUSE_VREF = 0,
+    ESP_ADC_CAL_VAL_EFUSE_TP = 1,
+    ESP_ADC_CAL_VAL_DEFAULT_VREF = 2
+} esp_adc_cal_value_t;
+
+typedef struct {
+    adc_unit_t adc_num;
+    adc_atten_t atten;
+    adc_bits_width_t bit_width;
+    uint32_t coeff_a;
+    uint32_t coeff_b;
+    uint32_t vref;
+    const uint32_t *low_curve;
+    const uint32_t *high_curve;
+} esp_adc_cal_characteristics_t;
+
+// on host the characteristics are a linear map of the 12bit reading, source is always the eFuse Vref
+esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t unit, adc_atten_t atten, adc_bits_width_t width, uint32_t defaultVref, esp_adc_cal_characteristics_t *chars);
+uint32_t esp_adc_cal_raw_to_voltage(uint32_t raw, const esp_adc_cal_characteristics_t *chars); // mV
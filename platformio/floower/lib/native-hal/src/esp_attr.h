@@ -0,0 +1,6 @@
+#pragma once
+
+#define IRAM_ATTR
+
+// RTC slow memory survives deep sleep, NativeHal clears the section on reset and restart like the bootloader does
+#define RTC_DATA_ATTR __attribute__((section("rtc_data")))
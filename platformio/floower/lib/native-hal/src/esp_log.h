@@ -0,0 +1,9 @@
+#pragma once
+
+// logging is compiled out on host, arguments are not evaluated (same as with CORE_DEBUG_LEVEL=0 on the device)
+
+#define ESP_LOGE(tag, format, ...) do {} while (0)
+#define ESP_LOGW(tag, format, ...) do {} while (0)
+#define ESP_LOGI(tag, format, ...) do {} while (0)
+#define ESP_LOGD(tag, format, ...) do {} while (0)
+#define ESP_LOGV(tag, format, ...) do {} while (0)
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED,
+    ESP_SLEEP_WAKEUP_ALL,
+    ESP_SLEEP_WAKEUP_EXT0,
+    ESP_SLEEP_WAKEUP_EXT1,
+    ESP_SLEEP_WAKEUP_TIMER,
+    ESP_SLEEP_WAKEUP_TOUCHPAD,
+    ESP_SLEEP_WAKEUP_ULP,
+    ESP_SLEEP_WAKEUP_GPIO,
+    ESP_SLEEP_WAKEUP_UART
+} esp_sleep_wakeup_cause_t;
+
+typedef esp_sleep_wakeup_cause_t esp_sleep_source_t;
+
+typedef enum {
+    ESP_EXT1_WAKEUP_ALL_LOW = 0,
+    ESP_EXT1_WAKEUP_ANY_HIGH = 1
+} esp_sleep_ext1_wakeup_mode_t;
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause();
+esp_err_t esp_sleep_enable_ext1_wakeup(uint64_t mask, esp_sleep_ext1_wakeup_mode_t mode);
+esp_err_t esp_sleep_enable_touchpad_wakeup();
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t timeInUs);
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t source);
+
+// on the device this never returns, on host it is recorded by NativeHal and returns with the wake up
+// cause of the next boot, the timer when armed
+void esp_deep_sleep_start();
+
+// on host the virtual clock moves to the timer wake up, unless a touch pad is touched already
+esp_err_t esp_light_sleep_start();
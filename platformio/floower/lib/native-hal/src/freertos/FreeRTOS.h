@@ -0,0 +1,19 @@
+#pragma once
+
+// Host replacement of the FreeRTOS types, there is a single thread on host so the queues never block;
+// waiting for an empty queue moves the virtual clock instead
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int32_t BaseType_t;
+typedef uint32_t UBaseType_t;
+
+#define pdFALSE ((BaseType_t) 0)
+#define pdTRUE ((BaseType_t) 1)
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+
+#define portMAX_DELAY ((TickType_t) 0xFFFFFFFFUL)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t) (ms))
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct QueueDefinition* QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticksToWait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *buffer, TickType_t ticksToWait);
+BaseType_t xQueuePeek(QueueHandle_t queue, void *buffer, TickType_t ticksToWait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
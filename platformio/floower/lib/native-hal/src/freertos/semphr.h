@@ -0,0 +1,11 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+// single thread on host, the mutex is always free
+typedef struct SemaphoreDefinition* SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+void vSemaphoreDelete(SemaphoreHandle_t semaphore);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
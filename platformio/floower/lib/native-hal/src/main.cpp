@@ -0,0 +1,61 @@
+#ifndef PIO_UNIT_TESTING
+
+// Host entry point, on the device this is provided by the Arduino core
+//
+//   program             run the firmware paced to the wall clock
+//   program --warp      run the virtual clock as fast as possible
+//   program --duration <s>  stop after given seconds of virtual time
+//   program --battery   run on battery (USB disconnected)
+
+#include "NativeHal.h"
+#include "SimulatedTMC2300.h"
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#define SIMULATION_SLICE_MS 10 // how much virtual time to run before syncing with the wall clock
+
+void setup();
+void loop();
+
+int main(int argc, char **argv) {
+    bool warp = false;
+    bool usbPowered = true;
+    unsigned long durationMs = 0; // forever
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--warp") == 0) {
+            warp = true;
+        }
+        else if (strcmp(argv[i], "--battery") == 0) {
+            usbPowered = false;
+        }
+        else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+            durationMs = atol(argv[++i]) * 1000;
+        }
+    }
+
+    NativeHal::setAnalogInput(GPIO_NUM_36, 2300); // battery ~4.1V
+    NativeHal::setAnalogInput(GPIO_NUM_39, usbPowered ? 2900 : 0);
+
+    // stepper driver, SG_VALUE stays at 0 as if the petals were against the end stop whenever homing looks
+    SimulatedTMC2300 stepperDriver;
+    Serial1.attach(&stepperDriver);
+    setup();
+
+    std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+    uint64_t clockStart = NativeHal::getClockMicros();
+    while (NativeHal::getDeepSleepCount() == 0 && (durationMs == 0 || millis() < durationMs)) {
+        NativeHal::simulate(loop, SIMULATION_SLICE_MS);
+        if (!warp) {
+            std::this_thread::sleep_until(wallStart + std::chrono::microseconds(NativeHal::getClockMicros() - clockStart));
+        }
+    }
+
+    if (NativeHal::getDeepSleepCount() > 0) {
+        printf("Entered deep sleep at %lums\n", NativeHal::getDeepSleepTime());
+    }
+    return 0;
+}
+
+#endif
@@ -1,5 +1,8 @@
 #include "tmc2300.h"
 
+constexpr uint8_t TMC2300::shadowAddresses[];
+constexpr uint8_t TMC2300::crcTable[];
+
 TMC2300::TMC2300(Stream *serialPort, float RSense, uint8_t uartAddress) :
     serialPort(serialPort), RSense(RSense), uartAddress(uartAddress) {
     //defaults();
@@ -64,146 +67,259 @@ void TMC2300::writeTCoolThrs(uint32_t tCoolThrs) {
     write(REG_TCOOLTHRS_ADDRESS, tCoolThrs);
 }
 
-uint8_t TMC2300::readSGValue() {
-    return read(REG_SG_VALUE_ADDRESS);
+uint16_t TMC2300::readSGValue() {
+    return read(REG_SG_VALUE_ADDRESS) & 0x3FF; // 10 bits
 }
 
 void TMC2300::writeSGThrs(uint32_t sgThrs) {
     write(REG_SGTHRS_ADDRESS, sgThrs);
 }
 
-uint32_t TMC2300::read(uint8_t regAddr) {
-    constexpr uint8_t len = 3;
-    regAddr |= TMC_READ;
+bool TMC2300::lastReadFailed() {
+    return CRCerror; // no reply or corrupted reply
+}
 
-    uint8_t datagram[] = {TMC2300_SYNC, uartAddress, regAddr, 0x00};
-    datagram[len] = calcCRC(datagram, len);
-    uint64_t out = 0x00000000UL;
+bool TMC2300::readAsync(uint8_t regAddr, TMC2300Callback callback) {
+    return enqueue({regAddr, false, 0, callback});
+}
 
-    for (uint8_t i = 0; i < maxRetries; i++) {
-        out = sendDatagram(datagram, len, abortWindow);
-        delay(replyDelay);
+bool TMC2300::writeAsync(uint8_t regAddr, uint32_t regVal, TMC2300Callback callback) {
+    if (!enqueue({regAddr, true, regVal, callback})) {
+        return false;
+    }
+    int8_t index = shadowIndex(regAddr);
+    if (index >= 0) {
+        // sent directly, supersedes a deferred write of the same register
+        shadow[index] = regVal;
+        shadowValid |= 1 << index;
+        shadowDirty &= ~(1 << index);
+    }
+    return true;
+}
 
-        CRCerror = false;
-        uint8_t outDatagram[] = {
-            static_cast<uint8_t>(out>>56),
-            static_cast<uint8_t>(out>>48),
-            static_cast<uint8_t>(out>>40),
-            static_cast<uint8_t>(out>>32),
-            static_cast<uint8_t>(out>>24),
-            static_cast<uint8_t>(out>>16),
-            static_cast<uint8_t>(out>> 8),
-            static_cast<uint8_t>(out>> 0)
-        };
-        uint8_t crc = calcCRC(outDatagram, 7);
-        if ((crc != static_cast<uint8_t>(out)) || crc == 0 ) {
-            CRCerror = true;
-            out = 0;
-        } else {
+bool TMC2300::readSGValueAsync(std::function<void(bool success, uint16_t sgValue)> callback) {
+    return readAsync(REG_SG_VALUE_ADDRESS, [=](bool success, uint32_t value) { callback(success, value & 0x3FF); });
+}
+
+bool TMC2300::readGStatAsync(std::function<void(bool success, REG_GSTAT gstat)> callback) {
+    return readAsync(REG_GSTAT::address, [=](bool success, uint32_t value) {
+        REG_GSTAT gstat;
+        gstat.sr = value;
+        callback(success, gstat);
+    });
+}
+
+bool TMC2300::readDrvStatusAsync(std::function<void(bool success, REG_DRV_STATUS drvStatus)> callback) {
+    return readAsync(REG_DRV_STATUS::address, [=](bool success, uint32_t value) {
+        REG_DRV_STATUS drvStatus;
+        drvStatus.sr = value;
+        callback(success, drvStatus);
+    });
+}
+
+bool TMC2300::isBusy() {
+    return transactionState != TRANSACTION_IDLE || queueHead != queueTail;
+}
+
+void TMC2300::update() {
+    if (flushPending) {
+        flush(); // queue was full, send the rest of the changes
+    }
+    switch (transactionState) {
+        case TRANSACTION_IDLE:
+            if (queueHead != queueTail) {
+                startTransaction();
+            }
             break;
+        case TRANSACTION_WRITING:
+            if (micros() - transactionTime >= replyDelay) {
+                while (serialPort->available() > 0) {
+                    serialPort->read(); // flush the echo of the single wire bus
+                }
+                for (uint8_t i = burstLength; i > 0; i--) {
+                    completeTransaction(true, queue[queueTail].value);
+                }
+            }
+            break;
+        case TRANSACTION_READING:
+            receiveReply();
+            break;
+    }
+}
+
+bool TMC2300::flush() {
+    for (uint8_t i = 0; i < shadowLength; i++) {
+        if (shadowDirty & (1 << i)) {
+            writeAsync(shadowAddresses[i], shadow[i]); // clears the dirty flag once queued
         }
     }
+    flushPending = shadowDirty != 0;
+    return !flushPending;
+}
 
-    return out>>8;
+bool TMC2300::isDirty() {
+    return shadowDirty != 0;
 }
 
-void TMC2300::write(uint8_t regAddr, uint32_t regVal) {
-    uint8_t len = 7;
-    regAddr |= TMC_WRITE;
+void TMC2300::invalidateShadow() {
+    shadowValid = 0;
+    shadowDirty = 0;
+    flushPending = false;
+}
 
-    uint8_t datagram[] = {TMC2300_SYNC, uartAddress, regAddr, (uint8_t)(regVal>>24), (uint8_t)(regVal>>16), (uint8_t)(regVal>>8), (uint8_t)(regVal>>0), 0x00};
-    datagram[len] = calcCRC(datagram, len);
+int8_t TMC2300::shadowIndex(uint8_t regAddr) {
+    for (uint8_t i = 0; i < shadowLength; i++) {
+        if (shadowAddresses[i] == regAddr) {
+            return i;
+        }
+    }
+    return -1;
+}
 
-    for (uint8_t i = 0; i <= len; i++) {
-        bytesWritten += serialPort->write(datagram[i]);
+uint32_t TMC2300::read(uint8_t regAddr) {
+    int8_t index = shadowIndex(regAddr);
+    if (index >= 0 && (shadowValid & (1 << index))) {
+        CRCerror = false;
+        return shadow[index]; // configuration does not change by itself
     }
 
-    delay(replyDelay);
+    // blocking read waits for the whole queue, the bus is shared with the background transactions
+    bool done = false;
+    bool succeeded = false;
+    uint32_t out = 0;
+    while (!readAsync(regAddr, [&](bool success, uint32_t value) { out = value; succeeded = success; done = true; })) {
+        update();
+    }
+    while (!done) {
+        update();
+    }
+    if (index >= 0 && succeeded) {
+        shadow[index] = out;
+        shadowValid |= 1 << index;
+    }
+    return out;
 }
 
-uint8_t TMC2300::calcCRC(uint8_t datagram[], uint8_t len) {
-    uint8_t crc = 0;
-    for (uint8_t i = 0; i < len; i++) {
-        uint8_t currentByte = datagram[i];
-        for (uint8_t j = 0; j < 8; j++) {
-            if ((crc >> 7) ^ (currentByte & 0x01)) {
-                crc = (crc << 1) ^ 0x07;
-            } else {
-                crc = (crc << 1);
-            }
-            crc &= 0xff;
-            currentByte = currentByte >> 1;
+void TMC2300::write(uint8_t regAddr, uint32_t regVal) {
+    int8_t index = shadowIndex(regAddr);
+    if (index >= 0) {
+        // deferred until flush()
+        uint8_t mask = 1 << index;
+        if (!(shadowValid & mask) || shadow[index] != regVal) {
+            shadow[index] = regVal;
+            shadowValid |= mask;
+            shadowDirty |= mask;
         }
+        return;
+    }
+
+    while (!writeAsync(regAddr, regVal)) {
+        update();
+    }
+    while (isBusy()) {
+        update();
     }
-    return crc;
 }
 
-uint64_t TMC2300::sendDatagram(uint8_t datagram[], const uint8_t len, uint16_t timeout) {
+bool TMC2300::enqueue(TMC2300Transaction transaction) {
+    uint8_t nextHead = (queueHead + 1) & (queueLength - 1);
+    if (nextHead == queueTail) {
+        return false;
+    }
+    queue[queueHead] = transaction;
+    queueHead = nextHead;
+    return true;
+}
+
+void TMC2300::startTransaction() {
+    TMC2300Transaction &transaction = queue[queueTail];
     while (serialPort->available() > 0) { // flush
         serialPort->read();
     }
 
-    for (int i = 0; i <= len; i++) {
-        serialPort->write(datagram[i]);
+    if (transaction.write) {
+        // consecutive writes need no reply, send them in one burst
+        TMC2300Datagram burst[queueLength];
+        burstLength = 0;
+        for (uint8_t i = queueTail; i != queueHead && queue[i].write; i = (i + 1) & (queueLength - 1)) {
+            TMC2300Datagram &datagram = burst[burstLength++];
+            datagram.sync = TMC2300_SYNC;
+            datagram.address = uartAddress;
+            datagram.regAddr = queue[i].regAddr | TMC_WRITE;
+            datagram.setValue(queue[i].value);
+            datagram.crc = calcCRC(&datagram.sync, sizeof(TMC2300Datagram) - 1);
+        }
+        bytesWritten += serialPort->write(&burst[0].sync, burstLength * sizeof(TMC2300Datagram));
+        transactionState = TRANSACTION_WRITING;
     }
+    else {
+        TMC2300ReadRequest datagram = {TMC2300_SYNC, uartAddress, (uint8_t)(transaction.regAddr | TMC_READ), 0x00};
+        datagram.crc = calcCRC(&datagram.sync, sizeof(TMC2300ReadRequest) - 1);
+        serialPort->write(&datagram.sync, sizeof(TMC2300ReadRequest));
+        replyLength = 0;
+        transactionState = TRANSACTION_READING;
+    }
+    transactionTime = micros();
+}
 
-    delay(replyDelay);
-
-    // scan for the rx frame and read it
-    uint32_t ms = millis();
-    uint32_t sync_target = (static_cast<uint32_t>(datagram[0])<<16) | 0xFF00 | datagram[2];
-    uint32_t sync = 0;
+void TMC2300::receiveReply() {
+    const uint8_t header[] = {TMC2300_SYNC, 0xFF, queue[queueTail].regAddr};
+    uint8_t *frame = &reply.sync;
 
-    do {
-        uint32_t ms2 = millis();
-        if (ms2 != ms) {
-            // 1ms tick
-            ms = ms2;
-            timeout--;
-        }
-        if (!timeout) {
-            return 0;
+    bool corrupted = false;
+    while (serialPort->available() > 0) {
+        uint8_t res = serialPort->read();
+        if (replyLength < sizeof(header) && res != header[replyLength]) {
+            // scan for the rx frame, skips the echo of the request
+            replyLength = 0;
+            if (res != header[0]) {
+                continue;
+            }
         }
-
-        int16_t res = serialPort->read();
-        if (res < 0) {
-            continue;
+        frame[replyLength++] = res;
+
+        if (replyLength == sizeof(TMC2300Datagram)) {
+            uint8_t crc = calcCRC(frame, sizeof(TMC2300Datagram) - 1);
+            if (crc == reply.crc && crc != 0) {
+                CRCerror = false;
+                completeTransaction(true, reply.getValue());
+                return;
+            }
+            corrupted = true; // retry
+            break;
         }
+    }
 
-        sync <<= 8;
-        sync |= res & 0xFF;
-        sync &= 0xFFFFFF;
-
-    } while (sync != sync_target);
-
-    uint64_t out = sync;
-    ms = millis();
-    timeout = this->abortWindow;
-
-    for(uint8_t i=0; i<5;) {
-        uint32_t ms2 = millis();
-        if (ms2 != ms) {
-            // 1ms tick
-            ms = ms2;
-          timeout--;
-        }
-        if (!timeout) {
-            return 0;
+    if (corrupted || micros() - transactionTime >= abortWindow) {
+        if (++transactionRetries < maxRetries) {
+            startTransaction();
         }
-
-        int16_t res = serialPort->read();
-        if (res < 0) {
-            continue;
+        else {
+            CRCerror = true;
+            completeTransaction(false, 0);
         }
-
-        out <<= 8;
-        out |= res & 0xFF;
-        i++;
     }
+}
 
-    while (serialPort->available() > 0) {
-        serialPort->read(); // flush
+void TMC2300::completeTransaction(bool success, uint32_t value) {
+    TMC2300Callback callback = queue[queueTail].callback;
+    queue[queueTail].callback = nullptr;
+    queueTail = (queueTail + 1) & (queueLength - 1);
+    transactionState = TRANSACTION_IDLE;
+    transactionRetries = 0;
+    if (callback) {
+        callback(success, value);
     }
+}
 
-    return out;
+uint8_t TMC2300::calcCRC(const uint8_t datagram[], uint8_t len) {
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < len; i++) {
+        crc = crcTable[crc ^ datagram[i]];
+    }
+    // reverse the bits back
+    crc = (crc >> 4) | (crc << 4);
+    crc = ((crc & 0xCC) >> 2) | ((crc & 0x33) << 2);
+    crc = ((crc & 0xAA) >> 1) | ((crc & 0x55) << 1);
+    return crc;
 }
@@ -2,8 +2,47 @@
 
 #include <Arduino.h>
 #include <Stream.h>
+#include <functional>
 #include "tmc2300-regs.h"
 
+typedef std::function<void(bool success, uint32_t value)> TMC2300Callback;
+
+#pragma pack(push, 1)
+// write request and read reply frame, validated in place as it is received
+struct TMC2300Datagram {
+    uint8_t sync;
+    uint8_t address; // 0xFF in replies
+    uint8_t regAddr;
+    uint8_t data[4]; // big endian
+    uint8_t crc;
+
+    uint32_t getValue() const {
+        return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) | (data[2] << 8) | data[3];
+    }
+
+    void setValue(uint32_t value) {
+        data[0] = value >> 24;
+        data[1] = value >> 16;
+        data[2] = value >> 8;
+        data[3] = value;
+    }
+};
+
+struct TMC2300ReadRequest {
+    uint8_t sync;
+    uint8_t address;
+    uint8_t regAddr;
+    uint8_t crc;
+};
+#pragma pack(pop)
+
+struct TMC2300Transaction {
+    uint8_t regAddr;
+    bool write;
+    uint32_t value;
+    TMC2300Callback callback;
+};
+
 class TMC2300 {
   public:
     TMC2300(Stream *serialPort, float RSense, uint8_t addr);
@@ -24,15 +63,35 @@ class TMC2300 {
     void writeChopconfReg(REG_CHOPCONF chopconf);
 
     void writeTCoolThrs(uint32_t tCoolThrs);
-    uint8_t readSGValue();
+    uint16_t readSGValue();
     void writeSGThrs(uint32_t sgThrs);
+    bool lastReadFailed();
     //void writeCoolConf(REG_COOL_CONF coolConf);
+
+    // non-blocking transactions, run in the background by update() and completed by the callback
+    bool readAsync(uint8_t regAddr, TMC2300Callback callback); // false when the queue is full
+    bool writeAsync(uint8_t regAddr, uint32_t regVal, TMC2300Callback callback = nullptr);
+    bool readSGValueAsync(std::function<void(bool success, uint16_t sgValue)> callback);
+    bool readGStatAsync(std::function<void(bool success, REG_GSTAT gstat)> callback);
+    bool readDrvStatusAsync(std::function<void(bool success, REG_DRV_STATUS drvStatus)> callback);
+    bool isBusy();
+    void update();
+
+    // configuration registers are cached, writes to them are deferred until flush() sends all changes in one burst
+    bool flush(); // false when the queue is full, the rest is sent by update()
+    bool isDirty();
+    void invalidateShadow(); // after the driver was reset
+
+    static uint8_t calcCRC(const uint8_t datagram[], uint8_t len);
     
   private:
     uint32_t read(uint8_t addr);
     void write(uint8_t regAddr, uint32_t regVal);
-    uint8_t calcCRC(uint8_t datagram[], uint8_t len);
-    uint64_t sendDatagram(uint8_t datagram[], const uint8_t len, uint16_t timeout);
+    bool enqueue(TMC2300Transaction transaction);
+    void startTransaction();
+    void receiveReply();
+    void completeTransaction(bool success, uint32_t value);
+    int8_t shadowIndex(uint8_t regAddr);
 
     Stream *serialPort = nullptr;
     const float RSense;
@@ -40,10 +99,53 @@ class TMC2300 {
     uint16_t bytesWritten = 0;
     bool CRCerror = false;
 
+    enum TransactionState : uint8_t { TRANSACTION_IDLE, TRANSACTION_WRITING, TRANSACTION_READING };
+
+    static constexpr uint8_t queueLength = 8; // power of 2
+    TMC2300Transaction queue[queueLength];
+    uint8_t queueHead = 0;
+    uint8_t queueTail = 0;
+    TransactionState transactionState = TRANSACTION_IDLE;
+    uint32_t transactionTime = 0; // us when the datagram was sent
+    uint8_t transactionRetries = 0;
+    TMC2300Datagram reply;
+    uint8_t replyLength = 0; // bytes of the reply frame received, header is matched byte by byte
+    uint8_t burstLength = 0; // write transactions sent together
+
+    static constexpr uint8_t shadowLength = 6;
+    static constexpr uint8_t shadowAddresses[shadowLength] = {
+        REG_GCONF::address, REG_IHOLD_IRUN::address, REG_TCOOLTHRS_ADDRESS, REG_SGTHRS_ADDRESS, REG_COOLCONF_ADDRESS, REG_CHOPCONF::address
+    };
+    uint32_t shadow[shadowLength];
+    uint8_t shadowValid = 0; // bit per register
+    uint8_t shadowDirty = 0;
+    bool flushPending = false;
+
     static constexpr uint8_t TMC_READ = 0x00;
     static constexpr uint8_t TMC_WRITE = 0x80;
     static constexpr uint8_t TMC2300_SYNC = 0x05;
-    static constexpr uint8_t replyDelay = 2;
-    static constexpr uint8_t abortWindow = 5;
+    static constexpr uint16_t replyDelay = 2000; // us, bus idle after a write
+    static constexpr uint16_t abortWindow = 5000; // us to wait for a reply
     static constexpr uint8_t maxRetries = 2;
+
+    // CRC8 (x^8 + x^2 + x + 1) with bytes sent LSB first, computed on the bit reversed register
+    // so every byte takes a single lookup
+    static constexpr uint8_t crcTable[256] = {
+    0x00, 0x91, 0xE3, 0x72, 0x07, 0x96, 0xE4, 0x75, 0x0E, 0x9F, 0xED, 0x7C, 0x09, 0x98, 0xEA, 0x7B,
+    0x1C, 0x8D, 0xFF, 0x6E, 0x1B, 0x8A, 0xF8, 0x69, 0x12, 0x83, 0xF1, 0x60, 0x15, 0x84, 0xF6, 0x67,
+    0x38, 0xA9, 0xDB, 0x4A, 0x3F, 0xAE, 0xDC, 0x4D, 0x36, 0xA7, 0xD5, 0x44, 0x31, 0xA0, 0xD2, 0x43,
+    0x24, 0xB5, 0xC7, 0x56, 0x23, 0xB2, 0xC0, 0x51, 0x2A, 0xBB, 0xC9, 0x58, 0x2D, 0xBC, 0xCE, 0x5F,
+    0x70, 0xE1, 0x93, 0x02, 0x77, 0xE6, 0x94, 0x05, 0x7E, 0xEF, 0x9D, 0x0C, 0x79, 0xE8, 0x9A, 0x0B,
+    0x6C, 0xFD, 0x8F, 0x1E, 0x6B, 0xFA, 0x88, 0x19, 0x62, 0xF3, 0x81, 0x10, 0x65, 0xF4, 0x86, 0x17,
+    0x48, 0xD9, 0xAB, 0x3A, 0x4F, 0xDE, 0xAC, 0x3D, 0x46, 0xD7, 0xA5, 0x34, 0x41, 0xD0, 0xA2, 0x33,
+    0x54, 0xC5, 0xB7, 0x26, 0x53, 0xC2, 0xB0, 0x21, 0x5A, 0xCB, 0xB9, 0x28, 0x5D, 0xCC, 0xBE, 0x2F,
+    0xE0, 0x71, 0x03, 0x92, 0xE7, 0x76, 0x04, 0x95, 0xEE, 0x7F, 0x0D, 0x9C, 0xE9, 0x78, 0x0A, 0x9B,
+    0xFC, 0x6D, 0x1F, 0x8E, 0xFB, 0x6A, 0x18, 0x89, 0xF2, 0x63, 0x11, 0x80, 0xF5, 0x64, 0x16, 0x87,
+    0xD8, 0x49, 0x3B, 0xAA, 0xDF, 0x4E, 0x3C, 0xAD, 0xD6, 0x47, 0x35, 0xA4, 0xD1, 0x40, 0x32, 0xA3,
+    0xC4, 0x55, 0x27, 0xB6, 0xC3, 0x52, 0x20, 0xB1, 0xCA, 0x5B, 0x29, 0xB8, 0xCD, 0x5C, 0x2E, 0xBF,
+    0x90, 0x01, 0x73, 0xE2, 0x97, 0x06, 0x74, 0xE5, 0x9E, 0x0F, 0x7D, 0xEC, 0x99, 0x08, 0x7A, 0xEB,
+    0x8C, 0x1D, 0x6F, 0xFE, 0x8B, 0x1A, 0x68, 0xF9, 0x82, 0x13, 0x61, 0xF0, 0x85, 0x14, 0x66, 0xF7,
+    0xA8, 0x39, 0x4B, 0xDA, 0xAF, 0x3E, 0x4C, 0xDD, 0xA6, 0x37, 0x45, 0xD4, 0xA1, 0x30, 0x42, 0xD3,
+    0xB4, 0x25, 0x57, 0xC6, 0xB3, 0x22, 0x50, 0xC1, 0xBA, 0x2B, 0x59, 0xC8, 0xBD, 0x2C, 0x5E, 0xCF,
+    };
 };
\ No newline at end of file
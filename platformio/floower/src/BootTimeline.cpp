@@ -0,0 +1,49 @@
+#include "BootTimeline.h"
+
+static const char* PHASE_NAMES[BOOT_PHASE_COUNT] = {
+    "setup", "watchdog", "config", "pixels", "adc", "touch", "power", "warm-up", "petals", "behavior", "first frame"
+};
+
+uint32_t BootTimeline::times[BOOT_PHASE_COUNT] = {};
+bool BootTimeline::printed = false;
+
+void BootTimeline::mark(BootPhase phase) {
+    if (phase < BOOT_PHASE_COUNT && times[phase] == 0) {
+        times[phase] = micros();
+        if (printed) {
+            printPhase(phase);
+        }
+    }
+}
+
+uint32_t BootTimeline::getTime(BootPhase phase) {
+    return phase < BOOT_PHASE_COUNT ? times[phase] : 0;
+}
+
+void BootTimeline::print() {
+    // printed at once, a line per phase would slow down the boot it measures
+    for (uint8_t phase = 0; phase < BOOT_PHASE_COUNT; phase++) {
+        if (times[phase] != 0) {
+            printPhase((BootPhase) phase);
+        }
+    }
+    printed = true;
+}
+
+void BootTimeline::reset() {
+    for (uint8_t phase = 0; phase < BOOT_PHASE_COUNT; phase++) {
+        times[phase] = 0;
+    }
+    printed = false;
+}
+
+void BootTimeline::printPhase(BootPhase phase) {
+    // time since reset and since the previous phase reached
+    uint32_t previous = 0;
+    for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+        if (times[i] != 0 && times[i] < times[phase] && times[i] > previous) {
+            previous = times[i];
+        }
+    }
+    Serial.printf("Boot %s: %luus (+%luus)\n", PHASE_NAMES[phase], (unsigned long) times[phase], (unsigned long) (times[phase] - previous));
+}
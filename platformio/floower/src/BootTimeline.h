@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Arduino.h"
+
+// compiled in with -DBOOT_TIMELINE, the marks cost nothing otherwise
+#ifdef BOOT_TIMELINE
+#define BOOT_PHASE(phase) BootTimeline::mark(phase)
+#else
+#define BOOT_PHASE(phase)
+#endif
+
+enum BootPhase : uint8_t {
+    BOOT_PHASE_SETUP, // setup() entered
+    BOOT_PHASE_WATCHDOG, // task watchdog running
+    BOOT_PHASE_CONFIG, // configuration loaded from the log or restored from RTC memory
+    BOOT_PHASE_PIXELS, // NeoPixels initialized
+    BOOT_PHASE_ADC, // ADC configured and characterized
+    BOOT_PHASE_TOUCH, // touch sensor enabled
+    BOOT_PHASE_POWER_STATE, // first battery and USB reading
+    BOOT_PHASE_WARM_UP, // warm-up delay elapsed
+    BOOT_PHASE_PETALS, // petals driver initialized (TMC2300 registers)
+    BOOT_PHASE_BEHAVIOR, // behavior set up, loop starts
+    BOOT_PHASE_FIRST_FRAME, // first lit frame of the LEDs
+    BOOT_PHASE_COUNT
+};
+
+// Time of every boot phase in us since reset, to see where the time from touch wake up to the
+// first bloom goes. Only the first time a phase is reached counts. print() writes the phases
+// recorded so far to the serial, the phases reached later are printed as they come.
+class BootTimeline {
+    public:
+        static void mark(BootPhase phase);
+        static uint32_t getTime(BootPhase phase); // 0 when not reached yet
+        static void print();
+        static void reset();
+
+    private:
+        static void printPhase(BootPhase phase);
+
+        static uint32_t times[BOOT_PHASE_COUNT];
+        static bool printed;
+};
@@ -1,5 +1,7 @@
 #include "Config.h"
 #include "math.h"
+#include <limits.h>
+#include <esp_attr.h>
 
 #if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
 #include "esp32-hal-log.h"
@@ -9,16 +11,15 @@
 static const char* LOG_TAG = "Config";
 #endif
 
-// max 512B of EEPROM
-
-#define EEPROM_SIZE 512
-#define CONFIG_VERSION 5
+#define CONFIG_VERSION 6
 
 #define FLAG_BIT_CALIBRATED 0
 #define FLAG_BIT_BLUETOOTH_ALWAYS_ON 1
 #define FLAG_BIT_TOUCH_CALIBRATED 2
 
-// DO NOT CHANGE MEMORY ADDRESSES!
+// Legacy EEPROM layout up to version 5, read only to migrate the configuration to the ConfigStore
+#define EEPROM_SIZE 512
+
 // Hardware constants (reserved 0-19)
 #define EEPROM_ADDRESS_CONFIG_VERSION 0 // byte - version of configuration
 #define EEPROM_ADDRESS_LEDS_MODEL 1 // 0 - WS2812b, 1 - SK6812 (1 byte) NOT USED ANYMORE (since version 1)
@@ -54,16 +55,53 @@ static const char* LOG_TAG = "Config";
 #define EEPROM_ADDRESS_FLOUD_DEVICE_ID 240 // (240-279) max 40 characters (since version 5)
 // next available is 239
 
+// Decoded configuration kept in RTC slow memory over the deep sleep, so the wake up does not need to
+// replay the log and decode the values. Valid only when it matches the flash, the bootloader clears it
+// on power on and on restart.
+#define SNAPSHOT_MAGIC 0x53574C46 // "FLWS"
+
+struct ConfigSnapshot {
+    uint32_t magic;
+    uint8_t firmwareVersion;
+    uint16_t servoClosed;
+    uint16_t servoOpen;
+    uint8_t hardwareRevision;
+    uint16_t serialNumber;
+    uint8_t flags;
+    uint8_t touchThreshold;
+    uint8_t speed;
+    uint8_t maxOpenLevel;
+    uint8_t colorBrightness;
+    uint8_t colorSchemeSize;
+    float colorScheme[COLOR_SCHEME_MAX_LENGTH][2]; // H, S - plain floats, RTC data must not have constructors
+    char name[NAME_MAX_LENGTH + 1];
+    char wifiSsid[WIFI_SSID_MAX_LENGTH + 1];
+    char wifiPassword[WIFI_PWD_MAX_LENGTH + 1];
+    char floudToken[FLOUD_TOKEN_MAX_LENGTH + 1];
+    char floudDeviceId[FLOUD_DEVICE_ID_MAX_LENGTH + 1];
+    uint16_t crc; // of everything above
+};
+
+RTC_DATA_ATTR static ConfigSnapshot snapshot;
+
 void Config::begin() {
-    EEPROM.begin(EEPROM_SIZE);
+    restored = restoreSnapshot();
+    if (!restored) {
+        openStore();
+    }
 }
 
 void Config::load() {
-    uint8_t configVersion = EEPROM.read(EEPROM_ADDRESS_CONFIG_VERSION);
+    if (restored) {
+        ESP_LOGI(LOG_TAG, "Config restored");
+        return;
+    }
+
+    uint8_t configVersion = store.readByte(CONFIG_FIELD_VERSION);
 
     if (configVersion > 0 && configVersion < 255) {
-        servoClosed = readInt(EEPROM_ADDRESS_SERVO_CLOSED);
-        servoOpen = readInt(EEPROM_ADDRESS_SERVO_OPEN);
+        servoClosed = store.readInt(CONFIG_FIELD_SERVO_CLOSED);
+        servoOpen = store.readInt(CONFIG_FIELD_SERVO_OPEN);
 
         // backward compatibility => reset to factory settings
         if (configVersion < 2) {
@@ -79,11 +117,11 @@ void Config::load() {
         // backward compatibility => settings values
         if (configVersion < 4) {
             resetColorScheme();
-            hardwareRevision = EEPROM.read(EEPROM_ADDRESS_REVISION);
-            EEPROM.write(EEPROM_ADDRESS_TOUCH_THRESHOLD, DEFAULT_TOUCH_THRESHOLD);
-            EEPROM.write(EEPROM_ADDRESS_SPEED, DEFAULT_SPEED);
-            EEPROM.write(EEPROM_ADDRESS_MAX_OPEN_LEVEL, DEFAULT_MAX_OPEN_LEVEL);
-            EEPROM.write(EEPROM_ADDRESS_COLOR_BRIGHTNESS, DEFAULT_COLOR_BRIGHTNESS);
+            hardwareRevision = store.readByte(CONFIG_FIELD_REVISION);
+            store.writeByte(CONFIG_FIELD_TOUCH_THRESHOLD, DEFAULT_TOUCH_THRESHOLD);
+            store.writeByte(CONFIG_FIELD_SPEED, DEFAULT_SPEED);
+            store.writeByte(CONFIG_FIELD_MAX_OPEN_LEVEL, DEFAULT_MAX_OPEN_LEVEL);
+            store.writeByte(CONFIG_FIELD_COLOR_BRIGHTNESS, DEFAULT_COLOR_BRIGHTNESS);
         }
 
         // backward compatibility => wifi settings
@@ -94,13 +132,13 @@ void Config::load() {
 
         if (configVersion < CONFIG_VERSION) {
             ESP_LOGW(LOG_TAG, "Config outdated %d -> %d", configVersion, CONFIG_VERSION);
-            EEPROM.write(EEPROM_ADDRESS_CONFIG_VERSION, CONFIG_VERSION);
-            commit(); // this will commit also changes above
+            store.writeByte(CONFIG_FIELD_VERSION, CONFIG_VERSION);
+            flush(); // this will commit also changes above
         }
 
-        hardwareRevision = EEPROM.read(EEPROM_ADDRESS_REVISION);
-        serialNumber = readInt(EEPROM_ADDRESS_SERIALNUMBER);
-        touchThreshold = EEPROM.read(EEPROM_ADDRESS_TOUCH_THRESHOLD);
+        hardwareRevision = store.readByte(CONFIG_FIELD_REVISION);
+        serialNumber = store.readInt(CONFIG_FIELD_SERIALNUMBER);
+        touchThreshold = store.readByte(CONFIG_FIELD_TOUCH_THRESHOLD);
         readFlags();
         readColorScheme();
         readName();
@@ -118,6 +156,7 @@ void Config::load() {
         }
         ESP_LOGI(LOG_TAG, "WiFi: %s, p%d", wifiSsid.c_str(), !wifiPassword.isEmpty());
         ESP_LOGI(LOG_TAG, "Floud: %s, t%d", floudDeviceId.c_str(), !floudToken.isEmpty());
+        saveSnapshot();
     }
     else {
         ESP_LOGE(LOG_TAG, "Not configured");
@@ -126,13 +165,13 @@ void Config::load() {
 
 void Config::hardwareCalibration(unsigned int servoClosed, unsigned int servoOpen, uint8_t hardwareRevision, unsigned int serialNumber) {
     ESP_LOGW(LOG_TAG, "New HW config: %d -> %d, R%d, SN%d", servoClosed, servoOpen, hardwareRevision, serialNumber);
-    EEPROM.write(EEPROM_ADDRESS_CONFIG_VERSION, CONFIG_VERSION);
-    EEPROM.write(EEPROM_ADDRESS_LEDS_MODEL, 0); // 0 - WS2812b, 1 - SK6812 not used any longer
-    writeInt(EEPROM_ADDRESS_SERVO_CLOSED, servoClosed);
-    writeInt(EEPROM_ADDRESS_SERVO_OPEN, servoOpen);
-    EEPROM.write(EEPROM_ADDRESS_REVISION, hardwareRevision);
-    writeInt(EEPROM_ADDRESS_SERIALNUMBER, serialNumber);
-    EEPROM.write(EEPROM_ADDRESS_FLAGS, 0);
+    openStore().writeByte(CONFIG_FIELD_VERSION, CONFIG_VERSION);
+    openStore().writeInt(CONFIG_FIELD_SERVO_CLOSED, servoClosed);
+    openStore().writeInt(CONFIG_FIELD_SERVO_OPEN, servoOpen);
+    openStore().writeByte(CONFIG_FIELD_REVISION, hardwareRevision);
+    openStore().writeInt(CONFIG_FIELD_SERIALNUMBER, serialNumber);
+    openStore().writeByte(CONFIG_FIELD_FLAGS, 0);
+    changedFields = CONFIG_ALL_FIELDS; // everything is reloaded after the calibration
 
     this->servoClosed = servoClosed;
     this->servoOpen = servoOpen;
@@ -147,8 +186,10 @@ void Config::factorySettings() {
     setSpeed(DEFAULT_SPEED);
     setMaxOpenLevel(DEFAULT_MAX_OPEN_LEVEL);
     setColorBrightness(DEFAULT_COLOR_BRIGHTNESS);
-    EEPROM.write(EEPROM_ADDRESS_TOUCH_THRESHOLD, DEFAULT_TOUCH_THRESHOLD); // not used, for forward compabitility only
-    EEPROM.write(EEPROM_ADDRESS_BEHAVIOR, DEFAULT_BEHAVIOR); // not used, for forward compabitility only
+    openStore().writeByte(CONFIG_FIELD_TOUCH_THRESHOLD, DEFAULT_TOUCH_THRESHOLD); // not used, for forward compabitility only
+    markChanged(CONFIG_FIELD_TOUCH_THRESHOLD);
+    openStore().writeByte(CONFIG_FIELD_BEHAVIOR, DEFAULT_BEHAVIOR); // not used, for forward compabitility only
+    markChanged(CONFIG_FIELD_BEHAVIOR);
     resetColorScheme();
 }
 
@@ -166,7 +207,7 @@ void Config::resetColorScheme() {
 }
 
 void Config::readFlags() {
-    flags = EEPROM.read(EEPROM_ADDRESS_FLAGS);
+    flags = store.readByte(CONFIG_FIELD_FLAGS);
     calibrated = CHECK_BIT(flags, FLAG_BIT_CALIBRATED);
     bluetoothAlwaysOn = CHECK_BIT(flags, FLAG_BIT_BLUETOOTH_ALWAYS_ON);
     touchCalibrated = CHECK_BIT(flags, FLAG_BIT_TOUCH_CALIBRATED);
@@ -174,19 +215,22 @@ void Config::readFlags() {
 
 void Config::setCalibrated() {
     flags = SET_BIT(flags, FLAG_BIT_CALIBRATED);
-    EEPROM.write(EEPROM_ADDRESS_FLAGS, flags);
+    openStore().writeByte(CONFIG_FIELD_FLAGS, flags);
+    markChanged(CONFIG_FIELD_FLAGS);
     this->calibrated = true;
 }
 
 void Config::setBluetoothAlwaysOn(bool bluetoothAlwaysOn) {
     flags = bluetoothAlwaysOn ? SET_BIT(flags, FLAG_BIT_BLUETOOTH_ALWAYS_ON) : CLEAR_BIT(flags, FLAG_BIT_BLUETOOTH_ALWAYS_ON);
-    EEPROM.write(EEPROM_ADDRESS_FLAGS, flags);
+    openStore().writeByte(CONFIG_FIELD_FLAGS, flags);
+    markChanged(CONFIG_FIELD_FLAGS);
     this->bluetoothAlwaysOn = bluetoothAlwaysOn;
 }
 
 void Config::setTouchCalibrated(bool touchCalibrated) {
     flags = touchCalibrated ? SET_BIT(flags, FLAG_BIT_TOUCH_CALIBRATED) : CLEAR_BIT(flags, FLAG_BIT_TOUCH_CALIBRATED);
-    EEPROM.write(EEPROM_ADDRESS_FLAGS, flags);
+    openStore().writeByte(CONFIG_FIELD_FLAGS, flags);
+    markChanged(CONFIG_FIELD_FLAGS);
     this->touchCalibrated = touchCalibrated;
 }
 
@@ -199,29 +243,32 @@ void Config::setColorScheme(HsbColor* colors, uint8_t size) {
 }
 
 void Config::setTouchThreshold(uint8_t touchThreshold) {
-    EEPROM.write(EEPROM_ADDRESS_TOUCH_THRESHOLD, touchThreshold);
+    openStore().writeByte(CONFIG_FIELD_TOUCH_THRESHOLD, touchThreshold);
+    markChanged(CONFIG_FIELD_TOUCH_THRESHOLD);
     this->touchThreshold = touchThreshold;
 }
 
 void Config::setSpeed(uint8_t speed) {
     this->speed = speed;
     this->speedMillis = speed * 100;
-    EEPROM.write(EEPROM_ADDRESS_SPEED, speed);
+    openStore().writeByte(CONFIG_FIELD_SPEED, speed);
+    markChanged(CONFIG_FIELD_SPEED);
 }
 
 void Config::setMaxOpenLevel(uint8_t maxOpenLevel) {
     this->maxOpenLevel = maxOpenLevel;
-    EEPROM.write(EEPROM_ADDRESS_MAX_OPEN_LEVEL, maxOpenLevel);
+    openStore().writeByte(CONFIG_FIELD_MAX_OPEN_LEVEL, maxOpenLevel);
+    markChanged(CONFIG_FIELD_MAX_OPEN_LEVEL);
 }
 
 void Config::setColorBrightness(uint8_t colorBrightness) {
     this->colorBrightness = colorBrightness;
-    this->colorBrightnessDecimal = (double) colorBrightness / 100.0;
-    EEPROM.write(EEPROM_ADDRESS_COLOR_BRIGHTNESS, colorBrightness);
+    openStore().writeByte(CONFIG_FIELD_COLOR_BRIGHTNESS, colorBrightness);
+    markChanged(CONFIG_FIELD_COLOR_BRIGHTNESS);
 }
 
 void Config::readSpeed() {
-    speed = EEPROM.read(EEPROM_ADDRESS_SPEED);
+    speed = store.readByte(CONFIG_FIELD_SPEED);
     if (speed < 5) {
         speed = 5;
     }
@@ -229,31 +276,36 @@ void Config::readSpeed() {
 }
 
 void Config::readMaxOpenLevel() {
-    maxOpenLevel = EEPROM.read(EEPROM_ADDRESS_MAX_OPEN_LEVEL);
+    maxOpenLevel = store.readByte(CONFIG_FIELD_MAX_OPEN_LEVEL);
     if (maxOpenLevel > 100) {
         maxOpenLevel = 100;
     }
 }
 
 void Config::readColorBrightness() {
-    colorBrightness = EEPROM.read(EEPROM_ADDRESS_COLOR_BRIGHTNESS);
+    colorBrightness = store.readByte(CONFIG_FIELD_COLOR_BRIGHTNESS);
     if (colorBrightness > 100) {
         colorBrightness = 100;
     }
-    colorBrightnessDecimal = (double) colorBrightness / 100.0;
 }
 
 void Config::writeColorScheme() {
-    for (uint8_t i = 0; i < colorSchemeSize && i < COLOR_SCHEME_MAX_LENGTH; i++) {
-        writeInt(EEPROM_ADDRESS_COLOR_SCHEME + i * 2, encodeHSColor(colorScheme[i].H, colorScheme[i].S));
+    uint8_t data[COLOR_SCHEME_MAX_LENGTH * 2];
+    uint8_t size = min(colorSchemeSize, (uint8_t) COLOR_SCHEME_MAX_LENGTH);
+    for (uint8_t i = 0; i < size; i++) {
+        uint16_t valueHS = encodeHSColor(colorScheme[i].H, colorScheme[i].S);
+        data[i * 2] = valueHS & 0xFF;
+        data[i * 2 + 1] = valueHS >> 8;
     }
-    EEPROM.write(EEPROM_ADDRESS_COLOR_SCHEME_LENGTH, colorSchemeSize);
+    openStore().write(CONFIG_FIELD_COLOR_SCHEME, data, size * 2);
+    markChanged(CONFIG_FIELD_COLOR_SCHEME);
 }
 
 void Config::readColorScheme() {
-    colorSchemeSize = min(EEPROM.read(EEPROM_ADDRESS_COLOR_SCHEME_LENGTH), (uint8_t) COLOR_SCHEME_MAX_LENGTH);
+    uint8_t data[COLOR_SCHEME_MAX_LENGTH * 2];
+    colorSchemeSize = store.read(CONFIG_FIELD_COLOR_SCHEME, data, COLOR_SCHEME_MAX_LENGTH * 2) / 2;
     for(uint8_t i = 0; i < colorSchemeSize; i++) {
-        colorScheme[i] = decodeHSColor(readInt(EEPROM_ADDRESS_COLOR_SCHEME + i * 2));
+        colorScheme[i] = decodeHSColor(data[i * 2] | (data[i * 2 + 1] << 8));
     }
 }
 
@@ -273,62 +325,84 @@ HsbColor Config::decodeHSColor(uint16_t valueHS) {
 
 void Config::setName(String name) {
     this->name = name;
-    writeString(EEPROM_ADDRESS_NAME, name, EEPROM_ADDRESS_NAME_LENGTH, NAME_MAX_LENGTH);
+    openStore().writeString(CONFIG_FIELD_NAME, name, NAME_MAX_LENGTH);
+    markChanged(CONFIG_FIELD_NAME);
 }
 
 void Config::readName() {
-    name = readString(EEPROM_ADDRESS_NAME, EEPROM_ADDRESS_NAME_LENGTH, NAME_MAX_LENGTH);
+    name = store.readString(CONFIG_FIELD_NAME, NAME_MAX_LENGTH);
 }
 
 void Config::setWifi(String ssid, String password) {
     this->wifiSsid = ssid;
     this->wifiPassword = password;
-    writeString(EEPROM_ADDRESS_WIFI_SSID, ssid, EEPROM_ADDRESS_WIFI_SSID_LENGTH, WIFI_SSID_MAX_LENGTH);
-    writeString(EEPROM_ADDRESS_WIFI_PWD, password, EEPROM_ADDRESS_WIFI_PWD_LENGTH, WIFI_PWD_MAX_LENGTH);
-    wifiChanged = true;
+    openStore().writeString(CONFIG_FIELD_WIFI_SSID, ssid, WIFI_SSID_MAX_LENGTH);
+    markChanged(CONFIG_FIELD_WIFI_SSID);
+    openStore().writeString(CONFIG_FIELD_WIFI_PWD, password, WIFI_PWD_MAX_LENGTH);
+    markChanged(CONFIG_FIELD_WIFI_PWD);
 }
 
 void Config::setFloud(String deviceId, String token) {
     this->floudDeviceId = deviceId;
     this->floudToken = token;
-    writeString(EEPROM_ADDRESS_FLOUD_DEVICE_ID, deviceId, EEPROM_ADDRESS_FLOUD_DEVICE_ID_LENGTH, FLOUD_DEVICE_ID_MAX_LENGTH);
-    writeString(EEPROM_ADDRESS_FLOUD_TOKEN, token, EEPROM_ADDRESS_FLOUD_TOKEN_LENGTH, FLOUD_TOKEN_MAX_LENGTH);
-    wifiChanged = true;
+    openStore().writeString(CONFIG_FIELD_FLOUD_DEVICE_ID, deviceId, FLOUD_DEVICE_ID_MAX_LENGTH);
+    markChanged(CONFIG_FIELD_FLOUD_DEVICE_ID);
+    openStore().writeString(CONFIG_FIELD_FLOUD_TOKEN, token, FLOUD_TOKEN_MAX_LENGTH);
+    markChanged(CONFIG_FIELD_FLOUD_TOKEN);
 }
 
 void Config::readWifiAndFloud() {
-    wifiSsid = readString(EEPROM_ADDRESS_WIFI_SSID, EEPROM_ADDRESS_WIFI_SSID_LENGTH, WIFI_SSID_MAX_LENGTH);
-    wifiPassword = readString(EEPROM_ADDRESS_WIFI_PWD, EEPROM_ADDRESS_WIFI_PWD_LENGTH, WIFI_PWD_MAX_LENGTH);
-    floudDeviceId = readString(EEPROM_ADDRESS_FLOUD_DEVICE_ID, EEPROM_ADDRESS_FLOUD_DEVICE_ID_LENGTH, FLOUD_DEVICE_ID_MAX_LENGTH);
-    floudToken = readString(EEPROM_ADDRESS_FLOUD_TOKEN, EEPROM_ADDRESS_FLOUD_TOKEN_LENGTH, FLOUD_TOKEN_MAX_LENGTH);
+    wifiSsid = store.readString(CONFIG_FIELD_WIFI_SSID, WIFI_SSID_MAX_LENGTH);
+    wifiPassword = store.readString(CONFIG_FIELD_WIFI_PWD, WIFI_PWD_MAX_LENGTH);
+    floudDeviceId = store.readString(CONFIG_FIELD_FLOUD_DEVICE_ID, FLOUD_DEVICE_ID_MAX_LENGTH);
+    floudToken = store.readString(CONFIG_FIELD_FLOUD_TOKEN, FLOUD_TOKEN_MAX_LENGTH);
 }
 
-void Config::writeInt(uint16_t address, uint16_t value) {
-    uint8_t two = (value & 0xFF);
-    uint8_t one = ((value >> 8) & 0xFF);
-    
-    EEPROM.write(address, two);
-    EEPROM.write(address + 1, one);
+void Config::migrateEeprom() {
+    EEPROM.begin(EEPROM_SIZE);
+    uint8_t configVersion = EEPROM.read(EEPROM_ADDRESS_CONFIG_VERSION);
+    if (configVersion > 0 && configVersion < 255) {
+        // copied as it is, load() upgrades the values of older versions
+        ESP_LOGW(LOG_TAG, "Migrating EEPROM config %d", configVersion);
+        store.writeByte(CONFIG_FIELD_VERSION, configVersion);
+        store.writeInt(CONFIG_FIELD_SERVO_CLOSED, readEepromInt(EEPROM_ADDRESS_SERVO_CLOSED));
+        store.writeInt(CONFIG_FIELD_SERVO_OPEN, readEepromInt(EEPROM_ADDRESS_SERVO_OPEN));
+        store.writeByte(CONFIG_FIELD_REVISION, EEPROM.read(EEPROM_ADDRESS_REVISION));
+        store.writeInt(CONFIG_FIELD_SERIALNUMBER, readEepromInt(EEPROM_ADDRESS_SERIALNUMBER));
+        store.writeByte(CONFIG_FIELD_FLAGS, EEPROM.read(EEPROM_ADDRESS_FLAGS));
+        store.writeByte(CONFIG_FIELD_TOUCH_THRESHOLD, EEPROM.read(EEPROM_ADDRESS_TOUCH_THRESHOLD));
+        store.writeByte(CONFIG_FIELD_BEHAVIOR, EEPROM.read(EEPROM_ADDRESS_BEHAVIOR));
+        store.writeByte(CONFIG_FIELD_SPEED, EEPROM.read(EEPROM_ADDRESS_SPEED));
+        store.writeByte(CONFIG_FIELD_MAX_OPEN_LEVEL, EEPROM.read(EEPROM_ADDRESS_MAX_OPEN_LEVEL));
+        store.writeByte(CONFIG_FIELD_COLOR_BRIGHTNESS, EEPROM.read(EEPROM_ADDRESS_COLOR_BRIGHTNESS));
+
+        uint8_t colorScheme[COLOR_SCHEME_MAX_LENGTH * 2];
+        uint8_t colorSchemeSize = min(EEPROM.read(EEPROM_ADDRESS_COLOR_SCHEME_LENGTH), (uint8_t) COLOR_SCHEME_MAX_LENGTH);
+        for (uint8_t i = 0; i < colorSchemeSize * 2; i++) {
+            colorScheme[i] = EEPROM.read(EEPROM_ADDRESS_COLOR_SCHEME + i);
+        }
+        store.write(CONFIG_FIELD_COLOR_SCHEME, colorScheme, colorSchemeSize * 2);
+
+        store.writeString(CONFIG_FIELD_NAME, readEepromString(EEPROM_ADDRESS_NAME, EEPROM_ADDRESS_NAME_LENGTH, NAME_MAX_LENGTH), NAME_MAX_LENGTH);
+        if (configVersion >= 5) {
+            store.writeString(CONFIG_FIELD_WIFI_SSID, readEepromString(EEPROM_ADDRESS_WIFI_SSID, EEPROM_ADDRESS_WIFI_SSID_LENGTH, WIFI_SSID_MAX_LENGTH), WIFI_SSID_MAX_LENGTH);
+            store.writeString(CONFIG_FIELD_WIFI_PWD, readEepromString(EEPROM_ADDRESS_WIFI_PWD, EEPROM_ADDRESS_WIFI_PWD_LENGTH, WIFI_PWD_MAX_LENGTH), WIFI_PWD_MAX_LENGTH);
+            store.writeString(CONFIG_FIELD_FLOUD_TOKEN, readEepromString(EEPROM_ADDRESS_FLOUD_TOKEN, EEPROM_ADDRESS_FLOUD_TOKEN_LENGTH, FLOUD_TOKEN_MAX_LENGTH), FLOUD_TOKEN_MAX_LENGTH);
+            store.writeString(CONFIG_FIELD_FLOUD_DEVICE_ID, readEepromString(EEPROM_ADDRESS_FLOUD_DEVICE_ID, EEPROM_ADDRESS_FLOUD_DEVICE_ID_LENGTH, FLOUD_DEVICE_ID_MAX_LENGTH), FLOUD_DEVICE_ID_MAX_LENGTH);
+        }
+        store.commit(); // EEPROM is kept as it is
+    }
+    EEPROM.end();
 }
 
-uint16_t Config::readInt(uint16_t address) {
+uint16_t Config::readEepromInt(uint16_t address) {
     uint8_t two = EEPROM.read(address);
     uint16_t one = EEPROM.read(address + 1);
   
     return (two & 0xFFFFFF) + ((one << 8) & 0xFFFFFFFF);
 }
 
-void Config::writeString(uint16_t address, String value, uint16_t sizeAddress, uint8_t maxLength) {
-    uint8_t length = min((uint8_t) value.length(), (uint8_t) maxLength);
-    if (length > 0) {
-        for (uint8_t i = 0; i < length; i++) {
-            EEPROM.write(address + i, value[i]);
-        }
-    }
-    EEPROM.write(sizeAddress, length);
-}
-
-String Config::readString(uint16_t address, uint16_t sizeAddress, uint8_t maxLength) {
+String Config::readEepromString(uint16_t address, uint16_t sizeAddress, uint8_t maxLength) {
     uint8_t length = min(EEPROM.read(sizeAddress), (uint8_t) maxLength);
     if (length == 0) {
         return String();
@@ -342,13 +416,131 @@ String Config::readString(uint16_t address, uint16_t sizeAddress, uint8_t maxLen
 }
 
 void Config::commit() {
-    EEPROM.commit();
-    if (configChangedCallback != nullptr) {
-        configChangedCallback(wifiChanged);
-        wifiChanged = false;
+    invalidateSnapshot(); // the flash is going to change
+    unsigned long now = millis();
+    if (!commitPending) {
+        commitPending = true;
+        commitFirstTime = now;
+    }
+    commitLastTime = now;
+}
+
+void Config::flush() {
+    commitPending = false;
+    if (!storeOpened) {
+        if (restored) {
+            saveSnapshot(); // nothing set since, the flash did not change
+        }
+        return;
+    }
+    if (store.commit() && store.has(CONFIG_FIELD_VERSION)) {
+        saveSnapshot();
+    }
+    else {
+        invalidateSnapshot();
+    }
+    uint32_t fields = changedFields;
+    changedFields = 0;
+    if (fields != 0 && configChangedCallback != nullptr) {
+        ESP_LOGI(LOG_TAG, "Changed fields %x", fields);
+        configChangedCallback(fields);
     }
 }
 
+void Config::update() {
+    if (commitPending && getCommitDelay() == 0) {
+        flush();
+    }
+}
+
+unsigned long Config::getCommitDelay() {
+    if (!commitPending) {
+        return ULONG_MAX;
+    }
+    unsigned long now = millis();
+    unsigned long settled = now - commitLastTime >= CONFIG_COMMIT_DELAY ? 0 : CONFIG_COMMIT_DELAY - (now - commitLastTime);
+    unsigned long limit = now - commitFirstTime >= CONFIG_COMMIT_MAX_DELAY ? 0 : CONFIG_COMMIT_MAX_DELAY - (now - commitFirstTime);
+    return _min(settled, limit);
+}
+
+void Config::markChanged(uint8_t field) {
+    changedFields |= CONFIG_FIELD_BIT(field);
+}
+
 void Config::onConfigChanged(ConfigChangedCallback callback) {
     configChangedCallback = callback;
-}
\ No newline at end of file
+}
+
+bool Config::isRestored() {
+    return restored;
+}
+
+ConfigStore& Config::openStore() {
+    if (!storeOpened) {
+        storeOpened = true;
+        if (!store.begin()) {
+            migrateEeprom();
+        }
+    }
+    return store;
+}
+
+bool Config::restoreSnapshot() {
+    if (snapshot.magic != SNAPSHOT_MAGIC || snapshot.firmwareVersion != firmwareVersion
+            || snapshot.crc != ConfigStore::crc16((const uint8_t*) &snapshot, offsetof(ConfigSnapshot, crc))) {
+        return false;
+    }
+    servoClosed = snapshot.servoClosed;
+    servoOpen = snapshot.servoOpen;
+    hardwareRevision = snapshot.hardwareRevision;
+    serialNumber = snapshot.serialNumber;
+    flags = snapshot.flags;
+    calibrated = CHECK_BIT(flags, FLAG_BIT_CALIBRATED);
+    bluetoothAlwaysOn = CHECK_BIT(flags, FLAG_BIT_BLUETOOTH_ALWAYS_ON);
+    touchCalibrated = CHECK_BIT(flags, FLAG_BIT_TOUCH_CALIBRATED);
+    touchThreshold = snapshot.touchThreshold;
+    speed = snapshot.speed;
+    speedMillis = speed * 100;
+    maxOpenLevel = snapshot.maxOpenLevel;
+    colorBrightness = snapshot.colorBrightness;
+    colorSchemeSize = _min(snapshot.colorSchemeSize, (uint8_t) COLOR_SCHEME_MAX_LENGTH);
+    for (uint8_t i = 0; i < colorSchemeSize; i++) {
+        colorScheme[i] = HsbColor(snapshot.colorScheme[i][0], snapshot.colorScheme[i][1], 1.0);
+    }
+    name = snapshot.name;
+    wifiSsid = snapshot.wifiSsid;
+    wifiPassword = snapshot.wifiPassword;
+    floudToken = snapshot.floudToken;
+    floudDeviceId = snapshot.floudDeviceId;
+    return true;
+}
+
+void Config::saveSnapshot() {
+    memset(&snapshot, 0, sizeof(ConfigSnapshot));
+    snapshot.magic = SNAPSHOT_MAGIC;
+    snapshot.firmwareVersion = firmwareVersion;
+    snapshot.servoClosed = servoClosed;
+    snapshot.servoOpen = servoOpen;
+    snapshot.hardwareRevision = hardwareRevision;
+    snapshot.serialNumber = serialNumber;
+    snapshot.flags = flags;
+    snapshot.touchThreshold = touchThreshold;
+    snapshot.speed = speed;
+    snapshot.maxOpenLevel = maxOpenLevel;
+    snapshot.colorBrightness = colorBrightness;
+    snapshot.colorSchemeSize = colorSchemeSize;
+    for (uint8_t i = 0; i < colorSchemeSize; i++) {
+        snapshot.colorScheme[i][0] = colorScheme[i].H;
+        snapshot.colorScheme[i][1] = colorScheme[i].S;
+    }
+    strncpy(snapshot.name, name.c_str(), NAME_MAX_LENGTH);
+    strncpy(snapshot.wifiSsid, wifiSsid.c_str(), WIFI_SSID_MAX_LENGTH);
+    strncpy(snapshot.wifiPassword, wifiPassword.c_str(), WIFI_PWD_MAX_LENGTH);
+    strncpy(snapshot.floudToken, floudToken.c_str(), FLOUD_TOKEN_MAX_LENGTH);
+    strncpy(snapshot.floudDeviceId, floudDeviceId.c_str(), FLOUD_DEVICE_ID_MAX_LENGTH);
+    snapshot.crc = ConfigStore::crc16((const uint8_t*) &snapshot, offsetof(ConfigSnapshot, crc));
+}
+
+void Config::invalidateSnapshot() {
+    snapshot.magic = 0;
+}
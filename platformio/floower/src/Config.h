@@ -2,6 +2,7 @@
 
 #include "Arduino.h"
 #include <EEPROM.h>
+#include "ConfigStore.h"
 #include "NeoPixelBus.h"
 
 #define CHECK_BIT(var, pos) ((var) & (1<<(pos)))
@@ -21,6 +22,42 @@
 #define DEFAULT_SPEED 50 // x0.1s = 5 seconds to open/close
 #define DEFAULT_MAX_OPEN_LEVEL 100 // default open level is 100%
 #define DEFAULT_COLOR_BRIGHTNESS 70 // default intensity is 70%
+#define DEFAULT_TOUCH_FADE_TIME 75 // ms without a touch interrupt ends the touch
+#define DEFAULT_TOUCH_TAP_TIME 400 // ms, longer touch is not a tap
+#define DEFAULT_TOUCH_MULTI_TAP_TIME 300 // ms between taps of double and triple tap
+#define DEFAULT_TOUCH_LONG_TIME 2000 // ms to recognize long touch
+#define DEFAULT_TOUCH_HOLD_TIME 5000 // ms to recognize hold touch
+
+// fields of the configuration, the IDs are stored in flash - DO NOT CHANGE FIELD IDS!
+// Hardware constants
+#define CONFIG_FIELD_VERSION 0 // byte - version of configuration
+#define CONFIG_FIELD_SERVO_CLOSED 1 // integer - calibrated position of servo blossom closed
+#define CONFIG_FIELD_SERVO_OPEN 2 // integer - calibrated position of servo blossom open
+#define CONFIG_FIELD_REVISION 3 // byte - revision number of the logic board to enable features
+#define CONFIG_FIELD_SERIALNUMBER 4 // integer
+#define CONFIG_FIELD_FLAGS 5 // byte (8 bites) - config flags [calibrated,bluetoothAlwaysOn,touchCalibrated,,,,,]
+
+// Customizable values
+#define CONFIG_FIELD_TOUCH_THRESHOLD 6 // byte - calibrated touch threshold value
+#define CONFIG_FIELD_BEHAVIOR 7 // byte - enumeration of predefined behaviors
+#define CONFIG_FIELD_SPEED 8 // byte - speed of opening/closing in 0.1s
+#define CONFIG_FIELD_MAX_OPEN_LEVEL 9 // byte - maximum open level in percents (0-100)
+#define CONFIG_FIELD_COLOR_BRIGHTNESS 10 // byte - intensity of LEDs in percents (0-100)
+#define CONFIG_FIELD_COLOR_SCHEME 11 // max 10x integer - HS colors [(H/9 + S/7), (H/9 + S/7), ..]
+#define CONFIG_FIELD_NAME 12 // max 25 chars
+
+// wifi
+#define CONFIG_FIELD_WIFI_SSID 13 // max 32 chars
+#define CONFIG_FIELD_WIFI_PWD 14 // max 64 chars
+#define CONFIG_FIELD_FLOUD_TOKEN 15 // max 40 chars
+#define CONFIG_FIELD_FLOUD_DEVICE_ID 16 // max 40 chars
+
+#define CONFIG_FIELD_BIT(field) (1UL << (field))
+#define CONFIG_ALL_FIELDS 0xFFFFFFFF
+#define CONFIG_WIFI_FIELDS (CONFIG_FIELD_BIT(CONFIG_FIELD_WIFI_SSID) | CONFIG_FIELD_BIT(CONFIG_FIELD_WIFI_PWD) | CONFIG_FIELD_BIT(CONFIG_FIELD_FLOUD_TOKEN) | CONFIG_FIELD_BIT(CONFIG_FIELD_FLOUD_DEVICE_ID))
+
+#define CONFIG_COMMIT_DELAY 1000 // ms without a change before the commit is written
+#define CONFIG_COMMIT_MAX_DELAY 5000 // ms a burst of changes can postpone the commit
 
 const HsbColor colorRed(0.0, 1.0, 1.0);
 const HsbColor colorGreen(0.3, 1.0, 1.0);
@@ -32,7 +69,7 @@ const HsbColor colorPurple(0.81, 1.0, 1.0);
 const HsbColor colorPink(0.93, 1.0, 1.0);
 const HsbColor colorBlack(0.0, 1.0, 0.0);
 
-typedef std::function<void(bool wifiChanged)> ConfigChangedCallback;
+typedef std::function<void(uint32_t changedFields)> ConfigChangedCallback; // CONFIG_FIELD_BIT mask
 
 class Config {
     public:
@@ -53,7 +90,11 @@ class Config {
         void setColorBrightness(uint8_t colorBrightness);
         void setWifi(String ssid, String password);
         void setFloud(String deviceId, String token);
-        void commit();
+        void commit(); // written once the changes settle down, see update()
+        void flush(); // writes the pending commit right away
+        void update(); // writes the commit when it is due
+        unsigned long getCommitDelay(); // ms until the pending commit is written, ULONG_MAX when none
+        bool isRestored(); // begin() took the values from the snapshot of the last deep sleep
         void onConfigChanged(ConfigChangedCallback callback);
 
         static uint16_t encodeHSColor(double hue, double saturation);
@@ -80,6 +121,13 @@ class Config {
         // static configuration
         String modelName = "Floower";
 
+        // touch gestures
+        uint16_t touchFadeTime = DEFAULT_TOUCH_FADE_TIME;
+        uint16_t touchTapTime = DEFAULT_TOUCH_TAP_TIME;
+        uint16_t touchMultiTapTime = DEFAULT_TOUCH_MULTI_TAP_TIME;
+        uint16_t touchLongTime = DEFAULT_TOUCH_LONG_TIME;
+        uint16_t touchHoldTime = DEFAULT_TOUCH_HOLD_TIME;
+
         // configration
         uint8_t colorSchemeSize = 0;
         HsbColor colorScheme[10]; // max 10 colors
@@ -87,8 +135,7 @@ class Config {
         String name;
         uint8_t speed;
         uint16_t speedMillis; // read-only, precalculated speed in ms
-        uint8_t colorBrightness;
-        double colorBrightnessDecimal; // read-only, precalcuated color brightness (0.0-1.0)
+        uint8_t colorBrightness; // global brightness of the petal LEDs, applied when the pixels are shown
         uint8_t maxOpenLevel;
         String wifiSsid;
         String wifiPassword;
@@ -104,15 +151,25 @@ class Config {
         void readSpeed();
         void readMaxOpenLevel();
         void readColorBrightness();
-
-        void writeInt(uint16_t address, uint16_t value);
-        uint16_t readInt(uint16_t address);
-
-        void writeString(uint16_t address, String value, uint16_t sizeAddress, uint8_t maxLength);
-        String readString(uint16_t address, uint16_t sizeAddress, uint8_t maxLength);
-
+        void markChanged(uint8_t field);
+        ConfigStore& openStore();
+        bool restoreSnapshot();
+        void saveSnapshot();
+        void invalidateSnapshot();
+
+        void migrateEeprom();
+        uint16_t readEepromInt(uint16_t address);
+        String readEepromString(uint16_t address, uint16_t sizeAddress, uint8_t maxLength);
+
+        ConfigStore store; // replayed only when needed, the snapshot does not need it
+        bool storeOpened = false;
+        bool restored = false;
         uint8_t flags = 0;
+
         ConfigChangedCallback configChangedCallback;
-        bool wifiChanged = false;
+        uint32_t changedFields = 0; // CONFIG_FIELD_BIT mask of the fields set since the last commit
+        bool commitPending = false;
+        unsigned long commitFirstTime = 0;
+        unsigned long commitLastTime = 0;
 
 };
\ No newline at end of file
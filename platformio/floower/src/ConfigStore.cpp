@@ -0,0 +1,252 @@
+#include "ConfigStore.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#define LOG_TAG ""
+#else
+#include "esp_log.h"
+static const char* LOG_TAG = "ConfigStore";
+#endif
+
+// sector: [magic 4B][sequence 4B][record][record]..[0xFF..]
+// record: [field 1B][length 1B][value][CRC16 of field, length and value 2B]
+// the header is written after the records of the compaction, a sector without it is not used
+
+#define SECTOR_MAGIC 0x43574C46 // "FLWC"
+#define SECTOR_HEADER_SIZE 8
+#define RECORD_OVERHEAD 4
+#define ERASED 0xFF
+
+bool ConfigStore::begin() {
+    for (uint8_t field = 0; field < CONFIG_STORE_FIELDS; field++) {
+        values[field].present = false;
+        values[field].dirty = false;
+    }
+    activeSector = CONFIG_STORE_SECTORS;
+    sequence = 0;
+    writeOffset = 0;
+    chunkLength = 0;
+
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, NULL);
+    if (partition == nullptr || partition->size < CONFIG_STORE_SECTORS * CONFIG_STORE_SECTOR_SIZE) {
+        ESP_LOGE(LOG_TAG, "No partition");
+        partition = nullptr;
+        return false;
+    }
+
+    // the sector with the highest sequence holds the log
+    for (uint8_t sector = 0; sector < CONFIG_STORE_SECTORS; sector++) {
+        uint32_t header[2];
+        if (readFlash(sectorAddress(sector), (uint8_t*) header, SECTOR_HEADER_SIZE) && header[0] == SECTOR_MAGIC && header[1] != 0xFFFFFFFF
+                && (activeSector == CONFIG_STORE_SECTORS || header[1] > sequence)) {
+            activeSector = sector;
+            sequence = header[1];
+        }
+    }
+    if (activeSector == CONFIG_STORE_SECTORS) {
+        ESP_LOGI(LOG_TAG, "Empty");
+        return false;
+    }
+
+    // replay the records
+    uint32_t address = sectorAddress(activeSector);
+    uint16_t offset = SECTOR_HEADER_SIZE;
+    uint16_t records = 0;
+    while (offset + RECORD_OVERHEAD <= CONFIG_STORE_SECTOR_SIZE) {
+        uint8_t record[2 + CONFIG_STORE_MAX_LENGTH + 2];
+        if (!readFlash(address + offset, record, 2)) {
+            break;
+        }
+        if (record[0] == ERASED && record[1] == ERASED) {
+            break; // end of the log
+        }
+        uint8_t field = record[0];
+        uint8_t length = record[1];
+        if (field >= CONFIG_STORE_FIELDS || length > CONFIG_STORE_MAX_LENGTH || offset + RECORD_OVERHEAD + length > CONFIG_STORE_SECTOR_SIZE
+                || !readFlash(address + offset + 2, record + 2, length + 2)
+                || crc16(record, length + 2) != (record[length + 2] | (record[length + 3] << 8))) {
+            ESP_LOGW(LOG_TAG, "Corrupted record at %d", offset);
+            offset = CONFIG_STORE_SECTOR_SIZE; // nothing can be appended after it, next commit compacts
+            break;
+        }
+        Value &value = values[field];
+        value.present = true;
+        value.length = length;
+        memcpy(value.data, record + 2, length);
+        offset += RECORD_OVERHEAD + length;
+        records++;
+    }
+    writeOffset = offset;
+    chunkLength = 0;
+    ESP_LOGI(LOG_TAG, "Sector %d, seq %d, %d records, %dB used", activeSector, sequence, records, writeOffset);
+    return true;
+}
+
+bool ConfigStore::commit() {
+    if (partition == nullptr) {
+        return false;
+    }
+    for (uint8_t field = 0; field < CONFIG_STORE_FIELDS; field++) {
+        if (values[field].dirty && !append(field)) {
+            return compact();
+        }
+    }
+    return true;
+}
+
+bool ConfigStore::has(uint8_t field) {
+    return field < CONFIG_STORE_FIELDS && values[field].present;
+}
+
+uint8_t ConfigStore::read(uint8_t field, uint8_t *data, uint8_t maxLength) {
+    if (!has(field)) {
+        return 0;
+    }
+    uint8_t length = _min(values[field].length, maxLength);
+    memcpy(data, values[field].data, length);
+    return length;
+}
+
+uint8_t ConfigStore::readByte(uint8_t field, uint8_t defaultValue) {
+    uint8_t value;
+    return read(field, &value, 1) == 1 ? value : defaultValue;
+}
+
+uint16_t ConfigStore::readInt(uint8_t field, uint16_t defaultValue) {
+    uint8_t value[2];
+    return read(field, value, 2) == 2 ? value[0] | (value[1] << 8) : defaultValue;
+}
+
+String ConfigStore::readString(uint8_t field, uint8_t maxLength) {
+    char data[CONFIG_STORE_MAX_LENGTH + 1];
+    uint8_t length = read(field, (uint8_t*) data, _min(maxLength, CONFIG_STORE_MAX_LENGTH));
+    data[length] = '\0';
+    return String(data);
+}
+
+void ConfigStore::write(uint8_t field, const uint8_t *data, uint8_t length) {
+    if (field >= CONFIG_STORE_FIELDS) {
+        return;
+    }
+    Value &value = values[field];
+    length = _min(length, CONFIG_STORE_MAX_LENGTH);
+    if (value.present && value.length == length && memcmp(value.data, data, length) == 0) {
+        return; // same value, nothing to append
+    }
+    value.present = true;
+    value.dirty = true;
+    value.length = length;
+    memcpy(value.data, data, length);
+}
+
+void ConfigStore::writeByte(uint8_t field, uint8_t value) {
+    write(field, &value, 1);
+}
+
+void ConfigStore::writeInt(uint8_t field, uint16_t value) {
+    uint8_t data[2] = {(uint8_t) (value & 0xFF), (uint8_t) (value >> 8)};
+    write(field, data, 2);
+}
+
+void ConfigStore::writeString(uint8_t field, const String& value, uint8_t maxLength) {
+    write(field, (const uint8_t*) value.c_str(), _min((uint8_t) value.length(), maxLength));
+}
+
+uint8_t ConfigStore::getActiveSector() {
+    return activeSector;
+}
+
+uint16_t ConfigStore::getWriteOffset() {
+    return writeOffset;
+}
+
+bool ConfigStore::append(uint8_t field) {
+    uint16_t size = RECORD_OVERHEAD + values[field].length;
+    if (activeSector == CONFIG_STORE_SECTORS || writeOffset + size > CONFIG_STORE_SECTOR_SIZE) {
+        return false; // sector full
+    }
+    if (!writeRecord(sectorAddress(activeSector) + writeOffset, field)) {
+        writeOffset = CONFIG_STORE_SECTOR_SIZE; // do not append after a failed record
+        return false;
+    }
+    writeOffset += size;
+    values[field].dirty = false;
+    return true;
+}
+
+bool ConfigStore::compact() {
+    uint8_t sector = activeSector == CONFIG_STORE_SECTORS ? 0 : (activeSector + 1) % CONFIG_STORE_SECTORS;
+    uint32_t address = sectorAddress(sector);
+    ESP_LOGI(LOG_TAG, "Compacting to sector %d", sector);
+
+    if (esp_partition_erase_range(partition, address, CONFIG_STORE_SECTOR_SIZE) != ESP_OK) {
+        ESP_LOGE(LOG_TAG, "Erase failed");
+        return false;
+    }
+    uint16_t offset = SECTOR_HEADER_SIZE;
+    for (uint8_t field = 0; field < CONFIG_STORE_FIELDS; field++) {
+        if (values[field].present) {
+            if (!writeRecord(address + offset, field)) {
+                return false; // the old sector is still the valid one
+            }
+            offset += RECORD_OVERHEAD + values[field].length;
+        }
+    }
+    uint32_t header[2] = {SECTOR_MAGIC, sequence + 1};
+    if (esp_partition_write(partition, address, header, SECTOR_HEADER_SIZE) != ESP_OK) {
+        ESP_LOGE(LOG_TAG, "Header write failed");
+        return false;
+    }
+
+    for (uint8_t field = 0; field < CONFIG_STORE_FIELDS; field++) {
+        values[field].dirty = false;
+    }
+    activeSector = sector;
+    sequence++;
+    writeOffset = offset;
+    return true;
+}
+
+bool ConfigStore::writeRecord(uint32_t offset, uint8_t field) {
+    Value &value = values[field];
+    uint8_t record[2 + CONFIG_STORE_MAX_LENGTH + 2];
+    record[0] = field;
+    record[1] = value.length;
+    memcpy(record + 2, value.data, value.length);
+    uint16_t crc = crc16(record, value.length + 2);
+    record[value.length + 2] = crc & 0xFF;
+    record[value.length + 3] = crc >> 8;
+    if (esp_partition_write(partition, offset, record, value.length + RECORD_OVERHEAD) != ESP_OK) {
+        ESP_LOGE(LOG_TAG, "Write failed");
+        return false;
+    }
+    return true;
+}
+
+bool ConfigStore::readFlash(uint32_t offset, uint8_t *data, uint16_t length) {
+    if (offset < chunkOffset || offset + length > chunkOffset + chunkLength) {
+        chunkOffset = offset;
+        chunkLength = _min((uint32_t) CONFIG_STORE_READ_CHUNK, partition->size - offset);
+        if (length > chunkLength || esp_partition_read(partition, chunkOffset, chunk, chunkLength) != ESP_OK) {
+            chunkLength = 0;
+            return false;
+        }
+    }
+    memcpy(data, chunk + (offset - chunkOffset), length);
+    return true;
+}
+
+uint32_t ConfigStore::sectorAddress(uint8_t sector) {
+    return sector * CONFIG_STORE_SECTOR_SIZE;
+}
+
+uint16_t ConfigStore::crc16(const uint8_t *data, uint16_t length, uint16_t crc) {
+    // CRC-16/CCITT-FALSE
+    for (uint16_t i = 0; i < length; i++) {
+        crc ^= data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
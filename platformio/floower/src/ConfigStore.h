@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Arduino.h"
+#include <esp_partition.h>
+
+#define CONFIG_STORE_SECTOR_SIZE 4096
+#define CONFIG_STORE_SECTORS 4 // the log moves to the next sector on every compaction, spreading the erases
+#define CONFIG_STORE_FIELDS 24 // field IDs 0-23
+#define CONFIG_STORE_MAX_LENGTH 64 // longest value (WiFi password)
+#define CONFIG_STORE_READ_CHUNK 256 // bytes read from flash at once while replaying the log
+
+// Append-only log of configuration fields in flash. Every record carries the field ID, the value
+// and a CRC, the last valid record of a field wins. A sector full of records is compacted into the
+// next erased one with only the latest values, so a changed value costs a few bytes of flash instead
+// of an erase. Torn records after a power loss fail the CRC and are dropped by the next compaction.
+// Values are kept in RAM, read() and write() never touch the flash, commit() appends the changes.
+class ConfigStore {
+    public:
+        bool begin(); // replays the log, false when nothing is stored
+        bool commit(); // appends the changed fields, false when the flash write failed
+
+        bool has(uint8_t field);
+        uint8_t read(uint8_t field, uint8_t *data, uint8_t maxLength); // returns the length, 0 when missing
+        uint8_t readByte(uint8_t field, uint8_t defaultValue = 0);
+        uint16_t readInt(uint8_t field, uint16_t defaultValue = 0);
+        String readString(uint8_t field, uint8_t maxLength);
+        void write(uint8_t field, const uint8_t *data, uint8_t length);
+        void writeByte(uint8_t field, uint8_t value);
+        void writeInt(uint8_t field, uint16_t value);
+        void writeString(uint8_t field, const String& value, uint8_t maxLength);
+
+        uint8_t getActiveSector(); // CONFIG_STORE_SECTORS when nothing is stored
+        uint16_t getWriteOffset(); // in the active sector
+
+        static uint16_t crc16(const uint8_t *data, uint16_t length, uint16_t crc = 0xFFFF);
+
+    private:
+        bool append(uint8_t field);
+        bool compact();
+        bool writeRecord(uint32_t offset, uint8_t field);
+        bool readFlash(uint32_t offset, uint8_t *data, uint16_t length);
+        uint32_t sectorAddress(uint8_t sector);
+
+        struct Value {
+            bool present;
+            bool dirty;
+            uint8_t length;
+            uint8_t data[CONFIG_STORE_MAX_LENGTH];
+        };
+
+        const esp_partition_t *partition = nullptr;
+        Value values[CONFIG_STORE_FIELDS] = {};
+        uint8_t activeSector = CONFIG_STORE_SECTORS;
+        uint32_t sequence = 0; // of the active sector, grows with every compaction
+        uint16_t writeOffset = 0;
+
+        // read cache of the replay
+        uint8_t chunk[CONFIG_STORE_READ_CHUNK];
+        uint32_t chunkOffset = 0;
+        uint16_t chunkLength = 0;
+};
@@ -9,4 +9,5 @@ class Behavior {
         virtual void setup(bool wokeUp = false) = 0;
         virtual void loop() = 0;
         virtual bool isIdle() = 0;
+        virtual unsigned long getIdleDuration() { return 0; } // ms the CPU may light sleep, 0 when it must stay awake
 };
\ No newline at end of file
@@ -39,7 +39,7 @@ bool BloomingBehavior::onLeafTouch(FloowerTouchEvent event) {
         if (state == STATE_STANDBY) {
             // light up instantly on touch
             HsbColor nextColor = nextRandomColor();
-            floower->transitionColor(nextColor.H, nextColor.S, config->colorBrightnessDecimal, config->speedMillis);
+            floower->transitionColor(nextColor.H, nextColor.S, 1.0, config->speedMillis);
             changeState(STATE_BLOOM_LIGHT);
             return true;
         }
@@ -48,7 +48,7 @@ bool BloomingBehavior::onLeafTouch(FloowerTouchEvent event) {
             if (floower->getPetalsOpenLevel() > 0) {
                 if (!floower->isLit()) {
                     HsbColor nextColor = nextRandomColor();
-                    floower->transitionColor(nextColor.H, nextColor.S, config->colorBrightnessDecimal, config->speedMillis);
+                    floower->transitionColor(nextColor.H, nextColor.S, 1.0, config->speedMillis);
                 }
                 changeState(STATE_BLOOM);
             }
@@ -75,7 +75,7 @@ bool BloomingBehavior::onLeafTouch(FloowerTouchEvent event) {
         if (state == STATE_STANDBY) {
             // light + open
             HsbColor nextColor = nextRandomColor();
-            floower->transitionColor(nextColor.H, nextColor.S, config->colorBrightnessDecimal, config->speedMillis);
+            floower->transitionColor(nextColor.H, nextColor.S, 1.0, config->speedMillis);
             floower->setPetalsOpenLevel(config->maxOpenLevel, config->speedMillis);
             changeState(STATE_BLOOM_OPEN);
             return true;
@@ -80,7 +80,7 @@ void Calibration::calibrateListenSerial() {
                 config->hardwareCalibration(config->servoClosed, config->servoOpen, config->hardwareRevision, config->serialNumber);
                 config->factorySettings();
                 config->setCalibrated();
-                config->commit();
+                config->flush();
                 ESP_LOGI(LOG_TAG, "Calibration done");
                 ESP.restart(); // restart now
             }
@@ -117,7 +117,7 @@ void Calibration::calibrateTouch() {
         config->setTouchCalibrated(true);
         ESP_LOGI(LOG_TAG, "Touch calibration: value=%d, threshold=%d", touchValue, config->touchThreshold);
         if (autoCalibrateTouch) {
-            config->commit();
+            config->flush();
             ESP_LOGI(LOG_TAG, "Calibration done");
 
             // start BLE for the first time, these is a bug that for a first time the BLE starts it crashes
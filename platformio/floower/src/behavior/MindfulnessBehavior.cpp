@@ -27,7 +27,7 @@ void MindfulnessBehavior::loop() {
             changeState(STATE_EXHALE);
         }
         else if (state == STATE_EXHALE) {
-            floower->transitionColorBrightness(0.2, 5000);
+            floower->transitionColorBrightness(0.5, 5000);
             floower->setPetalsOpenLevel(20, 4800);
             eventTime = now + 5000;
             changeState(STATE_INHALE);
@@ -35,13 +35,21 @@ void MindfulnessBehavior::loop() {
     }
 }
 
+unsigned long MindfulnessBehavior::getIdleDuration() {
+    unsigned long duration = SmartPowerBehavior::getIdleDuration();
+    if (state == STATE_INHALE || state == STATE_EXHALE) {
+        duration = _min(duration, timeUntil(eventTime, millis()));
+    }
+    return duration;
+}
+
 bool MindfulnessBehavior::onLeafTouch(FloowerTouchEvent event) {
     if (SmartPowerBehavior::onLeafTouch(event)) {
         return true;
     }
     else if (event == TOUCH_DOWN) {
         if (state == STATE_STANDBY) {
-            floower->transitionColor(colorYellow.H, colorYellow.S, 0.1, 2000);
+            floower->transitionColor(colorYellow.H, colorYellow.S, 0.35, 2000);
             floower->setPetalsOpenLevel(20, 2000);
             eventTime = millis() + 5000;
             changeState(STATE_INHALE);
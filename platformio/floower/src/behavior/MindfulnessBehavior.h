@@ -6,6 +6,7 @@ class MindfulnessBehavior : public SmartPowerBehavior {
     public:
         MindfulnessBehavior(Config *config, Floower *floower, RemoteControl *remoteControl);
         virtual void loop();
+        virtual unsigned long getIdleDuration();
 
     protected:
         virtual bool onLeafTouch(FloowerTouchEvent event);
@@ -1,6 +1,7 @@
 #include "behavior/SmartPowerBehavior.h"
 #include <esp_task_wdt.h>
 #include <esp_wifi.h>
+#include <limits.h>
 
 #if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
 #include "esp32-hal-log.h"
@@ -33,13 +34,8 @@ SmartPowerBehavior::SmartPowerBehavior(Config *config, Floower *floower, RemoteC
 }
 
 void SmartPowerBehavior::setup(bool wokeUp) {
-    // check if there is enough power to run
-    powerState = floower->readPowerState();
-    if (!powerState.usbPowered && powerState.batteryVoltage < LOW_BATTERY_THRESHOLD_V) {
-        delay(500); // wait and re-verify the voltage to make sure the battery is really dead
-    }
-
-    // run power watchdog to initialize state according to power
+    // run power watchdog to initialize state according to power, the first battery measurement
+    // is oversampled enough to tell if the battery is really dead
     powerWatchDog(true, wokeUp);
 
     if (state == STATE_STANDBY) {
@@ -75,6 +71,7 @@ void SmartPowerBehavior::loop() {
         esp_task_wdt_reset(); // reset watchdog timer
         powerWatchDog();
     }
+    config->update(); // writes the changes once they settle down
     if (bluetoothStartTime > 0 && bluetoothStartTime < now && !floower->arePetalsMoving()) {
         bluetoothStartTime = 0;
         remoteControl->enableBluetooth();
@@ -154,7 +151,31 @@ bool SmartPowerBehavior::isIdle() {
     return !floower->arePetalsMoving() && !floower->isChangingColor();
 }
 
+unsigned long SmartPowerBehavior::getIdleDuration() {
+    // the radios do not keep their connections in light sleep and on USB there is no point,
+    // animations and petals are bounded by the Floower itself
+    if (powerState.usbPowered || state == STATE_UPDATE_INIT || state == STATE_UPDATE_RUNNING
+            || remoteControl->isBluetoothEnabled() || remoteControl->isWifiEnabled()) {
+        return 0;
+    }
+    unsigned long now = millis();
+    unsigned long duration = timeUntil(watchDogsTime, now);
+    duration = _min(duration, timeUntil(bluetoothStartTime, now));
+    duration = _min(duration, timeUntil(wifiStartTime, now));
+    duration = _min(duration, timeUntil(deepSleepTime, now));
+    duration = _min(duration, config->getCommitDelay());
+    return duration;
+}
+
+unsigned long SmartPowerBehavior::timeUntil(unsigned long time, unsigned long now) {
+    if (time == 0) {
+        return ULONG_MAX;
+    }
+    return time > now ? time - now : 0;
+}
+
 void SmartPowerBehavior::powerWatchDog(bool initial, bool wokeUp) {
+    floower->setRadiosEnabled(remoteControl->isWifiEnabled(), remoteControl->isBluetoothEnabled());
     powerState = floower->readPowerState();
 
     if (!powerState.usbPowered && powerState.batteryVoltage < LOW_BATTERY_THRESHOLD_V) {
@@ -199,7 +220,7 @@ void SmartPowerBehavior::powerWatchDog(bool initial, bool wokeUp) {
         }
     }
 
-    remoteControl->updateStatusData(powerState.batteryLevel, powerState.batteryCharging);
+    remoteControl->updateStatusData(powerState);
     indicateStatus(powerState.batteryCharging);
 }
 
@@ -265,6 +286,7 @@ void SmartPowerBehavior::planDeepSleep(long timeoutMs) {
 
 void SmartPowerBehavior::enterDeepSleep() {
     ESP_LOGI(LOG_TAG, "Going to sleep now");
+    config->flush(); // pending changes would be lost
     floower->beforeDeepSleep();
     esp_sleep_enable_touchpad_wakeup();
     esp_wifi_stop();
@@ -21,6 +21,7 @@ class SmartPowerBehavior : public Behavior {
         virtual void setup(bool wokeUp = false);
         virtual void loop();
         virtual bool isIdle();
+        virtual unsigned long getIdleDuration();
         virtual void runUpdate(String firmwareUrl);
         
     protected:
@@ -31,6 +32,7 @@ class SmartPowerBehavior : public Behavior {
         void changeStateIfIdle(state_t fromState, state_t toState);
         void changeState(uint8_t newState);
         HsbColor nextRandomColor();
+        static unsigned long timeUntil(unsigned long time, unsigned long now); // ULONG_MAX when the timer is not set
 
         Config *config;
         Floower *floower;
@@ -29,7 +29,7 @@ void TestBehavior::loop() {
         }
         else if (state == STATE_FADE) {
             HsbColor nextColor = nextRandomColor();
-            floower->transitionColor(nextColor.H, nextColor.S, config->colorBrightnessDecimal, SPEED_MS);
+            floower->transitionColor(nextColor.H, nextColor.S, 1.0, SPEED_MS);
             floower->setPetalsOpenLevel(100, SPEED_MS);
             eventTime = now + SPEED_MS;
             changeState(STATE_BLOOM);
@@ -37,6 +37,10 @@ void TestBehavior::loop() {
     }
 }
 
+unsigned long TestBehavior::getIdleDuration() {
+    return _min(SmartPowerBehavior::getIdleDuration(), timeUntil(eventTime, millis()));
+}
+
 bool TestBehavior::onLeafTouch(FloowerTouchEvent event) {
     if (SmartPowerBehavior::onLeafTouch(event)) {
         return true;
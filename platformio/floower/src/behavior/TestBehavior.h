@@ -6,6 +6,7 @@ class TestBehavior : public SmartPowerBehavior {
     public:
         TestBehavior(Config *config, Floower *floower, RemoteControl *remoteControl);
         virtual void loop();
+        virtual unsigned long getIdleDuration();
 
     protected:
         virtual bool canInitializeBluetooth();
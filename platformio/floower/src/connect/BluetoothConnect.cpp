@@ -48,9 +48,11 @@ static const char* LOG_TAG = "BluetoothControl";
 #define BATTERY_UUID "180F"
 #define BATTERY_LEVEL_UUID "2A19" // uint8
 #define BATTERY_POWER_STATE_UUID "2A1A" // uint8 of states
+#define BATTERY_TIME_STATUS_UUID "2BEE" // uint8 flags, uint24 minutes until discharged
 
 #define BATTERY_POWER_STATE_CHARGING B00111011
 #define BATTERY_POWER_STATE_DISCHARGING B00101111
+#define BATTERY_TIME_UNKNOWN 0xFFFFFF
 
 typedef struct StateData {
     int8_t petalsOpenLevel; // normally petals open level 0-100%, read-write
@@ -76,7 +78,9 @@ void BluetoothConnect::disable() {
     if (advertising) {
         stopAdvertising();
     }
-    server->disconnect(connectionId);
+    if (server != nullptr) {
+        server->disconnect(connectionId);
+    }
 }
 
 void BluetoothConnect::init() {
@@ -105,6 +109,8 @@ void BluetoothConnect::init() {
     characteristic->addDescriptor(new BLE2902());
     characteristic = batteryService->createCharacteristic(BATTERY_POWER_STATE_UUID, BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
     characteristic->addDescriptor(new BLE2902());
+    characteristic = batteryService->createCharacteristic(BATTERY_TIME_STATUS_UUID, BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
+    characteristic->addDescriptor(new BLE2902());
     batteryService->start();
     
     // command protocol service
@@ -142,11 +148,11 @@ void BluetoothConnect::init() {
     initialized = true;
 }
 
-void BluetoothConnect::reloadConfig() {
+void BluetoothConnect::reloadConfig(uint32_t changedFields) {
     BLECharacteristic* characteristic;
 
     // connect service
-    if (connectService != nullptr) {
+    if (connectService != nullptr && (changedFields & CONFIG_WIFI_FIELDS)) {
         characteristic = connectService->getCharacteristic(FLOOWER_CHAR_WIFI_SSID);
         characteristic->setValue(String(config->wifiSsid).c_str());
         characteristic = connectService->getCharacteristic(FLOOWER_CHAR_FLOUD_DEVICE_ID);
@@ -157,23 +163,33 @@ void BluetoothConnect::reloadConfig() {
 
     // config service
     if (configService != nullptr) {
-        characteristic = configService->getCharacteristic(FLOOWER_CHAR_NAME_UUID);
-        characteristic->setValue(String(config->name).c_str());
-        characteristic = configService->getCharacteristic(FLOOWER_CHAR_MAX_OPEN_LEVEL);
-        characteristic->setValue(&config->maxOpenLevel, 1);
-        characteristic = configService->getCharacteristic(FLOOWER_CHAR_COLOR_BRIGHTNESS);
-        characteristic->setValue(&config->colorBrightness, 1);
-        characteristic = configService->getCharacteristic(FLOOWER_CHAR_SPEED_TENTS_OF_SEC);
-        characteristic->setValue(&config->speed, 1);
-        characteristic = configService->getCharacteristic(FLOOWER_COLORS_SCHEME_UUID);
-        size_t size = config->colorSchemeSize * 2;
-        uint8_t bytes[size];
-        for (uint8_t b = 0, i = 0; b < size; b += 2, i++) {
-            uint16_t valueHS = Config::encodeHSColor(config->colorScheme[i].H, config->colorScheme[i].S);
-            bytes[b] = (valueHS >> 8) & 0xFF;
-            bytes[b + 1] = valueHS & 0xFF;
+        if (changedFields & CONFIG_FIELD_BIT(CONFIG_FIELD_NAME)) {
+            characteristic = configService->getCharacteristic(FLOOWER_CHAR_NAME_UUID);
+            characteristic->setValue(String(config->name).c_str());
+        }
+        if (changedFields & CONFIG_FIELD_BIT(CONFIG_FIELD_MAX_OPEN_LEVEL)) {
+            characteristic = configService->getCharacteristic(FLOOWER_CHAR_MAX_OPEN_LEVEL);
+            characteristic->setValue(&config->maxOpenLevel, 1);
+        }
+        if (changedFields & CONFIG_FIELD_BIT(CONFIG_FIELD_COLOR_BRIGHTNESS)) {
+            characteristic = configService->getCharacteristic(FLOOWER_CHAR_COLOR_BRIGHTNESS);
+            characteristic->setValue(&config->colorBrightness, 1);
+        }
+        if (changedFields & CONFIG_FIELD_BIT(CONFIG_FIELD_SPEED)) {
+            characteristic = configService->getCharacteristic(FLOOWER_CHAR_SPEED_TENTS_OF_SEC);
+            characteristic->setValue(&config->speed, 1);
+        }
+        if (changedFields & CONFIG_FIELD_BIT(CONFIG_FIELD_COLOR_SCHEME)) {
+            characteristic = configService->getCharacteristic(FLOOWER_COLORS_SCHEME_UUID);
+            size_t size = config->colorSchemeSize * 2;
+            uint8_t bytes[size];
+            for (uint8_t b = 0, i = 0; b < size; b += 2, i++) {
+                uint16_t valueHS = Config::encodeHSColor(config->colorScheme[i].H, config->colorScheme[i].S);
+                bytes[b] = (valueHS >> 8) & 0xFF;
+                bytes[b + 1] = valueHS & 0xFF;
+            }
+            characteristic->setValue(bytes, size);
         }
-        characteristic->setValue(bytes, size);
     }
 }
 
@@ -200,6 +216,10 @@ bool BluetoothConnect::isConnected() {
     return deviceConnected;
 }
 
+bool BluetoothConnect::isEnabled() {
+    return enabled;
+}
+
 String BluetoothConnect::md5(String value) {
     MD5Builder md5;
     md5.begin();
@@ -208,17 +228,24 @@ String BluetoothConnect::md5(String value) {
     return md5.toString();
 }
 
-void BluetoothConnect::updateStatusData(uint8_t batteryLevel, bool batteryCharging, uint8_t wifiStatus) {
-    ESP_LOGD(LOG_TAG, "level: %d, charging: %d, wifi status: %d", batteryLevel, batteryCharging, wifiStatus);
+void BluetoothConnect::updateStatusData(const PowerState& powerState, uint8_t wifiStatus) {
+    ESP_LOGD(LOG_TAG, "level: %d, charging: %d, runtime: %d, wifi status: %d", powerState.batteryLevel, powerState.batteryCharging, powerState.batteryRuntime, wifiStatus);
     if (deviceConnected && batteryService != nullptr) {
+        uint8_t batteryLevel = powerState.batteryLevel;
         BLECharacteristic* characteristic = batteryService->getCharacteristic(BATTERY_LEVEL_UUID);
         characteristic->setValue(&batteryLevel, 1);
         characteristic->notify();
 
-        uint8_t batteryState = batteryCharging ? BATTERY_POWER_STATE_CHARGING : BATTERY_POWER_STATE_DISCHARGING;
+        uint8_t batteryState = powerState.batteryCharging ? BATTERY_POWER_STATE_CHARGING : BATTERY_POWER_STATE_DISCHARGING;
         characteristic = batteryService->getCharacteristic(BATTERY_POWER_STATE_UUID);
         characteristic->setValue(&batteryState, 1);
         characteristic->notify();
+
+        uint32_t runtime = powerState.batteryRuntime == BATTERY_RUNTIME_UNKNOWN ? BATTERY_TIME_UNKNOWN : powerState.batteryRuntime;
+        uint8_t timeStatus[4] = {0, (uint8_t) runtime, (uint8_t) (runtime >> 8), (uint8_t) (runtime >> 16)}; // little endian
+        characteristic = batteryService->getCharacteristic(BATTERY_TIME_STATUS_UUID);
+        characteristic->setValue(timeStatus, 4);
+        characteristic->notify();
     }
     if (deviceConnected && connectService != nullptr) {
         BLECharacteristic* characteristic = connectService->getCharacteristic(FLOOWER_CHAR_WIFI_STATUS);
@@ -266,7 +293,7 @@ void BluetoothConnect::CommandCharacteristicsCallbacks::onWrite(BLECharacteristi
             }
         }
 
-        bluetoothConnect->cmdProtocol->run(messageHeader.type, bytes.data() + headerSize, messageHeader.length);
+        bluetoothConnect->cmdProtocol->post(messageHeader.type, messageHeader.id, bytes.data() + headerSize, messageHeader.length);
     }
 }
 
@@ -276,10 +303,8 @@ void BluetoothConnect::ServerCallbacks::onConnect(BLEServer* server) {
     bluetoothConnect->advertising = false;
     bluetoothConnect->connectionId = server->getConnId(); // first one is 0
 
-    if (!bluetoothConnect->config->bluetoothAlwaysOn) {
-        bluetoothConnect->config->setBluetoothAlwaysOn(true);
-        bluetoothConnect->config->commit();
-    }
+    // config belongs to the control task
+    bluetoothConnect->cmdProtocol->post(PROTOCOL_BLUETOOTH_CONNECTED, 0, nullptr, 0);
 };
 
 void BluetoothConnect::ServerCallbacks::onDisconnect(BLEServer* server) {
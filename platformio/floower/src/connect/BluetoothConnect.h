@@ -18,9 +18,10 @@ class BluetoothConnect {
         void enable();
         void disable();
         void updateFloowerState(int8_t petalsOpenLevel, HsbColor hsbColor);
-        void updateStatusData(uint8_t batteryLevel, bool batteryCharging, uint8_t wifiStatus);
+        void updateStatusData(const PowerState& powerState, uint8_t wifiStatus);
         bool isConnected();
-        void reloadConfig();
+        bool isEnabled();
+        void reloadConfig(uint32_t changedFields = CONFIG_ALL_FIELDS);
 
     private:
         void init();
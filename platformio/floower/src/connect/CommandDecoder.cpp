@@ -0,0 +1,273 @@
+#include "CommandDecoder.h"
+
+bool CommandDecoder::decodeControl(const uint8_t *data, uint16_t length, ControlCommand &command) {
+    command = {};
+    CommandDecoder decoder(data, length);
+    uint32_t size;
+    if (!decoder.readMapSize(size)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        const char *key;
+        uint32_t keyLength;
+        if (!decoder.readString(key, keyLength)) {
+            return false;
+        }
+        if (keyLength != 1) {
+            if (!decoder.skip()) {
+                return false;
+            }
+            continue;
+        }
+
+        uint8_t field;
+        int64_t max = 0xFF;
+        switch (key[0]) {
+            case 'l': field = CONTROL_FIELD_LEVEL; break;
+            case 't': field = CONTROL_FIELD_TIME; max = 0xFFFF; break;
+            case 'r': field = CONTROL_FIELD_RED; break;
+            case 'g': field = CONTROL_FIELD_GREEN; break;
+            case 'b': field = CONTROL_FIELD_BLUE; break;
+            case 'a': field = CONTROL_FIELD_ANIMATION; break;
+            default:
+                if (!decoder.skip()) {
+                    return false;
+                }
+                continue;
+        }
+
+        int64_t value;
+        if (!decoder.readInteger(value)) {
+            // nil or another type, the field stays missing
+            if (!decoder.skip()) {
+                return false;
+            }
+            continue;
+        }
+        if (value < 0 || value > max) {
+            continue;
+        }
+        command.fields |= field;
+        switch (field) {
+            case CONTROL_FIELD_LEVEL: command.level = value; break;
+            case CONTROL_FIELD_TIME: command.time = value; break;
+            case CONTROL_FIELD_RED: command.red = value; break;
+            case CONTROL_FIELD_GREEN: command.green = value; break;
+            case CONTROL_FIELD_BLUE: command.blue = value; break;
+            case CONTROL_FIELD_ANIMATION: command.animation = value; break;
+        }
+    }
+    return true;
+}
+
+bool CommandDecoder::readMapSize(uint32_t &size) {
+    uint16_t start = offset;
+    uint8_t format;
+    if (!readByte(format)) {
+        return false;
+    }
+    uint64_t value;
+    if ((format & 0xF0) == 0x80) { // fixmap
+        size = format & 0x0F;
+    }
+    else if (format == 0xDE || format == 0xDF) { // map 16, 32
+        if (!readBigEndian(format == 0xDE ? 2 : 4, value)) {
+            offset = start;
+            return false;
+        }
+        size = value;
+    }
+    else {
+        offset = start;
+        return false;
+    }
+    if (size > (uint32_t) (length - offset) / 2) { // every entry takes 2 bytes at least
+        offset = start;
+        return false;
+    }
+    return true;
+}
+
+bool CommandDecoder::readString(const char *&value, uint32_t &valueLength) {
+    uint16_t start = offset;
+    uint8_t format;
+    if (!readByte(format)) {
+        return false;
+    }
+    uint64_t size;
+    if ((format & 0xE0) == 0xA0) { // fixstr
+        size = format & 0x1F;
+    }
+    else if (format >= 0xD9 && format <= 0xDB) { // str 8, 16, 32
+        if (!readBigEndian(1 << (format - 0xD9), size)) {
+            offset = start;
+            return false;
+        }
+    }
+    else {
+        offset = start;
+        return false;
+    }
+    value = (const char *) data + offset;
+    valueLength = size;
+    if (!advance(size)) {
+        offset = start;
+        return false;
+    }
+    return true;
+}
+
+bool CommandDecoder::readInteger(int64_t &value) {
+    uint16_t start = offset;
+    uint8_t format;
+    if (!readByte(format)) {
+        return false;
+    }
+    uint64_t raw;
+    if (format <= 0x7F) { // positive fixint
+        value = format;
+    }
+    else if (format >= 0xE0) { // negative fixint
+        value = (int8_t) format;
+    }
+    else if (format >= 0xCC && format <= 0xCF) { // uint 8, 16, 32, 64
+        if (!readBigEndian(1 << (format - 0xCC), raw)) {
+            offset = start;
+            return false;
+        }
+        value = raw > INT64_MAX ? INT64_MAX : raw;
+    }
+    else if (format >= 0xD0 && format <= 0xD3) { // int 8, 16, 32, 64
+        uint8_t size = 1 << (format - 0xD0);
+        if (!readBigEndian(size, raw)) {
+            offset = start;
+            return false;
+        }
+        uint8_t shift = 64 - size * 8;
+        value = (int64_t) (raw << shift) >> shift; // sign extension
+    }
+    else if (format == 0xCA) { // float 32
+        if (!readBigEndian(4, raw)) {
+            offset = start;
+            return false;
+        }
+        uint32_t bits = raw;
+        float number;
+        memcpy(&number, &bits, 4);
+        value = number != number ? 0 : number < INT32_MIN ? INT32_MIN : number > INT32_MAX ? INT32_MAX : (int64_t) number;
+    }
+    else if (format == 0xCB) { // float 64
+        if (!readBigEndian(8, raw)) {
+            offset = start;
+            return false;
+        }
+        double number;
+        memcpy(&number, &raw, 8);
+        value = number != number ? 0 : number < INT32_MIN ? INT32_MIN : number > INT32_MAX ? INT32_MAX : (int64_t) number;
+    }
+    else {
+        offset = start;
+        return false;
+    }
+    return true;
+}
+
+bool CommandDecoder::skip(uint8_t depth) {
+    uint8_t format;
+    if (depth > COMMAND_DECODER_MAX_DEPTH || !readByte(format)) {
+        return false;
+    }
+    uint64_t size = 0;
+    uint32_t items = 0; // nested values
+    if (format <= 0x7F || format >= 0xE0 || format == 0xC0 || format == 0xC2 || format == 0xC3) {
+        return true; // fixint, nil, bool
+    }
+    else if ((format & 0xF0) == 0x80) { // fixmap
+        items = (format & 0x0F) * 2;
+    }
+    else if ((format & 0xF0) == 0x90) { // fixarray
+        items = format & 0x0F;
+    }
+    else if ((format & 0xE0) == 0xA0) { // fixstr
+        size = format & 0x1F;
+    }
+    else if (format >= 0xC4 && format <= 0xC6) { // bin 8, 16, 32
+        if (!readBigEndian(1 << (format - 0xC4), size)) {
+            return false;
+        }
+    }
+    else if (format >= 0xC7 && format <= 0xC9) { // ext 8, 16, 32 + type
+        if (!readBigEndian(1 << (format - 0xC7), size)) {
+            return false;
+        }
+        size++;
+    }
+    else if (format == 0xCA || format == 0xCB) { // float 32, 64
+        size = format == 0xCA ? 4 : 8;
+    }
+    else if (format >= 0xCC && format <= 0xD3) { // uint, int 8 - 64
+        size = 1 << ((format - 0xCC) & 0x03);
+    }
+    else if (format >= 0xD4 && format <= 0xD8) { // fixext 1 - 16 + type
+        size = (1 << (format - 0xD4)) + 1;
+    }
+    else if (format >= 0xD9 && format <= 0xDB) { // str 8, 16, 32
+        if (!readBigEndian(1 << (format - 0xD9), size)) {
+            return false;
+        }
+    }
+    else if (format == 0xDC || format == 0xDD || format == 0xDE || format == 0xDF) { // array, map 16, 32
+        uint64_t count;
+        if (!readBigEndian(format == 0xDC || format == 0xDE ? 2 : 4, count)) {
+            return false;
+        }
+        if (count > length) {
+            return false; // every item takes a byte at least
+        }
+        items = format >= 0xDE ? count * 2 : count;
+    }
+    else {
+        return false; // 0xC1 is never used
+    }
+
+    if (!advance(size) || items > (uint32_t) (length - offset)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < items; i++) {
+        if (!skip(depth + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CommandDecoder::isAtEnd() {
+    return offset >= length;
+}
+
+bool CommandDecoder::readByte(uint8_t &value) {
+    if (offset >= length) {
+        return false;
+    }
+    value = data[offset++];
+    return true;
+}
+
+bool CommandDecoder::readBigEndian(uint8_t size, uint64_t &value) {
+    if (size > length - offset) {
+        return false;
+    }
+    value = 0;
+    for (uint8_t i = 0; i < size; i++) {
+        value = (value << 8) | data[offset++];
+    }
+    return true;
+}
+
+bool CommandDecoder::advance(uint64_t size) {
+    if (size > (uint64_t) (length - offset)) {
+        return false;
+    }
+    offset += size;
+    return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Arduino.h"
+
+#define COMMAND_DECODER_MAX_DEPTH 4 // nesting of skipped values, deeper payloads are rejected
+
+// fields present in the decoded ControlCommand
+#define CONTROL_FIELD_LEVEL 0x01
+#define CONTROL_FIELD_TIME 0x02
+#define CONTROL_FIELD_RED 0x04
+#define CONTROL_FIELD_GREEN 0x08
+#define CONTROL_FIELD_BLUE 0x10
+#define CONTROL_FIELD_ANIMATION 0x20
+#define CONTROL_FIELD_COLOR (CONTROL_FIELD_RED | CONTROL_FIELD_GREEN | CONTROL_FIELD_BLUE)
+
+// payload of the petals, color, state and animation commands { l, t, r, g, b, a }
+struct ControlCommand {
+    uint8_t fields; // CONTROL_FIELD_* bits
+    uint8_t level;
+    uint16_t time;
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+    uint8_t animation;
+};
+
+// Streaming decoder of the MsgPack payload of the control commands. It walks the map once and
+// reads the one letter keys straight into the ControlCommand, right from the received bytes.
+// Unknown keys are skipped, values out of the range of the field are ignored like a missing field.
+// Every read is bounds checked, a truncated or malformed payload is rejected as a whole.
+class CommandDecoder {
+    public:
+        CommandDecoder(const uint8_t *data, uint16_t length) : data(data), length(length) {}
+
+        static bool decodeControl(const uint8_t *data, uint16_t length, ControlCommand &command); // false when invalid
+
+        // false when the next value is of another type or truncated, nothing is consumed then so it can be skipped
+        bool readMapSize(uint32_t &size);
+        bool readString(const char *&value, uint32_t &valueLength); // points into the payload, not terminated
+        bool readInteger(int64_t &value); // floats are truncated
+        bool skip(uint8_t depth = 0);
+        bool isAtEnd();
+
+    private:
+        bool readByte(uint8_t &value);
+        bool readBigEndian(uint8_t size, uint64_t &value);
+        bool advance(uint64_t size);
+
+        const uint8_t *data;
+        uint16_t length;
+        uint16_t offset = 0;
+};
@@ -11,84 +11,197 @@ void CommandProtocol::onRunOTAUpdate(RunOTAUpdateCallback callback) {
     runOTAUpdateCallback = callback;
 }
 
-uint16_t CommandProtocol::run(const uint16_t type, const char *payload, const uint16_t payloadLength, char *responsePayload, uint16_t *responseLength) {
-    // commands that require request payload
+void CommandProtocol::enableQueue(SemaphoreHandle_t stateMutex) {
+    if (commandQueue == nullptr) {
+        commandQueue = xQueueCreate(COMMAND_QUEUE_LENGTH, sizeof(QueuedCommand));
+    }
+    this->stateMutex = stateMutex;
+}
+
+void CommandProtocol::lockState() {
+    if (stateMutex != nullptr) {
+        xSemaphoreTake(stateMutex, portMAX_DELAY);
+    }
+}
+
+void CommandProtocol::unlockState() {
+    if (stateMutex != nullptr) {
+        xSemaphoreGive(stateMutex);
+    }
+}
+
+bool CommandProtocol::post(const uint16_t type, const uint16_t id, const char *payload, const uint16_t payloadLength, CommandResponder *responder) {
+    if (payloadLength > MAX_MESSAGE_PAYLOAD_BYTES) {
+        return false;
+    }
+    QueuedCommand command;
+    command.type = type;
+    command.id = id;
+    command.length = payloadLength;
+    command.responder = responder;
     if (payloadLength > 0) {
-        payloadUnpacker.feed((const uint8_t *) payload, payloadLength);
-        if (!payloadUnpacker.deserialize(jsonPayload)) {
+        memcpy(command.payload, payload, payloadLength);
+    }
+    if (commandQueue == nullptr) {
+        runCommand(command);
+        return true;
+    }
+    if (xQueueSend(commandQueue, &command, 0) != pdTRUE) {
+        ESP_LOGW(LOG_TAG, "Command queue full");
+        return false;
+    }
+    return true;
+}
+
+bool CommandProtocol::waitForCommand(TickType_t ticksToWait) {
+    QueuedCommand command;
+    return commandQueue != nullptr && xQueuePeek(commandQueue, &command, ticksToWait) == pdTRUE;
+}
+
+void CommandProtocol::process() {
+    if (commandQueue == nullptr) {
+        return;
+    }
+    QueuedCommand command;
+    while (xQueueReceive(commandQueue, &command, 0) == pdTRUE) {
+        runCommand(command);
+    }
+}
+
+void CommandProtocol::runCommand(const QueuedCommand& command) {
+    uint16_t responseLength = 0;
+    uint16_t responseType = run(command.type, command.payload, command.length, responsePayload, &responseLength);
+    if (command.responder != nullptr) {
+        // the state is unlocked already, a slow connection does not hold up the Floower tasks
+        command.responder->sendResponse(responseType, command.id, responsePayload, responseLength);
+    }
+}
+
+uint16_t CommandProtocol::run(const uint16_t type, const char *payload, const uint16_t payloadLength, char *responsePayload, uint16_t *responseLength) {
+    // payloads are decoded and responses encoded outside of the lock, it is held only while the Floower state is accessed
+    if (type == CommandType::PROTOCOL_BLUETOOTH_CONNECTED) {
+        lockState();
+        if (!config->bluetoothAlwaysOn) {
+            config->setBluetoothAlwaysOn(true);
+            config->commit();
+        }
+        unlockState();
+        return STATUS_OK;
+    }
+
+    // commands with raw payload
+    if (type == CommandType::CMD_PLAY_CHOREOGRAPHY) {
+        // <bytecode>
+        bool played = true;
+        lockState();
+        if (payloadLength == 0) {
+            floower->stopChoreography();
+        }
+        else if ((played = floower->playChoreography((const uint8_t *) payload, payloadLength))) {
+            fireControlCommandCallback();
+        }
+        unlockState();
+        return played ? STATUS_OK : STATUS_ERROR;
+    }
+    if (type == CommandType::CMD_READ_TOUCH_TIMELINE && responsePayload != nullptr && responseLength != nullptr) {
+        // response: <time (uint32 LE)><touched (uint8)> for every edge, oldest first
+        TouchEdge edges[TOUCH_TIMELINE_LENGTH];
+        lockState();
+        uint8_t count = floower->getTouchTimeline(edges);
+        unlockState();
+        for (uint8_t i = 0; i < count; i++) {
+            char *edge = responsePayload + i * 5;
+            edge[0] = edges[i].time;
+            edge[1] = edges[i].time >> 8;
+            edge[2] = edges[i].time >> 16;
+            edge[3] = edges[i].time >> 24;
+            edge[4] = edges[i].touched;
+        }
+        *responseLength = count * 5;
+        return STATUS_OK;
+    }
+#ifdef BOOT_TIMELINE
+    if (type == CommandType::CMD_READ_BOOT_TIMELINE && responsePayload != nullptr && responseLength != nullptr) {
+        // response: <phase (uint8)><time since reset in us (uint32 LE)> for every phase reached
+        uint16_t length = 0;
+        for (uint8_t phase = 0; phase < BOOT_PHASE_COUNT; phase++) {
+            uint32_t time = BootTimeline::getTime((BootPhase) phase);
+            if (time != 0) {
+                char *record = responsePayload + length;
+                record[0] = phase;
+                record[1] = time;
+                record[2] = time >> 8;
+                record[3] = time >> 16;
+                record[4] = time >> 24;
+                length += 5;
+            }
+        }
+        *responseLength = length;
+        return STATUS_OK;
+    }
+#endif
+
+    // control commands, decoded straight from the payload
+    if (payloadLength > 0 && (type == CommandType::CMD_WRITE_PETALS || type == CommandType::CMD_WRITE_RGB_COLOR
+            || type == CommandType::CMD_WRITE_STATE || type == CommandType::CMD_PLAY_ANIMATION)) {
+        ControlCommand command;
+        if (!CommandDecoder::decodeControl((const uint8_t *) payload, payloadLength, command)) {
             ESP_LOGE(LOG_TAG, "Invalid Payload");
             return STATUS_ERROR;
         }
+        bool validLevel = (command.fields & CONTROL_FIELD_LEVEL) && command.level <= 100;
+        HsbColor color = HsbColor(RgbColor(command.red, command.green, command.blue)); // missing components are 0
+        lockState();
+        uint16_t time = command.fields & CONTROL_FIELD_TIME ? command.time : config->speedMillis;
         switch (type) {
             case CommandType::CMD_WRITE_PETALS: {
                 // { l: <level>, t: <time> }
-                if (jsonPayload.containsKey("l")) {
-                    uint8_t level = jsonPayload["l"];
-                    uint16_t time = config->speedMillis;
-                    if (jsonPayload.containsKey("t")) {
-                        time = jsonPayload["t"];
-                    }
-                    if (level >= 0 && level <= 100) {
-                        floower->setPetalsOpenLevel(level, time);
-                        fireControlCommandCallback();
-                    }
+                if (validLevel) {
+                    floower->setPetalsOpenLevel(command.level, time);
+                    fireControlCommandCallback();
                 }
-                return STATUS_OK;
+                break;
             }
             case CommandType::CMD_WRITE_RGB_COLOR: {
                 // { r: <red>, g: <green>, b: <blue>, t: <time> }
-                HsbColor color = HsbColor(RgbColor(
-                    jsonPayload["r"], 
-                    jsonPayload["g"], 
-                    jsonPayload["b"]
-                ));
-                uint16_t time = config->speedMillis;
-                if (jsonPayload.containsKey("t")) {
-                    time = jsonPayload["t"];
-                }
                 floower->transitionColor(color.H, color.S, color.B, time);
                 fireControlCommandCallback();
-                return STATUS_OK;
+                break;
             }
             case CommandType::CMD_WRITE_STATE: {
                 // { r: <red>, g: <green>, b: <blue>, l: <petalsLevel>, t: <time> }
-                uint16_t time = config->speedMillis;
-                uint8_t level = -1;
-                HsbColor color;
-                bool transitionColor = false;
-
-                if (jsonPayload.containsKey("t")) {
-                    time = jsonPayload["t"];
+                if (validLevel) {
+                    floower->setPetalsOpenLevel(command.level, time);
                 }
-                if (jsonPayload.containsKey("l")) {
-                    level = jsonPayload["l"];
-                }
-                if (jsonPayload.containsKey("r") || jsonPayload.containsKey("g") || jsonPayload.containsKey("b")) {
-                    color = HsbColor(RgbColor(
-                        jsonPayload["r"], 
-                        jsonPayload["g"], 
-                        jsonPayload["b"]
-                    ));
-                    transitionColor = true;
-                }
-                if (level >= 0 && level <= 100) {
-                    floower->setPetalsOpenLevel(level, time);
-                }
-                if (transitionColor) {
+                if (command.fields & CONTROL_FIELD_COLOR) {
                     floower->transitionColor(color.H, color.S, color.B, time);
                 }
                 fireControlCommandCallback();
-                return STATUS_OK;
+                break;
             }
             case CommandType::CMD_PLAY_ANIMATION: {
                 // { a: <animationCode> }
-                uint8_t animation = jsonPayload["a"];
-                if (animation > 0) {
-                    floower->startAnimation(animation);
+                if (command.animation > 0) {
+                    floower->startAnimation(command.animation);
                     fireControlCommandCallback();
                 }
-                return STATUS_OK;
+                break;
             }
+        }
+        unlockState();
+        return STATUS_OK;
+    }
+
+    // commands that require request payload
+    if (payloadLength > 0) {
+        payloadUnpacker.feed((const uint8_t *) payload, payloadLength);
+        if (!payloadUnpacker.deserialize(jsonPayload)) {
+            ESP_LOGE(LOG_TAG, "Invalid Payload");
+            return STATUS_ERROR;
+        }
+        uint16_t status = STATUS_UNSUPPORTED;
+        lockState();
+        switch (type) {
             case CommandType::CMD_WRITE_WIFI: {
                 // { ssid: <wifiSsid>, pwd: <wifiPwd>, dvc: <floudDeviceId>, tkn: <floudToken> }
                 if (jsonPayload.containsKey("ssid")) {
@@ -98,7 +211,8 @@ uint16_t CommandProtocol::run(const uint16_t type, const char *payload, const ui
                     config->setFloud(jsonPayload["dvc"], jsonPayload["tkn"]);
                 }
                 config->commit();
-                return STATUS_OK;
+                status = STATUS_OK;
+                break;
             }
             case CommandType::CMD_WRITE_NAME: {
                 // { n: <string> }
@@ -107,7 +221,8 @@ uint16_t CommandProtocol::run(const uint16_t type, const char *payload, const ui
                     config->setName(name);
                 }
                 config->commit();
-                return STATUS_OK;
+                status = STATUS_OK;
+                break;
             }
             case CommandType::CMD_WRITE_CUSTOMIZATION: {
                 // { spd: <transitionSpeedInTenthsOfSeconds>, brg: <colorBrightness>, mol: <maxOpenLevel> }
@@ -121,7 +236,8 @@ uint16_t CommandProtocol::run(const uint16_t type, const char *payload, const ui
                     config->setMaxOpenLevel(jsonPayload["mol"]);
                 }
                 config->commit();
-                return STATUS_OK;
+                status = STATUS_OK;
+                break;
             }
             case CommandType::CMD_WRITE_COLOR_SCHEME: {
                 // [ <encoded HS color values as single 2 byte number>, ... ]
@@ -137,85 +253,108 @@ uint16_t CommandProtocol::run(const uint16_t type, const char *payload, const ui
                     }
                     config->setColorScheme(colors, size);
                     config->commit();
-                    return STATUS_OK;
+                    status = STATUS_OK;
                 }
-                return STATUS_ERROR;
+                else {
+                    status = STATUS_ERROR;
+                }
+                break;
             }
             case CommandType::CMD_RUN_OTA_UPDATE: {
                 // { u: <firmwareUrl> }
                 if (jsonPayload.containsKey("u") && runOTAUpdateCallback != nullptr) {
                     runOTAUpdateCallback(jsonPayload["u"]);
-                    return STATUS_OK;
+                    status = STATUS_OK;
+                }
+                else {
+                    status = STATUS_ERROR;
                 }
-                return STATUS_ERROR;
+                break;
             }
         }
+        unlockState();
+        if (status != STATUS_UNSUPPORTED) {
+            return status;
+        }
     }
     
     // command to retrive data
     if (responsePayload != nullptr && responseLength != nullptr) {
+        bool supported = true;
+        jsonPayload.clear();
+        lockState();
         switch (type) {
             case CommandType::CMD_READ_STATE: {
                 // response: { r: <red>, g: <green>, b: <blue>, l: <level >}
-                jsonPayload.clear();
                 RgbColor color = RgbColor(floower->getColor());
                 jsonPayload["r"] = color.R;
                 jsonPayload["g"] = color.G;
                 jsonPayload["b"] = color.B;
                 jsonPayload["l"] = floower->getPetalsOpenLevel();
-                *responseLength = serializeMsgPack(jsonPayload, responsePayload, MAX_MESSAGE_PAYLOAD_BYTES);
-                return STATUS_OK;
+                break;
             }
             case CommandType::CMD_READ_WIFI: {
                 // response: { ssid: <wifiSsid>, tkn: <floudToken>, s: <state>}
-                jsonPayload.clear();
                 jsonPayload["ssid"] = config->wifiSsid;
                 jsonPayload["tkn"] = config->floudToken;
                 //jsonPayload["s"] = color.B; TODO: how to get state of WiFi
-                *responseLength = serializeMsgPack(jsonPayload, responsePayload, MAX_MESSAGE_PAYLOAD_BYTES);
-                return STATUS_OK;
+                break;
             }
             case CommandType::CMD_READ_CUSTOMIZATION: {
                 // response: { spd: <transitionSpeedInTenthsOfSeconds>, brg: <colorBrightness>, mol: <maxOpenLevel>}
-                jsonPayload.clear();
                 jsonPayload["spd"] = config->speed;
                 jsonPayload["brg"] = config->colorBrightness;
                 jsonPayload["mol"] = config->maxOpenLevel;
-                *responseLength = serializeMsgPack(jsonPayload, responsePayload, MAX_MESSAGE_PAYLOAD_BYTES);
-                return STATUS_OK;
+                break;
             }
             case CommandType::CMD_READ_COLOR_SCHEME: {
                 // response: [ <encoded HS color values as single 2 byte number>, ... ]
-                jsonPayload.clear();
                 JsonArray array = jsonPayload.to<JsonArray>();
                 for (uint8_t i = 0; i < config->colorSchemeSize; i++) {
                     array.add(Config::encodeHSColor(config->colorScheme[i].H, config->colorScheme[i].S));
                 }
-                *responseLength = serializeMsgPack(jsonPayload, responsePayload, MAX_MESSAGE_PAYLOAD_BYTES);
-                return STATUS_OK;
+                break;
             }
             case CommandType::CMD_READ_DEVICE_INFO: {
                 // response: { n: <name>, m: <modelName>, fw: <firmwareVersion>, hw: <hardwareRevision>, sn: <serialNumber> }
-                jsonPayload.clear();
                 jsonPayload["n"] = config->name;
                 jsonPayload["m"] = config->modelName;
                 jsonPayload["fw"] = config->firmwareVersion;
                 jsonPayload["hw"] = config->hardwareRevision;
                 jsonPayload["sn"] = config->serialNumber;
-                *responseLength = serializeMsgPack(jsonPayload, responsePayload, MAX_MESSAGE_PAYLOAD_BYTES);
-                return STATUS_OK;
+                break;
+            }
+            case CommandType::CMD_READ_DIAGNOSTICS: {
+                // response: { tv: <touchValue>, tb: <touchBaseline>, tn: <touchNoise>, tt: <touchThreshold> }
+                jsonPayload["tv"] = floower->readTouch();
+                jsonPayload["tb"] = floower->getTouchBaseline();
+                jsonPayload["tn"] = floower->getTouchNoise();
+                jsonPayload["tt"] = floower->getTouchThreshold();
+                break;
             }
+            default:
+                supported = false;
+                break;
+        }
+        unlockState();
+        if (supported) {
+            *responseLength = serializeMsgPack(jsonPayload, responsePayload, MAX_MESSAGE_PAYLOAD_BYTES);
+            return STATUS_OK;
         }
     }
 
     return STATUS_UNSUPPORTED;
 }
 
-uint16_t CommandProtocol::sendStatus(const uint8_t batteryLevel, const bool charging, char *payload, uint16_t *payloadLength) {
-    // payload: { b: <batteryLevel>, bc: <batteryCharging> }
+uint16_t CommandProtocol::sendStatus(const PowerState& powerState, char *payload, uint16_t *payloadLength) {
+    // payload: { b: <batteryLevel>, c: <batteryCharging>, i: <currentMilliamps>, r: <runtimeMinutes> }
     jsonPayload.clear();
-    jsonPayload["b"] = batteryLevel;
-    jsonPayload["c"] = charging;
+    jsonPayload["b"] = powerState.batteryLevel;
+    jsonPayload["c"] = powerState.batteryCharging;
+    jsonPayload["i"] = powerState.batteryCurrent;
+    if (powerState.batteryRuntime != BATTERY_RUNTIME_UNKNOWN) {
+        jsonPayload["r"] = powerState.batteryRuntime;
+    }
     *payloadLength = serializeMsgPack(jsonPayload, payload, MAX_MESSAGE_PAYLOAD_BYTES);
     return PROTOCOL_STATUS;
 }
@@ -2,14 +2,35 @@
 
 #include "Arduino.h"
 #include "Config.h"
+#include "BootTimeline.h"
 #include "hardware/Floower.h"
 #include "ArduinoJson.h"
 #include "MsgPack.h"
 #include "CommandProtocolDef.h"
+#include "CommandDecoder.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+#define COMMAND_QUEUE_LENGTH 4
 
 typedef std::function<void()> ControlCommandCallback;
 typedef std::function<void(String firmwareUrl)> RunOTAUpdateCallback;
 
+// connection that expects the response of the command it has posted
+class CommandResponder {
+    public:
+        virtual void sendResponse(const uint16_t type, const uint16_t id, const char *payload, const uint16_t payloadLength) = 0;
+};
+
+struct QueuedCommand {
+    uint16_t type;
+    uint16_t id;
+    uint16_t length;
+    CommandResponder *responder;
+    char payload[MAX_MESSAGE_PAYLOAD_BYTES];
+};
+
 class CommandProtocol {
     public:
         CommandProtocol(Config *config, Floower *floower);
@@ -20,7 +41,14 @@ class CommandProtocol {
             char *responsePayload = nullptr,
             uint16_t *responseLength = nullptr
         );
-        uint16_t sendStatus(const uint8_t batteryLevel, const bool charging, char *payload, uint16_t *payloadLength); // returns type of command that should be send
+        // commands received by the connections, they run right away until the queue is enabled, then they are
+        // passed to process() in the control task so the connections never touch the Floower state; the state
+        // mutex is taken only around the Floower and config calls, not while decoding or responding
+        void enableQueue(SemaphoreHandle_t stateMutex = nullptr);
+        bool post(const uint16_t type, const uint16_t id, const char *payload, const uint16_t payloadLength, CommandResponder *responder = nullptr); // false when the queue is full
+        bool waitForCommand(TickType_t ticksToWait); // false when no command came in time
+        void process(); // runs all queued commands
+        uint16_t sendStatus(const PowerState& powerState, char *payload, uint16_t *payloadLength); // returns type of command that should be send
         uint16_t sendState(const int8_t petalsOpenLevel, const HsbColor hsbColor, char *payload, uint16_t *payloadLength); // returns type of command that should be send
         void onControlCommand(ControlCommandCallback callback);
         void onRunOTAUpdate(RunOTAUpdateCallback callback);
@@ -31,11 +59,17 @@ class CommandProtocol {
     private:
         StaticJsonDocument<MAX_MESSAGE_PAYLOAD_BYTES> jsonPayload;  
         MsgPack::Unpacker payloadUnpacker;
+        QueueHandle_t commandQueue = nullptr;
+        SemaphoreHandle_t stateMutex = nullptr;
+        char responsePayload[MAX_MESSAGE_PAYLOAD_BYTES + 1]; // extra space for 0 terminating string
         ControlCommandCallback controlCommandCallback;
         RunOTAUpdateCallback runOTAUpdateCallback;
 
         Config *config;
         Floower *floower;
 
+        void runCommand(const QueuedCommand& command);
+        void lockState();
+        void unlockState();
         void fireControlCommandCallback(); 
 };
\ No newline at end of file
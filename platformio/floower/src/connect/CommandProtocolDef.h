@@ -14,6 +14,7 @@ enum CommandType {
     // protocol commands (16-63)
     PROTOCOL_AUTH               = 16, // authorize the connection with server by sending a secure token
     PROTOCOL_STATUS             = 17, // heartbeat status
+    PROTOCOL_BLUETOOTH_CONNECTED = 18, // posted by the Bluetooth connection, keeps Bluetooth on after the first client
 
     // device commands (64+)
     CMD_WRITE_PETALS            = 64,
@@ -31,7 +32,11 @@ enum CommandType {
     CMD_READ_CUSTOMIZATION      = 76,
     CMD_WRITE_COLOR_SCHEME      = 77,
     CMD_READ_COLOR_SCHEME       = 78,
-    CMD_READ_DEVICE_INFO        = 79 // serial number, name, hw revision, fw revision, model name
+    CMD_READ_DEVICE_INFO        = 79, // serial number, name, hw revision, fw revision, model name
+    CMD_PLAY_CHOREOGRAPHY       = 80, // raw bytecode payload (see Choreography.h), empty payload stops the show
+    CMD_READ_DIAGNOSTICS        = 81, // sensor readings for troubleshooting
+    CMD_READ_TOUCH_TIMELINE     = 82, // raw touch edges to replay a gesture on host (see TouchGestures.h)
+    CMD_READ_BOOT_TIMELINE      = 83 // raw times of the boot phases, firmware built with BOOT_TIMELINE (see BootTimeline.h)
 };
 
 struct CommandMessageHeader {
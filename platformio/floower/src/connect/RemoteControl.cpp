@@ -24,6 +24,10 @@ void RemoteControl::disableBluetooth() {
     bluetoothConnect->disable();
 }
 
+bool RemoteControl::isBluetoothEnabled() {
+    return bluetoothConnect->isEnabled();
+}
+
 bool RemoteControl::isBluetoothConnected() {
     return bluetoothConnect->isConnected();
 }
@@ -44,9 +48,9 @@ bool RemoteControl::isWifiEnabled() {
     return wifiConnect->isEnabled();
 }
 
-void RemoteControl::updateStatusData(uint8_t batteryLevel, bool batteryCharging) {
-    wifiConnect->updateStatusData(batteryLevel, batteryCharging);
-    bluetoothConnect->updateStatusData(batteryLevel, batteryCharging, wifiConnect->getStatus());
+void RemoteControl::updateStatusData(const PowerState& powerState) {
+    wifiConnect->updateStatusData(powerState);
+    bluetoothConnect->updateStatusData(powerState, wifiConnect->getStatus());
 }
 
 void RemoteControl::runUpdate(String firmwareUrl) {
@@ -17,12 +17,13 @@ class RemoteControl {
         void onRemoteControl(RemoteControlCallback callback);
         void enableBluetooth();
         void disableBluetooth();
+        bool isBluetoothEnabled();
         bool isBluetoothConnected();
         bool isWifiConnected();
         void enableWifi();
         void disableWifi();
         bool isWifiEnabled();
-        void updateStatusData(uint8_t batteryLevel, bool batteryCharging);
+        void updateStatusData(const PowerState& powerState);
 
         void onRunUpdate(RunUpdateCallback callback);
         void runUpdate(String firmwareUrl);
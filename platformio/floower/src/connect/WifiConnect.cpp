@@ -109,10 +109,10 @@ void WifiConnect::reconnect() {
     }
 }
 
-void WifiConnect::updateStatusData(uint8_t batteryLevel, bool batteryCharging) {
+void WifiConnect::updateStatusData(const PowerState& powerState) {
     if (enabled && state == STATE_FLOUD_AUTHORIZED) {
         uint16_t payloadSize = 0;
-        uint16_t type = cmdProtocol->sendStatus(batteryLevel, batteryCharging, sendBuffer, &payloadSize);
+        uint16_t type = cmdProtocol->sendStatus(powerState, sendBuffer, &payloadSize);
         sendRequest(type, receivedMessage.id, sendBuffer, payloadSize);
     }
 }
@@ -156,6 +156,7 @@ void WifiConnect::ensureClient() {
 }
 
 void WifiConnect::loop() {
+    sendQueuedResponses();
     if (!enabled) {
         return;
     }
@@ -231,10 +232,46 @@ void WifiConnect::handleReceivedMessage() {
         socketReconnect();
     }
     else if (state == STATE_FLOUD_AUTHORIZED) {
-        // handle commands
-        uint16_t responseSize = 0;
-        uint16_t responseType = cmdProtocol->run(receivedMessage.type, receiveBuffer, receivedMessage.length, sendBuffer, &responseSize);
-        sendMessage(responseType, receivedMessage.id, sendBuffer, responseSize);
+        // handle commands, the response comes back through sendResponse()
+        if (!cmdProtocol->post(receivedMessage.type, receivedMessage.id, receiveBuffer, receivedMessage.length, this)) {
+            sendMessage(CommandType::STATUS_ERROR, receivedMessage.id, sendBuffer, 0);
+        }
+    }
+}
+
+void WifiConnect::enableResponseQueue() {
+    if (responseQueue == nullptr) {
+        responseQueue = xQueueCreate(COMMAND_QUEUE_LENGTH, sizeof(QueuedCommand));
+    }
+}
+
+void WifiConnect::sendResponse(const uint16_t type, const uint16_t id, const char *payload, const uint16_t payloadLength) {
+    if (responseQueue == nullptr) {
+        if (state == STATE_FLOUD_AUTHORIZED) {
+            sendMessage(type, id, payload, payloadLength);
+        }
+        return;
+    }
+    QueuedCommand response;
+    response.type = type;
+    response.id = id;
+    response.length = _min(payloadLength, MAX_MESSAGE_PAYLOAD_BYTES);
+    response.responder = nullptr;
+    memcpy(response.payload, payload, response.length);
+    if (xQueueSend(responseQueue, &response, 0) != pdTRUE) {
+        ESP_LOGW(LOG_TAG, "Response queue full");
+    }
+}
+
+void WifiConnect::sendQueuedResponses() {
+    if (responseQueue == nullptr) {
+        return;
+    }
+    QueuedCommand response;
+    while (xQueueReceive(responseQueue, &response, 0) == pdTRUE) {
+        if (state == STATE_FLOUD_AUTHORIZED) {
+            sendMessage(response.type, response.id, response.payload, response.length);
+        }
     }
 }
 
@@ -504,6 +541,7 @@ void WifiConnect::finalizeOTAUpdate() {
     if (Update.end()) {
         if (Update.isFinished()) {
             ESP_LOGI(LOG_TAG, "OTA successful, restarting");
+            config->flush();
             ESP.restart();
         }
         else {
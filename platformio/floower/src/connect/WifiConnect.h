@@ -18,7 +18,7 @@
 #define WIFI_STATUS_FLOUD_UNAUTHORIZED 3
 #define WIFI_STATUS_FLOUD_CONNECTED 4
 
-class WifiConnect {
+class WifiConnect : public CommandResponder {
     public:
         WifiConnect(Config *config, CommandProtocol *cmdProtocol);
         void setup();
@@ -27,12 +27,16 @@ class WifiConnect {
         void disable();
         void reconnect();
         void updateFloowerState(int8_t petalsOpenLevel, HsbColor hsbColor);
-        void updateStatusData(uint8_t batteryLevel, bool batteryCharging);
+        void updateStatusData(const PowerState& powerState);
         bool isEnabled();
         bool isConnected();
         uint8_t getStatus();
         void startOTAUpdate(String firmwareUrl);
         bool isOTAUpdateRunning();
+        // responses are sent right away until the queue is enabled, then they wait for loop() so only the
+        // connection task touches the socket
+        void enableResponseQueue();
+        void sendResponse(const uint16_t type, const uint16_t id, const char *payload, const uint16_t payloadLength);
 
     private:
         void onWifiDisconnected(WiFiEvent_t event, WiFiEventInfo_t info);
@@ -52,6 +56,7 @@ class WifiConnect {
         uint16_t sendRequest(const uint16_t type, const char* payload, const size_t payloadSize);
         void sendRequest(const uint16_t type, const uint16_t id, const char* payload, const size_t payloadSize);
         void sendMessage(const uint16_t type, const uint16_t id, const char* payload, const size_t payloadSize);
+        void sendQueuedResponses();
 
         void requestOTAUpdateData();
         void receiveOTAUpdateData(char *data, size_t len);
@@ -81,6 +86,7 @@ class WifiConnect {
         volatile bool received = false;
         CommandMessageHeader receivedMessage; 
         char receiveBuffer[MAX_MESSAGE_PAYLOAD_BYTES + 1]; // extra space for 0 terminating string
+        QueueHandle_t responseQueue = nullptr;
 
         String updateFirmwareHost;
         String updateFirmwarePath;
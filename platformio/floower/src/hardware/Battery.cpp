@@ -0,0 +1,84 @@
+#include "Battery.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#define LOG_TAG ""
+#else
+#include "esp_log.h"
+static const char* LOG_TAG = "Battery";
+#endif
+
+struct DischargePoint {
+    uint16_t millivolts;
+    uint8_t level;
+};
+
+// open circuit voltage of a LiPo cell at 0.2C discharge
+static const DischargePoint dischargeCurve[] = {
+    {4200, 100}, {4150, 95}, {4110, 90}, {4080, 85}, {4020, 80}, {3980, 75}, {3950, 70},
+    {3910, 65}, {3870, 60}, {3850, 55}, {3840, 50}, {3820, 45}, {3800, 40}, {3790, 35},
+    {3770, 30}, {3750, 25}, {3730, 20}, {3710, 15}, {3690, 10}, {3610, 5}, {3300, 0}
+};
+
+Battery::Battery(uint8_t pin) : pin(pin) {
+}
+
+void Battery::init() {
+    calibration = esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, BATTERY_DEFAULT_VREF, &characteristics);
+    ESP_LOGI(LOG_TAG, "ADC calibration: %s", calibration == ESP_ADC_CAL_VAL_EFUSE_TP ? "eFuse Two Point" : (calibration == ESP_ADC_CAL_VAL_EFUSE_VREF ? "eFuse Vref" : "Default Vref"));
+    reset();
+}
+
+void Battery::reset() {
+    measured = false;
+}
+
+float Battery::measure() {
+    uint8_t samples = measured ? BATTERY_OVERSAMPLING : BATTERY_FIRST_OVERSAMPLING;
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < samples; i++) {
+        sum += analogRead(pin); // 0-4095
+    }
+    rawReading = (sum + samples / 2) / samples;
+    float measuredVoltage = rawReading > 0 ? esp_adc_cal_raw_to_voltage(rawReading, &characteristics) * BATTERY_DIVIDER / 1000.0 : 0;
+
+    if (!measured || rawReading == 0) {
+        voltage = measuredVoltage; // no history or the battery was switched off
+        measured = true;
+    }
+    else {
+        voltage += (measuredVoltage - voltage) / BATTERY_FILTER_WEIGHT;
+    }
+    return voltage;
+}
+
+float Battery::getVoltage() {
+    return voltage;
+}
+
+uint8_t Battery::getLevel() {
+    return voltageToLevel(voltage);
+}
+
+uint16_t Battery::getRawReading() {
+    return rawReading;
+}
+
+bool Battery::isCalibrated() {
+    return calibration != ESP_ADC_CAL_VAL_DEFAULT_VREF;
+}
+
+uint8_t Battery::voltageToLevel(float voltage) {
+    float millivolts = voltage * 1000;
+    if (millivolts >= dischargeCurve[0].millivolts) {
+        return 100;
+    }
+    for (uint8_t i = 1; i < sizeof(dischargeCurve) / sizeof(DischargePoint); i++) {
+        const DischargePoint& upper = dischargeCurve[i - 1];
+        const DischargePoint& lower = dischargeCurve[i];
+        if (millivolts >= lower.millivolts) {
+            return lower.level + (millivolts - lower.millivolts) * (upper.level - lower.level) / (upper.millivolts - lower.millivolts) + 0.5;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Arduino.h"
+#include <esp_adc_cal.h>
+
+#define BATTERY_OVERSAMPLING 16 // readings averaged into one measurement
+#define BATTERY_FIRST_OVERSAMPLING 64 // the first measurement decides alone if the battery is dead
+#define BATTERY_FILTER_WEIGHT 4 // every measurement moves the voltage by 1/4 of the difference
+#define BATTERY_DIVIDER 2 // 1:1 voltage divider in front of the ADC
+#define BATTERY_DEFAULT_VREF 1100 // mV, when the chip has no calibration burned in the eFuse
+
+// Voltage of the LiPo battery measured by the ADC. Every measurement averages a burst of readings,
+// converts them to mV with the eFuse calibration of the chip and feeds an exponential filter,
+// the charge level follows the discharge curve of a LiPo cell.
+class Battery {
+    public:
+        Battery(uint8_t pin);
+        void init(); // characterizes the ADC
+        void reset(); // the next measurement starts the filter over
+
+        float measure(); // filtered voltage including the new measurement
+        float getVoltage();
+        uint8_t getLevel(); // 0 - 100%
+        uint16_t getRawReading(); // average of the last burst, 0 when there is no battery
+        bool isCalibrated(); // eFuse calibration of the ADC is used
+
+        static uint8_t voltageToLevel(float voltage);
+
+    private:
+        uint8_t pin;
+        esp_adc_cal_characteristics_t characteristics;
+        esp_adc_cal_value_t calibration;
+        bool measured = false;
+        uint16_t rawReading = 0;
+        float voltage = 0;
+};
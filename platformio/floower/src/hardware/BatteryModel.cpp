@@ -0,0 +1,91 @@
+#include "BatteryModel.h"
+#include "hardware/Battery.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#define LOG_TAG ""
+#else
+#include "esp_log.h"
+static const char* LOG_TAG = "BatteryModel";
+#endif
+
+#define MS_PER_HOUR 3600000.0
+
+BatteryModel::BatteryModel(uint16_t capacity) : capacity(capacity) {
+}
+
+void BatteryModel::reset() {
+    initialized = false;
+}
+
+void BatteryModel::update(unsigned long now, float voltage, uint16_t current, bool charging, bool usbPowered) {
+    float openCircuitVoltage = usbPowered ? voltage : voltage + current * BATTERY_INTERNAL_RESISTANCE / 1000;
+    float voltageCharge = Battery::voltageToLevel(openCircuitVoltage);
+    discharging = !usbPowered && voltage > 0;
+
+    if (!initialized) {
+        initialized = true;
+        updateTime = now;
+        stateOfCharge = voltageCharge;
+        averageCurrent = current;
+        ESP_LOGI(LOG_TAG, "Initial charge %.0f%%", stateOfCharge);
+        return;
+    }
+
+    unsigned long elapsed = now - updateTime;
+    updateTime = now;
+    if (elapsed == 0) {
+        return;
+    }
+
+    if (charging) {
+        // charger powers the load, the rest goes to the battery, full only when the charger says so
+        float chargeCurrent = _max(0, BATTERY_CHARGE_CURRENT_MA - current);
+        stateOfCharge = _min(99, stateOfCharge + chargeCurrent * elapsed / MS_PER_HOUR * 100 / capacity);
+    }
+    else if (usbPowered) {
+        // charged, the charger holds the voltage
+        stateOfCharge += (voltageCharge - stateOfCharge) * elapsed / (elapsed + BATTERY_AVERAGE_CURRENT_TIME);
+    }
+    else {
+        stateOfCharge -= current * elapsed / MS_PER_HOUR * 100 / capacity;
+        stateOfCharge += (voltageCharge - stateOfCharge) * elapsed / (elapsed + BATTERY_VOLTAGE_CORRECTION_TIME);
+    }
+    stateOfCharge = _min(_max(0, stateOfCharge), 100);
+    averageCurrent += (current - averageCurrent) * elapsed / (elapsed + BATTERY_AVERAGE_CURRENT_TIME);
+}
+
+uint8_t BatteryModel::getStateOfCharge() {
+    return stateOfCharge + 0.5;
+}
+
+float BatteryModel::getRemainingCapacity() {
+    return stateOfCharge * capacity / 100;
+}
+
+uint16_t BatteryModel::getAverageCurrent() {
+    return averageCurrent + 0.5;
+}
+
+uint16_t BatteryModel::getRemainingRuntime() {
+    if (!discharging || averageCurrent < 1) {
+        return BATTERY_RUNTIME_UNKNOWN;
+    }
+    return _min(getRemainingCapacity() * 60 / averageCurrent, BATTERY_RUNTIME_UNKNOWN - 1);
+}
+
+uint16_t BatteryModel::estimateCurrent(const PowerLoad& load) {
+    uint32_t current = LOAD_IDLE_MA;
+    current += load.pixelCount * LOAD_PIXEL_MA;
+    current += (uint32_t) load.ledIntensity * LOAD_LED_CHANNEL_MA / 255;
+    if (load.stepperEnabled) {
+        current += LOAD_STEPPER_MA;
+    }
+    if (load.wifiEnabled) {
+        current += LOAD_WIFI_MA;
+    }
+    if (load.bluetoothEnabled) {
+        current += LOAD_BLUETOOTH_MA;
+    }
+    return current;
+}
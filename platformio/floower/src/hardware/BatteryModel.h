@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Arduino.h"
+
+#define BATTERY_CAPACITY_MAH 1600
+#define BATTERY_INTERNAL_RESISTANCE 0.15 // Ohm, the voltage sags by the load
+#define BATTERY_CHARGE_CURRENT_MA 500 // charger current limit
+#define BATTERY_VOLTAGE_CORRECTION_TIME 600000 // ms, coulomb counting drifts to the voltage estimate in ~10 minutes
+#define BATTERY_AVERAGE_CURRENT_TIME 60000 // ms, time constant of the current averaged for the runtime
+#define BATTERY_RUNTIME_UNKNOWN 0xFFFF
+
+// current estimates of the subsystems
+#define LOAD_IDLE_MA 25 // CPU with the light sleep between frames
+#define LOAD_PIXEL_MA 1 // quiescent current of a NeoPixel
+#define LOAD_LED_CHANNEL_MA 12 // one NeoPixel channel at full intensity
+#define LOAD_STEPPER_MA 180
+#define LOAD_WIFI_MA 80
+#define LOAD_BLUETOOTH_MA 12
+
+// subsystems drawing current from the battery
+struct PowerLoad {
+    uint16_t ledIntensity; // sum of all the channels of all the pixels (0-255 each)
+    uint8_t pixelCount;
+    bool stepperEnabled;
+    bool wifiEnabled;
+    bool bluetoothEnabled;
+};
+
+// State of charge of the battery. The current estimated from the active subsystems is integrated
+// over time and the result slowly corrected towards the charge read from the open circuit voltage,
+// so the sag under load and the ADC noise do not move the level while the counting does not drift.
+// The remaining runtime assumes the current averaged over the last minute keeps going.
+class BatteryModel {
+    public:
+        BatteryModel(uint16_t capacity = BATTERY_CAPACITY_MAH);
+        void reset(); // the next update starts from the voltage
+        void update(unsigned long now, float voltage, uint16_t current, bool charging, bool usbPowered);
+
+        uint8_t getStateOfCharge(); // 0 - 100%
+        float getRemainingCapacity(); // mAh
+        uint16_t getAverageCurrent(); // mA
+        uint16_t getRemainingRuntime(); // minutes, BATTERY_RUNTIME_UNKNOWN when not discharging
+
+        static uint16_t estimateCurrent(const PowerLoad& load); // mA
+
+    private:
+        uint16_t capacity;
+        bool initialized = false;
+        bool discharging = false;
+        unsigned long updateTime = 0;
+        float stateOfCharge = 0; // %
+        float averageCurrent = 0; // mA
+};
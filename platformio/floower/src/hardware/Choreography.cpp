@@ -0,0 +1,191 @@
+#include "Choreography.h"
+#include <limits.h>
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#define LOG_TAG ""
+#else
+#include "esp_log.h"
+static const char* LOG_TAG = "Choreography";
+#endif
+
+void Choreography::onAction(ChoreographyActionCallback callback) {
+    actionCallback = callback;
+}
+
+bool Choreography::load(const uint8_t *program, uint16_t length, unsigned long now) {
+    if (!validate(program, length)) {
+        ESP_LOGW(LOG_TAG, "Invalid program");
+        return false;
+    }
+    memcpy(this->program, program, length);
+    this->length = length;
+    pc = 0;
+    running = length > 0;
+    waitingTime = false;
+    waitingIdle = false;
+    lastWakeTime = now;
+    loopDepth = 0;
+    executedCount = 0;
+    ESP_LOGI(LOG_TAG, "Loaded %d bytes", length);
+    return true;
+}
+
+void Choreography::stop() {
+    running = false;
+}
+
+bool Choreography::isRunning() {
+    return running;
+}
+
+unsigned long Choreography::getIdleDuration(unsigned long now) {
+    if (!running) {
+        return ULONG_MAX;
+    }
+    if (waitingTime && (long) (waitUntil - now) > 0) {
+        return waitUntil - now;
+    }
+    return 0;
+}
+
+uint32_t Choreography::getExecutedCount() {
+    return executedCount;
+}
+
+void Choreography::update(unsigned long now, bool idle) {
+    for (uint8_t steps = 0; running && steps < CHOREOGRAPHY_STEPS_PER_UPDATE; steps++) {
+        if (waitingTime) {
+            if ((long) (now - waitUntil) < 0) {
+                return;
+            }
+            waitingTime = false;
+            lastWakeTime = waitUntil;
+        }
+        if (waitingIdle) {
+            if (!idle) {
+                return;
+            }
+            waitingIdle = false;
+            lastWakeTime = now;
+        }
+        if (pc >= length) {
+            running = false;
+            return;
+        }
+
+        uint8_t opcode = program[pc];
+        uint16_t operands = pc + 1;
+        pc += instructionLength(opcode);
+        executedCount++;
+
+        switch (opcode) {
+            case CHOREO_END:
+                running = false;
+                return;
+            case CHOREO_WAIT:
+                waitingTime = true;
+                waitUntil = lastWakeTime + readTime(operands);
+                break;
+            case CHOREO_WAIT_IDLE:
+                waitingIdle = true;
+                return; // the flower has to pick up the previous instructions first
+            case CHOREO_LOOP:
+                loopStart[loopDepth] = pc;
+                loopRemaining[loopDepth] = program[operands];
+                loopDepth++;
+                break;
+            case CHOREO_NEXT:
+                if (loopRemaining[loopDepth - 1] == 0 || --loopRemaining[loopDepth - 1] > 0) {
+                    pc = loopStart[loopDepth - 1]; // forever or not done yet
+                }
+                else {
+                    loopDepth--;
+                }
+                break;
+            default: {
+                ChoreographyAction action;
+                action.opcode = (ChoreographyOpcode) opcode;
+                action.value = 0;
+                action.time = 0;
+                switch (opcode) {
+                    case CHOREO_COLOR:
+                    case CHOREO_FLASH:
+                    case CHOREO_CIRCLE:
+                        action.color = RgbColor(program[operands], program[operands + 1], program[operands + 2]);
+                        action.time = readTime(operands + 3);
+                        break;
+                    case CHOREO_BRIGHTNESS:
+                    case CHOREO_PETALS:
+                        action.value = program[operands];
+                        action.time = readTime(operands + 1);
+                        break;
+                    case CHOREO_ANIMATION:
+                        action.value = program[operands];
+                        break;
+                }
+                if (actionCallback != nullptr) {
+                    actionCallback(action);
+                }
+                break;
+            }
+        }
+    }
+}
+
+uint16_t Choreography::readTime(uint16_t at) {
+    return program[at] | (program[at + 1] << 8);
+}
+
+bool Choreography::validate(const uint8_t *program, uint16_t length) {
+    if (length > CHOREOGRAPHY_MAX_LENGTH) {
+        return false;
+    }
+    uint8_t depth = 0;
+    for (uint16_t pc = 0; pc < length; ) {
+        uint8_t opcode = program[pc];
+        uint8_t size = instructionLength(opcode);
+        if (size == 0 || pc + size > length) {
+            return false; // unknown instruction or missing operands
+        }
+        if (opcode == CHOREO_LOOP) {
+            if (++depth > CHOREOGRAPHY_MAX_LOOPS) {
+                return false;
+            }
+        }
+        else if (opcode == CHOREO_NEXT) {
+            if (depth-- == 0) {
+                return false;
+            }
+        }
+        else if ((opcode == CHOREO_BRIGHTNESS || opcode == CHOREO_PETALS) && program[pc + 1] > 100) {
+            return false;
+        }
+        pc += size;
+    }
+    return depth == 0;
+}
+
+uint8_t Choreography::instructionLength(uint8_t opcode) {
+    switch (opcode) {
+        case CHOREO_END:
+        case CHOREO_STOP_ANIMATION:
+        case CHOREO_WAIT_IDLE:
+        case CHOREO_NEXT:
+            return 1;
+        case CHOREO_ANIMATION:
+        case CHOREO_LOOP:
+            return 2;
+        case CHOREO_WAIT:
+            return 3;
+        case CHOREO_BRIGHTNESS:
+        case CHOREO_PETALS:
+            return 4;
+        case CHOREO_COLOR:
+        case CHOREO_FLASH:
+        case CHOREO_CIRCLE:
+            return 6;
+        default:
+            return 0;
+    }
+}
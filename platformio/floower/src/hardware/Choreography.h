@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Arduino.h"
+#include <functional>
+#include <NeoPixelBus.h>
+
+#define CHOREOGRAPHY_MAX_LENGTH 255 // fits a single protocol message
+#define CHOREOGRAPHY_MAX_LOOPS 4 // nesting depth
+#define CHOREOGRAPHY_STEPS_PER_UPDATE 32 // instructions executed in one update at most, bounds a program that never waits
+
+// Bytecode of the choreography, operands follow the opcode, 16 bit values are little endian.
+enum ChoreographyOpcode : uint8_t {
+    CHOREO_END              = 0x00, // end of the show
+    CHOREO_COLOR            = 0x01, // r, g, b, time (2) - transition to the color
+    CHOREO_BRIGHTNESS       = 0x02, // brightness (0 - 100%), time (2) - transition to the brightness of the current color
+    CHOREO_PETALS           = 0x03, // level (0 - 100%), time (2) - move the petals
+    CHOREO_FLASH            = 0x04, // r, g, b, duration (2) - flash the color until the next color instruction
+    CHOREO_CIRCLE           = 0x05, // r, g, b, duration (2) - circle the color until the next color instruction
+    CHOREO_ANIMATION        = 0x06, // animation (FloowerColorAnimation)
+    CHOREO_STOP_ANIMATION   = 0x07, // stop the animation and keep its current color
+    CHOREO_WAIT             = 0x08, // time (2) - counts from the end of the previous wait so long shows do not drift
+    CHOREO_WAIT_IDLE        = 0x09, // until the color transition and the petals finish, at least one update
+    CHOREO_LOOP             = 0x0A, // count (0 is forever) - repeat the instructions up to the matching NEXT
+    CHOREO_NEXT             = 0x0B
+};
+
+struct ChoreographyAction {
+    ChoreographyOpcode opcode;
+    RgbColor color;
+    uint8_t value; // brightness, level or animation
+    uint16_t time;
+};
+
+typedef std::function<void(const ChoreographyAction& action)> ChoreographyActionCallback;
+
+// Tiny interpreter of an uploaded light and petals show. The program is validated when loaded and
+// runs from Floower::update(), every instruction that changes the flower is handed to the callback.
+// It does not depend on the hardware so the same interpreter runs shows on the host.
+class Choreography {
+    public:
+        void onAction(ChoreographyActionCallback callback);
+        bool load(const uint8_t *program, uint16_t length, unsigned long now); // false when the program is invalid
+        void stop();
+        bool isRunning();
+        void update(unsigned long now, bool idle);
+        unsigned long getIdleDuration(unsigned long now); // ms until the next instruction runs, 0 when right away
+
+        uint32_t getExecutedCount(); // instructions executed since load
+
+        static bool validate(const uint8_t *program, uint16_t length);
+        static uint8_t instructionLength(uint8_t opcode); // 0 for unknown opcode
+
+    private:
+        uint16_t readTime(uint16_t at);
+
+        ChoreographyActionCallback actionCallback;
+        uint8_t program[CHOREOGRAPHY_MAX_LENGTH];
+        uint16_t length = 0;
+        uint16_t pc = 0;
+        bool running = false;
+
+        // waiting
+        bool waitingTime = false;
+        bool waitingIdle = false;
+        unsigned long waitUntil;
+        unsigned long lastWakeTime;
+
+        // loops
+        uint16_t loopStart[CHOREOGRAPHY_MAX_LOOPS];
+        uint8_t loopRemaining[CHOREOGRAPHY_MAX_LOOPS];
+        uint8_t loopDepth = 0;
+
+        uint32_t executedCount = 0;
+};
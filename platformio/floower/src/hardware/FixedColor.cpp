@@ -0,0 +1,93 @@
+#include "FixedColor.h"
+
+// a * b / 65535, exact at both ends of the range (b = 0 and b = 65535)
+static inline uint16_t scale(uint16_t a, uint16_t b) {
+    return ((uint32_t) a * b + 0xFFFF) >> 16;
+}
+
+// left to right by progress 0 - 65535, the product of a 16 bit distance and progress fits in uint32_t
+static inline uint16_t blend(uint16_t left, uint16_t right, uint16_t progress) {
+    return right >= left ? left + scale(right - left, progress) : left - scale(left - right, progress);
+}
+
+FixedHsbColor::FixedHsbColor(const HsbColor& color) {
+    H = (uint32_t) (color.H * FIXED_HUE_TURN) & 0xFFFF;
+    S = color.S * FIXED_COLOR_ONE + 0.5f;
+    B = color.B * FIXED_COLOR_ONE + 0.5f;
+}
+
+HsbColor FixedHsbColor::toHsbColor() const {
+    return HsbColor(H / (float) FIXED_HUE_TURN, S / (float) FIXED_COLOR_ONE, B / (float) FIXED_COLOR_ONE);
+}
+
+RgbColor FixedHsbColor::toRgbColor() const {
+    uint32_t v = ((uint32_t) B * 255 + 255) >> 8; // brightness of the 8 bit channel in 8.8
+    if (S == 0 || v == 0) {
+        return RgbColor(v >> 8); // achromatic or black
+    }
+
+    uint32_t h = (uint32_t) H * 6;
+    uint8_t sector = h >> 16;
+    uint16_t sf = scale(S, h & 0xFFFF); // saturation times position within the sector
+    uint8_t w = v >> 8;
+    uint8_t p = (v * (FIXED_COLOR_ONE - S)) >> 24;
+    uint8_t q = (v * (FIXED_COLOR_ONE - sf)) >> 24;
+    uint8_t t = (v * (FIXED_COLOR_ONE - S + sf)) >> 24; // 1 - s * (1 - f)
+
+    switch (sector) {
+        case 0: return RgbColor(w, t, p);
+        case 1: return RgbColor(q, w, p);
+        case 2: return RgbColor(p, w, t);
+        case 3: return RgbColor(p, q, w);
+        case 4: return RgbColor(t, p, w);
+        default: return RgbColor(w, p, q);
+    }
+}
+
+FixedHsbColor FixedHsbColor::fromRgbColor(const RgbColor& color) {
+    uint8_t max = _max(color.R, _max(color.G, color.B));
+    uint8_t min = _min(color.R, _min(color.G, color.B));
+    uint8_t d = max - min;
+
+    FixedHsbColor result;
+    result.B = max * 257; // 255 -> 65535
+    result.S = max == 0 ? 0 : (uint32_t) d * FIXED_COLOR_ONE / max;
+    if (d != 0) {
+        // hue in sixths of the circle, 65536 / 6 per sector
+        int32_t sector;
+        int32_t offset;
+        if (color.R == max) {
+            sector = 0;
+            offset = (int32_t) color.G - color.B;
+        }
+        else if (color.G == max) {
+            sector = 2;
+            offset = (int32_t) color.B - color.R;
+        }
+        else {
+            sector = 4;
+            offset = (int32_t) color.R - color.G;
+        }
+        result.H = (sector * FIXED_HUE_TURN + offset * FIXED_HUE_TURN / d) / 6;
+    }
+    return result;
+}
+
+FixedHsbColor FixedHsbColor::LinearBlend(const FixedHsbColor& left, const FixedHsbColor& right, uint16_t progress) {
+    int16_t hueDelta = right.H - left.H; // wraps to the shortest distance
+    return FixedHsbColor(
+        left.H + (int16_t) (((int32_t) hueDelta * progress) / FIXED_COLOR_ONE),
+        blend(left.S, right.S, progress),
+        blend(left.B, right.B, progress));
+}
+
+RgbColor FixedHsbColor::LinearBlend(const RgbColor& left, const RgbColor& right, uint16_t progress) {
+    return RgbColor(
+        left.R + ((int32_t) (right.R - left.R) * progress) / FIXED_COLOR_ONE,
+        left.G + ((int32_t) (right.G - left.G) * progress) / FIXED_COLOR_ONE,
+        left.B + ((int32_t) (right.B - left.B) * progress) / FIXED_COLOR_ONE);
+}
+
+uint16_t FixedHsbColor::toProgress(float progress) {
+    return constrain(progress, 0.0f, 1.0f) * FIXED_COLOR_ONE + 0.5f;
+}
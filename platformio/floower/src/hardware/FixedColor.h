@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Arduino.h"
+#include <NeoPixelBus.h>
+
+#define FIXED_COLOR_ONE 65535 // saturation and brightness of 1.0
+#define FIXED_HUE_TURN 65536 // full circle of hue, wraps around with uint16_t overflow
+
+// HSB color in Q16 fixed point for the per-frame LED math. Conversion and blending use only
+// integer arithmetic (ESP32 has no FPU for double and float calls are not free either),
+// floats are needed only when converting from/to HsbColor.
+struct FixedHsbColor {
+    FixedHsbColor() : H(0), S(0), B(0) {}
+    FixedHsbColor(uint16_t h, uint16_t s, uint16_t b) : H(h), S(s), B(b) {}
+    FixedHsbColor(const HsbColor& color);
+
+    HsbColor toHsbColor() const;
+    RgbColor toRgbColor() const;
+    static FixedHsbColor fromRgbColor(const RgbColor& color);
+
+    // hue takes the shortest way around the circle, progress is 0 - FIXED_COLOR_ONE
+    static FixedHsbColor LinearBlend(const FixedHsbColor& left, const FixedHsbColor& right, uint16_t progress);
+    static RgbColor LinearBlend(const RgbColor& left, const RgbColor& right, uint16_t progress);
+    static uint16_t toProgress(float progress);
+
+    uint16_t H;
+    uint16_t S;
+    uint16_t B;
+};
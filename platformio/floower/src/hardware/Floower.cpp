@@ -1,4 +1,6 @@
 #include "Floower.h"
+#include <limits.h>
+#include "BootTimeline.h"
 
 #if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
 #include "esp32-hal-log.h"
@@ -14,6 +16,7 @@ static const char* LOG_TAG = "Floower";
 #define BATTERY_ANALOG_PIN GPIO_NUM_36 // VP
 #define USB_ANALOG_PIN GPIO_NUM_39 // VN
 #define CHARGE_PIN GPIO_NUM_35
+#define USB_OVERSAMPLING 4 // readings averaged to detect USB power
 
 #define STATUS_NEOPIXEL_PIN GPIO_NUM_32
 #define ACTY_LED_PIN GPIO_NUM_2
@@ -24,19 +27,21 @@ static const char* LOG_TAG = "Floower";
 #define ANIMATION_INDEX_STATUS 2
 
 #define TOUCH_SENSOR_PIN GPIO_NUM_4
-#define TOUCH_FADE_TIME 75 // 50
-#define TOUCH_LONG_TIME_THRESHOLD 2000 // 2s to recognize long touch
-#define TOUCH_HOLD_TIME_THRESHOLD 5000 // 5s to recognize hold touch
-#define TOUCH_COOLDOWN_TIME 300 // prevent random touch within 300ms after last touch
+#define TOUCH_ENABLE_DELAY 300 // prevent random touch within 300ms after power on
+#define TOUCH_BASELINE_INTERVAL 1000 // sample the untouched sensor once a second to follow the drift
+
+#define LIGHT_SLEEP_MIN_TIME 5 // ms, entering and leaving light sleep takes about 1ms
 
-unsigned long Floower::touchStartedTime = 0;
-unsigned long Floower::touchEndedTime = 0;
 unsigned long Floower::lastTouchTime = 0;
 
 const HsbColor candleColor(0.042, 1.0, 1.0); // candle orange color
+const FixedHsbColor candleFixedColor(candleColor);
+const PixelsKeyframe candleMiddleKeyframes[] = {{0, candleFixedColor, PIXELS_EASE_LINEAR}};
 
 Floower::Floower(Config *config) 
-        : animations(ANIMATIONS_INDECES), config(config), pixels(7, NEOPIXEL_PIN), statusPixel(2, STATUS_NEOPIXEL_PIN) {
+        : animations(ANIMATIONS_INDECES), config(config), pixels(7, NEOPIXEL_PIN), pixelsFrame(7), candleTimeline(PIXELS_TIMELINE(candleTracks)), statusPixel(2, STATUS_NEOPIXEL_PIN), touchGestures(config), battery(BATTERY_ANALOG_PIN) {
+    lastTouchTime = 0;
+    choreography.onAction([=](const ChoreographyAction& action) { runChoreographyAction(action); });
 }
 
 void Floower::init() {
@@ -58,20 +63,24 @@ void Floower::init() {
     pixelsColor = colorBlack;
     pixelsOriginColor = colorBlack;
     pixelsTargetColor = colorBlack;
+    pixelsFrame.setBrightness(config->colorBrightness);
+    pixelsFrame.clearTo(pixelsColor);
     pixels.Begin();
-    pixels.ClearTo(pixelsColor);
-    pixels.Show();
+    pixelsFrame.show(pixels, true);
 
     statusColor = colorBlack;
     statusPixel.Begin();
     statusPixel.SetPixelColor(0, statusColor);
     statusPixel.Show();
+    BOOT_PHASE(BOOT_PHASE_PIXELS);
 
     // configure ADC for battery level reading
     analogReadResolution(12); // se0t 12bit resolution (0-4095)
     analogSetAttenuation(ADC_11db); // set AREF to be 3.6V
     //analogSetCycles(8); // num of cycles per sample, 8 is default optimal
     //analogSetSamples(1); // num of samples
+    battery.init();
+    BOOT_PHASE(BOOT_PHASE_ADC);
 
     // wake up when USB is connected
     pinMode(CHARGE_PIN, INPUT);
@@ -80,68 +89,53 @@ void Floower::init() {
 
 void Floower::initPetals(bool initial, bool wokeUp) {
     petals->init(initial, wokeUp);
+    BOOT_PHASE(BOOT_PHASE_PETALS);
 }
 
 void Floower::update() {
+    updateMotion();
+    updateControl();
+    updatePixels();
+}
+
+void Floower::updateMotion() {
     petals->update();
+}
+
+void Floower::updatePixels() {
     animations.UpdateAnimations();
 
     // show pixels
+    pixelsFrame.setBrightness(config->colorBrightness); // regenerates the gamma table only when changed
     if (pixelsColor.B > 0) {
         setPixelsPowerOn(true);
-        if (pixels.IsDirty() && pixels.CanShow()) {
-            pixels.Show();
-        }
+        pixelsFrame.show(pixels);
+        BOOT_PHASE(BOOT_PHASE_FIRST_FRAME);
     }
     else if (pixelsPowerOn) {
-        pixels.Show();
+        pixelsFrame.show(pixels, true);
         setPixelsPowerOn(false);
     }
     if (statusPixel.IsDirty() && statusPixel.CanShow()) {
         statusPixel.Show();
     }
+}
+
+void Floower::updateControl() {
+    if (choreography.isRunning()) {
+        choreography.update(millis(), !isChangingColor() && !petals->arePetalsMoving());
+    }
 
     unsigned long now = millis();
-    if (touchStartedTime > 0) {
-        unsigned int touchTime = now - touchStartedTime;
-        unsigned long sinceLastTouch = now - lastTouchTime;
-
-        if (!touchRegistered) {
-            ESP_LOGI(LOG_TAG, "Touch Down");
-            touchRegistered = true;
-            if (touchCallback != nullptr) {
-                touchCallback(FloowerTouchEvent::TOUCH_DOWN);
-            }
-        }
-        if (!longTouchRegistered && touchTime > TOUCH_LONG_TIME_THRESHOLD) {
-            ESP_LOGI(LOG_TAG, "Long Touch %d", touchTime);
-            longTouchRegistered = true;
-            if (touchCallback != nullptr) {
-                touchCallback(FloowerTouchEvent::TOUCH_LONG);
-            }
-        }
-        if (!holdTouchRegistered && touchTime > TOUCH_HOLD_TIME_THRESHOLD) {
-            ESP_LOGI(LOG_TAG, "Hold Touch %d", touchTime);
-            holdTouchRegistered = true;
-            if (touchCallback != nullptr) {
-                touchCallback(FloowerTouchEvent::TOUCH_HOLD);
-            }
+    touchGestures.update(now, lastTouchTime);
+
+    if (touchEnabled && now - touchBaselineTime >= TOUCH_BASELINE_INTERVAL) {
+        touchBaselineTime = now;
+        if (touchBaseline.update(readTouch()) && touchBaseline.getThreshold() != touchThreshold) {
+            ESP_LOGD(LOG_TAG, "Touch baseline=%d noise=%d", touchBaseline.getBaseline(), touchBaseline.getNoise());
+            touchThreshold = touchBaseline.getThreshold();
+            reconfigureTouch();
         }
-        if (sinceLastTouch > TOUCH_FADE_TIME) {
-            ESP_LOGI(LOG_TAG, "Touch Up %d", sinceLastTouch);
-            touchStartedTime = 0;
-            touchEndedTime = now;
-            touchRegistered = false;
-            longTouchRegistered = false;
-            holdTouchRegistered = false;
-            if (touchCallback != nullptr) {
-                touchCallback(FloowerTouchEvent::TOUCH_UP);
-            }
-        }
-    }
-    else if (touchEndedTime > 0 && now - touchEndedTime > TOUCH_COOLDOWN_TIME) {
-        ESP_LOGI(LOG_TAG, "Touch enabled");
-        touchEndedTime = 0;
     }
 
     if (wasChanged && changeCallback != nullptr) {
@@ -155,10 +149,15 @@ void Floower::registerOutsideTouch() {
 }
 
 void Floower::enableTouch(FloowerOnLeafTouchCallback callback, bool defer) {
-    touchCallback = callback;
-    touchAttachInterrupt(TOUCH_SENSOR_PIN, Floower::touchISR, config->touchThreshold);
+    touchGestures.onGesture(callback);
+    touchEnabled = true;
+    // start from the calibration, unless the leaf is untouched now and tells better
+    touchBaseline.reset(_max(readTouch(), config->touchThreshold + TOUCH_MIN_MARGIN));
+    touchThreshold = touchBaseline.getThreshold();
+    touchBaselineTime = millis();
+    touchAttachInterrupt(TOUCH_SENSOR_PIN, Floower::touchISR, touchThreshold);
     if (defer) {
-        touchEndedTime = millis();
+        touchGestures.ignoreUntil(millis() + TOUCH_ENABLE_DELAY);
     }
     else {
         ESP_LOGI(LOG_TAG, "Touch enabled");
@@ -167,26 +166,44 @@ void Floower::enableTouch(FloowerOnLeafTouchCallback callback, bool defer) {
 
 void Floower::reconfigureTouch() {
     detachInterrupt(TOUCH_SENSOR_PIN);
-    touchAttachInterrupt(TOUCH_SENSOR_PIN, Floower::touchISR, config->touchThreshold);
-    ESP_LOGI(LOG_TAG, "Touch reconfigured");
+    touchAttachInterrupt(TOUCH_SENSOR_PIN, Floower::touchISR, touchThreshold);
+    ESP_LOGI(LOG_TAG, "Touch reconfigured, threshold=%d", touchThreshold);
 }
 
 void Floower::disableTouch() {
+    touchEnabled = false;
     detachInterrupt(TOUCH_SENSOR_PIN);
     ESP_LOGI(LOG_TAG, "Touch disabled");
 }
 
 void Floower::touchISR() {
     lastTouchTime = millis();
-    if (touchStartedTime == 0 && touchEndedTime == 0) {
-        touchStartedTime = lastTouchTime;
-    }
 }
 
 uint8_t Floower::readTouch() {
     return touchRead(TOUCH_SENSOR_PIN);
 }
 
+uint16_t Floower::getTouchBaseline() {
+    return touchBaseline.getBaseline();
+}
+
+uint16_t Floower::getTouchNoise() {
+    return touchBaseline.getNoise();
+}
+
+uint8_t Floower::getTouchThreshold() {
+    return touchThreshold;
+}
+
+unsigned long Floower::getTouchDuration() {
+    return touchGestures.getTouchDuration();
+}
+
+uint8_t Floower::getTouchTimeline(TouchEdge *edges) {
+    return touchGestures.getTimeline(edges);
+}
+
 void Floower::onChange(FloowerChangeCallback callback) {
     changeCallback = callback;
 }
@@ -241,6 +258,8 @@ void Floower::transitionColor(double hue, double saturation, double brightness,
     }
     else {
         pixelsOriginColor = pixelsColor;
+        transitionOriginColor = FixedHsbColor(pixelsOriginColor);
+        transitionTargetColor = FixedHsbColor(pixelsTargetColor);
         animations.StartAnimation(ANIMATION_INDEX_LEDS, transitionTime, [=](const AnimationParam& param){ pixelsTransitionAnimationUpdate(param); });  
     }
 
@@ -248,14 +267,18 @@ void Floower::transitionColor(double hue, double saturation, double brightness,
 }
 
 void Floower::pixelsTransitionAnimationUpdate(const AnimationParam& param) {
-    double diff = pixelsOriginColor.H - pixelsTargetColor.H;
-    if (diff < 0.2 && diff > -0.2) {
-        pixelsColor = HsbColor::LinearBlend<NeoHueBlendShortestDistance>(pixelsOriginColor, pixelsTargetColor, param.progress);
+    uint16_t progress = FixedHsbColor::toProgress(param.progress);
+    int32_t diff = (int32_t) transitionOriginColor.H - transitionTargetColor.H;
+    FixedHsbColor color;
+    if (diff < FIXED_HUE_TURN / 5 && diff > -FIXED_HUE_TURN / 5) {
+        color = FixedHsbColor::LinearBlend(transitionOriginColor, transitionTargetColor, progress);
     }
     else {
-        pixelsColor = RgbColor::LinearBlend(pixelsOriginColor, pixelsTargetColor, param.progress);
+        RgbColor rgbColor = FixedHsbColor::LinearBlend(transitionOriginColor.toRgbColor(), transitionTargetColor.toRgbColor(), progress);
+        color = FixedHsbColor::fromRgbColor(rgbColor);
     }
-    showColor(pixelsColor);
+    pixelsColor = param.state == AnimationState_Completed ? pixelsTargetColor : color.toHsbColor();
+    showColor(color);
 }
 
 void Floower::flashColor(double hue, double saturation, int flashDuration) {
@@ -264,24 +287,7 @@ void Floower::flashColor(double hue, double saturation, int flashDuration) {
     pixelsColor.B = 0;
 
     interruptiblePixelsAnimation = false;
-    animations.StartAnimation(ANIMATION_INDEX_LEDS, flashDuration, [=](const AnimationParam& param){ pixelsFlashAnimationUpdate(param); });
-}
-
-void Floower::pixelsFlashAnimationUpdate(const AnimationParam& param) {
-    if (param.progress < 0.5) {
-        pixelsColor.B = NeoEase::CubicInOut(param.progress * 2);
-    }
-    else {
-        pixelsColor.B = NeoEase::CubicInOut((1 - param.progress) * 2);
-    }
-
-    showColor(pixelsColor);
-
-    if (param.state == AnimationState_Completed) {
-        if (pixelsTargetColor.B > 0) { // while there is something to show
-            animations.RestartAnimation(param.index);
-        }
-    }
+    playTimeline(flashTimeline, pixelsTargetColor, flashDuration, true);
 }
 
 void Floower::circleColor(double hue, double saturation, int flashDuration) {
@@ -289,26 +295,29 @@ void Floower::circleColor(double hue, double saturation, int flashDuration) {
     pixelsColor = pixelsTargetColor;
 
     interruptiblePixelsAnimation = false;
-    animations.StartAnimation(ANIMATION_INDEX_LEDS, flashDuration, [=](const AnimationParam& param){ pixelsCircleAnimationUpdate(param); });
+    playTimeline(circleTimeline, pixelsColor, flashDuration, false);
 }
 
-void Floower::pixelsCircleAnimationUpdate(const AnimationParam& param) {
-    int index = (param.progress * 6) + 1;
-    float brightness = 1;
+void Floower::playTimeline(const PixelsTimeline& timeline, const HsbColor& base, int duration, bool followColor) {
+    pixelsTimeline = &timeline;
+    pixelsTimelineBase = FixedHsbColor(base);
+    pixelsTimelineColor = followColor;
+    animations.StartAnimation(ANIMATION_INDEX_LEDS, duration, [=](const AnimationParam& param){ pixelsTimelineAnimationUpdate(param); });
+}
 
-    pixels.ClearTo(colorBlack);
-    for (uint8_t i = 0; i < 3; i++, index--, brightness -= 0.45) {
-        if (index < 1) {
-            index += 6;
-        }
-        if (brightness < 0) {
-            brightness = 0;
-        }
-        pixels.SetPixelColor(index, HsbColor(pixelsColor.H, pixelsColor.S, brightness));
+void Floower::pixelsTimelineAnimationUpdate(const AnimationParam& param) {
+    uint16_t position = FixedHsbColor::toProgress(param.progress);
+    pixelsTimeline->render(pixelsFrame, pixelsTimelineBase, position);
+    if (pixelsTimelineColor) {
+        pixelsColor = pixelsTimeline->colorOf(0, pixelsTimelineBase, position).toHsbColor();
     }
 
     if (param.state == AnimationState_Completed) {
-        if (pixelsTargetColor.B > 0) { // while there is something to show
+        if (pixelsTimeline == &candleTimeline) {
+            nextCandleKeyframes();
+            animations.StartAnimation(param.index, random(10, 400), [=](const AnimationParam& param){ pixelsTimelineAnimationUpdate(param); });
+        }
+        else if (pixelsTargetColor.B > 0) { // while there is something to show
             animations.RestartAnimation(param.index);
         }
     }
@@ -327,19 +336,29 @@ void Floower::startAnimation(uint8_t animation) {
 
     if (animation == RAINBOW) {
         pixelsOriginColor = pixelsColor;
-        animations.StartAnimation(ANIMATION_INDEX_LEDS, 10000, [=](const AnimationParam& param){ pixelsRainbowAnimationUpdate(param); });
+        playTimeline(rainbowTimeline, pixelsOriginColor, 10000, true);
     }
     else if (animation == RAINBOW_LOOP) {
         pixelsTargetColor = pixelsColor = colorWhite;
-        animations.StartAnimation(ANIMATION_INDEX_LEDS, 10000, [=](const AnimationParam& param){ pixelsRainbowLoopAnimationUpdate(param); });
+        playTimeline(rainbowLoopTimeline, pixelsColor, 10000, false);
     }
     else if (animation == CANDLE) {
         pixelsTargetColor = pixelsColor = candleColor; // candle orange
         for (uint8_t i = 0; i < 6; i++) {
-            candleOriginColors[i] = pixelsTargetColor;
-            candleTargetColors[i] = pixelsTargetColor;
+            candleKeyframes[i][0] = {0, candleFixedColor, PIXELS_EASE_LINEAR};
+            candleKeyframes[i][1] = {PIXELS_TIMELINE_END, candleFixedColor, PIXELS_EASE_LINEAR};
+            candleTracks[i + 1] = PIXELS_TRACK((uint8_t) (1 << (i + 1)), 0, 0, candleKeyframes[i]);
         }
-        animations.StartAnimation(ANIMATION_INDEX_LEDS, 100, [=](const AnimationParam& param){ pixelsCandleAnimationUpdate(param); });
+        candleTracks[0] = PIXELS_TRACK(0x01, 0, 0, candleMiddleKeyframes);
+        playTimeline(candleTimeline, pixelsColor, 100, false);
+    }
+}
+
+void Floower::nextCandleKeyframes() {
+    // flickering, each pixel goes to a random brightness in random time
+    for (uint8_t i = 0; i < 6; i++) {
+        candleKeyframes[i][0].color = candleKeyframes[i][1].color;
+        candleKeyframes[i][1].color.B = random(20, 100) * FIXED_COLOR_ONE / 100;
     }
 }
 
@@ -350,53 +369,65 @@ void Floower::stopAnimation(bool retainColor) {
     }
 }
 
-void Floower::pixelsRainbowAnimationUpdate(const AnimationParam& param) {
-    float hue = pixelsOriginColor.H + param.progress;
-    if (hue >= 1.0) {
-        hue = hue - 1;
-    }
-    pixelsColor = HsbColor(hue, 1, pixelsOriginColor.B);
-    showColor(pixelsColor);
+void Floower::showColor(HsbColor color) {
+    showColor(FixedHsbColor(color));
+}
 
-    if (param.state == AnimationState_Completed) {
-        if (pixelsTargetColor.B > 0) { // while there is something to show
-            animations.RestartAnimation(param.index);
-        }
-    }
+void Floower::showColor(const FixedHsbColor& color) {
+    pixelsFrame.clearTo(color.toRgbColor());
 }
 
-void Floower::pixelsRainbowLoopAnimationUpdate(const AnimationParam& param) {
-    double hue = param.progress;
-    double step = 1.0 / 6.0;
-    pixels.SetPixelColor(0, HsbColor(param.progress, 1, config->colorBrightnessDecimal));
-    for (uint8_t i = 1; i < 7; i++, hue += step) {
-        if (hue >= 1.0) {
-            hue = hue - 1;
-        }
-        pixels.SetPixelColor(i, HsbColor(hue, 1, config->colorBrightnessDecimal));
-    }
-    if (param.state == AnimationState_Completed) {
-        animations.RestartAnimation(param.index);
-    }
+void Floower::setPixelsFrameRate(uint8_t fps) {
+    pixelsFrame.setFrameRate(fps);
 }
 
-void Floower::pixelsCandleAnimationUpdate(const AnimationParam& param) {
-    pixels.SetPixelColor(0, pixelsTargetColor);
-    for (uint8_t i = 0; i < 6; i++) {
-        pixels.SetPixelColor(i + 1, HsbColor::LinearBlend<NeoHueBlendShortestDistance>(candleOriginColors[i], candleTargetColors[i], param.progress));
-    }
+uint32_t Floower::getPixelsFramesShown() {
+    return pixelsFrame.getFramesShown();
+}
 
-    if (param.state == AnimationState_Completed) {
-        for (uint8_t i = 0; i < 6; i++) {
-            candleOriginColors[i] = candleTargetColors[i];
-            candleTargetColors[i] = HsbColor(candleColor.H, candleColor.S, random(20, 100) / 100.0);
-        }
-        animations.StartAnimation(param.index, random(10, 400), [=](const AnimationParam& param){ pixelsCandleAnimationUpdate(param); });
-    }
+uint32_t Floower::getPixelsFramesSkipped() {
+    return pixelsFrame.getFramesSkipped();
 }
 
-void Floower::showColor(HsbColor color) {
-    pixels.ClearTo(color);
+bool Floower::playChoreography(const uint8_t *program, uint16_t length) {
+    return choreography.load(program, length, millis());
+}
+
+void Floower::stopChoreography() {
+    choreography.stop();
+}
+
+bool Floower::isPlayingChoreography() {
+    return choreography.isRunning();
+}
+
+void Floower::runChoreographyAction(const ChoreographyAction& action) {
+    HsbColor color(action.color);
+    switch (action.opcode) {
+        case CHOREO_COLOR:
+            transitionColor(color.H, color.S, color.B, action.time);
+            break;
+        case CHOREO_BRIGHTNESS:
+            transitionColorBrightness(action.value / 100.0, action.time);
+            break;
+        case CHOREO_PETALS:
+            setPetalsOpenLevel(action.value, action.time);
+            break;
+        case CHOREO_FLASH:
+            flashColor(color.H, color.S, action.time);
+            break;
+        case CHOREO_CIRCLE:
+            circleColor(color.H, color.S, action.time);
+            break;
+        case CHOREO_ANIMATION:
+            startAnimation(action.value);
+            break;
+        case CHOREO_STOP_ANIMATION:
+            stopAnimation(true);
+            break;
+        default:
+            break;
+    }
 }
 
 bool Floower::isLit() {
@@ -468,21 +499,28 @@ bool Floower::setPixelsPowerOn(bool powerOn) {
 }
 
 PowerState Floower::readPowerState() {
-    float reading = analogRead(BATTERY_ANALOG_PIN); // 0-4095
-    float voltage = reading * 0.00181; // 1/4069 for scale * analog reference voltage is 3.6V * 2 for using 1:1 voltage divider + adjustment
-    uint8_t level = _min(_max(0, voltage - 3.3) * 111, 100); // 3.3 .. 0%, 4.2 .. 100%
+    float voltage = battery.measure();
 
     bool charging = digitalRead(CHARGE_PIN) == LOW;
-    bool switchedOn = reading > 0; // there is voltage of battery present
+    bool switchedOn = battery.getRawReading() > 0; // there is voltage of battery present
     bool usbPowered = true;
 
     if (config->hardwareRevision > 5) { // logic board with revision 5 lack the USB detection circuitry, pretend its always charging
-        usbPowered = analogRead(USB_ANALOG_PIN) > 2000; // ~2900 is 5V
+        uint32_t sum = 0;
+        for (uint8_t i = 0; i < USB_OVERSAMPLING; i++) {
+            sum += analogRead(USB_ANALOG_PIN);
+        }
+        usbPowered = sum / USB_OVERSAMPLING > 2000; // ~2900 is 5V
     }
 
-    ESP_LOGD(LOG_TAG, "Battery %.0f %.2fV %d%% %s", reading, voltage, level, charging ? "CHRG" : (usbPowered ? "USB" : ""));
+    uint16_t current = BatteryModel::estimateCurrent(getPowerLoad());
+    batteryModel.update(millis(), voltage, current, charging, usbPowered);
+    uint8_t level = batteryModel.getStateOfCharge();
+    uint16_t runtime = batteryModel.getRemainingRuntime();
+
+    ESP_LOGD(LOG_TAG, "Battery %d %.2fV %d%% %dmA %dmin %s", battery.getRawReading(), voltage, level, current, runtime, charging ? "CHRG" : (usbPowered ? "USB" : ""));
 
-    powerState = {voltage, level, charging, usbPowered, switchedOn};
+    powerState = {voltage, level, current, runtime, charging, usbPowered, switchedOn};
     return powerState;
 }
 
@@ -490,7 +528,59 @@ bool Floower::isUsbPowered() {
     return powerState.usbPowered;
 }
 
+PowerLoad Floower::getPowerLoad() {
+    PowerLoad load = {0, 0, !petals->isIdle(), wifiEnabled, bluetoothEnabled};
+    if (pixelsPowerOn) {
+        load.pixelCount = pixels.PixelCount();
+        for (uint16_t i = 0; i < pixels.PixelCount(); i++) {
+            RgbColor color = pixels.GetPixelColor(i);
+            load.ledIntensity += color.R + color.G + color.B;
+        }
+    }
+    return load;
+}
+
+void Floower::setRadiosEnabled(bool wifiEnabled, bool bluetoothEnabled) {
+    this->wifiEnabled = wifiEnabled;
+    this->bluetoothEnabled = bluetoothEnabled;
+}
+
+unsigned long Floower::getIdleDuration() {
+    bool touching = touchGestures.isTouching() || (lastTouchTime > 0 && millis() - lastTouchTime <= config->touchFadeTime);
+    if (!petals->isIdle() || touching || (wasChanged && changeCallback != nullptr) || statusPixel.IsDirty() || !pixels.CanShow() || !statusPixel.CanShow()) {
+        return 0; // touch in progress, change to report or data still going out to the LEDs
+    }
+    unsigned long now = millis();
+    unsigned long duration = ULONG_MAX;
+    if (animations.IsAnimating() || pixelsFrame.isDirty()) {
+        duration = pixelsFrame.getTimeToNextFrame(); // the last frame of an animation may still wait for its slot
+    }
+    if (choreography.isRunning()) {
+        duration = _min(duration, choreography.getIdleDuration(now));
+    }
+    return duration;
+}
+
+bool Floower::lightSleep(unsigned long maxDuration) {
+    unsigned long duration = _min(maxDuration, getIdleDuration());
+    if (duration < LIGHT_SLEEP_MIN_TIME) {
+        return false;
+    }
+    esp_sleep_enable_timer_wakeup(duration * 1000ULL);
+    esp_sleep_enable_touchpad_wakeup();
+    esp_err_t result = esp_light_sleep_start();
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER); // would wake up the next deep sleep
+    if (result != ESP_OK) {
+        return false;
+    }
+    if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TOUCHPAD) {
+        registerOutsideTouch(); // same as after the deep sleep
+    }
+    return true;
+}
+
 void Floower::beforeDeepSleep() {
+    pixelsFrame.clearTo(colorBlack);
     pixels.ClearTo(colorBlack);
     pixels.Show();
     statusPixel.ClearTo(colorBlack);
@@ -3,6 +3,14 @@
 #include "Arduino.h"
 #include "Config.h"
 #include "hardware/Petals.h"
+#include "hardware/FixedColor.h"
+#include "hardware/PixelsFrame.h"
+#include "hardware/PixelsEffects.h"
+#include "hardware/Choreography.h"
+#include "hardware/TouchBaseline.h"
+#include "hardware/TouchGestures.h"
+#include "hardware/Battery.h"
+#include "hardware/BatteryModel.h"
 #include <tmc2300.h>
 #include <functional>
 #include <NeoPixelBus.h>
@@ -20,22 +28,16 @@ enum FloowerStatusAnimation {
     PULSATING
 };
 
-enum FloowerTouchEvent {
-    TOUCH_DOWN,
-    TOUCH_LONG, // >2s
-    TOUCH_HOLD, // >5s
-    TOUCH_UP
-};
-
 struct PowerState {
     float batteryVoltage;
-    uint8_t batteryLevel;
+    uint8_t batteryLevel; // state of charge
+    uint16_t batteryCurrent; // mA, estimated from the load
+    uint16_t batteryRuntime; // minutes left, BATTERY_RUNTIME_UNKNOWN when not discharging
     bool batteryCharging;
     bool usbPowered;
     bool switchedOn;
 };
 
-typedef std::function<void(const FloowerTouchEvent& event)> FloowerOnLeafTouchCallback;
 typedef std::function<void(const uint8_t petalsOpenLevel, const HsbColor color)> FloowerChangeCallback;
 
 class Floower {
@@ -43,13 +45,21 @@ class Floower {
         Floower(Config *config);
         void init();
         void initPetals(bool initial, bool wokeUp);
-        void update();
+        void update(); // all of the below, in the order of the main loop
+        void updateMotion(); // petals movement and the stepper driver
+        void updateControl(); // choreography and touch events
+        void updatePixels(); // animations and the LED frame
 
         void registerOutsideTouch();
         void enableTouch(FloowerOnLeafTouchCallback callback, bool defer = false);
-        void reconfigureTouch();
+        void reconfigureTouch(); // reattach the touch interrupt with the current threshold
         void disableTouch();
         uint8_t readTouch();
+        uint16_t getTouchBaseline(); // untouched reading tracked in the background
+        uint16_t getTouchNoise();
+        uint8_t getTouchThreshold();
+        unsigned long getTouchDuration(); // of the touch in progress or the last one
+        uint8_t getTouchTimeline(TouchEdge *edges); // last TOUCH_TIMELINE_LENGTH touches and releases, oldest first
         void onChange(FloowerChangeCallback callback);
 
         void setPetalsOpenLevel(int8_t level, int transitionTime = 0);
@@ -63,29 +73,41 @@ class Floower {
         HsbColor getCurrentColor();
         void startAnimation(uint8_t animation);
         void stopAnimation(bool retainColor);
+        bool playChoreography(const uint8_t *program, uint16_t length); // false when the program is invalid
+        void stopChoreography();
+        bool isPlayingChoreography();
         bool isLit();
         bool isAnimating();
         bool arePetalsMoving();
         bool isChangingColor();
+        void setPixelsFrameRate(uint8_t fps);
+        uint32_t getPixelsFramesShown();
+        uint32_t getPixelsFramesSkipped();
 
         void showStatus(HsbColor color, FloowerStatusAnimation animation, int duration);
 
         PowerState readPowerState();
         bool isUsbPowered();
+        PowerLoad getPowerLoad();
+        void setRadiosEnabled(bool wifiEnabled, bool bluetoothEnabled); // accounted in the power load
         void beforeDeepSleep();
 
+        // tickless idle, the LEDs keep their color and the touch sensor runs while the CPU sleeps
+        unsigned long getIdleDuration(); // ms until the Floower needs to run again, 0 when busy
+        bool lightSleep(unsigned long maxDuration); // until the next deadline (at most given ms) or a touch, false when not worth it
+
     private:
         bool setStepperPowerOn(bool powerOn);
         bool setPixelsPowerOn(bool powerOn);
 
         NeoPixelAnimator animations; // animation management object used for both servo and pixels to animate
         void pixelsTransitionAnimationUpdate(const AnimationParam& param);
-        void pixelsFlashAnimationUpdate(const AnimationParam& param);
-        void pixelsCircleAnimationUpdate(const AnimationParam& param);
-        void pixelsRainbowAnimationUpdate(const AnimationParam& param);
-        void pixelsRainbowLoopAnimationUpdate(const AnimationParam& param);
-        void pixelsCandleAnimationUpdate(const AnimationParam& param);
+        void playTimeline(const PixelsTimeline& timeline, const HsbColor& base, int duration, bool followColor);
+        void pixelsTimelineAnimationUpdate(const AnimationParam& param);
+        void nextCandleKeyframes();
+        void runChoreographyAction(const ChoreographyAction& action);
         void showColor(HsbColor color);
+        void showColor(const FixedHsbColor& color);
         void statusBlinkOnceAnimationUpdate(const AnimationParam& param);
         void statusPulsatingAnimationUpdate(const AnimationParam& param);
 
@@ -100,6 +122,7 @@ class Floower {
 
         // leds
         NeoPixelBus<NeoGrbFeature, NeoEsp32I2s0800KbpsMethod> pixels;
+        PixelsFrame pixelsFrame; // what the animations draw, gamma and brightness applied when shown
 
         // leds state
         HsbColor pixelsColor; // current color
@@ -109,22 +132,34 @@ class Floower {
 
         // leds animations
         bool interruptiblePixelsAnimation = false;
-        HsbColor candleOriginColors[6];
-        HsbColor candleTargetColors[6];
+        FixedHsbColor transitionOriginColor;
+        FixedHsbColor transitionTargetColor;
+        const PixelsTimeline *pixelsTimeline = nullptr;
+        FixedHsbColor pixelsTimelineBase;
+        bool pixelsTimelineColor = false; // pixel 0 of the timeline is the current color
+        PixelsKeyframe candleKeyframes[6][2]; // regenerated with every flicker
+        PixelsTrack candleTracks[7];
+        const PixelsTimeline candleTimeline;
+
+        // show uploaded by the user
+        Choreography choreography;
 
         // status LED
         HsbColor statusColor = colorBlack;
         NeoPixelBus<NeoGrbFeature, NeoEsp32I2s1800KbpsMethod> statusPixel;
 
         // touch
-        FloowerOnLeafTouchCallback touchCallback;
-        static unsigned long touchStartedTime;
-        static unsigned long touchEndedTime;
-        static unsigned long lastTouchTime;
-        bool touchRegistered = false;
-        bool holdTouchRegistered = false;
-        bool longTouchRegistered = false;
+        TouchGestures touchGestures;
+        static unsigned long lastTouchTime; // of the last touch interrupt
+        bool touchEnabled = false;
+        TouchBaseline touchBaseline;
+        uint8_t touchThreshold;
+        unsigned long touchBaselineTime = 0;
 
         // battery
+        Battery battery;
+        BatteryModel batteryModel;
         PowerState powerState;
+        bool wifiEnabled = false;
+        bool bluetoothEnabled = false;
 };
\ No newline at end of file
@@ -0,0 +1,288 @@
+#include "MotionPlanner.h"
+
+#define FIXED_POINT_ONE 256 // Q24.8
+#define MICROS_FIXED (1000000.0 * FIXED_POINT_ONE)
+#define SEARCH_ITERATIONS 40
+
+MotionPlanner::MotionPlanner(float acceleration, float jerk, float maxSpeed)
+        : acceleration(acceleration), jerk(jerk), maxSpeed(maxSpeed) {
+}
+
+bool MotionPlanner::plan(uint32_t steps, uint32_t durationMs, float startSpeed) {
+    this->steps = steps;
+    this->startSpeed = 0;
+    entryTable = rampIntervals;
+    if (steps == 0) {
+        speed = rampDuration = duration = 0;
+        rampSteps = entrySteps = cruiseInterval = rampDurationFixed = entryDurationFixed = 0;
+        return true;
+    }
+    if (startSpeed > 0 && getStopSteps(startSpeed) <= steps && rampDistance(startSpeed) + 1 <= MOTION_RAMP_MAX_STEPS) {
+        this->startSpeed = startSpeed;
+        return planFromSpeed(durationMs);
+    }
+
+    // fastest cruise speed with both ramps fitting into the movement and the ramp table
+    double low = 0;
+    double high = maxSpeed;
+    if (2 * rampDistance(high) > steps || rampDistance(high) + 1 > MOTION_RAMP_MAX_STEPS) {
+        for (uint8_t i = 0; i < SEARCH_ITERATIONS; i++) {
+            double mid = (low + high) / 2;
+            if (2 * rampDistance(mid) <= steps && rampDistance(mid) + 1 <= MOTION_RAMP_MAX_STEPS) {
+                low = mid;
+            }
+            else {
+                high = mid;
+            }
+        }
+        high = low;
+    }
+
+    // total time (steps / speed + ramp time) decreases with speed, find the speed landing on the duration
+    double targetTime = durationMs / 1000.0;
+    bool feasible = steps / high + rampTime(high) <= targetTime;
+    if (feasible) {
+        low = steps / targetTime; // too slow, ramps make it longer than the duration
+        for (uint8_t i = 0; i < SEARCH_ITERATIONS; i++) {
+            double mid = (low + high) / 2;
+            if (steps / mid + rampTime(mid) > targetTime) {
+                low = mid;
+            }
+            else {
+                high = mid;
+            }
+        }
+    }
+    speed = high;
+    rampDuration = rampTime(speed);
+    duration = steps / speed + rampDuration;
+
+    // ramp table, step times are rounded to fixed point first so the rounding does not accumulate
+    double distance = rampDistance(speed);
+    rampSteps = _min((uint32_t) ceil(distance), _min(steps, (uint32_t) MOTION_RAMP_MAX_STEPS));
+    uint64_t lastTime = 0;
+    for (uint32_t step = 1; step <= rampSteps; step++) {
+        double time;
+        if (step <= distance) {
+            time = rampTimeAt(step);
+        }
+        else if (step >= steps - distance) {
+            time = duration - rampTimeAt(steps - step); // both ramps overlap (triangular profile)
+        }
+        else {
+            time = rampDuration + (step - distance) / speed;
+        }
+        uint64_t fixedTime = llround(time * MICROS_FIXED);
+        rampIntervals[step - 1] = fixedTime - lastTime;
+        lastTime = fixedTime;
+    }
+    rampDurationFixed = lastTime;
+    cruiseInterval = llround(MICROS_FIXED / speed);
+    entrySteps = rampSteps;
+    entryDurationFixed = rampDurationFixed;
+
+    return feasible;
+}
+
+bool MotionPlanner::planFromSpeed(uint32_t durationMs) {
+    // fastest cruise speed with the entry and the deceleration ramps fitting next to each other
+    double low = startSpeed;
+    double high = maxSpeed;
+    if (!fitsEntry(high)) {
+        for (uint8_t i = 0; i < SEARCH_ITERATIONS; i++) {
+            double mid = (low + high) / 2;
+            if (fitsEntry(mid)) {
+                low = mid;
+            }
+            else {
+                high = mid;
+            }
+        }
+        high = low;
+    }
+
+    // entry ramp may slow down as well, speeds where it would not fit count as too slow
+    double targetTime = durationMs / 1000.0;
+    bool feasible = totalTime(high) <= targetTime;
+    if (feasible) {
+        low = 0;
+        for (uint8_t i = 0; i < SEARCH_ITERATIONS; i++) {
+            double mid = (low + high) / 2;
+            if (!fitsEntry(mid) || totalTime(mid) > targetTime) {
+                low = mid;
+            }
+            else {
+                high = mid;
+            }
+        }
+    }
+    speed = high;
+    rampDuration = rampTime(speed);
+    double entryDuration = entryTime(speed);
+    double entry = entryDistance(speed);
+    double distance = rampDistance(speed);
+    duration = totalTime(speed);
+
+    // entry ramp table, then cruise until the deceleration
+    entrySteps = ceil(entry);
+    uint64_t lastTime = 0;
+    double time = 0;
+    for (uint32_t step = 1; step <= entrySteps; step++) {
+        time = step <= entry ? entryTimeAt(step, time) : entryDuration + (step - entry) / speed;
+        uint64_t fixedTime = llround(time * MICROS_FIXED);
+        entryIntervals[step - 1] = fixedTime - lastTime;
+        lastTime = fixedTime;
+    }
+    entryDurationFixed = lastTime;
+    entryTable = entryIntervals;
+
+    // deceleration table counted back from the end, step 0 is the last one
+    rampSteps = ceil(distance);
+    lastTime = 0;
+    for (uint32_t step = 1; step <= rampSteps; step++) {
+        time = step <= distance ? rampTimeAt(step) : rampDuration + (step - distance) / speed;
+        uint64_t fixedTime = llround(time * MICROS_FIXED);
+        rampIntervals[step - 1] = fixedTime - lastTime;
+        lastTime = fixedTime;
+    }
+    rampDurationFixed = lastTime;
+    cruiseInterval = llround(MICROS_FIXED / speed);
+
+    return feasible;
+}
+
+StepSegment MotionPlanner::getSegment(uint32_t plannedSteps, uint16_t maxSteps) {
+    StepSegment segment = {};
+    uint32_t step = plannedSteps + 1;
+    if (step > steps) {
+        return segment; // all planned
+    }
+    if (step <= entrySteps) {
+        // acceleration
+        segment.steps = _min(entrySteps - plannedSteps, (uint32_t) maxSteps);
+        segment.intervals = &entryTable[step - 1];
+        segment.intervalsStep = 1;
+    }
+    else if (step <= steps - rampSteps) {
+        // cruise
+        segment.steps = _min(steps - rampSteps - plannedSteps, (uint32_t) maxSteps);
+        segment.interval = cruiseInterval;
+    }
+    else {
+        // deceleration, mirrored acceleration
+        segment.steps = _min(steps - plannedSteps, (uint32_t) maxSteps);
+        segment.intervals = &rampIntervals[steps - step];
+        segment.intervalsStep = -1;
+    }
+    return segment;
+}
+
+uint32_t MotionPlanner::getInterval(uint32_t step) {
+    if (step <= entrySteps) {
+        return entryTable[step - 1];
+    }
+    if (step > steps - rampSteps) {
+        return rampIntervals[steps - step];
+    }
+    return cruiseInterval;
+}
+
+uint32_t MotionPlanner::getSteps() {
+    return steps;
+}
+
+uint32_t MotionPlanner::getRampSteps() {
+    return rampSteps;
+}
+
+uint32_t MotionPlanner::getEntrySteps() {
+    return entrySteps;
+}
+
+uint32_t MotionPlanner::getStopSteps(float speed) {
+    return ceil(rampDistance(speed));
+}
+
+uint32_t MotionPlanner::getCruiseInterval() {
+    return cruiseInterval;
+}
+
+uint64_t MotionPlanner::getDuration() {
+    if (steps >= entrySteps + rampSteps) {
+        return entryDurationFixed + rampDurationFixed + (uint64_t) (steps - entrySteps - rampSteps) * cruiseInterval;
+    }
+    // ramps overlap (only when starting at rest), deceleration uses only the beginning of the table
+    uint64_t fixedDuration = rampDurationFixed;
+    for (uint32_t i = 0; i < steps - rampSteps; i++) {
+        fixedDuration += rampIntervals[i];
+    }
+    return fixedDuration;
+}
+
+double MotionPlanner::rampTime(double speed) {
+    if (jerk <= 0) {
+        return speed / acceleration;
+    }
+    // S-curve velocity follows smoothstep, peak acceleration is 1.5 v/t and peak jerk 6 v/t^2
+    return _max(1.5 * speed / acceleration, sqrt(6 * speed / jerk));
+}
+
+double MotionPlanner::rampDistance(double speed) {
+    return speed * rampTime(speed) / 2; // same for both profiles thanks to the symmetry
+}
+
+double MotionPlanner::rampTimeAt(double distance) {
+    // relative distance of the ramp up (0 - 0.5) to relative time (0 - 1)
+    double u = distance / (speed * rampDuration);
+    if (jerk <= 0) {
+        return rampDuration * sqrt(2 * u); // u = x^2 / 2
+    }
+    // u = x^3 - x^4 / 2, solved by Newton's method in float, last iteration in double for precision
+    float x = _min(cbrtf(u), 1.0f);
+    for (uint8_t i = 0; i < 3; i++) {
+        float derivative = 3 * x * x - 2 * x * x * x;
+        if (derivative <= 0) {
+            break;
+        }
+        x = constrain(x - (x * x * x - x * x * x * x / 2 - u) / derivative, 0.0f, 1.0f);
+    }
+    double precise = x;
+    double derivative = 3 * precise * precise - 2 * precise * precise * precise;
+    if (derivative > 0) {
+        precise -= (precise * precise * precise - precise * precise * precise * precise / 2 - u) / derivative;
+    }
+    return rampDuration * constrain(precise, 0.0, 1.0);
+}
+
+double MotionPlanner::entryTime(double speed) {
+    return rampTime(fabs(speed - startSpeed)); // same profile over the change of speed
+}
+
+double MotionPlanner::entryDistance(double speed) {
+    return (startSpeed + speed) * entryTime(speed) / 2;
+}
+
+double MotionPlanner::entryTimeAt(double distance, double time) {
+    // x(t) = v0 t + (v - v0) T S(t / T), solved by Newton's method from the time of the previous step,
+    // the derivative is the speed which never drops below the start or the cruise speed
+    double entryDuration = entryTime(speed);
+    double change = speed - startSpeed;
+    for (uint8_t i = 0; i < 4; i++) {
+        double x = time / entryDuration;
+        double position = jerk <= 0 ? x * x / 2 : x * x * x - x * x * x * x / 2;
+        double velocity = jerk <= 0 ? x : 3 * x * x - 2 * x * x * x;
+        time -= (startSpeed * time + change * entryDuration * position - distance) / (startSpeed + change * velocity);
+        time = constrain(time, 0.0, entryDuration);
+    }
+    return time;
+}
+
+bool MotionPlanner::fitsEntry(double speed) {
+    double entry = entryDistance(speed);
+    double distance = rampDistance(speed);
+    return ceil(entry) + ceil(distance) <= steps && entry + 1 <= MOTION_RAMP_MAX_STEPS && distance + 1 <= MOTION_RAMP_MAX_STEPS;
+}
+
+double MotionPlanner::totalTime(double speed) {
+    return entryTime(speed) + rampTime(speed) + (steps - entryDistance(speed) - rampDistance(speed)) / speed;
+}
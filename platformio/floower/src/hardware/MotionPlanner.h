@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Arduino.h"
+#include "hardware/StepGenerator.h"
+
+#define MOTION_RAMP_MAX_STEPS 2048 // size of the acceleration table, limits the cruise speed
+
+// Plans a movement with acceleration and deceleration ramps that takes the requested time.
+// Ramps are trapezoidal (constant acceleration) or S-curve (limited jerk) when jerk is set.
+// Per-step intervals of the ramp are precomputed into a table in Q24.8 fixed point (1/256us),
+// the deceleration ramp walks the same table backwards. A movement planned from a running start
+// gets its own entry ramp from the start speed to the cruise speed.
+class MotionPlanner {
+    public:
+        MotionPlanner(float acceleration, float jerk, float maxSpeed); // steps/s^2, steps/s^3 (0 for trapezoidal), steps/s
+
+        // returns false when the movement cannot be done in time, it is planned as fast as possible then;
+        // start speed (steps/s) is kept only when there are enough steps to stop (see getStopSteps)
+        bool plan(uint32_t steps, uint32_t durationMs, float startSpeed = 0);
+        // next segment of the plan for the step generator, direction is left to the caller
+        StepSegment getSegment(uint32_t plannedSteps, uint16_t maxSteps);
+
+        uint32_t getInterval(uint32_t step); // Q24.8 us before given step (1 - steps)
+        uint32_t getSteps();
+        uint32_t getRampSteps();
+        uint32_t getEntrySteps();
+        uint32_t getStopSteps(float speed); // shortest deceleration from the speed (steps/s) to standstill
+        uint32_t getCruiseInterval(); // Q24.8 us
+        uint64_t getDuration(); // Q24.8 us
+
+    private:
+        double rampTime(double speed);
+        double rampDistance(double speed);
+        double rampTimeAt(double distance); // time when the ramp up covered the distance
+        bool planFromSpeed(uint32_t durationMs);
+        double entryTime(double speed);
+        double entryDistance(double speed);
+        double entryTimeAt(double distance, double time); // time when the entry ramp covered the distance
+        bool fitsEntry(double speed);
+        double totalTime(double speed);
+
+        const float acceleration;
+        const float jerk;
+        const float maxSpeed;
+
+        uint32_t steps = 0;
+        double startSpeed = 0;
+        double speed = 0; // cruise speed
+        double rampDuration = 0;
+        double duration = 0;
+
+        uint32_t rampSteps = 0;
+        uint32_t cruiseInterval = 0;
+        uint64_t rampDurationFixed = 0; // sum of the ramp table
+        uint32_t rampIntervals[MOTION_RAMP_MAX_STEPS];
+
+        // acceleration, the ramp table itself when starting at rest
+        uint32_t entrySteps = 0;
+        uint64_t entryDurationFixed = 0;
+        const uint32_t *entryTable = rampIntervals;
+        uint32_t entryIntervals[MOTION_RAMP_MAX_STEPS]; // from the start speed to the cruise speed
+};
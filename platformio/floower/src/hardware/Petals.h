@@ -2,6 +2,8 @@
 
 #include "Arduino.h"
 #include "Config.h"
+#include "hardware/StepGenerator.h"
+#include "hardware/MotionPlanner.h"
 #include <tmc2300.h>
 #include <ESP32Servo.h>
 
@@ -14,6 +16,7 @@ class Petals {
         virtual int8_t getPetalsOpenLevel() = 0;
         virtual int8_t getCurrentPetalsOpenLevel() = 0;
         virtual bool arePetalsMoving() = 0;
+        virtual bool isIdle() = 0; // motor powered off and nothing left to do until the next move
         virtual bool setEnabled(bool enabled) = 0;
 };
 
@@ -27,27 +30,49 @@ class StepperPetals : public Petals {
         int8_t getPetalsOpenLevel();
         int8_t getCurrentPetalsOpenLevel();
         bool arePetalsMoving();
+        bool isIdle();
         bool setEnabled(bool enabled);
 
     private:
-        bool runStepper();
-        void detectStall();
+        void startMovement(int transitionTime);
+        void planSegments();
+        void startHoming(uint32_t maxSteps);
+        void planHomingSegments();
+        void updateHoming();
+        void finishHoming();
+        bool detectStall();
+        void checkDriverStatus();
+        void configureDriver();
 
         Config *config;
 
         // stepper config
         TMC2300 stepperDriver;
+        StepGenerator stepGenerator;
+        MotionPlanner motionPlanner;
 
         // stepper state
         int8_t petalsOpenLevel; // 0-100% (target angle in percentage)
         int8_t direction; // 1 CW, -1 CCW
         long targetSteps;
-        long currentSteps;
-        unsigned long lastStepTime;
-        unsigned long stepInterval;
+        uint32_t plannedSteps; // steps of the movement already queued
         bool enabled;
         bool initialized;
+
+        // homing state
+        bool homing = false; // running towards the closed end stop
+        bool homed = false; // position synced with the end stop since the last movement
+        long homingStart;
+        uint32_t homingSteps; // search limit
+        bool movePending = false; // level requested during homing or braking, applied once the petals stopped
+        int pendingTransitionTime;
+        uint8_t sgReadFailures;
+        bool sgPending = false; // SG_VALUE read in progress
+        bool stalled;
         unsigned long sgTimer = 0;
+        bool driverStatusPending = false;
+        bool driverReset = false; // GSTAT reported a reset, configuration has to be written again
+        unsigned long driverStatusTimer = 0;
 };
 
 class ServoPetals : public Petals {
@@ -60,6 +85,7 @@ class ServoPetals : public Petals {
         int8_t getPetalsOpenLevel();
         int8_t getCurrentPetalsOpenLevel();
         bool arePetalsMoving();
+        bool isIdle();
         bool setEnabled(bool enabled);
 
     private:
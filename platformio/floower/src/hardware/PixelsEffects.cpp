@@ -0,0 +1,63 @@
+#include "PixelsEffects.h"
+
+#define ALL_PIXELS 0x7F
+#define THIRD (PIXELS_TIMELINE_END / 3)
+#define SIXTH (PIXELS_TIMELINE_END / 6)
+
+// flash
+
+static const PixelsKeyframe flashKeyframes[] = {
+    {0, FixedHsbColor(0, 0, 0), PIXELS_EASE_CUBIC_IN_OUT}, // easing of the way back at the end of the loop
+    {PIXELS_TIMELINE_END / 2, FixedHsbColor(0, 0, FIXED_COLOR_ONE), PIXELS_EASE_CUBIC_IN_OUT}
+};
+static const PixelsTrack flashTracks[] = {
+    PIXELS_TRACK(ALL_PIXELS, PIXELS_TRACK_LOOP | PIXELS_TRACK_BASE_HUE | PIXELS_TRACK_BASE_SATURATION, 0, flashKeyframes)
+};
+const PixelsTimeline flashTimeline = PIXELS_TIMELINE(flashTracks);
+
+// circle
+
+static const PixelsKeyframe circleKeyframes[] = {
+    {0, FixedHsbColor(0, 0, FIXED_COLOR_ONE), PIXELS_EASE_STEP},
+    {SIXTH, FixedHsbColor(0, 0, FIXED_COLOR_ONE * 55 / 100), PIXELS_EASE_STEP},
+    {2 * SIXTH, FixedHsbColor(0, 0, FIXED_COLOR_ONE * 10 / 100), PIXELS_EASE_STEP},
+    {3 * SIXTH, FixedHsbColor(0, 0, 0), PIXELS_EASE_STEP}
+};
+static const PixelsKeyframe blackKeyframes[] = {
+    {0, FixedHsbColor(0, 0, 0), PIXELS_EASE_LINEAR}
+};
+#define CIRCLE_FLAGS (PIXELS_TRACK_LOOP | PIXELS_TRACK_BASE_HUE | PIXELS_TRACK_BASE_SATURATION)
+static const PixelsTrack circleTracks[] = {
+    PIXELS_TRACK(0x01, 0, 0, blackKeyframes),
+    PIXELS_TRACK(0x02, CIRCLE_FLAGS, 0, circleKeyframes),
+    PIXELS_TRACK(0x04, CIRCLE_FLAGS, PIXELS_TIMELINE_END - SIXTH, circleKeyframes),
+    PIXELS_TRACK(0x08, CIRCLE_FLAGS, PIXELS_TIMELINE_END - 2 * SIXTH, circleKeyframes),
+    PIXELS_TRACK(0x10, CIRCLE_FLAGS, PIXELS_TIMELINE_END - 3 * SIXTH, circleKeyframes),
+    PIXELS_TRACK(0x20, CIRCLE_FLAGS, PIXELS_TIMELINE_END - 4 * SIXTH, circleKeyframes),
+    PIXELS_TRACK(0x40, CIRCLE_FLAGS, PIXELS_TIMELINE_END - 5 * SIXTH, circleKeyframes)
+};
+const PixelsTimeline circleTimeline = PIXELS_TIMELINE(circleTracks);
+
+// rainbow
+
+static const PixelsKeyframe hueTurnKeyframes[] = { // hue 0 -> 1 in thirds to keep the blend going forward
+    {0, FixedHsbColor(0, FIXED_COLOR_ONE, FIXED_COLOR_ONE), PIXELS_EASE_LINEAR},
+    {THIRD, FixedHsbColor(FIXED_HUE_TURN / 3, FIXED_COLOR_ONE, FIXED_COLOR_ONE), PIXELS_EASE_LINEAR},
+    {2 * THIRD, FixedHsbColor(FIXED_HUE_TURN * 2 / 3, FIXED_COLOR_ONE, FIXED_COLOR_ONE), PIXELS_EASE_LINEAR}
+};
+static const PixelsTrack rainbowTracks[] = {
+    PIXELS_TRACK(ALL_PIXELS, PIXELS_TRACK_LOOP | PIXELS_TRACK_BASE_HUE | PIXELS_TRACK_BASE_BRIGHTNESS, 0, hueTurnKeyframes)
+};
+const PixelsTimeline rainbowTimeline = PIXELS_TIMELINE(rainbowTracks);
+
+// rainbow loop
+
+static const PixelsTrack rainbowLoopTracks[] = {
+    PIXELS_TRACK(0x03, PIXELS_TRACK_LOOP, 0, hueTurnKeyframes),
+    PIXELS_TRACK(0x04, PIXELS_TRACK_LOOP, SIXTH, hueTurnKeyframes),
+    PIXELS_TRACK(0x08, PIXELS_TRACK_LOOP, 2 * SIXTH, hueTurnKeyframes),
+    PIXELS_TRACK(0x10, PIXELS_TRACK_LOOP, 3 * SIXTH, hueTurnKeyframes),
+    PIXELS_TRACK(0x20, PIXELS_TRACK_LOOP, 4 * SIXTH, hueTurnKeyframes),
+    PIXELS_TRACK(0x40, PIXELS_TRACK_LOOP, 5 * SIXTH, hueTurnKeyframes)
+};
+const PixelsTimeline rainbowLoopTimeline = PIXELS_TIMELINE(rainbowLoopTracks);
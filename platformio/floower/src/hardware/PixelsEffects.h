@@ -0,0 +1,9 @@
+#pragma once
+
+#include "hardware/PixelsTimeline.h"
+
+// Effects of the petal pixels (pixel 0 is in the middle, 1 - 6 around), play at any duration
+extern const PixelsTimeline flashTimeline; // base color fades in and out
+extern const PixelsTimeline circleTimeline; // base color runs around with a fading tail
+extern const PixelsTimeline rainbowTimeline; // hue of the base color goes around the circle
+extern const PixelsTimeline rainbowLoopTimeline; // full rainbow spread around the pixels and spinning
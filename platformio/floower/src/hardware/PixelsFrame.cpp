@@ -0,0 +1,103 @@
+#include "PixelsFrame.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#define LOG_TAG ""
+#else
+#include "esp_log.h"
+static const char* LOG_TAG = "PixelsFrame";
+#endif
+
+PixelsFrame::PixelsFrame(uint16_t count) : count(count) {
+    colors = new RgbColor[count];
+    output = new RgbColor[count];
+    for (uint16_t i = 0; i < count; i++) {
+        colors[i] = output[i] = RgbColor(0);
+    }
+    setBrightness(100);
+    setFrameRate(PIXELS_DEFAULT_FRAME_RATE);
+}
+
+PixelsFrame::~PixelsFrame() {
+    delete[] colors;
+    delete[] output;
+}
+
+void PixelsFrame::setBrightness(uint8_t brightness) {
+    brightness = _min(brightness, 100);
+    if (this->brightness == brightness) {
+        return;
+    }
+    this->brightness = brightness;
+    dirty = true;
+
+    ESP_LOGD(LOG_TAG, "Gamma table for brightness %d%%", brightness);
+    double scale = 255.0 * brightness / 100.0;
+    for (uint16_t i = 0; i < 256; i++) {
+        table[i] = pow(i / 255.0, PIXELS_GAMMA) * scale + 0.5;
+    }
+}
+
+uint8_t PixelsFrame::getBrightness() {
+    return brightness;
+}
+
+unsigned long PixelsFrame::getTimeToNextFrame() {
+    unsigned long elapsed = micros() - lastFrameTime;
+    if (elapsed < frameInterval) {
+        return (frameInterval - elapsed) / 1000;
+    }
+    return dirty ? 0 : (frameInterval - elapsed % frameInterval) / 1000; // nothing to show, next slot on the frame grid
+}
+
+void PixelsFrame::setFrameRate(uint8_t fps) {
+    frameInterval = 1000000UL / _max(fps, 1);
+}
+
+void PixelsFrame::setPixelColor(uint16_t index, const RgbColor& color) {
+    if (index < count && colors[index] != color) {
+        colors[index] = color;
+        dirty = true;
+    }
+}
+
+RgbColor PixelsFrame::getPixelColor(uint16_t index) {
+    return index < count ? colors[index] : RgbColor(0);
+}
+
+void PixelsFrame::clearTo(const RgbColor& color) {
+    for (uint16_t i = 0; i < count; i++) {
+        if (colors[i] != color) {
+            colors[i] = color;
+            dirty = true;
+        }
+    }
+}
+
+bool PixelsFrame::isDirty() {
+    return dirty;
+}
+
+RgbColor PixelsFrame::toOutputColor(const RgbColor& color) {
+    return RgbColor(table[color.R], table[color.G], table[color.B]);
+}
+
+uint32_t PixelsFrame::getFramesShown() {
+    return framesShown;
+}
+
+uint32_t PixelsFrame::getFramesSkipped() {
+    return framesSkipped;
+}
+
+bool PixelsFrame::updateOutput() {
+    bool changed = false;
+    for (uint16_t i = 0; i < count; i++) {
+        RgbColor color = toOutputColor(colors[i]);
+        if (output[i] != color) {
+            output[i] = color;
+            changed = true;
+        }
+    }
+    return changed;
+}
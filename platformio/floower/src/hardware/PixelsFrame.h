@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Arduino.h"
+#include <NeoPixelBus.h>
+
+#define PIXELS_GAMMA 2.2 // perceived brightness of the LEDs is roughly a power of the PWM duty
+#define PIXELS_DEFAULT_FRAME_RATE 50 // fps, smooth for the eye and well within the I2S bandwidth
+
+// Petal LED colors as the animations draw them (linear in perceived brightness, full scale) kept
+// apart from the pixel bus. Gamma correction and the global brightness are one 256 entry lookup
+// table that is regenerated only when the brightness changes and applied in one pass over the
+// frame right before it is shown. Frames are governed by a target frame rate and a frame that
+// quantizes to the same output as the previous one is not sent to the strip at all.
+class PixelsFrame {
+    public:
+        PixelsFrame(uint16_t count);
+        ~PixelsFrame();
+
+        void setBrightness(uint8_t brightness); // 0 - 100%
+        uint8_t getBrightness();
+        void setFrameRate(uint8_t fps);
+
+        void setPixelColor(uint16_t index, const RgbColor& color);
+        RgbColor getPixelColor(uint16_t index);
+        void clearTo(const RgbColor& color);
+        bool isDirty();
+
+        RgbColor toOutputColor(const RgbColor& color);
+        unsigned long getTimeToNextFrame(); // ms until show() would send the next frame
+
+        // statistics
+        uint32_t getFramesShown();
+        uint32_t getFramesSkipped(); // changed frames that quantized to the previous output
+
+        // shows the corrected frame on the bus once the frame interval elapsed (immediately when forced),
+        // returns true when the strip was refreshed
+        template <typename T_BUS> bool show(T_BUS& bus, bool force = false) {
+            unsigned long now = micros();
+            if (!force && (!dirty || now - lastFrameTime < frameInterval || !bus.CanShow())) {
+                return false;
+            }
+            lastFrameTime = now;
+            dirty = false;
+            if (!updateOutput() && !force) {
+                framesSkipped++;
+                return false;
+            }
+            for (uint16_t i = 0; i < count; i++) {
+                bus.SetPixelColor(i, output[i]);
+            }
+            bus.Show();
+            framesShown++;
+            return true;
+        }
+
+    private:
+        bool updateOutput();
+
+        uint16_t count;
+        RgbColor *colors;
+        RgbColor *output; // last frame sent to the strip
+        bool dirty = true;
+        uint8_t brightness = 0xFF; // forces the table to be generated on first setBrightness()
+        uint8_t table[256];
+
+        unsigned long frameInterval;
+        unsigned long lastFrameTime = 0;
+        uint32_t framesShown = 0;
+        uint32_t framesSkipped = 0;
+};
@@ -0,0 +1,85 @@
+#include "PixelsTimeline.h"
+
+void PixelsTimeline::render(PixelsFrame& frame, const FixedHsbColor& base, uint16_t position) const {
+    for (uint8_t i = 0; i < tracksCount; i++) {
+        RgbColor color = evaluate(tracks[i], base, position).toRgbColor();
+        for (uint8_t pixel = 0, mask = tracks[i].pixels; mask != 0; pixel++, mask >>= 1) {
+            if (mask & 0x01) {
+                frame.setPixelColor(pixel, color);
+            }
+        }
+    }
+}
+
+FixedHsbColor PixelsTimeline::colorOf(uint8_t pixel, const FixedHsbColor& base, uint16_t position) const {
+    for (int8_t i = tracksCount - 1; i >= 0; i--) {
+        if (tracks[i].pixels & (1 << pixel)) {
+            return evaluate(tracks[i], base, position);
+        }
+    }
+    return FixedHsbColor();
+}
+
+FixedHsbColor PixelsTimeline::evaluate(const PixelsTrack& track, const FixedHsbColor& base, uint16_t position) {
+    const PixelsKeyframe *keyframes = track.keyframes;
+    uint8_t count = track.keyframesCount;
+    uint32_t at = position;
+    if (track.offset > 0) {
+        at = (at + track.offset) % PIXELS_TIMELINE_END;
+    }
+
+    // segment that contains the position, keyframe tables are tiny so linear search is fine
+    uint8_t next = 0;
+    while (next < count && keyframes[next].at <= at) {
+        next++;
+    }
+
+    FixedHsbColor color;
+    if (next == 0) {
+        color = keyframes[0].color; // before the first keyframe
+    }
+    else if (next == count && !(track.flags & PIXELS_TRACK_LOOP)) {
+        color = keyframes[count - 1].color; // after the last keyframe
+    }
+    else {
+        const PixelsKeyframe &from = keyframes[next - 1];
+        const PixelsKeyframe &to = keyframes[next % count]; // wraps to the first keyframe at the end
+        uint32_t toAt = next < count ? to.at : PIXELS_TIMELINE_END;
+        uint16_t progress = toAt > from.at ? (at - from.at) * FIXED_COLOR_ONE / (toAt - from.at) : FIXED_COLOR_ONE;
+        color = FixedHsbColor::LinearBlend(from.color, to.color, ease(to.easing, progress));
+    }
+
+    if (track.flags & PIXELS_TRACK_BASE_HUE) {
+        color.H += base.H;
+    }
+    if (track.flags & PIXELS_TRACK_BASE_SATURATION) {
+        color.S = base.S;
+    }
+    if (track.flags & PIXELS_TRACK_BASE_BRIGHTNESS) {
+        color.B = base.B;
+    }
+    return color;
+}
+
+uint16_t PixelsTimeline::ease(PixelsEasing easing, uint16_t progress) {
+    // same curves as NeoEase, integer in 0 - 65535
+    uint32_t x = progress;
+    switch (easing) {
+        case PIXELS_EASE_STEP:
+            return progress < FIXED_COLOR_ONE ? 0 : FIXED_COLOR_ONE;
+        case PIXELS_EASE_QUADRATIC_IN_OUT:
+            if (x < 32768) {
+                return (x * x) >> 15; // 2x^2
+            }
+            x = FIXED_COLOR_ONE - x;
+            return FIXED_COLOR_ONE - ((x * x) >> 15);
+        case PIXELS_EASE_CUBIC_IN_OUT:
+            if (x < 32768) {
+                return (((x * x) >> 16) * x) >> 14; // 4x^3
+            }
+            x = FIXED_COLOR_ONE - x;
+            return FIXED_COLOR_ONE - ((((x * x) >> 16) * x) >> 14);
+        default:
+            return progress;
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Arduino.h"
+#include "hardware/FixedColor.h"
+#include "hardware/PixelsFrame.h"
+
+#define PIXELS_TIMELINE_END 65535 // position of the end of the timeline, keyframes are placed in 0 - 65535
+
+// track flags
+#define PIXELS_TRACK_LOOP 0x01 // after the last keyframe blend back to the first one at the end (required for offset tracks)
+#define PIXELS_TRACK_BASE_HUE 0x02 // keyframe hue is added to the hue of the base color
+#define PIXELS_TRACK_BASE_SATURATION 0x04 // saturation of the base color is used instead of the keyframe one
+#define PIXELS_TRACK_BASE_BRIGHTNESS 0x08 // brightness of the base color is used instead of the keyframe one
+
+enum PixelsEasing : uint8_t {
+    PIXELS_EASE_LINEAR,
+    PIXELS_EASE_STEP, // hold the previous keyframe until this one is reached
+    PIXELS_EASE_QUADRATIC_IN_OUT,
+    PIXELS_EASE_CUBIC_IN_OUT
+};
+
+struct PixelsKeyframe {
+    uint16_t at; // 0 - PIXELS_TIMELINE_END
+    FixedHsbColor color;
+    PixelsEasing easing; // of the segment that leads to this keyframe (the first one eases the loop back)
+};
+
+struct PixelsTrack {
+    uint8_t pixels; // bit mask of the pixels the track draws
+    uint8_t flags;
+    uint16_t offset; // the track runs ahead by this position (0 - PIXELS_TIMELINE_END)
+    const PixelsKeyframe *keyframes; // sorted by position
+    uint8_t keyframesCount;
+};
+
+// Animation of the petal pixels as a table of per-pixel keyframe tracks, interpolated with easing
+// at any position of the timeline. Duration and looping are up to the player (the NeoPixelAnimator
+// in Floower), the same table plays at any speed. Later tracks overwrite earlier ones.
+struct PixelsTimeline {
+    const PixelsTrack *tracks;
+    uint8_t tracksCount;
+
+    void render(PixelsFrame& frame, const FixedHsbColor& base, uint16_t position) const;
+    FixedHsbColor colorOf(uint8_t pixel, const FixedHsbColor& base, uint16_t position) const;
+
+    static FixedHsbColor evaluate(const PixelsTrack& track, const FixedHsbColor& base, uint16_t position);
+    static uint16_t ease(PixelsEasing easing, uint16_t progress);
+};
+
+#define PIXELS_TIMELINE(tracks) PixelsTimeline{tracks, sizeof(tracks) / sizeof(tracks[0])}
+#define PIXELS_TRACK(pixels, flags, offset, keyframes) PixelsTrack{pixels, flags, offset, keyframes, sizeof(keyframes) / sizeof(keyframes[0])}
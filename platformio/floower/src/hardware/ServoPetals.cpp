@@ -113,6 +113,10 @@ bool ServoPetals::arePetalsMoving() {
     return servoAngle != servoTargetAngle;
 }
 
+bool ServoPetals::isIdle() {
+    return !enabled && !arePetalsMoving(); // the PWM does not run in light sleep
+}
+
 bool ServoPetals::setEnabled(bool enabled) {
     if (enabled && !this->enabled) {
         this->enabled = true;
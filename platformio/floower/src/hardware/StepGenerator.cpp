@@ -0,0 +1,131 @@
+#include "StepGenerator.h"
+
+#define STEP_PULSE_WIDTH 1 // us
+#define STEP_TIMER_DIVIDER 80 // 80MHz APB clock, 1us timer tick
+#define STEP_QUEUE_MASK (STEP_QUEUE_LENGTH - 1)
+
+StepGenerator *StepGenerator::instance = nullptr;
+
+StepGenerator::StepGenerator(uint8_t stepPin, uint8_t timerNum) : stepPin(stepPin), timerNum(timerNum) {
+}
+
+void StepGenerator::begin() {
+    pinMode(stepPin, OUTPUT);
+    digitalWrite(stepPin, LOW);
+
+    if (timer == nullptr) {
+        instance = this;
+        timer = timerBegin(timerNum, STEP_TIMER_DIVIDER, true);
+        timerAttachInterrupt(timer, StepGenerator::onTimer, true);
+    }
+}
+
+bool StepGenerator::push(StepSegment segment) {
+    if (segment.steps == 0) {
+        return true; // nothing to do
+    }
+    uint8_t nextHead = (queueHead + 1) & STEP_QUEUE_MASK;
+    if (nextHead == queueTail) {
+        return false;
+    }
+    queue[queueHead] = segment;
+    queueHead = nextHead; // publish to the interrupt
+
+    if (!running) {
+        startSegment();
+    }
+    return true;
+}
+
+bool StepGenerator::isFull() {
+    return ((queueHead + 1) & STEP_QUEUE_MASK) == queueTail;
+}
+
+bool StepGenerator::isRunning() {
+    return running;
+}
+
+void StepGenerator::stop() {
+    if (timer != nullptr) {
+        timerAlarmDisable(timer);
+    }
+    running = false;
+    queueTail = queueHead;
+    resumeTicks = 0;
+}
+
+uint32_t StepGenerator::clear() {
+    if (!running) {
+        return 0;
+    }
+    timerAlarmDisable(timer);
+    running = false;
+    queueTail = queueHead;
+    resumeTicks = timerRead(timer); // 1us ticks since the last step
+    return stepInterval;
+}
+
+long StepGenerator::getPosition() {
+    return position;
+}
+
+void StepGenerator::setPosition(long position) {
+    this->position = position;
+}
+
+void StepGenerator::startSegment() {
+    // timer is stopped, no interrupt can interfere
+    segmentSteps = queue[queueTail].steps;
+    segmentInterval = queue[queueTail].intervals;
+    periodFraction = 0;
+    running = true;
+    uint32_t period = nextPeriod();
+    timerWrite(timer, resumeTicks);
+    timerAlarmWrite(timer, _max(period, resumeTicks + 1), true); // alarm must stay ahead of the counter
+    timerAlarmEnable(timer);
+    resumeTicks = 0;
+}
+
+// timer ticks until the next step of the segment at the queue tail
+uint32_t IRAM_ATTR StepGenerator::nextPeriod() {
+    StepSegment &segment = queue[queueTail];
+    uint32_t interval = segment.interval;
+    if (segmentInterval != nullptr) {
+        interval = *segmentInterval;
+        segmentInterval += segment.intervalsStep;
+    }
+    stepInterval = interval;
+    interval += periodFraction;
+    periodFraction = interval & 0xFF;
+    return _max(interval >> 8, STEP_MIN_INTERVAL);
+}
+
+void IRAM_ATTR StepGenerator::onTimer() {
+    StepGenerator *generator = instance;
+    if (!generator->running) {
+        return;
+    }
+
+    // step
+    digitalWrite(generator->stepPin, HIGH);
+    // Caution 200ns setup time
+    // Delay the minimum allowed pulse width
+    delayMicroseconds(STEP_PULSE_WIDTH);
+    digitalWrite(generator->stepPin, LOW);
+    generator->position += generator->queue[generator->queueTail].direction;
+
+    if (--generator->segmentSteps == 0) {
+        uint8_t tail = (generator->queueTail + 1) & STEP_QUEUE_MASK;
+        generator->queueTail = tail;
+        if (tail == generator->queueHead) {
+            // queue drained
+            timerAlarmDisable(generator->timer);
+            generator->running = false;
+            return;
+        }
+        generator->segmentSteps = generator->queue[tail].steps;
+        generator->segmentInterval = generator->queue[tail].intervals;
+    }
+    // timer was reloaded already, the new alarm applies to the period just started
+    timerAlarmWrite(generator->timer, generator->nextPeriod(), true);
+}
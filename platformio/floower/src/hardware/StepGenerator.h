@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Arduino.h"
+
+#define STEP_QUEUE_LENGTH 8 // power of 2
+#define STEP_MIN_INTERVAL 50 // us, fastest step rate the timer interrupt can keep up with
+
+// run of steps, either at constant speed or following a table of intervals (ramps)
+struct StepSegment {
+    uint16_t steps;
+    uint32_t interval; // Q24.8 us between steps, used when there is no table
+    const uint32_t *intervals; // Q24.8 us before each step, nullptr for constant speed
+    int8_t intervalsStep; // walk the table forward (1) or backward (-1)
+    int8_t direction; // 1 CW, -1 CCW
+};
+
+// Generates STEP pulses from a hardware timer interrupt. The main loop keeps a small queue
+// of segments filled, pulse timing does not depend on how long the main loop takes.
+class StepGenerator {
+    public:
+        StepGenerator(uint8_t stepPin, uint8_t timerNum);
+        void begin();
+
+        bool push(StepSegment segment); // false when the queue is full
+        bool isFull();
+        bool isRunning();
+        void stop(); // stop immediately and drop all queued segments
+        // drop all queued segments but keep the timing of the step in progress, the next pushed segment continues
+        // from it; returns the interval of the step in progress (Q24.8 us), 0 when not running
+        uint32_t clear();
+
+        long getPosition();
+        void setPosition(long position);
+
+    private:
+        void startSegment();
+        uint32_t nextPeriod();
+        static void onTimer();
+
+        const uint8_t stepPin;
+        const uint8_t timerNum;
+        hw_timer_t *timer = nullptr;
+
+        StepSegment queue[STEP_QUEUE_LENGTH];
+        volatile uint8_t queueHead = 0; // written by main loop
+        volatile uint8_t queueTail = 0; // written by interrupt
+        volatile uint16_t segmentSteps = 0; // steps left in the segment at the queue tail
+        const uint32_t *segmentInterval = nullptr; // table entry of the next step
+        uint8_t periodFraction = 0; // carried over 1/256us so fixed point intervals do not drift
+        volatile uint32_t stepInterval = 0; // Q24.8 us of the step in progress
+        uint32_t resumeTicks = 0; // time since the last step when the queue was cleared
+        volatile bool running = false;
+        volatile long position = 0;
+
+        static StepGenerator *instance; // interrupt target
+};
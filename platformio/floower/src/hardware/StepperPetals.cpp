@@ -18,13 +18,29 @@ static const char* LOG_TAG = "StepperPetals";
 #define TMC_MICROSTEPS 32
 #define TMC_OPEN_STEPS 30000
 
-#define TMC_MIN_PULSE_WIDTH 1
+#define STEP_TIMER_NUM 0
+#define STEP_SEGMENT_MAX_STEPS 100 // split movement to segments to keep the step queue short
+
+#define MOTION_ACCELERATION 100000 // steps/s^2
+#define MOTION_JERK 2000000 // steps/s^3, 0 for trapezoidal profile
+#define MOTION_MAX_SPEED (1000000 / STEP_MIN_INTERVAL) // steps/s
+
 #define DIRECTION_CW 1
 #define DIRECTION_CCW -1
 
-//#define STALLGUARD_SAMPLING_PERIOD 50
+#define HOMING_INTERVAL (200 * 256) // Q24.8 us, StallGuard needs a steady speed
+#define HOMING_MARGIN_STEPS 1000 // how far behind the expected closed position to search for the end stop
+#define HOMING_BLANK_STEPS 100 // StallGuard readings are not valid until the motor runs steadily
+#define STALLGUARD_THRESHOLD 40 // stall when SG_VALUE <= 2 * threshold
+#define STALLGUARD_TCOOLTHRS 0xFFFFF // StallGuard active at any speed
+#define STALLGUARD_SAMPLING_PERIOD 10 // ms
+#define DRIVER_STATUS_PERIOD 500 // ms, DRV_STATUS polling while the motor is running
+#define STALLGUARD_MAX_READ_FAILURES 3 // driver does not answer, continue homing blindly
+#define GSTAT_CLEAR 0b111 // write 1 to clear reset, drv_err and u3v5
 
-StepperPetals::StepperPetals(Config *config) : config(config), stepperDriver(&Serial1, TMC_R_SENSE, TMC_DRIVER_ADDRESS) {
+StepperPetals::StepperPetals(Config *config) 
+        : config(config), stepperDriver(&Serial1, TMC_R_SENSE, TMC_DRIVER_ADDRESS), stepGenerator(TMC_STEP_PIN, STEP_TIMER_NUM),
+        motionPlanner(MOTION_ACCELERATION, MOTION_JERK, MOTION_MAX_SPEED) {
     Serial1.begin(500000, SERIAL_8N1, TMC_UART_RX_PIN, TMC_UART_TX_PIN);
     initialized = false;
     petalsOpenLevel = 0; // 0-100%
@@ -36,17 +52,14 @@ void StepperPetals::init(bool initial, bool wokeUp) {
     setEnabled(true); // it will be auto-disabled in update method
     pinMode(TMC_EN_PIN, OUTPUT);
 
-    currentSteps = 0;
+    stepGenerator.begin();
+    stepGenerator.setPosition(0);
+    plannedSteps = 0;
     targetSteps = 0;
-    stepInterval = 200; // default speed
-    lastStepTime = 0;
-    pinMode(TMC_STEP_PIN, OUTPUT);
-    digitalWrite(TMC_STEP_PIN, LOW);
-
-    if (initial && !wokeUp) {
-        // make sure the Floower is closed for the first time it's turned on
-        currentSteps = 0; // TODO
-    }
+    motionPlanner.plan(0, 0);
+    homing = false;
+    homed = !initial;
+    movePending = false;
 
     direction = DIRECTION_CCW; // default is closing
     pinMode(TMC_DIR_PIN, OUTPUT);
@@ -62,33 +75,65 @@ void StepperPetals::init(bool initial, bool wokeUp) {
         (void)iont; // to disable unused variable warning
         ESP_LOGI(LOG_TAG, "TMC2300: v=%d", iont.version);
 
-        REG_CHOPCONF chopconf = stepperDriver.readChopconf();
-        chopconf.setMicrosteps(TMC_MICROSTEPS);
-        chopconf.diss2vs = true; // HOTFIX
-        chopconf.diss2g = true; // HOTFIX
-        stepperDriver.writeChopconfReg(chopconf);
-
-        REG_IHOLD_IRUN iholdIrun;
-        iholdIrun.irun = 31;
-        iholdIrun.ihold = 1;
-        iholdIrun.iholddelay = 1;
-        stepperDriver.writeIholdIrunReg(iholdIrun);
-
+        configureDriver();
         initialized = true;
     }
+
+    if (initial) {
+        // position is lost after power on and deep sleep, find the closed end stop from wherever the petals are
+        startHoming(TMC_OPEN_STEPS + HOMING_MARGIN_STEPS);
+    }
 }
 
 void StepperPetals::update() {
-    if (currentSteps != targetSteps) {
-        runStepper();
-        //detectStall();
+    stepperDriver.update(); // background UART transactions
+    if (driverReset) {
+        // registers are back at their defaults, the cached configuration is not in the driver anymore
+        driverReset = false;
+        stepperDriver.invalidateShadow();
+        configureDriver();
+    }
+    if (enabled) {
+        checkDriverStatus();
+    }
+
+    if (homing) {
+        updateHoming();
+    }
+    else if (movePending && plannedSteps >= motionPlanner.getSteps() && !stepGenerator.isRunning()) {
+        startMovement(pendingTransitionTime); // stopped after braking
+    }
+    else if (arePetalsMoving()) {
+        planSegments();
+    }
+    else if (targetSteps == 0 && petalsOpenLevel <= 0 && !homed) {
+        // closed, verify by running into the end stop
+        startHoming(HOMING_MARGIN_STEPS);
     }
     else if (enabled) {
         setEnabled(false);
-        sgTimer = 0;
     }
 }
 
+void StepperPetals::configureDriver() {
+    REG_CHOPCONF chopconf = stepperDriver.readChopconf();
+    chopconf.setMicrosteps(TMC_MICROSTEPS);
+    chopconf.diss2vs = true; // HOTFIX
+    chopconf.diss2g = true; // HOTFIX
+    stepperDriver.writeChopconfReg(chopconf);
+
+    REG_IHOLD_IRUN iholdIrun;
+    iholdIrun.irun = 31;
+    iholdIrun.ihold = 1;
+    iholdIrun.iholddelay = 1;
+    stepperDriver.writeIholdIrunReg(iholdIrun);
+
+    stepperDriver.writeTCoolThrs(STALLGUARD_TCOOLTHRS);
+    stepperDriver.writeSGThrs(STALLGUARD_THRESHOLD);
+    stepperDriver.writeAsync(REG_GSTAT::address, GSTAT_CLEAR); // flags are set again by the next reset
+    stepperDriver.flush(); // all configuration in one burst, sent in the background
+}
+
 void StepperPetals::setPetalsOpenLevel(int8_t level, int transitionTime) {
     ESP_LOGI(LOG_TAG, "Petals %d%%->%d%%", petalsOpenLevel, level);
 /*
@@ -119,31 +164,57 @@ void StepperPetals::setPetalsOpenLevel(int8_t level, int transitionTime) {
     }
     petalsOpenLevel = level;
 
-    if (level >= 100) {
+    if (homing) {
+        // position is unknown until the end stop is found, move from the synced origin afterwards
+        movePending = true;
+        pendingTransitionTime = transitionTime;
+        return;
+    }
+    startMovement(transitionTime);
+}
+
+void StepperPetals::startMovement(int transitionTime) {
+    // replace the rest of the current movement, new one starts from where and how fast the petals are moving now
+    uint32_t interval = stepGenerator.clear();
+    float speed = interval > 0 ? 256000000.0f / interval : 0; // steps/s
+    movePending = false;
+    homed = false;
+    long currentSteps = stepGenerator.getPosition();
+
+    if (petalsOpenLevel >= 100) {
         targetSteps = TMC_OPEN_STEPS;
     }
-    else if (level <= 0) {
-        currentSteps += 1000; // TODO: make sure the petals will close completelly
-        targetSteps = 0;
+    else if (petalsOpenLevel <= 0) {
+        targetSteps = 0; // end stop is found by homing once closed
     }
     else {
-        targetSteps = level * TMC_OPEN_STEPS / 100;
+        targetSteps = petalsOpenLevel * TMC_OPEN_STEPS / 100;
+    }
+
+    int8_t targetDirection = targetSteps >= currentSteps ? DIRECTION_CW : DIRECTION_CCW;
+    if (speed > 0 && (targetDirection != direction || abs(targetSteps - currentSteps) < motionPlanner.getStopSteps(speed))) {
+        // turning around or too close to stop, brake to standstill first and plan the rest from there
+        motionPlanner.plan(motionPlanner.getStopSteps(speed), 0, speed);
+        movePending = true;
+        pendingTransitionTime = transitionTime;
+        plannedSteps = 0;
+        planSegments();
+        return;
     }
 
-    // calculate the speed
-    float stepsToTake = abs(targetSteps - currentSteps);
-    float stepsPerMs = stepsToTake / transitionTime;
-    stepInterval = fabs(1000.0 / stepsPerMs);
+    // plan the acceleration (from the current speed), cruise and deceleration
+    if (!motionPlanner.plan(abs(targetSteps - currentSteps), _max(transitionTime, 0), speed)) {
+        ESP_LOGW(LOG_TAG, "Movement too fast, takes %lums", (unsigned long) (motionPlanner.getDuration() / 256000));
+    }
 
-    // set direction upfront
-    direction = targetSteps >= currentSteps ? DIRECTION_CW : DIRECTION_CCW;
+    // set direction upfront, it changes only from standstill
+    direction = targetDirection;
     digitalWrite(TMC_DIR_PIN, direction == DIRECTION_CW ? LOW : HIGH);
     
     // enable
     setEnabled(true);
-#ifdef STALLGUARD_SAMPLING_PERIOD
-    sgTimer = millis() + STALLGUARD_SAMPLING_PERIOD;
-#endif
+    plannedSteps = 0;
+    planSegments();
 }
 
 int8_t StepperPetals::getPetalsOpenLevel() {
@@ -151,6 +222,7 @@ int8_t StepperPetals::getPetalsOpenLevel() {
 }
 
 int8_t StepperPetals::getCurrentPetalsOpenLevel() {
+    long currentSteps = stepGenerator.getPosition();
     if (currentSteps != targetSteps) {
         return (currentSteps / TMC_OPEN_STEPS) * 100;
     }
@@ -159,7 +231,12 @@ int8_t StepperPetals::getCurrentPetalsOpenLevel() {
 }
 
 bool StepperPetals::arePetalsMoving() {
-    return currentSteps != targetSteps;
+    return homing || movePending || stepGenerator.isRunning() || stepGenerator.getPosition() != targetSteps;
+}
+
+bool StepperPetals::isIdle() {
+    // closed but not homed yet would start homing with the next update
+    return !enabled && !arePetalsMoving() && !stepperDriver.isBusy() && (homed || targetSteps != 0 || petalsOpenLevel > 0);
 }
 
 bool StepperPetals::setEnabled(bool enabled) {
@@ -171,6 +248,7 @@ bool StepperPetals::setEnabled(bool enabled) {
     }
     if (!enabled && this->enabled) {
         this->enabled = false;
+        stepGenerator.stop(); // no pulses into disabled driver, position would be lost
         ESP_LOGI(LOG_TAG, "Stepper disabled");
         digitalWrite(TMC_EN_PIN, LOW);
         return true;
@@ -178,37 +256,122 @@ bool StepperPetals::setEnabled(bool enabled) {
     return false; // no change
 }
 
-bool StepperPetals::runStepper() {
-    if (stepInterval <= 0) {
-	    return false;
+void StepperPetals::planSegments() {
+    // keep the step queue filled, the timer interrupt generates the pulses
+    while (plannedSteps < motionPlanner.getSteps() && !stepGenerator.isFull()) {
+        StepSegment segment = motionPlanner.getSegment(plannedSteps, STEP_SEGMENT_MAX_STEPS);
+        segment.direction = direction;
+        stepGenerator.push(segment);
+        plannedSteps += segment.steps;
     }
+}
 
-    unsigned long time = micros();
-    if (time - lastStepTime >= stepInterval) {
-        currentSteps += direction;
-        //Serial.println(currentSteps);
+void StepperPetals::startHoming(uint32_t maxSteps) {
+    ESP_LOGI(LOG_TAG, "Homing");
+    homing = true;
+    homingStart = stepGenerator.getPosition();
+    homingSteps = maxSteps;
+    plannedSteps = 0;
+    sgReadFailures = 0;
+    sgTimer = millis();
+    stalled = false;
 
-        // step
-        digitalWrite(TMC_STEP_PIN, HIGH);
-        // Caution 200ns setup time 
-        // Delay the minimum allowed pulse width
-        delayMicroseconds(TMC_MIN_PULSE_WIDTH);
-        digitalWrite(TMC_STEP_PIN, LOW);
+    direction = DIRECTION_CCW;
+    digitalWrite(TMC_DIR_PIN, HIGH);
+    setEnabled(true);
+    planHomingSegments();
+}
 
-	    lastStepTime = time; // Caution: does not account for costs in step()
-	    return true;
+void StepperPetals::planHomingSegments() {
+    // constant speed towards the closed end stop until stall or the search limit
+    while (plannedSteps < homingSteps && !stepGenerator.isFull()) {
+        StepSegment segment = {};
+        segment.steps = _min(homingSteps - plannedSteps, (uint32_t) STEP_SEGMENT_MAX_STEPS);
+        segment.interval = HOMING_INTERVAL;
+        segment.direction = direction;
+        stepGenerator.push(segment);
+        plannedSteps += segment.steps;
     }
-	return false;
 }
 
-void StepperPetals::detectStall() {
-#ifdef STALLGUARD_SAMPLING_PERIOD
-    if (sgTimer > 0 && sgTimer < millis()) {
-        uint8_t sgValue = stepperDriver.readSGValue();
-        Serial.print("sgValue=");
-        Serial.println(sgValue);
-        sgTimer = millis() + STALLGUARD_SAMPLING_PERIOD;
+void StepperPetals::updateHoming() {
+    if (detectStall()) {
+        ESP_LOGI(LOG_TAG, "End stop found after %ld steps", homingStart - stepGenerator.getPosition());
+        finishHoming();
     }
-#endif
-    // also check error conditions
-}
\ No newline at end of file
+    else if (plannedSteps >= homingSteps && !stepGenerator.isRunning()) {
+        ESP_LOGW(LOG_TAG, "End stop not found, assuming closed");
+        finishHoming();
+    }
+    else {
+        planHomingSegments();
+    }
+}
+
+void StepperPetals::finishHoming() {
+    // closed end stop is the origin
+    stepGenerator.stop();
+    stepGenerator.setPosition(0);
+    targetSteps = 0;
+    homing = false;
+    homed = true;
+
+    if (movePending) {
+        movePending = false;
+        startMovement(pendingTransitionTime);
+    }
+}
+
+bool StepperPetals::detectStall() {
+    // sample SG_VALUE in the background, the result arrives in one of the next updates
+    if (!sgPending && millis() - sgTimer >= STALLGUARD_SAMPLING_PERIOD) {
+        sgPending = stepperDriver.readSGValueAsync([=](bool success, uint16_t sgValue) {
+            sgPending = false;
+            sgTimer = millis();
+            if (!homing) {
+                return; // finished meanwhile
+            }
+            if (!success) {
+                if (++sgReadFailures == STALLGUARD_MAX_READ_FAILURES) {
+                    // no StallGuard, fall back to a blind overshoot that grinds the petals closed
+                    ESP_LOGE(LOG_TAG, "StallGuard not available");
+                    homingSteps = _min(homingSteps, (uint32_t) HOMING_MARGIN_STEPS);
+                }
+                return;
+            }
+            sgReadFailures = 0;
+            ESP_LOGD(LOG_TAG, "SG=%d", sgValue);
+            if (homingStart - stepGenerator.getPosition() >= HOMING_BLANK_STEPS) {
+                stalled = sgValue <= 2 * STALLGUARD_THRESHOLD;
+            }
+        });
+    }
+    return stalled;
+}
+
+void StepperPetals::checkDriverStatus() {
+    if (driverStatusPending || millis() - driverStatusTimer < DRIVER_STATUS_PERIOD) {
+        return;
+    }
+    driverStatusPending = stepperDriver.readDrvStatusAsync([=](bool success, REG_DRV_STATUS drvStatus) {
+        driverStatusPending = false;
+        driverStatusTimer = millis();
+        if (!success) {
+            return;
+        }
+        if (drvStatus.ot || drvStatus.s2ga || drvStatus.s2gb || drvStatus.s2vsa || drvStatus.s2vsb) {
+            ESP_LOGE(LOG_TAG, "TMC2300 shut down: ot=%d s2g=%d%d s2vs=%d%d", drvStatus.ot, drvStatus.s2ga, drvStatus.s2gb, drvStatus.s2vsa, drvStatus.s2vsb);
+        }
+        else if (drvStatus.otpw) {
+            ESP_LOGW(LOG_TAG, "TMC2300 overtemperature warning");
+        }
+    });
+    if (driverStatusPending) {
+        stepperDriver.readGStatAsync([=](bool success, REG_GSTAT gstat) {
+            if (success && (gstat.reset || gstat.u3v5)) {
+                ESP_LOGW(LOG_TAG, "TMC2300 reset: reset=%d uv=%d", gstat.reset, gstat.u3v5);
+                driverReset = true; // configured again by the next update
+            }
+        });
+    }
+}
@@ -0,0 +1,57 @@
+#include "TouchBaseline.h"
+
+#define FIXED_POINT_ONE 256 // Q24.8
+
+void TouchBaseline::reset(uint16_t baseline) {
+    this->baseline = (uint32_t) baseline * FIXED_POINT_ONE;
+    noise = 0;
+    stuckSamples = 0;
+    updateThreshold(true);
+}
+
+bool TouchBaseline::update(uint16_t value) {
+    sampleCount++;
+    if (value < threshold) {
+        // finger on the leaf or the reading dropped for good
+        if (++stuckSamples < TOUCH_STUCK_SAMPLES) {
+            return false;
+        }
+        reset(value);
+        return true;
+    }
+    stuckSamples = 0;
+
+    int32_t sample = (int32_t) value * FIXED_POINT_ONE;
+    int32_t deviation = abs(sample - (int32_t) baseline);
+    noise += (deviation - (int32_t) noise) / TOUCH_NOISE_WEIGHT;
+    baseline += (sample - (int32_t) baseline) / TOUCH_BASELINE_WEIGHT;
+    return updateThreshold(false);
+}
+
+uint16_t TouchBaseline::getBaseline() {
+    return (baseline + FIXED_POINT_ONE / 2) / FIXED_POINT_ONE;
+}
+
+uint16_t TouchBaseline::getNoise() {
+    return (noise + FIXED_POINT_ONE / 2) / FIXED_POINT_ONE;
+}
+
+uint16_t TouchBaseline::getThreshold() {
+    return threshold;
+}
+
+uint32_t TouchBaseline::getSampleCount() {
+    return sampleCount;
+}
+
+bool TouchBaseline::updateThreshold(bool force) {
+    uint16_t value = getBaseline();
+    uint16_t margin = (TOUCH_NOISE_FACTOR * noise + FIXED_POINT_ONE / 2) / FIXED_POINT_ONE;
+    margin = _min(_max(margin, TOUCH_MIN_MARGIN), value / TOUCH_MAX_MARGIN_DIVIDER);
+    uint16_t newThreshold = value - margin;
+    if (!force && abs((int32_t) newThreshold - (int32_t) threshold) < TOUCH_THRESHOLD_HYSTERESIS) {
+        return false;
+    }
+    threshold = newThreshold;
+    return true;
+}
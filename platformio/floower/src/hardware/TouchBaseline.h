@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Arduino.h"
+
+#define TOUCH_BASELINE_WEIGHT 16 // every sample moves the baseline by 1/16 of its difference
+#define TOUCH_NOISE_WEIGHT 8
+#define TOUCH_NOISE_FACTOR 4 // the threshold sits this many mean deviations below the baseline
+#define TOUCH_MIN_MARGIN 5 // same as the factory calibration
+#define TOUCH_MAX_MARGIN_DIVIDER 3 // a finger drops the reading by more than a third
+#define TOUCH_THRESHOLD_HYSTERESIS 2 // do not reattach the interrupt for every small change
+#define TOUCH_STUCK_SAMPLES 60 // consecutive samples below the threshold are drift, not a finger
+
+// Tracks the untouched reading of the touch sensor and its noise to keep the touch threshold
+// right while humidity and temperature drift. Samples below the threshold (finger on the leaf)
+// are ignored unless they stay there for too long, then the baseline starts over from them.
+// Baseline and noise are exponential moving averages in Q24.8 fixed point.
+class TouchBaseline {
+    public:
+        void reset(uint16_t baseline);
+        bool update(uint16_t value); // returns true when the threshold changed
+
+        uint16_t getBaseline();
+        uint16_t getNoise(); // mean absolute deviation from the baseline
+        uint16_t getThreshold(); // touched below this value
+        uint32_t getSampleCount();
+
+    private:
+        bool updateThreshold(bool force);
+
+        uint32_t baseline = 0; // Q24.8
+        uint32_t noise = 0; // Q24.8
+        uint16_t threshold = 0;
+        uint16_t stuckSamples = 0;
+        uint32_t sampleCount = 0;
+};
@@ -0,0 +1,130 @@
+#include "TouchGestures.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#define LOG_TAG ""
+#else
+#include "esp_log.h"
+static const char* LOG_TAG = "TouchGestures";
+#endif
+
+TouchGestures::TouchGestures(Config *config) : config(config) {
+}
+
+void TouchGestures::onGesture(FloowerOnLeafTouchCallback callback) {
+    this->callback = callback;
+}
+
+void TouchGestures::update(unsigned long now, unsigned long lastTouchTime) {
+    bool touched = lastTouchTime > 0 && lastTouchTime >= ignoredTime && now - lastTouchTime <= config->touchFadeTime;
+
+    if (!touching) {
+        if (touched) {
+            touching = true;
+            touchStartedTime = lastTouchTime;
+            touchDuration = 0;
+            longRegistered = false;
+            holdRegistered = false;
+            taps = (tapEndedTime > 0 && touchStartedTime - tapEndedTime <= config->touchMultiTapTime) ? taps + 1 : 1;
+            record(touchStartedTime, true);
+
+            ESP_LOGI(LOG_TAG, "Touch Down %d", taps);
+            fire(FloowerTouchEvent::TOUCH_DOWN);
+            if (taps == 2) {
+                fire(FloowerTouchEvent::TOUCH_DOUBLE_TAP);
+            }
+            else if (taps == 3) {
+                fire(FloowerTouchEvent::TOUCH_TRIPLE_TAP);
+            }
+        }
+        return;
+    }
+
+    if (!touched) {
+        touching = false;
+        touchDuration = lastTouchTime - touchStartedTime;
+        tapEndedTime = touchDuration <= config->touchTapTime ? lastTouchTime : 0;
+        record(lastTouchTime, false);
+
+        ESP_LOGI(LOG_TAG, "Touch Up %lu", touchDuration);
+        fire(FloowerTouchEvent::TOUCH_UP);
+        return;
+    }
+
+    touchDuration = now - touchStartedTime;
+    if (!longRegistered && touchDuration > config->touchLongTime) {
+        ESP_LOGI(LOG_TAG, "Long Touch %lu", touchDuration);
+        longRegistered = true;
+        fire(FloowerTouchEvent::TOUCH_LONG);
+    }
+    if (!holdRegistered && touchDuration > config->touchHoldTime) {
+        ESP_LOGI(LOG_TAG, "Hold Touch %lu", touchDuration);
+        holdRegistered = true;
+        fire(FloowerTouchEvent::TOUCH_HOLD);
+    }
+}
+
+void TouchGestures::ignoreUntil(unsigned long time) {
+    ignoredTime = time;
+}
+
+void TouchGestures::reset() {
+    touching = false;
+    touchStartedTime = touchDuration = tapEndedTime = ignoredTime = 0;
+    taps = 0;
+    timelineHead = timelineCount = 0;
+}
+
+bool TouchGestures::isTouching() {
+    return touching;
+}
+
+unsigned long TouchGestures::getTouchDuration() {
+    return touchDuration;
+}
+
+uint8_t TouchGestures::getTapCount() {
+    return taps;
+}
+
+uint8_t TouchGestures::getTimeline(TouchEdge *edges) {
+    uint8_t first = (timelineHead + TOUCH_TIMELINE_LENGTH - timelineCount) % TOUCH_TIMELINE_LENGTH;
+    for (uint8_t i = 0; i < timelineCount; i++) {
+        edges[i] = timeline[(first + i) % TOUCH_TIMELINE_LENGTH];
+    }
+    return timelineCount;
+}
+
+void TouchGestures::replay(const TouchEdge *edges, uint8_t count, unsigned long until) {
+    reset();
+    if (count == 0) {
+        return;
+    }
+    // regenerate the interrupts the edges were recognized from
+    bool touched = false;
+    unsigned long lastTouchTime = 0;
+    uint8_t next = 0;
+    for (unsigned long now = edges[0].time; now <= until; now++) {
+        while (next < count && edges[next].time <= now) {
+            touched = edges[next].touched;
+            lastTouchTime = edges[next].time; // release is recorded at the last interrupt
+            next++;
+        }
+        if (touched && now - lastTouchTime >= TOUCH_REPLAY_INTERRUPT_INTERVAL) {
+            lastTouchTime = now;
+        }
+        update(now, lastTouchTime);
+    }
+}
+
+void TouchGestures::fire(FloowerTouchEvent event) {
+    if (callback != nullptr) {
+        callback(event);
+    }
+}
+
+void TouchGestures::record(unsigned long time, bool touched) {
+    timeline[timelineHead] = {(uint32_t) time, touched};
+    timelineHead = (timelineHead + 1) % TOUCH_TIMELINE_LENGTH;
+    timelineCount = _min(timelineCount + 1, TOUCH_TIMELINE_LENGTH);
+}
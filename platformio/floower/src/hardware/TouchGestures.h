@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Arduino.h"
+#include "Config.h"
+#include <functional>
+
+#define TOUCH_TIMELINE_LENGTH 32 // edges kept for replay
+#define TOUCH_REPLAY_INTERRUPT_INTERVAL 10 // ms, the touch interrupt keeps firing while the leaf is touched
+
+enum FloowerTouchEvent {
+    TOUCH_DOWN,
+    TOUCH_LONG, // >2s
+    TOUCH_HOLD, // >5s
+    TOUCH_UP, // getTouchDuration() tells how long the leaf was held
+    TOUCH_DOUBLE_TAP, // right after the second TOUCH_DOWN
+    TOUCH_TRIPLE_TAP // right after the third TOUCH_DOWN
+};
+
+// touch or release seen by the recognizer
+struct TouchEdge {
+    uint32_t time;
+    bool touched;
+};
+
+typedef std::function<void(const FloowerTouchEvent& event)> FloowerOnLeafTouchCallback;
+
+// Turns the times of the touch interrupt into gestures. The touch ends when the interrupt stays
+// quiet for the fade time, a touch shorter than the tap time starting within the multi tap time
+// after the previous tap counts as the next tap. All the thresholds are taken from the Config.
+// The last edges are recorded so a misrecognized gesture can be read out and replayed on host.
+class TouchGestures {
+    public:
+        TouchGestures(Config *config);
+        void onGesture(FloowerOnLeafTouchCallback callback);
+        void update(unsigned long now, unsigned long lastTouchTime); // time of the last touch interrupt, 0 for none
+        void ignoreUntil(unsigned long time); // touches before are not recognized
+        void reset();
+
+        bool isTouching();
+        unsigned long getTouchDuration(); // of the touch in progress or the last one
+        uint8_t getTapCount();
+
+        uint8_t getTimeline(TouchEdge *edges); // oldest first, returns the count
+        void replay(const TouchEdge *edges, uint8_t count, unsigned long until); // runs the recognizer on recorded edges
+
+    private:
+        void fire(FloowerTouchEvent event);
+        void record(unsigned long time, bool touched);
+
+        Config *config;
+        FloowerOnLeafTouchCallback callback;
+
+        bool touching = false;
+        unsigned long touchStartedTime = 0;
+        unsigned long touchDuration = 0;
+        unsigned long tapEndedTime = 0; // 0 when the last touch was not a tap
+        unsigned long ignoredTime = 0;
+        uint8_t taps = 0;
+        bool longRegistered = false;
+        bool holdRegistered = false;
+
+        TouchEdge timeline[TOUCH_TIMELINE_LENGTH];
+        uint8_t timelineHead = 0;
+        uint8_t timelineCount = 0;
+};
@@ -4,6 +4,7 @@
 #include <esp_wifi.h>
 #include <esp_task_wdt.h>
 #include "Config.h"
+#include "BootTimeline.h"
 #include "connect/RemoteControl.h"
 #include "behavior/BloomingBehavior.h"
 #include "behavior/MindfulnessBehavior.h"
@@ -32,6 +33,17 @@ void setFeatureFlags(Config &config) {
 
 #define WDT_TIMEOUT 10 // 10s for watch dog, reset with ever periodic operation
 
+// tasks, the radio stacks run on the PRO core so the connection task joins them there, the Floower
+// itself runs on the APP core where the motion and the LED frames preempt everything else
+#define PRO_CORE 0
+#define APP_CORE 1
+#define MOTION_TASK_PRIORITY 5
+#define PIXELS_TASK_PRIORITY 4
+#define CONTROL_TASK_PRIORITY 3
+#define CONNECT_TASK_PRIORITY 2
+#define ACTIVE_PERIOD_MS 1
+#define IDLE_PERIOD_MS 10
+
 Config config(FIRMWARE_VERSION);
 Floower floower(&config);
 Behavior *behavior;
@@ -41,17 +53,27 @@ BluetoothConnect bluetoothConnect(&floower, &config, &cmdProtocol);
 WifiConnect wifiConnect(&config, &cmdProtocol);
 RemoteControl remoteControl(&bluetoothConnect, &wifiConnect, &cmdProtocol);
 
+#ifndef NATIVE
+SemaphoreHandle_t floowerMutex; // the Floower state is shared by the motion, pixels and control tasks
+TaskHandle_t motionTask;
+TaskHandle_t pixelsTask;
+TaskHandle_t controlTask;
+TaskHandle_t connectTask;
+
+void startTasks();
+#endif
+
 void configure();
 void planDeepSleep(long timeoutMs);
 void enterDeepSleep();
 void periodicOperation();
 
-void onConfigChanged(bool wifiChanged) {
-    ESP_LOGI(LOG_TAG, "Config changed: wifi=%d", wifiChanged ? 1 : 0);
-    if (wifiChanged) {
+void onConfigChanged(uint32_t changedFields) {
+    ESP_LOGI(LOG_TAG, "Config changed: %x", changedFields);
+    if (changedFields & CONFIG_WIFI_FIELDS) {
         wifiConnect.reconnect();
     }
-    bluetoothConnect.reloadConfig();
+    bluetoothConnect.reloadConfig(changedFields);
 }
 
 void onFloowerChanged(int8_t petalsOpenLevel, HsbColor hsbColor) {
@@ -61,15 +83,18 @@ void onFloowerChanged(int8_t petalsOpenLevel, HsbColor hsbColor) {
 }
 
 void setup() {
+    BOOT_PHASE(BOOT_PHASE_SETUP);
     Serial.begin(115200);
     ESP_LOGI(LOG_TAG, "Initializing");
 
     // start watchdog timer
     esp_task_wdt_init(WDT_TIMEOUT, true); // enable panic so ESP32 restarts
     esp_task_wdt_add(nullptr);
+    BOOT_PHASE(BOOT_PHASE_WATCHDOG);
 
     // read configuration
     configure();
+    BOOT_PHASE(BOOT_PHASE_CONFIG);
     setFeatureFlags(config);
     config.onConfigChanged(onConfigChanged);
 
@@ -91,9 +116,12 @@ void setup() {
     btStop();
     floower.init();
     floower.enableTouch([=](FloowerTouchEvent event){}, !wokeUp); // enable NOP touch to enable deep sleep wake up function
+    BOOT_PHASE(BOOT_PHASE_TOUCH);
     floower.readPowerState(); // calibrate the ADC
+    BOOT_PHASE(BOOT_PHASE_POWER_STATE);
     floower.onChange(onFloowerChanged);
     delay(50); // wait to warm-up
+    BOOT_PHASE(BOOT_PHASE_WARM_UP);
 
     // init state machine, this is core logic
     if (!config.calibrated || !config.touchCalibrated) {
@@ -105,31 +133,113 @@ void setup() {
         //behavior = new TestBehavior(&config, &floower, &remoteControl);
     }
     behavior->setup(wokeUp);
+    BOOT_PHASE(BOOT_PHASE_BEHAVIOR);
+#ifdef BOOT_TIMELINE
+    BootTimeline::print();
+#endif
+
+#ifndef NATIVE
+    startTasks();
+#endif
 }
 
+#ifdef NATIVE
+
+// the host has no scheduler, everything runs one after another
 void loop() {
     floower.update();
     behavior->loop();
     wifiConnect.loop();
 
     // save some power when there is nothing happening
-    if (behavior->isIdle()) {
+    if (!floower.lightSleep(behavior->getIdleDuration()) && behavior->isIdle()) {
         delay(10);
     }
 }
 
+#else
+
+void loop() {
+    // all the work is done by the tasks
+    esp_task_wdt_delete(nullptr);
+    vTaskDelete(nullptr);
+}
+
+void motionTaskLoop(void *parameter) {
+    while (true) {
+        xSemaphoreTake(floowerMutex, portMAX_DELAY);
+        floower.updateMotion();
+        bool moving = floower.arePetalsMoving();
+        xSemaphoreGive(floowerMutex);
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(moving ? ACTIVE_PERIOD_MS : IDLE_PERIOD_MS));
+    }
+}
+
+void pixelsTaskLoop(void *parameter) {
+    while (true) {
+        xSemaphoreTake(floowerMutex, portMAX_DELAY);
+        floower.updatePixels();
+        bool animating = floower.isAnimating() || floower.isChangingColor();
+        xSemaphoreGive(floowerMutex);
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(animating ? ACTIVE_PERIOD_MS : IDLE_PERIOD_MS));
+    }
+}
+
+void controlTaskLoop(void *parameter) {
+    esp_task_wdt_add(nullptr); // reset by the behavior watchdogs
+    while (true) {
+        xSemaphoreTake(floowerMutex, portMAX_DELAY);
+        floower.updateControl();
+        behavior->loop();
+        bool idle = behavior->isIdle();
+        bool slept = floower.lightSleep(behavior->getIdleDuration()); // under the lock so no task is in the middle of an update
+        xSemaphoreGive(floowerMutex);
+
+        // wake up the Floower tasks in case the behavior started a movement or an animation, or a deadline woke the CPU
+        xTaskNotifyGive(motionTask);
+        xTaskNotifyGive(pixelsTask);
+
+        // commands from the connections wake the task right away, after light sleep the deadline is due already
+        TickType_t waitTicks = slept ? 0 : pdMS_TO_TICKS(idle ? IDLE_PERIOD_MS : ACTIVE_PERIOD_MS);
+        if (cmdProtocol.waitForCommand(waitTicks)) {
+            cmdProtocol.process(); // takes the mutex only while a command changes the state
+        }
+    }
+}
+
+void connectTaskLoop(void *parameter) {
+    while (true) {
+        xSemaphoreTake(floowerMutex, portMAX_DELAY); // the connection state and config are shared with the control task
+        wifiConnect.loop();
+        xSemaphoreGive(floowerMutex);
+        vTaskDelay(pdMS_TO_TICKS(IDLE_PERIOD_MS));
+    }
+}
+
+void startTasks() {
+    floowerMutex = xSemaphoreCreateMutex();
+    cmdProtocol.enableQueue(floowerMutex);
+    wifiConnect.enableResponseQueue(); // command responses come from the control task outside of the mutex
+    xTaskCreatePinnedToCore(motionTaskLoop, "motion", 4096, nullptr, MOTION_TASK_PRIORITY, &motionTask, APP_CORE);
+    xTaskCreatePinnedToCore(pixelsTaskLoop, "pixels", 4096, nullptr, PIXELS_TASK_PRIORITY, &pixelsTask, APP_CORE);
+    xTaskCreatePinnedToCore(controlTaskLoop, "control", 8192, nullptr, CONTROL_TASK_PRIORITY, &controlTask, APP_CORE);
+    xTaskCreatePinnedToCore(connectTaskLoop, "connect", 8192, nullptr, CONNECT_TASK_PRIORITY, &connectTask, PRO_CORE);
+}
+
+#endif
+
 void configure() {
     config.begin();
 #ifdef CALIBRATE_HARDWARE
     config.hardwareCalibration(SERVO_CLOSED, SERVO_OPEN, HARDWARE_REVISION, SERIAL_NUMBER);
     config.factorySettings();
     config.setCalibrated();
-    config.commit();
+    config.flush();
 #endif
 #ifdef FACTORY_RESET
     config.factorySettings();
     config.setCalibrated();
-    config.commit();
+    config.flush();
 #endif
     config.load();
-}
\ No newline at end of file
+}
@@ -0,0 +1,100 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "hardware/Battery.h"
+#include "NativeHal.h"
+
+#define BATTERY_ANALOG_PIN GPIO_NUM_36
+
+#define ADC_BATTERY_FULL 2300 // ~4.16V
+#define ADC_BATTERY_HALF 2075 // ~3.75V
+#define ADC_BATTERY_DEAD 1800 // ~3.26V
+
+Battery battery(BATTERY_ANALOG_PIN);
+
+void setUp(void) {
+    NativeHal::reset();
+    battery.init();
+}
+
+void tearDown(void) {
+}
+
+void test_calibrated_voltage(void) {
+    NativeHal::setAnalogInput(BATTERY_ANALOG_PIN, ADC_BATTERY_FULL);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 4.16, battery.measure());
+    TEST_ASSERT_TRUE(battery.isCalibrated());
+    TEST_ASSERT_EQUAL(ADC_BATTERY_FULL, battery.getRawReading());
+}
+
+void test_noise_is_filtered(void) {
+    NativeHal::setAnalogInput(BATTERY_ANALOG_PIN, ADC_BATTERY_HALF);
+    NativeHal::setAnalogNoise(BATTERY_ANALOG_PIN, 150); // +-0.27V on a single reading
+    float expected = battery.measure();
+    TEST_ASSERT_FLOAT_WITHIN(0.03, 3.75, expected);
+    for (uint8_t i = 0; i < 100; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(0.03, 3.75, battery.measure());
+    }
+}
+
+void test_filter_follows_the_voltage(void) {
+    NativeHal::setAnalogInput(BATTERY_ANALOG_PIN, ADC_BATTERY_FULL);
+    battery.measure();
+    NativeHal::setAnalogInput(BATTERY_ANALOG_PIN, ADC_BATTERY_HALF);
+    float voltage = battery.measure();
+    TEST_ASSERT_TRUE(voltage > 4.0); // single measurement moves it only a little
+    for (uint8_t i = 0; i < 30; i++) {
+        voltage = battery.measure();
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 3.75, voltage);
+}
+
+void test_switched_off_is_immediate(void) {
+    NativeHal::setAnalogInput(BATTERY_ANALOG_PIN, ADC_BATTERY_FULL);
+    battery.measure();
+    NativeHal::setAnalogInput(BATTERY_ANALOG_PIN, 0);
+    TEST_ASSERT_EQUAL_FLOAT(0, battery.measure());
+    TEST_ASSERT_EQUAL(0, battery.getRawReading());
+    TEST_ASSERT_EQUAL(0, battery.getLevel());
+}
+
+void test_dead_battery_on_first_measurement(void) {
+    NativeHal::setAnalogInput(BATTERY_ANALOG_PIN, ADC_BATTERY_DEAD);
+    NativeHal::setAnalogNoise(BATTERY_ANALOG_PIN, 300);
+    unsigned long started = micros();
+    TEST_ASSERT_TRUE(battery.measure() < 3.4);
+    TEST_ASSERT_LESS_THAN(1000, micros() - started); // no settling delay needed
+    TEST_ASSERT_EQUAL(0, battery.getLevel());
+}
+
+void test_discharge_curve(void) {
+    TEST_ASSERT_EQUAL(100, Battery::voltageToLevel(4.3));
+    TEST_ASSERT_EQUAL(100, Battery::voltageToLevel(4.2));
+    TEST_ASSERT_EQUAL(90, Battery::voltageToLevel(4.11));
+    TEST_ASSERT_EQUAL(50, Battery::voltageToLevel(3.84));
+    TEST_ASSERT_EQUAL(25, Battery::voltageToLevel(3.75));
+    TEST_ASSERT_EQUAL(10, Battery::voltageToLevel(3.69));
+    TEST_ASSERT_EQUAL(3, Battery::voltageToLevel(3.5));
+    TEST_ASSERT_EQUAL(0, Battery::voltageToLevel(3.3));
+    TEST_ASSERT_EQUAL(0, Battery::voltageToLevel(0));
+
+    // never goes up with lower voltage
+    uint8_t previous = 100;
+    for (uint16_t millivolts = 4300; millivolts > 3000; millivolts -= 5) {
+        uint8_t level = Battery::voltageToLevel(millivolts / 1000.0);
+        TEST_ASSERT_TRUE(level <= previous);
+        previous = level;
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_calibrated_voltage);
+    RUN_TEST(test_noise_is_filtered);
+    RUN_TEST(test_filter_follows_the_voltage);
+    RUN_TEST(test_switched_off_is_immediate);
+    RUN_TEST(test_dead_battery_on_first_measurement);
+    RUN_TEST(test_discharge_curve);
+    UNITY_END();
+
+    return 0;
+}
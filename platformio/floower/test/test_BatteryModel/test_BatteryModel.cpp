@@ -0,0 +1,120 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "hardware/BatteryModel.h"
+#include "hardware/Battery.h"
+#include "NativeHal.h"
+
+#define MINUTE 60000UL
+#define HOUR (60 * MINUTE)
+
+BatteryModel model;
+
+void setUp(void) {
+    NativeHal::reset();
+    model.reset();
+}
+
+void tearDown(void) {
+}
+
+// voltage of a battery with given charge under the current
+float loadedVoltage(float charge, uint16_t current) {
+    uint16_t openCircuit = 3300;
+    while (openCircuit < 4200 && Battery::voltageToLevel(openCircuit / 1000.0) < charge) {
+        openCircuit++;
+    }
+    return openCircuit / 1000.0 - current * BATTERY_INTERNAL_RESISTANCE / 1000;
+}
+
+void test_current_follows_the_load(void) {
+    PowerLoad dark = {0, 7, false, false, false};
+    PowerLoad lit = {7 * 3 * 255, 7, false, false, false};
+    PowerLoad busy = {7 * 3 * 255, 7, true, true, true};
+
+    TEST_ASSERT_EQUAL(LOAD_IDLE_MA + 7 * LOAD_PIXEL_MA, BatteryModel::estimateCurrent(dark));
+    TEST_ASSERT_EQUAL(LOAD_IDLE_MA + 7 * LOAD_PIXEL_MA + 21 * LOAD_LED_CHANNEL_MA, BatteryModel::estimateCurrent(lit));
+    TEST_ASSERT_EQUAL(BatteryModel::estimateCurrent(lit) + LOAD_STEPPER_MA + LOAD_WIFI_MA + LOAD_BLUETOOTH_MA, BatteryModel::estimateCurrent(busy));
+}
+
+void test_initial_charge_compensates_the_sag(void) {
+    // 300mA makes the voltage look lower than it is
+    model.update(0, loadedVoltage(80, 300), 300, false, false);
+    TEST_ASSERT_UINT8_WITHIN(2, 80, model.getStateOfCharge());
+}
+
+void test_coulomb_counting(void) {
+    float charge = 100;
+    uint16_t current = 160; // 10 hours for the full battery
+    for (unsigned long now = 0; now <= HOUR; now += 1000) {
+        model.update(now, loadedVoltage(charge, current), current, false, false);
+        charge -= current / 3600.0 * 100 / BATTERY_CAPACITY_MAH;
+    }
+    TEST_ASSERT_UINT8_WITHIN(2, 90, model.getStateOfCharge());
+    TEST_ASSERT_EQUAL(160, model.getAverageCurrent());
+    TEST_ASSERT_UINT16_WITHIN(15, 540, model.getRemainingRuntime());
+}
+
+void test_noisy_voltage_does_not_move_the_charge(void) {
+    model.update(0, loadedVoltage(60, 50), 50, false, false);
+    uint8_t initial = model.getStateOfCharge();
+    for (unsigned long now = 1000; now <= 10 * MINUTE; now += 1000) {
+        float noise = (now / 1000) % 2 == 0 ? 0.02 : -0.02; // +-5% of the level
+        model.update(now, loadedVoltage(60, 50) + noise, 50, false, false);
+    }
+    TEST_ASSERT_UINT8_WITHIN(2, initial, model.getStateOfCharge());
+}
+
+void test_counting_drift_is_corrected(void) {
+    // the load is underestimated, the voltage drops faster than counted
+    float charge = 80;
+    for (unsigned long now = 0; now <= 2 * HOUR; now += 1000) {
+        model.update(now, loadedVoltage(charge, 100), 100, false, false);
+        charge -= 400 / 3600.0 * 100 / BATTERY_CAPACITY_MAH; // really 400mA
+    }
+    TEST_ASSERT_UINT8_WITHIN(5, 30, model.getStateOfCharge());
+}
+
+void test_runtime_with_the_load(void) {
+    model.update(0, loadedVoltage(50, 50), 50, false, false);
+    for (unsigned long now = 1000; now <= 5 * MINUTE; now += 1000) {
+        model.update(now, loadedVoltage(50, 50), 50, false, false);
+    }
+    TEST_ASSERT_UINT16_WITHIN(5, model.getRemainingCapacity() * 60 / 50, model.getRemainingRuntime());
+
+    // WiFi and LEDs turned on, runtime follows within a few minutes
+    for (unsigned long now = 5 * MINUTE + 1000; now <= 10 * MINUTE; now += 1000) {
+        model.update(now, loadedVoltage(50, 300), 300, false, false);
+    }
+    TEST_ASSERT_UINT16_WITHIN(5, model.getRemainingCapacity() * 60 / 300, model.getRemainingRuntime());
+}
+
+void test_charging(void) {
+    model.update(0, 4.1, 50, true, true);
+    uint8_t initial = model.getStateOfCharge();
+    TEST_ASSERT_EQUAL(BATTERY_RUNTIME_UNKNOWN, model.getRemainingRuntime());
+
+    for (unsigned long now = 1000; now <= HOUR; now += 1000) {
+        model.update(now, 4.2, 50, true, true);
+    }
+    TEST_ASSERT_EQUAL(99, model.getStateOfCharge()); // full only when the charger finishes
+    TEST_ASSERT_TRUE(initial < 99);
+
+    for (unsigned long now = HOUR + 1000; now <= HOUR + 5 * MINUTE; now += 1000) {
+        model.update(now, 4.2, 50, false, true);
+    }
+    TEST_ASSERT_EQUAL(100, model.getStateOfCharge());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_current_follows_the_load);
+    RUN_TEST(test_initial_charge_compensates_the_sag);
+    RUN_TEST(test_coulomb_counting);
+    RUN_TEST(test_noisy_voltage_does_not_move_the_charge);
+    RUN_TEST(test_counting_drift_is_corrected);
+    RUN_TEST(test_runtime_with_the_load);
+    RUN_TEST(test_charging);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "BootTimeline.h"
+#include "connect/CommandProtocol.h"
+#include "NativeHal.h"
+
+void setUp(void) {
+    NativeHal::reset();
+    BootTimeline::reset();
+}
+
+void tearDown(void) {
+}
+
+void test_first_mark_counts(void) {
+    TEST_ASSERT_EQUAL(0, BootTimeline::getTime(BOOT_PHASE_CONFIG));
+    BootTimeline::mark(BOOT_PHASE_CONFIG);
+    uint32_t time = BootTimeline::getTime(BOOT_PHASE_CONFIG);
+    TEST_ASSERT_EQUAL(micros() - 1, time); // micros() itself takes 1us on host
+
+    delay(10);
+    BootTimeline::mark(BOOT_PHASE_CONFIG);
+    TEST_ASSERT_EQUAL(time, BootTimeline::getTime(BOOT_PHASE_CONFIG));
+}
+
+void test_floower_phases(void) {
+    Config config(1);
+    config.begin();
+    config.hardwareCalibration(1000, 1000, 9, 1);
+    config.factorySettings();
+    config.setCalibrated();
+    config.load();
+    Floower floower(&config);
+
+    floower.init();
+    floower.initPetals(true, false);
+    TEST_ASSERT_TRUE(BootTimeline::getTime(BOOT_PHASE_PIXELS) > 0);
+    TEST_ASSERT_TRUE(BootTimeline::getTime(BOOT_PHASE_ADC) >= BootTimeline::getTime(BOOT_PHASE_PIXELS));
+    TEST_ASSERT_TRUE(BootTimeline::getTime(BOOT_PHASE_PETALS) >= BootTimeline::getTime(BOOT_PHASE_ADC));
+
+    // dark frames do not count
+    NativeHal::simulate([&]() { floower.update(); }, 100);
+    TEST_ASSERT_EQUAL(0, BootTimeline::getTime(BOOT_PHASE_FIRST_FRAME));
+
+    unsigned long lightTime = micros(); // a frame later at most
+    floower.transitionColor(0.5, 1.0, 1.0, 0);
+    NativeHal::simulate([&]() { floower.update(); }, 100);
+    TEST_ASSERT_UINT32_WITHIN(10000, lightTime, BootTimeline::getTime(BOOT_PHASE_FIRST_FRAME));
+}
+
+void test_read_boot_timeline_command(void) {
+    Config config(1);
+    Floower floower(&config);
+    CommandProtocol protocol(&config, &floower);
+
+    BootTimeline::mark(BOOT_PHASE_SETUP);
+    delay(20);
+    BootTimeline::mark(BOOT_PHASE_CONFIG);
+
+    char response[MAX_MESSAGE_PAYLOAD_BYTES];
+    uint16_t responseLength = 0;
+    TEST_ASSERT_EQUAL(STATUS_OK, protocol.run(CMD_READ_BOOT_TIMELINE, nullptr, 0, response, &responseLength));
+    TEST_ASSERT_EQUAL(10, responseLength);
+    TEST_ASSERT_EQUAL(BOOT_PHASE_SETUP, response[0]);
+    TEST_ASSERT_EQUAL(BOOT_PHASE_CONFIG, response[5]);
+    uint32_t setupTime = (uint8_t) response[1] | (uint8_t) response[2] << 8 | (uint8_t) response[3] << 16 | (uint32_t) (uint8_t) response[4] << 24;
+    uint32_t configTime = (uint8_t) response[6] | (uint8_t) response[7] << 8 | (uint8_t) response[8] << 16 | (uint32_t) (uint8_t) response[9] << 24;
+    TEST_ASSERT_EQUAL(BootTimeline::getTime(BOOT_PHASE_SETUP), setupTime);
+    TEST_ASSERT_UINT32_WITHIN(5, 20000, configTime - setupTime);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_mark_counts);
+    RUN_TEST(test_floower_phases);
+    RUN_TEST(test_read_boot_timeline_command);
+    UNITY_END();
+
+    return 0;
+}
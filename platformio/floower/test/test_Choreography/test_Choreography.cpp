@@ -0,0 +1,203 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <chrono>
+#include <vector>
+#include "hardware/Choreography.h"
+
+#define BENCHMARK_SHOWS 20000
+
+struct RecordedAction {
+    unsigned long time;
+    ChoreographyAction action;
+};
+
+Choreography choreography;
+std::vector<RecordedAction> actions;
+unsigned long now;
+
+void setUp(void) {
+    actions.clear();
+    now = 0;
+    choreography.onAction([](const ChoreographyAction& action) { actions.push_back({now, action}); });
+}
+
+void tearDown(void) {
+}
+
+// runs the show with 1ms updates, the flower is idle after given ms since the last action
+void play(unsigned long durationMs, unsigned long busyMs = 0) {
+    for (; now <= durationMs && choreography.isRunning(); now++) {
+        bool idle = actions.empty() || now - actions.back().time >= busyMs;
+        choreography.update(now, idle);
+    }
+}
+
+void test_validate(void) {
+    const uint8_t valid[] = {CHOREO_COLOR, 255, 0, 0, 0xE8, 0x03, CHOREO_PETALS, 100, 0, 0, CHOREO_END};
+    TEST_ASSERT_TRUE(Choreography::validate(valid, sizeof(valid)));
+    TEST_ASSERT_TRUE(Choreography::validate(valid, 0));
+
+    const uint8_t unknownOpcode[] = {CHOREO_STOP_ANIMATION, 0x42};
+    TEST_ASSERT_FALSE(Choreography::validate(unknownOpcode, sizeof(unknownOpcode)));
+    const uint8_t truncated[] = {CHOREO_COLOR, 255, 0, 0, 0xE8};
+    TEST_ASSERT_FALSE(Choreography::validate(truncated, sizeof(truncated)));
+    const uint8_t levelOutOfRange[] = {CHOREO_PETALS, 101, 0, 0};
+    TEST_ASSERT_FALSE(Choreography::validate(levelOutOfRange, sizeof(levelOutOfRange)));
+    const uint8_t unmatchedNext[] = {CHOREO_NEXT};
+    TEST_ASSERT_FALSE(Choreography::validate(unmatchedNext, sizeof(unmatchedNext)));
+    const uint8_t unclosedLoop[] = {CHOREO_LOOP, 2, CHOREO_WAIT_IDLE};
+    TEST_ASSERT_FALSE(Choreography::validate(unclosedLoop, sizeof(unclosedLoop)));
+    const uint8_t tooDeep[] = {CHOREO_LOOP, 1, CHOREO_LOOP, 1, CHOREO_LOOP, 1, CHOREO_LOOP, 1, CHOREO_LOOP, 1,
+            CHOREO_NEXT, CHOREO_NEXT, CHOREO_NEXT, CHOREO_NEXT, CHOREO_NEXT};
+    TEST_ASSERT_FALSE(Choreography::validate(tooDeep, sizeof(tooDeep)));
+    uint8_t tooLong[CHOREOGRAPHY_MAX_LENGTH + 1] = {0};
+    TEST_ASSERT_FALSE(Choreography::validate(tooLong, sizeof(tooLong)));
+
+    TEST_ASSERT_FALSE(choreography.load(truncated, sizeof(truncated), 0));
+    TEST_ASSERT_FALSE(choreography.isRunning());
+}
+
+void test_actions_and_operands(void) {
+    const uint8_t program[] = {
+        CHOREO_COLOR, 10, 20, 30, 0xE8, 0x03, // 1000ms
+        CHOREO_BRIGHTNESS, 50, 0xF4, 0x01, // 500ms
+        CHOREO_PETALS, 75, 0x10, 0x27, // 10000ms
+        CHOREO_FLASH, 1, 2, 3, 0x2C, 0x01,
+        CHOREO_CIRCLE, 4, 5, 6, 0x64, 0x00,
+        CHOREO_ANIMATION, 2,
+        CHOREO_STOP_ANIMATION,
+        CHOREO_END,
+        CHOREO_PETALS, 0, 0, 0 // never reached
+    };
+    TEST_ASSERT_TRUE(choreography.load(program, sizeof(program), now));
+    play(10);
+    TEST_ASSERT_FALSE(choreography.isRunning());
+    TEST_ASSERT_EQUAL(7, actions.size());
+
+    TEST_ASSERT_EQUAL(CHOREO_COLOR, actions[0].action.opcode);
+    TEST_ASSERT_TRUE(RgbColor(10, 20, 30) == actions[0].action.color);
+    TEST_ASSERT_EQUAL(1000, actions[0].action.time);
+    TEST_ASSERT_EQUAL(CHOREO_BRIGHTNESS, actions[1].action.opcode);
+    TEST_ASSERT_EQUAL(50, actions[1].action.value);
+    TEST_ASSERT_EQUAL(500, actions[1].action.time);
+    TEST_ASSERT_EQUAL(CHOREO_PETALS, actions[2].action.opcode);
+    TEST_ASSERT_EQUAL(75, actions[2].action.value);
+    TEST_ASSERT_EQUAL(10000, actions[2].action.time);
+    TEST_ASSERT_EQUAL(CHOREO_FLASH, actions[3].action.opcode);
+    TEST_ASSERT_TRUE(RgbColor(1, 2, 3) == actions[3].action.color);
+    TEST_ASSERT_EQUAL(300, actions[3].action.time);
+    TEST_ASSERT_EQUAL(CHOREO_CIRCLE, actions[4].action.opcode);
+    TEST_ASSERT_EQUAL(100, actions[4].action.time);
+    TEST_ASSERT_EQUAL(CHOREO_ANIMATION, actions[5].action.opcode);
+    TEST_ASSERT_EQUAL(2, actions[5].action.value);
+    TEST_ASSERT_EQUAL(CHOREO_STOP_ANIMATION, actions[6].action.opcode);
+    // all at once, no waits in the program
+    TEST_ASSERT_EQUAL(0, actions[6].time);
+}
+
+void test_waits_do_not_drift(void) {
+    // 300ms wait, the flower is busy for 7ms after each action which must not push the next one later
+    const uint8_t program[] = {
+        CHOREO_LOOP, 10,
+            CHOREO_ANIMATION, 0,
+            CHOREO_WAIT, 0x2C, 0x01,
+        CHOREO_NEXT
+    };
+    TEST_ASSERT_TRUE(choreography.load(program, sizeof(program), now));
+    play(10000, 7);
+    TEST_ASSERT_EQUAL(10, actions.size());
+    for (uint8_t i = 0; i < actions.size(); i++) {
+        TEST_ASSERT_EQUAL(i * 300, actions[i].time);
+    }
+    TEST_ASSERT_FALSE(choreography.isRunning());
+}
+
+void test_wait_idle(void) {
+    const uint8_t program[] = {
+        CHOREO_PETALS, 100, 0xE8, 0x03,
+        CHOREO_WAIT_IDLE,
+        CHOREO_PETALS, 0, 0xE8, 0x03,
+        CHOREO_WAIT, 0x64, 0x00, // counts from the end of the idle wait
+        CHOREO_ANIMATION, 1
+    };
+    TEST_ASSERT_TRUE(choreography.load(program, sizeof(program), now));
+    play(5000, 1000);
+    TEST_ASSERT_EQUAL(3, actions.size());
+    TEST_ASSERT_EQUAL(0, actions[0].time);
+    TEST_ASSERT_EQUAL(1000, actions[1].time);
+    TEST_ASSERT_EQUAL(1100, actions[2].time);
+}
+
+void test_nested_loops(void) {
+    const uint8_t program[] = {
+        CHOREO_LOOP, 3,
+            CHOREO_ANIMATION, 0,
+            CHOREO_LOOP, 4,
+                CHOREO_ANIMATION, 1,
+            CHOREO_NEXT,
+        CHOREO_NEXT,
+        CHOREO_ANIMATION, 2
+    };
+    TEST_ASSERT_TRUE(choreography.load(program, sizeof(program), now));
+    play(1000);
+    TEST_ASSERT_EQUAL(3 * (1 + 4) + 1, actions.size());
+    TEST_ASSERT_EQUAL(0, actions[0].action.value);
+    TEST_ASSERT_EQUAL(1, actions[4].action.value);
+    TEST_ASSERT_EQUAL(0, actions[5].action.value);
+    TEST_ASSERT_EQUAL(2, actions.back().action.value);
+}
+
+void test_endless_loop_is_bounded(void) {
+    // a show that never waits must not block the update
+    const uint8_t program[] = {CHOREO_LOOP, 0, CHOREO_STOP_ANIMATION, CHOREO_NEXT};
+    TEST_ASSERT_TRUE(choreography.load(program, sizeof(program), now));
+    choreography.update(now, true);
+    TEST_ASSERT_EQUAL(CHOREOGRAPHY_STEPS_PER_UPDATE, choreography.getExecutedCount());
+    TEST_ASSERT_TRUE(choreography.isRunning());
+
+    choreography.stop();
+    choreography.update(now, true);
+    TEST_ASSERT_EQUAL(CHOREOGRAPHY_STEPS_PER_UPDATE, choreography.getExecutedCount());
+}
+
+void test_interpreter_benchmark(void) {
+    // every instruction kind, the callback does nothing so only the interpreter is measured
+    const uint8_t program[] = {
+        CHOREO_LOOP, 5,
+            CHOREO_COLOR, 255, 128, 0, 0xE8, 0x03,
+            CHOREO_BRIGHTNESS, 80, 0xF4, 0x01,
+            CHOREO_PETALS, 50, 0xE8, 0x03,
+            CHOREO_FLASH, 0, 0, 255, 0x2C, 0x01,
+            CHOREO_CIRCLE, 0, 255, 0, 0x2C, 0x01,
+            CHOREO_ANIMATION, 1,
+            CHOREO_STOP_ANIMATION,
+            CHOREO_WAIT, 0x00, 0x00,
+        CHOREO_NEXT,
+        CHOREO_END
+    };
+    choreography.onAction([](const ChoreographyAction& action) {});
+    uint32_t executed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCHMARK_SHOWS; i++) {
+        choreography.load(program, sizeof(program), 0);
+        while (choreography.isRunning()) {
+            choreography.update(0, true);
+        }
+        executed += choreography.getExecutedCount();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    TEST_ASSERT_EQUAL(BENCHMARK_SHOWS * (1 + 5 * 9 + 1), executed);
+    printf("choreography: %.1fM instructions/s, %.0fns per instruction\n", executed / seconds / 1e6, seconds * 1e9 / executed);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_validate);
+    RUN_TEST(test_actions_and_operands);
+    RUN_TEST(test_waits_do_not_drift);
+    RUN_TEST(test_wait_idle);
+    RUN_TEST(test_nested_loops);
+    RUN_TEST(test_endless_loop_is_bounded);
+    RUN_TEST(test_interpreter_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,186 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <chrono>
+#include <vector>
+#include "connect/CommandDecoder.h"
+#include "connect/CommandProtocol.h"
+#include "NativeHal.h"
+
+#define FUZZ_ITERATIONS 200000
+#define BENCHMARK_COMMANDS 1000000
+
+typedef std::vector<uint8_t> Payload;
+
+// seed corpus of the fuzzer, valid and broken payloads of the control commands
+const Payload CORPUS[] = {
+    {0x82, 0xA1, 'l', 0x32, 0xA1, 't', 0xCD, 0x07, 0xD0}, // { l: 50, t: 2000 }
+    {0x84, 0xA1, 'r', 0xCC, 0xFF, 0xA1, 'g', 0x00, 0xA1, 'b', 0x7F, 0xA1, 't', 0xCD, 0x01, 0xF4}, // { r: 255, g: 0, b: 127, t: 500 }
+    {0x85, 0xA1, 'r', 0x0A, 0xA1, 'g', 0x14, 0xA1, 'b', 0x1E, 0xA1, 'l', 0x64, 0xA1, 't', 0x00}, // state
+    {0x81, 0xA1, 'a', 0x02}, // { a: 2 }
+    {0x82, 0xA4, 's', 's', 'i', 'd', 0xA4, 'h', 'o', 'm', 'e', 0xA1, 'l', 0x0A}, // unknown key
+    {0x82, 0xA1, 'x', 0x92, 0x81, 0xA1, 'y', 0xC0, 0xC4, 0x02, 0x01, 0x02, 0xA1, 'l', 0x05}, // nested unknown value
+    {0x83, 0xA1, 'l', 0xC0, 0xA1, 'r', 0xC3, 0xA1, 'g', 0xA2, 'h', 'i'}, // nil, bool and string values
+    {0x82, 0xA1, 'l', 0xCD, 0x01, 0x2C, 0xA1, 'r', 0xFF}, // { l: 300, r: -1 }
+    {0x82, 0xA1, 'l', 0xCA, 0x42, 0x48, 0x00, 0x00, 0xA1, 't', 0xCB, 0x40, 0x8F, 0x40, 0, 0, 0, 0, 0}, // floats 50.0, 1000.0
+    {0xDE, 0x00, 0x01, 0xD9, 0x01, 'l', 0xD0, 0x14}, // map 16, str 8, int 8
+    {0x82, 0xA1, 'l', 0x32, 0xA1, 't', 0xCD, 0x07}, // truncated
+    {0x8F, 0xA1, 'l'}, // more entries than bytes
+    {0x91, 0x01}, // array
+    {0x81, 0x01, 0x02}, // integer key
+    {0x81, 0xA1, 'x', 0x91, 0x91, 0x91, 0x91, 0x91, 0x91, 0x01}, // too deep
+    {0x81, 0xA1, 'x', 0xDD, 0xFF, 0xFF, 0xFF, 0xFF}, // huge array
+    {0x81, 0xA1, 'x', 0xC9, 0xFF, 0xFF, 0xFF, 0xFF, 0x01}, // huge ext
+    {0x81, 0xA1, 'x', 0xC1}, // never used format
+};
+
+void setUp(void) {
+    NativeHal::reset();
+}
+
+void tearDown(void) {
+}
+
+bool decode(const Payload &payload, ControlCommand &command) {
+    return CommandDecoder::decodeControl(payload.data(), payload.size(), command);
+}
+
+void test_decode_fields(void) {
+    ControlCommand command;
+    TEST_ASSERT_TRUE(decode(CORPUS[0], command));
+    TEST_ASSERT_EQUAL(CONTROL_FIELD_LEVEL | CONTROL_FIELD_TIME, command.fields);
+    TEST_ASSERT_EQUAL(50, command.level);
+    TEST_ASSERT_EQUAL(2000, command.time);
+
+    TEST_ASSERT_TRUE(decode(CORPUS[1], command));
+    TEST_ASSERT_EQUAL(CONTROL_FIELD_COLOR | CONTROL_FIELD_TIME, command.fields);
+    TEST_ASSERT_EQUAL(255, command.red);
+    TEST_ASSERT_EQUAL(0, command.green);
+    TEST_ASSERT_EQUAL(127, command.blue);
+    TEST_ASSERT_EQUAL(500, command.time);
+
+    TEST_ASSERT_TRUE(decode(CORPUS[3], command));
+    TEST_ASSERT_EQUAL(CONTROL_FIELD_ANIMATION, command.fields);
+    TEST_ASSERT_EQUAL(2, command.animation);
+
+    TEST_ASSERT_TRUE(decode(CORPUS[9], command));
+    TEST_ASSERT_EQUAL(CONTROL_FIELD_LEVEL, command.fields);
+    TEST_ASSERT_EQUAL(20, command.level);
+}
+
+void test_unknown_and_invalid_values(void) {
+    ControlCommand command;
+    TEST_ASSERT_TRUE(decode(CORPUS[4], command));
+    TEST_ASSERT_EQUAL(CONTROL_FIELD_LEVEL, command.fields);
+    TEST_ASSERT_EQUAL(10, command.level);
+
+    TEST_ASSERT_TRUE(decode(CORPUS[5], command));
+    TEST_ASSERT_EQUAL(CONTROL_FIELD_LEVEL, command.fields);
+    TEST_ASSERT_EQUAL(5, command.level);
+
+    // missing like in the JSON document
+    TEST_ASSERT_TRUE(decode(CORPUS[6], command));
+    TEST_ASSERT_EQUAL(0, command.fields);
+    TEST_ASSERT_TRUE(decode(CORPUS[7], command));
+    TEST_ASSERT_EQUAL(0, command.fields);
+
+    TEST_ASSERT_TRUE(decode(CORPUS[8], command));
+    TEST_ASSERT_EQUAL(50, command.level);
+    TEST_ASSERT_EQUAL(1000, command.time);
+}
+
+void test_malformed_payloads(void) {
+    ControlCommand command;
+    for (uint8_t i = 10; i < sizeof(CORPUS) / sizeof(Payload); i++) {
+        TEST_ASSERT_FALSE(decode(CORPUS[i], command));
+    }
+    // every prefix of a valid payload is truncated
+    for (uint8_t length = 0; length < CORPUS[2].size(); length++) {
+        Payload prefix(CORPUS[2].begin(), CORPUS[2].begin() + length);
+        TEST_ASSERT_FALSE(decode(prefix, command));
+    }
+}
+
+void test_commands_run(void) {
+    Config config(1);
+    config.begin();
+    config.hardwareCalibration(1000, 1000, 9, 1);
+    config.factorySettings();
+    config.setCalibrated();
+    config.load();
+    Floower floower(&config);
+    floower.init();
+    floower.initPetals(true, false);
+    CommandProtocol protocol(&config, &floower);
+
+    const Payload &state = CORPUS[2];
+    TEST_ASSERT_EQUAL(STATUS_OK, protocol.run(CMD_WRITE_STATE, (const char *) state.data(), state.size()));
+    TEST_ASSERT_EQUAL(100, floower.getPetalsOpenLevel());
+    RgbColor color = RgbColor(floower.getColor());
+    TEST_ASSERT_UINT8_WITHIN(1, 10, color.R);
+    TEST_ASSERT_UINT8_WITHIN(1, 20, color.G);
+    TEST_ASSERT_UINT8_WITHIN(1, 30, color.B);
+
+    const Payload &petals = CORPUS[0];
+    TEST_ASSERT_EQUAL(STATUS_OK, protocol.run(CMD_WRITE_PETALS, (const char *) petals.data(), petals.size()));
+    TEST_ASSERT_EQUAL(50, floower.getPetalsOpenLevel());
+
+    const Payload &truncated = CORPUS[10];
+    TEST_ASSERT_EQUAL(STATUS_ERROR, protocol.run(CMD_WRITE_PETALS, (const char *) truncated.data(), truncated.size()));
+    TEST_ASSERT_EQUAL(50, floower.getPetalsOpenLevel());
+}
+
+void test_fuzz(void) {
+    // mutations of the corpus, exact size buffers so an overread hits the sanitizer
+    uint32_t seed = 1;
+    uint32_t accepted = 0;
+    for (uint32_t i = 0; i < FUZZ_ITERATIONS; i++) {
+        seed = seed * 1103515245 + 12345;
+        Payload payload = CORPUS[(seed >> 16) % (sizeof(CORPUS) / sizeof(Payload))];
+        uint8_t mutations = 1 + (seed >> 8) % 4;
+        for (uint8_t m = 0; m < mutations; m++) {
+            seed = seed * 1103515245 + 12345;
+            uint8_t position = payload.empty() ? 0 : (seed >> 16) % payload.size();
+            switch ((seed >> 8) % 4) {
+                case 0: if (!payload.empty()) payload[position] ^= 1 << ((seed >> 24) % 8); break;
+                case 1: if (!payload.empty()) payload[position] = seed >> 24; break;
+                case 2: payload.insert(payload.begin() + position, seed >> 24); break;
+                case 3: payload.resize(position); break;
+            }
+        }
+        ControlCommand command;
+        uint8_t *buffer = new uint8_t[payload.size()];
+        memcpy(buffer, payload.data(), payload.size());
+        if (CommandDecoder::decodeControl(buffer, payload.size(), command)) {
+            accepted++;
+            TEST_ASSERT_EQUAL(0, command.fields & ~(CONTROL_FIELD_LEVEL | CONTROL_FIELD_TIME | CONTROL_FIELD_COLOR | CONTROL_FIELD_ANIMATION));
+        }
+        delete[] buffer;
+    }
+    TEST_ASSERT_TRUE(accepted > 0);
+}
+
+void test_benchmark(void) {
+    const Payload &state = CORPUS[2];
+    ControlCommand command;
+    uint32_t decoded = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCHMARK_COMMANDS; i++) {
+        decoded += CommandDecoder::decodeControl(state.data(), state.size(), command);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    TEST_ASSERT_EQUAL(BENCHMARK_COMMANDS, decoded);
+    printf("Control command decoding: %.0f commands/s\n", BENCHMARK_COMMANDS / seconds);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_decode_fields);
+    RUN_TEST(test_unknown_and_invalid_values);
+    RUN_TEST(test_malformed_payloads);
+    RUN_TEST(test_commands_run);
+    RUN_TEST(test_fuzz);
+    RUN_TEST(test_benchmark);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,216 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "Config.h"
+#include "NativeHal.h"
+#include <limits.h>
+
+Config *config;
+uint8_t notifications;
+uint32_t notifiedFields;
+unsigned long notifiedTime;
+unsigned long burstTime;
+
+void onConfigChanged(uint32_t changedFields) {
+    if (notifications++ == 0) {
+        notifiedTime = millis();
+    }
+    notifiedFields = changedFields;
+}
+
+void setUp(void) {
+    NativeHal::reset();
+    config = new Config(1);
+    config->begin();
+    config->hardwareCalibration(1000, 1000, 9, 1);
+    config->factorySettings();
+    config->flush();
+    config->load();
+    config->onConfigChanged(onConfigChanged);
+    notifications = 0;
+    notifiedFields = 0;
+}
+
+void tearDown(void) {
+    delete config;
+}
+
+// what the next boot would read from the flash
+uint8_t storedBrightness() {
+    ESP.restart(); // no snapshot
+    Config restarted(1);
+    restarted.begin();
+    restarted.load();
+    return restarted.colorBrightness;
+}
+
+void test_burst_is_written_once(void) {
+    uint32_t erases = NativeHal::getFlashEraseCount();
+
+    // dragging the brightness slider
+    NativeHal::simulate([]() {
+        config->setColorBrightness(millis() % 100);
+        config->commit();
+        config->update();
+    }, 500, 50000);
+    uint8_t brightness = config->colorBrightness;
+    TEST_ASSERT_EQUAL(0, notifications);
+    TEST_ASSERT_NOT_EQUAL(brightness, storedBrightness());
+
+    NativeHal::simulate([]() { config->update(); }, CONFIG_COMMIT_DELAY);
+    TEST_ASSERT_EQUAL(1, notifications);
+    TEST_ASSERT_EQUAL(CONFIG_FIELD_BIT(CONFIG_FIELD_COLOR_BRIGHTNESS), notifiedFields);
+    TEST_ASSERT_EQUAL(brightness, storedBrightness());
+    TEST_ASSERT_EQUAL(erases, NativeHal::getFlashEraseCount());
+}
+
+void test_changes_are_coalesced(void) {
+    config->setName("Garden");
+    config->commit();
+    NativeHal::simulate([]() {}, 200);
+    config->setSpeed(30);
+    config->setWifi("home", "secret");
+    config->commit();
+
+    NativeHal::simulate([]() { config->update(); }, CONFIG_COMMIT_DELAY + 10);
+    TEST_ASSERT_EQUAL(1, notifications);
+    TEST_ASSERT_EQUAL(CONFIG_FIELD_BIT(CONFIG_FIELD_NAME) | CONFIG_FIELD_BIT(CONFIG_FIELD_SPEED) | CONFIG_FIELD_BIT(CONFIG_FIELD_WIFI_SSID) | CONFIG_FIELD_BIT(CONFIG_FIELD_WIFI_PWD), notifiedFields);
+    TEST_ASSERT_TRUE(notifiedFields & CONFIG_WIFI_FIELDS);
+    TEST_ASSERT_FALSE(notifiedFields & CONFIG_FIELD_BIT(CONFIG_FIELD_COLOR_BRIGHTNESS));
+}
+
+void test_continuous_changes_are_written_in_time(void) {
+    // a change every 500ms never settles down
+    burstTime = millis();
+    NativeHal::simulate([]() {
+        if ((millis() - burstTime) % 500 == 0) {
+            config->setColorBrightness(millis() / 500 % 100);
+            config->commit();
+        }
+        config->update();
+    }, CONFIG_COMMIT_MAX_DELAY + 250);
+    TEST_ASSERT_EQUAL(1, notifications);
+    TEST_ASSERT_UINT32_WITHIN(1, burstTime + CONFIG_COMMIT_MAX_DELAY, notifiedTime);
+    TEST_ASSERT_EQUAL(config->colorBrightness, storedBrightness());
+}
+
+void test_flush_writes_immediately(void) {
+    config->setMaxOpenLevel(70);
+    config->commit();
+    TEST_ASSERT_EQUAL(CONFIG_COMMIT_DELAY, config->getCommitDelay());
+
+    config->flush();
+    TEST_ASSERT_EQUAL(1, notifications);
+    TEST_ASSERT_EQUAL(ULONG_MAX, config->getCommitDelay());
+    Config restarted(1);
+    restarted.begin();
+    restarted.load();
+    TEST_ASSERT_EQUAL(70, restarted.maxOpenLevel);
+}
+
+void test_commit_delay(void) {
+    TEST_ASSERT_EQUAL(ULONG_MAX, config->getCommitDelay());
+
+    config->setSpeed(20);
+    config->commit();
+    NativeHal::simulate([]() {}, 400);
+    TEST_ASSERT_EQUAL(CONFIG_COMMIT_DELAY - 400, config->getCommitDelay());
+
+    // nothing changed, no notification
+    config->flush();
+    notifications = 0;
+    config->commit();
+    config->flush();
+    TEST_ASSERT_EQUAL(0, notifications);
+}
+
+// begin() and load() after the deep sleep, returns the us it took
+unsigned long wakeUp(Config &woken) {
+    uint64_t start = NativeHal::getClockMicros();
+    woken.begin();
+    woken.load();
+    return NativeHal::getClockMicros() - start;
+}
+
+void test_wake_up_restores_snapshot(void) {
+    config->setName("Garden");
+    config->setWifi("home", "secret");
+    config->flush();
+
+    Config woken(1);
+    unsigned long restoreTime = wakeUp(woken);
+    TEST_ASSERT_TRUE(woken.isRestored());
+    TEST_ASSERT_TRUE(woken.calibrated == config->calibrated);
+    TEST_ASSERT_EQUAL(config->speed, woken.speed);
+    TEST_ASSERT_EQUAL(config->speedMillis, woken.speedMillis);
+    TEST_ASSERT_EQUAL(config->colorSchemeSize, woken.colorSchemeSize);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, config->colorScheme[3].H, woken.colorScheme[3].H);
+    TEST_ASSERT_EQUAL_STRING("Garden", woken.name.c_str());
+    TEST_ASSERT_EQUAL_STRING("secret", woken.wifiPassword.c_str());
+
+    ESP.restart();
+    Config booted(1);
+    unsigned long loadTime = wakeUp(booted);
+    TEST_ASSERT_FALSE(booted.isRestored());
+    TEST_ASSERT_EQUAL_STRING("Garden", booted.name.c_str());
+    TEST_ASSERT_TRUE(restoreTime * 10 < loadTime);
+    printf("Config wake up: %luus restored, %luus from flash\n", restoreTime, loadTime);
+}
+
+void test_commit_invalidates_snapshot(void) {
+    config->setName("Garden");
+    config->commit();
+
+    // the commit was not written before the sleep
+    Config woken(1);
+    wakeUp(woken);
+    TEST_ASSERT_FALSE(woken.isRestored());
+    TEST_ASSERT_EQUAL_STRING("Floower", woken.name.c_str());
+
+    config->flush();
+    Config wokenAgain(1);
+    wakeUp(wokenAgain);
+    TEST_ASSERT_TRUE(wokenAgain.isRestored());
+    TEST_ASSERT_EQUAL_STRING("Garden", wokenAgain.name.c_str());
+}
+
+extern uint8_t __start_rtc_data[];
+
+void test_corrupted_snapshot_is_ignored(void) {
+    __start_rtc_data[20] ^= 0x01;
+
+    Config woken(1);
+    wakeUp(woken);
+    TEST_ASSERT_FALSE(woken.isRestored());
+    TEST_ASSERT_EQUAL(config->colorBrightness, woken.colorBrightness);
+}
+
+void test_restored_config_can_be_changed(void) {
+    Config woken(1);
+    wakeUp(woken);
+    TEST_ASSERT_TRUE(woken.isRestored());
+    woken.setSpeed(20);
+    woken.flush();
+
+    ESP.restart();
+    Config booted(1);
+    wakeUp(booted);
+    TEST_ASSERT_EQUAL(20, booted.speed);
+    TEST_ASSERT_EQUAL(config->colorSchemeSize, booted.colorSchemeSize);
+    TEST_ASSERT_TRUE(booted.calibrated == config->calibrated);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_burst_is_written_once);
+    RUN_TEST(test_changes_are_coalesced);
+    RUN_TEST(test_continuous_changes_are_written_in_time);
+    RUN_TEST(test_flush_writes_immediately);
+    RUN_TEST(test_commit_delay);
+    RUN_TEST(test_wake_up_restores_snapshot);
+    RUN_TEST(test_commit_invalidates_snapshot);
+    RUN_TEST(test_corrupted_snapshot_is_ignored);
+    RUN_TEST(test_restored_config_can_be_changed);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,283 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <EEPROM.h>
+#include "ConfigStore.h"
+#include "Config.h"
+#include "NativeHal.h"
+
+#define FIELD_A 1
+#define FIELD_B 2
+
+void setUp(void) {
+    NativeHal::reset();
+}
+
+void tearDown(void) {
+}
+
+void test_empty_flash(void) {
+    ConfigStore store;
+    TEST_ASSERT_FALSE(store.begin());
+    TEST_ASSERT_FALSE(store.has(FIELD_A));
+    TEST_ASSERT_EQUAL(7, store.readByte(FIELD_A, 7));
+    TEST_ASSERT_EQUAL(CONFIG_STORE_SECTORS, store.getActiveSector());
+}
+
+void test_values_survive_restart(void) {
+    ConfigStore store;
+    store.begin();
+    store.writeInt(FIELD_A, 1234);
+    store.writeString(FIELD_B, "Floower", 25);
+    TEST_ASSERT_TRUE(store.commit());
+
+    ConfigStore restarted;
+    TEST_ASSERT_TRUE(restarted.begin());
+    TEST_ASSERT_EQUAL(1234, restarted.readInt(FIELD_A));
+    TEST_ASSERT_EQUAL_STRING("Floower", restarted.readString(FIELD_B, 25).c_str());
+}
+
+void test_changes_are_appended(void) {
+    ConfigStore store;
+    store.begin();
+    store.writeByte(FIELD_A, 1);
+    store.commit();
+    uint32_t erases = NativeHal::getFlashEraseCount();
+    uint16_t offset = store.getWriteOffset();
+
+    store.writeByte(FIELD_A, 2);
+    store.commit();
+    TEST_ASSERT_EQUAL(offset + 5, store.getWriteOffset()); // field, length, value, CRC
+    TEST_ASSERT_EQUAL(erases, NativeHal::getFlashEraseCount());
+
+    // unchanged value is not written again
+    store.writeByte(FIELD_A, 2);
+    store.commit();
+    TEST_ASSERT_EQUAL(offset + 5, store.getWriteOffset());
+
+    ConfigStore restarted;
+    restarted.begin();
+    TEST_ASSERT_EQUAL(2, restarted.readByte(FIELD_A));
+}
+
+void test_compaction_rotates_sectors(void) {
+    ConfigStore store;
+    store.begin();
+    store.writeString(FIELD_B, "keep me", 25);
+    for (uint16_t i = 0; i < 10000; i++) {
+        store.writeInt(FIELD_A, i);
+        TEST_ASSERT_TRUE(store.commit());
+    }
+
+    ConfigStore restarted;
+    restarted.begin();
+    TEST_ASSERT_EQUAL(9999, restarted.readInt(FIELD_A));
+    TEST_ASSERT_EQUAL_STRING("keep me", restarted.readString(FIELD_B, 25).c_str());
+
+    // ~680 records fit a sector, the erases are spread over all the sectors
+    uint32_t minErases = UINT32_MAX, maxErases = 0;
+    for (uint8_t sector = 0; sector < CONFIG_STORE_SECTORS; sector++) {
+        uint32_t erases = NativeHal::getFlashSectorEraseCount(sector * CONFIG_STORE_SECTOR_SIZE);
+        minErases = _min(minErases, erases);
+        maxErases = _max(maxErases, erases);
+    }
+    TEST_ASSERT_TRUE(minErases > 0);
+    TEST_ASSERT_TRUE(maxErases - minErases <= 1);
+    TEST_ASSERT_TRUE(NativeHal::getFlashEraseCount() < 10000 / 500);
+}
+
+void test_torn_record_is_dropped(void) {
+    ConfigStore store;
+    store.begin();
+    store.writeByte(FIELD_A, 1);
+    store.commit();
+
+    // power lost in the middle of the record
+    NativeHal::setFlashWriteBudget(3);
+    store.writeByte(FIELD_A, 2);
+    store.commit();
+    NativeHal::setFlashWriteBudget(-1);
+
+    ConfigStore restarted;
+    TEST_ASSERT_TRUE(restarted.begin());
+    TEST_ASSERT_EQUAL(1, restarted.readByte(FIELD_A));
+
+    // the next commit moves past the torn record
+    restarted.writeByte(FIELD_B, 3);
+    TEST_ASSERT_TRUE(restarted.commit());
+    ConfigStore again;
+    again.begin();
+    TEST_ASSERT_EQUAL(1, again.readByte(FIELD_A));
+    TEST_ASSERT_EQUAL(3, again.readByte(FIELD_B));
+}
+
+void test_torn_compaction_keeps_old_sector(void) {
+    ConfigStore store;
+    store.begin();
+    store.writeByte(FIELD_A, 1);
+    store.commit();
+    uint8_t sector = store.getActiveSector();
+
+    // fill the sector, the compaction is cut before its header is written
+    char value[CONFIG_STORE_MAX_LENGTH + 1];
+    memset(value, 'x', CONFIG_STORE_MAX_LENGTH);
+    value[CONFIG_STORE_MAX_LENGTH] = '\0';
+    while (store.getWriteOffset() + CONFIG_STORE_MAX_LENGTH + 4 <= CONFIG_STORE_SECTOR_SIZE) {
+        value[0] = value[0] == 'x' ? 'y' : 'x';
+        store.writeString(FIELD_B, value, CONFIG_STORE_MAX_LENGTH);
+        store.commit();
+    }
+    String lastValue = value;
+    NativeHal::setFlashWriteBudget(20);
+    value[0] = 'z'; // does not fit anymore
+    store.writeString(FIELD_B, value, CONFIG_STORE_MAX_LENGTH);
+    store.commit();
+    NativeHal::setFlashWriteBudget(-1);
+
+    ConfigStore restarted;
+    TEST_ASSERT_TRUE(restarted.begin());
+    TEST_ASSERT_EQUAL(sector, restarted.getActiveSector());
+    TEST_ASSERT_EQUAL(1, restarted.readByte(FIELD_A));
+    TEST_ASSERT_EQUAL_STRING(lastValue.c_str(), restarted.readString(FIELD_B, CONFIG_STORE_MAX_LENGTH).c_str());
+}
+
+void test_corrupted_record_is_ignored(void) {
+    ConfigStore store;
+    store.begin();
+    store.writeByte(FIELD_A, 1);
+    store.commit();
+    uint16_t offset = store.getWriteOffset();
+    store.writeByte(FIELD_A, 0xF0);
+    store.commit();
+
+    // flip a bit of the value, NOR flash can only clear them
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, NULL);
+    uint8_t corrupted = 0xE0;
+    esp_partition_write(partition, store.getActiveSector() * CONFIG_STORE_SECTOR_SIZE + offset + 2, &corrupted, 1);
+
+    ConfigStore restarted;
+    restarted.begin();
+    TEST_ASSERT_EQUAL(1, restarted.readByte(FIELD_A));
+}
+
+void test_slider_commits_erase_rarely(void) {
+    Config config(1);
+    config.begin();
+    config.hardwareCalibration(1000, 1000, 9, 1);
+    config.factorySettings();
+    config.flush();
+    uint32_t erases = NativeHal::getFlashEraseCount();
+
+    // every slider change committed, EEPROM would rewrite its sector every time
+    for (uint16_t i = 0; i < 1000; i++) {
+        config.setColorBrightness(i % 100);
+        config.flush();
+    }
+    TEST_ASSERT_TRUE(NativeHal::getFlashEraseCount() - erases <= 1000 / 100);
+    TEST_ASSERT_EQUAL(0, EEPROM.getCommitCount());
+
+    Config restarted(1);
+    restarted.begin();
+    restarted.load();
+    TEST_ASSERT_EQUAL(99, restarted.colorBrightness);
+}
+
+void writeEepromString(uint16_t address, uint16_t sizeAddress, const char *value) {
+    EEPROM.write(sizeAddress, strlen(value));
+    for (uint8_t i = 0; i < strlen(value); i++) {
+        EEPROM.write(address + i, value[i]);
+    }
+}
+
+void test_migration_from_eeprom(void) {
+    // version 5 layout
+    EEPROM.begin(512);
+    EEPROM.write(0, 5);
+    EEPROM.write(2, 0xE8); EEPROM.write(3, 0x03); // servo closed 1000
+    EEPROM.write(4, 0xD0); EEPROM.write(5, 0x07); // servo open 2000
+    EEPROM.write(6, 9); // revision
+    EEPROM.write(7, 0x39); EEPROM.write(8, 0x30); // serial number 12345
+    EEPROM.write(9, 0b011); // calibrated, bluetooth always on
+    EEPROM.write(20, 50); // touch threshold
+    EEPROM.write(22, 2); // colors
+    EEPROM.write(24, 30); // speed
+    EEPROM.write(25, 80); // max open level
+    EEPROM.write(26, 60); // brightness
+    uint16_t red = Config::encodeHSColor(0, 1), blue = Config::encodeHSColor(0.61, 1);
+    EEPROM.write(30, red & 0xFF); EEPROM.write(31, red >> 8);
+    EEPROM.write(32, blue & 0xFF); EEPROM.write(33, blue >> 8);
+    writeEepromString(60, 23, "My Floower");
+    writeEepromString(101, 100, "home");
+    writeEepromString(134, 133, "secret");
+    writeEepromString(199, 198, "token");
+    writeEepromString(240, 239, "device");
+    EEPROM.commit();
+
+    Config config(1);
+    config.begin();
+    config.load();
+    TEST_ASSERT_EQUAL(1000, config.servoClosed);
+    TEST_ASSERT_EQUAL(2000, config.servoOpen);
+    TEST_ASSERT_EQUAL(9, config.hardwareRevision);
+    TEST_ASSERT_EQUAL(12345, config.serialNumber);
+    TEST_ASSERT_TRUE(config.calibrated);
+    TEST_ASSERT_TRUE(config.bluetoothAlwaysOn);
+    TEST_ASSERT_FALSE(config.touchCalibrated);
+    TEST_ASSERT_EQUAL(50, config.touchThreshold);
+    TEST_ASSERT_EQUAL(30, config.speed);
+    TEST_ASSERT_EQUAL(80, config.maxOpenLevel);
+    TEST_ASSERT_EQUAL(60, config.colorBrightness);
+    TEST_ASSERT_EQUAL(2, config.colorSchemeSize);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 0.61, config.colorScheme[1].H);
+    TEST_ASSERT_EQUAL_STRING("My Floower", config.name.c_str());
+    TEST_ASSERT_EQUAL_STRING("home", config.wifiSsid.c_str());
+    TEST_ASSERT_EQUAL_STRING("secret", config.wifiPassword.c_str());
+    TEST_ASSERT_EQUAL_STRING("token", config.floudToken.c_str());
+    TEST_ASSERT_EQUAL_STRING("device", config.floudDeviceId.c_str());
+
+    // next boot reads the log only
+    EEPROM.clear();
+    Config rebooted(1);
+    rebooted.begin();
+    rebooted.load();
+    TEST_ASSERT_EQUAL(12345, rebooted.serialNumber);
+    TEST_ASSERT_EQUAL_STRING("My Floower", rebooted.name.c_str());
+    TEST_ASSERT_EQUAL_STRING("secret", rebooted.wifiPassword.c_str());
+}
+
+void test_migration_from_old_version(void) {
+    // version 3 had no settings values and no WiFi yet
+    EEPROM.begin(512);
+    EEPROM.write(0, 3);
+    EEPROM.write(2, 0xE8); EEPROM.write(3, 0x03);
+    EEPROM.write(6, 7);
+    EEPROM.write(9, 0b001);
+    writeEepromString(60, 23, "Old");
+    EEPROM.commit();
+
+    Config config(1);
+    config.begin();
+    config.load();
+    TEST_ASSERT_EQUAL(7, config.hardwareRevision);
+    TEST_ASSERT_EQUAL(DEFAULT_SPEED, config.speed);
+    TEST_ASSERT_EQUAL(DEFAULT_COLOR_BRIGHTNESS, config.colorBrightness);
+    TEST_ASSERT_EQUAL(8, config.colorSchemeSize);
+    TEST_ASSERT_EQUAL_STRING("Old", config.name.c_str());
+    TEST_ASSERT_TRUE(config.wifiSsid.isEmpty());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_flash);
+    RUN_TEST(test_values_survive_restart);
+    RUN_TEST(test_changes_are_appended);
+    RUN_TEST(test_compaction_rotates_sectors);
+    RUN_TEST(test_torn_record_is_dropped);
+    RUN_TEST(test_torn_compaction_keeps_old_sector);
+    RUN_TEST(test_corrupted_record_is_ignored);
+    RUN_TEST(test_slider_commits_erase_rarely);
+    RUN_TEST(test_migration_from_eeprom);
+    RUN_TEST(test_migration_from_old_version);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <chrono>
+#include "hardware/FixedColor.h"
+
+#define BENCHMARK_FRAMES 100000
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void assertRgbWithin(uint8_t delta, const RgbColor& expected, const RgbColor& actual) {
+    TEST_ASSERT_UINT8_WITHIN(delta, expected.R, actual.R);
+    TEST_ASSERT_UINT8_WITHIN(delta, expected.G, actual.G);
+    TEST_ASSERT_UINT8_WITHIN(delta, expected.B, actual.B);
+}
+
+void test_hsb_to_rgb_matches_float(void) {
+    for (float h = 0; h < 1; h += 0.01) {
+        for (float s = 0; s <= 1; s += 0.1) {
+            for (float b = 0; b <= 1; b += 0.1) {
+                HsbColor color(h, s, b);
+                assertRgbWithin(1, RgbColor(color), FixedHsbColor(color).toRgbColor());
+            }
+        }
+    }
+    // exact primaries
+    TEST_ASSERT_TRUE(RgbColor(255, 0, 0) == FixedHsbColor(HsbColor(0, 1, 1)).toRgbColor());
+    TEST_ASSERT_TRUE(RgbColor(0, 255, 0) == FixedHsbColor(HsbColor(1 / 3.0, 1, 1)).toRgbColor());
+    TEST_ASSERT_TRUE(RgbColor(255) == FixedHsbColor(HsbColor(0.5, 0, 1)).toRgbColor());
+    TEST_ASSERT_TRUE(RgbColor(0) == FixedHsbColor(HsbColor(0.5, 1, 0)).toRgbColor());
+}
+
+void test_rgb_to_hsb_round_trip(void) {
+    for (uint16_t r = 0; r < 256; r += 15) {
+        for (uint16_t g = 0; g < 256; g += 15) {
+            for (uint16_t b = 0; b < 256; b += 15) {
+                RgbColor color(r, g, b);
+                assertRgbWithin(1, color, FixedHsbColor::fromRgbColor(color).toRgbColor());
+            }
+        }
+    }
+}
+
+void test_blend_takes_shortest_hue_distance(void) {
+    FixedHsbColor left(HsbColor(0.9, 1, 1));
+    FixedHsbColor right(HsbColor(0.1, 0, 0.5));
+
+    HsbColor middle = FixedHsbColor::LinearBlend(left, right, FixedHsbColor::toProgress(0.5)).toHsbColor();
+    HsbColor expected = HsbColor::LinearBlend<NeoHueBlendShortestDistance>(HsbColor(0.9, 1, 1), HsbColor(0.1, 0, 0.5), 0.5);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, 0, middle.H < 0.5 ? middle.H : middle.H - 1);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, expected.S, middle.S);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, expected.B, middle.B);
+
+    // ends are exact
+    FixedHsbColor end = FixedHsbColor::LinearBlend(left, right, FixedHsbColor::toProgress(1));
+    TEST_ASSERT_EQUAL(right.H, end.H);
+    TEST_ASSERT_EQUAL(right.S, end.S);
+    TEST_ASSERT_EQUAL(right.B, end.B);
+    end = FixedHsbColor::LinearBlend(left, right, 0);
+    TEST_ASSERT_EQUAL(left.H, end.H);
+
+    RgbColor rgb = FixedHsbColor::LinearBlend(RgbColor(0, 100, 200), RgbColor(200, 100, 0), FixedHsbColor::toProgress(0.25));
+    TEST_ASSERT_TRUE(RgbColor(50, 100, 150) == rgb);
+}
+
+// 7 pixels of the rainbow loop and 6 candle blends, the heaviest animation frames. Reported only, on the host
+// the float path runs on a fast FPU, the integer kernels are meant for the ESP32
+void test_frame_benchmark(void) {
+    volatile uint8_t sink = 0;
+    HsbColor candleOrigin[6], candleTarget[6];
+    FixedHsbColor candleFixedOrigin[6], candleFixedTarget[6];
+    for (uint8_t i = 0; i < 6; i++) {
+        candleOrigin[i] = HsbColor(0.042, 1.0, random(20, 100) / 100.0);
+        candleTarget[i] = HsbColor(0.042, 1.0, random(20, 100) / 100.0);
+        candleFixedOrigin[i] = FixedHsbColor(candleOrigin[i]);
+        candleFixedTarget[i] = FixedHsbColor(candleTarget[i]);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < BENCHMARK_FRAMES; frame++) {
+        double progress = (frame % 1000) / 1000.0;
+        double hue = progress;
+        for (uint8_t i = 0; i < 7; i++, hue += 1.0 / 6.0) {
+            if (hue >= 1.0) {
+                hue = hue - 1;
+            }
+            sink = sink ^ RgbColor(HsbColor(hue, 1, 0.8)).G;
+        }
+        for (uint8_t i = 0; i < 6; i++) {
+            sink = sink ^ RgbColor(HsbColor::LinearBlend<NeoHueBlendShortestDistance>(candleOrigin[i], candleTarget[i], progress)).R;
+        }
+    }
+    double floatNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCHMARK_FRAMES;
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < BENCHMARK_FRAMES; frame++) {
+        uint16_t progress = FixedHsbColor::toProgress((frame % 1000) / 1000.0f);
+        FixedHsbColor color(progress, FIXED_COLOR_ONE, FIXED_COLOR_ONE * 8 / 10);
+        for (uint8_t i = 0; i < 7; i++, color.H += FIXED_HUE_TURN / 6) {
+            sink = sink ^ color.toRgbColor().G;
+        }
+        for (uint8_t i = 0; i < 6; i++) {
+            sink = sink ^ FixedHsbColor::LinearBlend(candleFixedOrigin[i], candleFixedTarget[i], progress).toRgbColor().R;
+        }
+    }
+    double fixedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCHMARK_FRAMES;
+
+    printf("animation frame (13 pixels): float %.0fns, fixed %.0fns (%.1fx)\n", floatNs, fixedNs, floatNs / fixedNs);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_hsb_to_rgb_matches_float);
+    RUN_TEST(test_rgb_to_hsb_round_trip);
+    RUN_TEST(test_blend_takes_shortest_hue_distance);
+    RUN_TEST(test_frame_benchmark);
+    UNITY_END();
+
+    return 0;
+}
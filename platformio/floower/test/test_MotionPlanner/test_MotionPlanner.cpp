@@ -0,0 +1,184 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "hardware/MotionPlanner.h"
+
+#define ACCELERATION 100000 // steps/s^2
+#define JERK 2000000 // steps/s^3
+#define MAX_SPEED 20000 // steps/s
+#define OPEN_STEPS 30000
+
+#define FIXED_US 256.0
+
+MotionPlanner trapezoidal(ACCELERATION, 0, MAX_SPEED);
+MotionPlanner sCurve(ACCELERATION, JERK, MAX_SPEED);
+
+uint64_t sumIntervals(MotionPlanner &planner) {
+    uint64_t sum = 0;
+    for (uint32_t step = 1; step <= planner.getSteps(); step++) {
+        sum += planner.getInterval(step);
+    }
+    return sum;
+}
+
+// steps/s^2 between two steps, speed is taken in the middle of intervals
+double accelerationAt(MotionPlanner &planner, uint32_t step) {
+    double interval = planner.getInterval(step) / FIXED_US / 1000000;
+    double previousInterval = planner.getInterval(step - 1) / FIXED_US / 1000000;
+    return (1 / interval - 1 / previousInterval) / ((interval + previousInterval) / 2);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_lands_on_transition_time(void) {
+    TEST_ASSERT_TRUE(trapezoidal.plan(OPEN_STEPS, 5000));
+    TEST_ASSERT_UINT32_WITHIN(100, 5000000, trapezoidal.getDuration() / FIXED_US);
+    TEST_ASSERT_TRUE(trapezoidal.getDuration() == sumIntervals(trapezoidal));
+
+    TEST_ASSERT_TRUE(sCurve.plan(OPEN_STEPS + 1000, 2500));
+    TEST_ASSERT_UINT32_WITHIN(100, 2500000, sCurve.getDuration() / FIXED_US);
+    TEST_ASSERT_TRUE(sCurve.getDuration() == sumIntervals(sCurve));
+}
+
+void test_trapezoidal_ramp_table(void) {
+    trapezoidal.plan(OPEN_STEPS, 5000);
+    uint32_t rampSteps = trapezoidal.getRampSteps();
+    TEST_ASSERT_GREATER_THAN(10, rampSteps);
+    TEST_ASSERT_LESS_OR_EQUAL(MOTION_RAMP_MAX_STEPS, rampSteps);
+
+    // first step after sqrt(2 / a)
+    TEST_ASSERT_UINT32_WITHIN(2, 4472, trapezoidal.getInterval(1) / FIXED_US);
+    for (uint32_t step = 2; step < rampSteps; step++) {
+        TEST_ASSERT_LESS_OR_EQUAL(trapezoidal.getInterval(step - 1), trapezoidal.getInterval(step));
+        if (step > 2) { // midpoint estimate is off on the very first steps
+            TEST_ASSERT_FLOAT_WITHIN(ACCELERATION * 0.02, ACCELERATION, accelerationAt(trapezoidal, step));
+        }
+    }
+    // cruise and mirrored deceleration
+    TEST_ASSERT_EQUAL(trapezoidal.getCruiseInterval(), trapezoidal.getInterval(OPEN_STEPS / 2));
+    for (uint32_t step = 1; step <= rampSteps; step++) {
+        TEST_ASSERT_EQUAL(trapezoidal.getInterval(step), trapezoidal.getInterval(OPEN_STEPS - step + 1));
+    }
+}
+
+void test_s_curve_ramp_table(void) {
+    sCurve.plan(OPEN_STEPS, 5000);
+    uint32_t rampSteps = sCurve.getRampSteps();
+    TEST_ASSERT_GREATER_THAN(10, rampSteps);
+
+    double maxAcceleration = 0;
+    for (uint32_t step = 2; step <= rampSteps; step++) {
+        TEST_ASSERT_LESS_OR_EQUAL(sCurve.getInterval(step - 1), sCurve.getInterval(step));
+        maxAcceleration = _max(maxAcceleration, accelerationAt(sCurve, step));
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(ACCELERATION * 1.02, maxAcceleration);
+    // acceleration builds up and fades out smoothly
+    TEST_ASSERT_LESS_THAN(maxAcceleration * 0.7, accelerationAt(sCurve, 3));
+    TEST_ASSERT_LESS_THAN(maxAcceleration * 0.1, accelerationAt(sCurve, rampSteps - 1));
+}
+
+void test_too_fast_movement(void) {
+    TEST_ASSERT_FALSE(trapezoidal.plan(OPEN_STEPS, 500));
+    TEST_ASSERT_GREATER_THAN(500000, trapezoidal.getDuration() / FIXED_US);
+    TEST_ASSERT_GREATER_OR_EQUAL(1000000 / MAX_SPEED, trapezoidal.getCruiseInterval() / FIXED_US);
+    TEST_ASSERT_TRUE(trapezoidal.getDuration() == sumIntervals(trapezoidal));
+
+    // instant movement is as fast as possible
+    TEST_ASSERT_FALSE(sCurve.plan(1000, 0));
+    TEST_ASSERT_GREATER_THAN(0, sCurve.getDuration());
+}
+
+void test_short_movement(void) {
+    // ramps overlap, no cruise
+    TEST_ASSERT_FALSE(trapezoidal.plan(7, 0));
+    TEST_ASSERT_TRUE(trapezoidal.getDuration() == sumIntervals(trapezoidal));
+    for (uint32_t step = 1; step <= 7; step++) {
+        TEST_ASSERT_EQUAL(trapezoidal.getInterval(step), trapezoidal.getInterval(8 - step));
+    }
+
+    TEST_ASSERT_TRUE(sCurve.plan(1, 1000));
+    TEST_ASSERT_UINT32_WITHIN(100, 1000000, sCurve.getDuration() / FIXED_US);
+
+    TEST_ASSERT_TRUE(sCurve.plan(0, 1000));
+    TEST_ASSERT_TRUE(sCurve.getDuration() == 0);
+}
+
+void test_segments_follow_plan(void) {
+    sCurve.plan(OPEN_STEPS, 5000);
+
+    uint32_t planned = 0;
+    while (planned < OPEN_STEPS) {
+        StepSegment segment = sCurve.getSegment(planned, 100);
+        TEST_ASSERT_GREATER_THAN(0, segment.steps);
+        for (uint16_t i = 0; i < segment.steps; i++) {
+            uint32_t interval = segment.intervals != nullptr ? segment.intervals[i * segment.intervalsStep] : segment.interval;
+            TEST_ASSERT_EQUAL(sCurve.getInterval(planned + i + 1), interval);
+        }
+        planned += segment.steps;
+    }
+    TEST_ASSERT_EQUAL(0, sCurve.getSegment(planned, 100).steps);
+}
+
+// steps/s^2 of the steepest change of the whole plan, taken over 16 steps as the fixed point rounding
+// of short intervals is in the order of the change between two steps
+double maxAccelerationOf(MotionPlanner &planner) {
+    double maxAcceleration = 0;
+    for (uint32_t step = 17; step <= planner.getSteps(); step++) {
+        double interval = planner.getInterval(step) / FIXED_US / 1000000;
+        double previousInterval = planner.getInterval(step - 16) / FIXED_US / 1000000;
+        double time = (interval + previousInterval) / 2;
+        for (uint32_t i = step - 15; i < step; i++) {
+            time += planner.getInterval(i) / FIXED_US / 1000000;
+        }
+        maxAcceleration = _max(maxAcceleration, fabs(1 / interval - 1 / previousInterval) / time);
+    }
+    return maxAcceleration;
+}
+
+void test_plan_from_running_start(void) {
+    // retargeted while cruising at 8000 steps/s, speeds up
+    TEST_ASSERT_TRUE(sCurve.plan(OPEN_STEPS / 2, 1500, 8000));
+    TEST_ASSERT_UINT32_WITHIN(2, 125, sCurve.getInterval(1) / FIXED_US);
+    TEST_ASSERT_GREATER_THAN(0, sCurve.getEntrySteps());
+    TEST_ASSERT_LESS_THAN(125 * FIXED_US, sCurve.getCruiseInterval());
+    TEST_ASSERT_UINT32_WITHIN(100, 1500000, sCurve.getDuration() / FIXED_US);
+    TEST_ASSERT_TRUE(sCurve.getDuration() == sumIntervals(sCurve));
+    TEST_ASSERT_LESS_OR_EQUAL(ACCELERATION * 1.02, maxAccelerationOf(sCurve));
+
+    // slows down to cruise
+    TEST_ASSERT_TRUE(trapezoidal.plan(OPEN_STEPS / 2, 5000, 15000));
+    TEST_ASSERT_UINT32_WITHIN(2, 67, trapezoidal.getInterval(1) / FIXED_US);
+    TEST_ASSERT_GREATER_THAN(67 * FIXED_US, trapezoidal.getCruiseInterval());
+    TEST_ASSERT_UINT32_WITHIN(100, 5000000, trapezoidal.getDuration() / FIXED_US);
+    TEST_ASSERT_TRUE(trapezoidal.getDuration() == sumIntervals(trapezoidal));
+    TEST_ASSERT_LESS_OR_EQUAL(ACCELERATION * 1.02, maxAccelerationOf(trapezoidal));
+
+    // braking to standstill
+    uint32_t stopSteps = trapezoidal.getStopSteps(15000);
+    TEST_ASSERT_EQUAL(1125, stopSteps); // v^2 / 2a
+    trapezoidal.plan(stopSteps, 0, 15000);
+    TEST_ASSERT_UINT32_WITHIN(2, 67, trapezoidal.getInterval(1) / FIXED_US);
+    TEST_ASSERT_LESS_OR_EQUAL(ACCELERATION * 1.02, maxAccelerationOf(trapezoidal));
+    TEST_ASSERT_GREATER_THAN(1000 * FIXED_US, trapezoidal.getInterval(stopSteps));
+
+    // not enough steps to stop, planned from rest
+    trapezoidal.plan(stopSteps - 1, 0, 15000);
+    TEST_ASSERT_GREATER_THAN(1000 * FIXED_US, trapezoidal.getInterval(1));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_lands_on_transition_time);
+    RUN_TEST(test_trapezoidal_ramp_table);
+    RUN_TEST(test_s_curve_ramp_table);
+    RUN_TEST(test_too_fast_movement);
+    RUN_TEST(test_short_movement);
+    RUN_TEST(test_segments_follow_plan);
+    RUN_TEST(test_plan_from_running_start);
+    UNITY_END();
+
+    return 0;
+}
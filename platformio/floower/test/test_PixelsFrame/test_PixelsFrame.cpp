@@ -0,0 +1,118 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "hardware/PixelsFrame.h"
+#include "NativeHal.h"
+
+void setUp(void) {
+    NativeHal::reset();
+}
+
+void tearDown(void) {
+}
+
+void test_gamma_table(void) {
+    PixelsFrame frame(1);
+    frame.setBrightness(100);
+
+    TEST_ASSERT_TRUE(RgbColor(0) == frame.toOutputColor(RgbColor(0)));
+    TEST_ASSERT_TRUE(RgbColor(255) == frame.toOutputColor(RgbColor(255)));
+    TEST_ASSERT_UINT8_WITHIN(1, 56, frame.toOutputColor(RgbColor(128)).R); // 0.5^2.2
+    uint8_t last = 0;
+    for (uint16_t i = 0; i < 256; i++) {
+        uint8_t value = frame.toOutputColor(RgbColor(i)).G;
+        TEST_ASSERT_TRUE(value >= last);
+        last = value;
+    }
+}
+
+void test_brightness_scales_output(void) {
+    PixelsFrame frame(1);
+    frame.setBrightness(50);
+    TEST_ASSERT_EQUAL(50, frame.getBrightness());
+    TEST_ASSERT_TRUE(RgbColor(128, 0, 28) == frame.toOutputColor(RgbColor(255, 0, 128)));
+
+    frame.setBrightness(0);
+    TEST_ASSERT_TRUE(RgbColor(0) == frame.toOutputColor(RgbColor(255)));
+
+    frame.setBrightness(150); // clamped
+    TEST_ASSERT_EQUAL(100, frame.getBrightness());
+}
+
+void test_applied_to_bus_when_dirty(void) {
+    NeoPixelBus<NeoGrbFeature, NeoEsp32I2s0800KbpsMethod> bus(3, 0);
+    PixelsFrame frame(3);
+    frame.setBrightness(100);
+    frame.show(bus, true);
+    TEST_ASSERT_FALSE(frame.isDirty());
+
+    frame.setPixelColor(1, RgbColor(255, 128, 0));
+    frame.setPixelColor(5, RgbColor(255)); // out of range
+    TEST_ASSERT_TRUE(frame.isDirty());
+    TEST_ASSERT_TRUE(frame.show(bus, true));
+    TEST_ASSERT_FALSE(frame.isDirty());
+    TEST_ASSERT_TRUE(RgbColor(0) == bus.GetPixelColor(0));
+    TEST_ASSERT_TRUE(RgbColor(255, 56, 0) == bus.GetPixelColor(1));
+    TEST_ASSERT_TRUE(RgbColor(255, 128, 0) == frame.getPixelColor(1)); // frame stays linear
+
+    // same brightness again does not touch the frame, a new one makes it dirty
+    frame.setBrightness(100);
+    TEST_ASSERT_FALSE(frame.isDirty());
+    frame.setBrightness(20);
+    TEST_ASSERT_TRUE(frame.isDirty());
+    frame.show(bus, true);
+    TEST_ASSERT_TRUE(RgbColor(51, 11, 0) == bus.GetShownPixelColor(1));
+}
+
+void test_frame_rate(void) {
+    NeoPixelBus<NeoGrbFeature, NeoEsp32I2s0800KbpsMethod> bus(7, 0);
+    PixelsFrame frame(7);
+    frame.setFrameRate(25);
+
+    // slow fade redrawn every 1ms for a second
+    NativeHal::simulate([&]() {
+        frame.clearTo(RgbColor(millis() / 4));
+        frame.show(bus);
+    }, 1000);
+
+    TEST_ASSERT_UINT32_WITHIN(1, 25, frame.getFramesShown());
+    TEST_ASSERT_UINT32_WITHIN(1, 25, bus.GetShowCount());
+}
+
+void test_identical_output_is_skipped(void) {
+    NeoPixelBus<NeoGrbFeature, NeoEsp32I2s0800KbpsMethod> bus(7, 0);
+    PixelsFrame frame(7);
+    frame.setBrightness(10);
+    frame.show(bus, true);
+    uint32_t showCount = bus.GetShowCount();
+
+    // the bottom of a fade at low brightness stays dark after gamma
+    for (uint8_t i = 1; i <= 30; i++) {
+        frame.clearTo(RgbColor(i));
+        NativeHal::advanceClock(20000);
+        TEST_ASSERT_FALSE(frame.show(bus));
+    }
+    TEST_ASSERT_EQUAL(30, frame.getFramesSkipped());
+    TEST_ASSERT_EQUAL(showCount, bus.GetShowCount());
+
+    // the same color again does not even make the frame dirty
+    frame.clearTo(RgbColor(255));
+    NativeHal::advanceClock(20000);
+    TEST_ASSERT_TRUE(frame.show(bus));
+    frame.clearTo(RgbColor(255));
+    TEST_ASSERT_FALSE(frame.isDirty());
+    NativeHal::advanceClock(20000);
+    TEST_ASSERT_FALSE(frame.show(bus));
+    TEST_ASSERT_EQUAL(30, frame.getFramesSkipped());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_gamma_table);
+    RUN_TEST(test_brightness_scales_output);
+    RUN_TEST(test_applied_to_bus_when_dirty);
+    RUN_TEST(test_frame_rate);
+    RUN_TEST(test_identical_output_is_skipped);
+    UNITY_END();
+
+    return 0;
+}
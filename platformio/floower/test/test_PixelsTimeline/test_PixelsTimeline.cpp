@@ -0,0 +1,204 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <chrono>
+#include "hardware/PixelsEffects.h"
+
+#define BENCHMARK_FRAMES 20000
+
+const FixedHsbColor base(HsbColor(0.61, 0.8, 1.0));
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void assertRgbWithin(uint8_t delta, const RgbColor& expected, const RgbColor& actual, uint32_t time, uint8_t pixel) {
+    char message[40];
+    snprintf(message, sizeof(message), "at %ums pixel %d", time, pixel);
+    TEST_ASSERT_UINT8_WITHIN_MESSAGE(delta, expected.R, actual.R, message);
+    TEST_ASSERT_UINT8_WITHIN_MESSAGE(delta, expected.G, actual.G, message);
+    TEST_ASSERT_UINT8_WITHIN_MESSAGE(delta, expected.B, actual.B, message);
+}
+
+// the hand written effects the timelines replaced, frame by frame
+
+void referenceFlash(float progress, RgbColor *pixels) {
+    HsbColor color = base.toHsbColor();
+    color.B = progress < 0.5 ? NeoEase::CubicInOut(progress * 2) : NeoEase::CubicInOut((1 - progress) * 2);
+    for (uint8_t i = 0; i < 7; i++) {
+        pixels[i] = FixedHsbColor(color).toRgbColor();
+    }
+}
+
+void referenceCircle(float progress, RgbColor *pixels) {
+    int index = (progress * 6) + 1;
+    FixedHsbColor color(base);
+    int32_t brightness = FIXED_COLOR_ONE;
+    for (uint8_t i = 0; i < 7; i++) {
+        pixels[i] = RgbColor(0);
+    }
+    for (uint8_t i = 0; i < 3; i++, index--, brightness -= FIXED_COLOR_ONE * 45 / 100) {
+        if (index < 1) {
+            index += 6;
+        }
+        color.B = _max(brightness, 0);
+        pixels[index] = color.toRgbColor();
+    }
+}
+
+void referenceRainbow(float progress, RgbColor *pixels) {
+    HsbColor origin = base.toHsbColor();
+    float hue = origin.H + progress;
+    if (hue >= 1.0) {
+        hue = hue - 1;
+    }
+    for (uint8_t i = 0; i < 7; i++) {
+        pixels[i] = FixedHsbColor(HsbColor(hue, 1, origin.B)).toRgbColor();
+    }
+}
+
+void referenceRainbowLoop(float progress, RgbColor *pixels) {
+    FixedHsbColor color(HsbColor(progress, 1, 1));
+    pixels[0] = color.toRgbColor();
+    for (uint8_t i = 1; i < 7; i++, color.H += FIXED_HUE_TURN / 6) {
+        pixels[i] = color.toRgbColor();
+    }
+}
+
+// plays the timeline with 1ms frames and compares every frame, except the ones right at a
+// step of the reference where the float and integer positions may fall on different sides
+void assertGolden(const PixelsTimeline& timeline, void (*reference)(float, RgbColor*), uint32_t duration, uint8_t steps) {
+    PixelsFrame frame(7);
+    RgbColor expected[7];
+    for (uint32_t time = 0; time <= duration; time++) {
+        float progress = time / (float) duration;
+        if (steps > 0 && time > 0 && (time * steps) % duration == 0) {
+            continue;
+        }
+        timeline.render(frame, base, FixedHsbColor::toProgress(progress));
+        reference(progress, expected);
+        for (uint8_t i = 0; i < 7; i++) {
+            assertRgbWithin(1, expected[i], frame.getPixelColor(i), time, i);
+        }
+    }
+}
+
+void test_easing_matches_neo_ease(void) {
+    for (uint32_t x = 0; x <= FIXED_COLOR_ONE; x += 97) {
+        float unit = x / (float) FIXED_COLOR_ONE;
+        TEST_ASSERT_FLOAT_WITHIN(0.0001, NeoEase::CubicInOut(unit), PixelsTimeline::ease(PIXELS_EASE_CUBIC_IN_OUT, x) / (float) FIXED_COLOR_ONE);
+        TEST_ASSERT_FLOAT_WITHIN(0.0001, NeoEase::QuadraticInOut(unit), PixelsTimeline::ease(PIXELS_EASE_QUADRATIC_IN_OUT, x) / (float) FIXED_COLOR_ONE);
+        TEST_ASSERT_EQUAL(x, PixelsTimeline::ease(PIXELS_EASE_LINEAR, x));
+    }
+    TEST_ASSERT_EQUAL(0, PixelsTimeline::ease(PIXELS_EASE_STEP, FIXED_COLOR_ONE - 1));
+    TEST_ASSERT_EQUAL(FIXED_COLOR_ONE, PixelsTimeline::ease(PIXELS_EASE_STEP, FIXED_COLOR_ONE));
+}
+
+void test_track_interpolation(void) {
+    const PixelsKeyframe keyframes[] = {
+        {1000, FixedHsbColor(0, 0, 1000), PIXELS_EASE_LINEAR},
+        {2000, FixedHsbColor(0, 0, 2000), PIXELS_EASE_LINEAR},
+        {3000, FixedHsbColor(0, 0, 5000), PIXELS_EASE_STEP}
+    };
+    PixelsTrack track = PIXELS_TRACK(0x01, 0, 0, keyframes);
+
+    TEST_ASSERT_EQUAL(1000, PixelsTimeline::evaluate(track, base, 0).B); // before the first
+    TEST_ASSERT_EQUAL(1500, PixelsTimeline::evaluate(track, base, 1500).B);
+    TEST_ASSERT_EQUAL(2000, PixelsTimeline::evaluate(track, base, 2999).B); // step holds
+    TEST_ASSERT_EQUAL(5000, PixelsTimeline::evaluate(track, base, 3000).B);
+    TEST_ASSERT_EQUAL(5000, PixelsTimeline::evaluate(track, base, PIXELS_TIMELINE_END).B); // after the last
+
+    // looping goes back to the first keyframe at the end, an offset shifts the whole track
+    track.flags = PIXELS_TRACK_LOOP;
+    TEST_ASSERT_UINT16_WITHIN(1, 3000, PixelsTimeline::evaluate(track, base, 3000 + (PIXELS_TIMELINE_END - 3000) / 2).B);
+    track.offset = 500;
+    TEST_ASSERT_EQUAL(1500, PixelsTimeline::evaluate(track, base, 1000).B);
+
+    // base color channels
+    track.flags = PIXELS_TRACK_BASE_HUE | PIXELS_TRACK_BASE_SATURATION | PIXELS_TRACK_BASE_BRIGHTNESS;
+    FixedHsbColor color = PixelsTimeline::evaluate(track, base, 1000);
+    TEST_ASSERT_EQUAL(base.H, color.H);
+    TEST_ASSERT_EQUAL(base.S, color.S);
+    TEST_ASSERT_EQUAL(base.B, color.B);
+}
+
+void test_later_tracks_overwrite(void) {
+    const PixelsKeyframe red[] = {{0, FixedHsbColor(0, FIXED_COLOR_ONE, FIXED_COLOR_ONE), PIXELS_EASE_LINEAR}};
+    const PixelsKeyframe black[] = {{0, FixedHsbColor(0, 0, 0), PIXELS_EASE_LINEAR}};
+    const PixelsTrack tracks[] = {
+        PIXELS_TRACK(0x7F, 0, 0, red),
+        PIXELS_TRACK(0x41, 0, 0, black)
+    };
+    PixelsTimeline timeline = PIXELS_TIMELINE(tracks);
+    PixelsFrame frame(7);
+    timeline.render(frame, base, 0);
+
+    TEST_ASSERT_TRUE(RgbColor(0) == frame.getPixelColor(0));
+    TEST_ASSERT_TRUE(RgbColor(255, 0, 0) == frame.getPixelColor(1));
+    TEST_ASSERT_TRUE(RgbColor(255, 0, 0) == frame.getPixelColor(5));
+    TEST_ASSERT_TRUE(RgbColor(0) == frame.getPixelColor(6));
+    TEST_ASSERT_EQUAL(0, timeline.colorOf(6, base, 0).B);
+    TEST_ASSERT_EQUAL(FIXED_COLOR_ONE, timeline.colorOf(3, base, 0).B);
+}
+
+void test_flash_golden(void) {
+    assertGolden(flashTimeline, referenceFlash, 1000, 0);
+}
+
+void test_circle_golden(void) {
+    assertGolden(circleTimeline, referenceCircle, 600, 6);
+}
+
+void test_rainbow_golden(void) {
+    assertGolden(rainbowTimeline, referenceRainbow, 10000, 0);
+}
+
+void test_rainbow_loop_golden(void) {
+    assertGolden(rainbowLoopTimeline, referenceRainbowLoop, 10000, 0);
+}
+
+// per frame cost of drawing 7 pixels, the timeline against the hand written effect
+void benchmark(const char* name, const PixelsTimeline& timeline, void (*reference)(float, RgbColor*)) {
+    PixelsFrame frame(7);
+    RgbColor pixels[7];
+    volatile uint8_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCHMARK_FRAMES; i++) {
+        reference((i % 1000) / 1000.0f, pixels);
+        sink = sink ^ pixels[3].R;
+    }
+    double referenceNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCHMARK_FRAMES;
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCHMARK_FRAMES; i++) {
+        timeline.render(frame, base, FixedHsbColor::toProgress((i % 1000) / 1000.0f));
+        sink = sink ^ frame.getPixelColor(3).R;
+    }
+    double timelineNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCHMARK_FRAMES;
+
+    printf("%s frame: hand written %.0fns, timeline %.0fns\n", name, referenceNs, timelineNs);
+}
+
+void test_frame_benchmark(void) {
+    benchmark("flash", flashTimeline, referenceFlash);
+    benchmark("circle", circleTimeline, referenceCircle);
+    benchmark("rainbow", rainbowTimeline, referenceRainbow);
+    benchmark("rainbow loop", rainbowLoopTimeline, referenceRainbowLoop);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_easing_matches_neo_ease);
+    RUN_TEST(test_track_interpolation);
+    RUN_TEST(test_later_tracks_overwrite);
+    RUN_TEST(test_flash_golden);
+    RUN_TEST(test_circle_golden);
+    RUN_TEST(test_rainbow_golden);
+    RUN_TEST(test_rainbow_loop_golden);
+    RUN_TEST(test_frame_benchmark);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,367 @@
+#include <Arduino.h>
+#include <NativeHal.h>
+#include <unity.h>
+#include <vector>
+#include "connect/RemoteControl.h"
+#include "behavior/BloomingBehavior.h"
+
+#define BATTERY_ANALOG_PIN GPIO_NUM_36
+#define USB_ANALOG_PIN GPIO_NUM_39
+#define TOUCH_SENSOR_PIN GPIO_NUM_4
+#define CHARGE_PIN GPIO_NUM_35
+
+#define ADC_BATTERY_FULL 2300 // ~4.16V
+#define ADC_USB_CONNECTED 2900
+
+#define HOUR_MS 3600000UL
+#define HOMING_MS 7000 // petals search for the closed end stop after power on
+
+struct Device {
+    Config config;
+    Floower floower;
+    CommandProtocol cmdProtocol;
+    BluetoothConnect bluetoothConnect;
+    WifiConnect wifiConnect;
+    RemoteControl remoteControl;
+    BloomingBehavior behavior;
+
+    Device(bool usbPowered, bool wifiEnabled = false) : config(1), floower(&config), cmdProtocol(&config, &floower),
+            bluetoothConnect(&floower, &config, &cmdProtocol), wifiConnect(&config, &cmdProtocol),
+            remoteControl(&bluetoothConnect, &wifiConnect, &cmdProtocol), behavior(&config, &floower, &remoteControl) {
+        NativeHal::setAnalogInput(BATTERY_ANALOG_PIN, ADC_BATTERY_FULL);
+        NativeHal::setAnalogInput(USB_ANALOG_PIN, usbPowered ? ADC_USB_CONNECTED : 0);
+        NativeHal::setDigitalInput(CHARGE_PIN, usbPowered ? LOW : HIGH); // charger pulls the pin low
+        config.begin();
+        config.hardwareCalibration(1000, 1000, 9, 1);
+        config.factorySettings();
+        config.setCalibrated();
+        config.load();
+        config.deepSleepEnabled = true;
+        config.wifiEnabled = wifiEnabled;
+        floower.init();
+        floower.readPowerState();
+        behavior.setup(false);
+    }
+
+    // same as loop() in main.cpp
+    void loop() {
+        uint32_t deepSleepCount = NativeHal::getDeepSleepCount();
+        floower.update();
+        behavior.loop();
+        if (NativeHal::getDeepSleepCount() != deepSleepCount) {
+            return; // esp_deep_sleep_start() never returns on the device
+        }
+        wifiConnect.loop();
+        if (!floower.lightSleep(behavior.getIdleDuration()) && behavior.isIdle()) {
+            delay(10);
+        }
+    }
+
+    unsigned long run(unsigned long durationMs) {
+        return NativeHal::simulate([this]() { loop(); }, durationMs);
+    }
+};
+
+void setUp(void) {
+    NativeHal::reset();
+}
+
+void tearDown(void) {
+}
+
+void test_deep_sleep_after_inactivity(void) {
+    Device device(false);
+    unsigned long setupTime = millis();
+
+    unsigned long simulated = device.run(2 * HOUR_MS);
+
+    TEST_ASSERT_EQUAL(1, NativeHal::getDeepSleepCount());
+    TEST_ASSERT_UINT32_WITHIN(100, 60000, NativeHal::getDeepSleepTime() - setupTime);
+    TEST_ASSERT_LESS_THAN(2 * HOUR_MS, simulated);
+}
+
+void test_no_deep_sleep_when_usb_powered(void) {
+    Device device(true);
+
+    unsigned long simulated = device.run(2 * HOUR_MS);
+
+    TEST_ASSERT_EQUAL(0, NativeHal::getDeepSleepCount());
+    TEST_ASSERT_UINT32_WITHIN(20, 2 * HOUR_MS, simulated); // the last loop may overrun by its idle delay
+    TEST_ASSERT_UINT32_WITHIN(100, 2 * 3600, NativeHal::getWatchdogResetCount()); // ~1s period
+}
+
+void test_wifi_reconnect_interval(void) {
+    Device device(true, true);
+    device.config.setWifi("home", "secret");
+
+    // access point is down, retry every 30s
+    device.run(10 * 60000);
+    TEST_ASSERT_UINT32_WITHIN(1, 20, WiFi.getConnectAttempts());
+    TEST_ASSERT_EQUAL(WIFI_STATUS_FAILED, device.wifiConnect.getStatus());
+
+    // access point is back, connected with the next retry
+    WiFi.setNetworkAvailable("home", true);
+    device.run(30000);
+    TEST_ASSERT_EQUAL(WL_CONNECTED, WiFi.status());
+    TEST_ASSERT_EQUAL(WIFI_STATUS_CONNECTING, device.wifiConnect.getStatus()); // no Floud token
+}
+
+void test_color_transition_completes(void) {
+    Device device(true);
+    device.run(1000);
+
+    device.floower.transitionColor(colorGreen.H, colorGreen.S, 0.7, 5000);
+    device.run(4900);
+    TEST_ASSERT_TRUE(device.floower.isChangingColor());
+
+    device.run(200);
+    TEST_ASSERT_FALSE(device.floower.isChangingColor());
+    TEST_ASSERT_TRUE(device.floower.isLit());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, colorGreen.H, device.floower.getCurrentColor().H);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.7, device.floower.getCurrentColor().B);
+}
+
+void test_light_sleep_while_lit_on_battery(void) {
+    Device device(false);
+    device.run(HOMING_MS);
+    device.floower.transitionColor(colorGreen.H, colorGreen.S, 0.7, 1000);
+    device.run(1500);
+    TEST_ASSERT_FALSE(device.floower.isChangingColor());
+
+    // static color, the CPU sleeps between the behavior watchdogs
+    unsigned long sleepStart = NativeHal::getLightSleepTime();
+    uint32_t watchdogStart = NativeHal::getWatchdogResetCount();
+    device.run(20000);
+    TEST_ASSERT_GREATER_THAN(19000, NativeHal::getLightSleepTime() - sleepStart);
+    TEST_ASSERT_UINT32_WITHIN(1, 20, NativeHal::getWatchdogResetCount() - watchdogStart);
+    TEST_ASSERT_TRUE(device.floower.isLit());
+    TEST_ASSERT_EQUAL(0, NativeHal::getDeepSleepCount());
+}
+
+void test_light_sleep_between_frames(void) {
+    Device device(false);
+    device.run(HOMING_MS);
+
+    // the CPU may sleep between the frames only
+    device.floower.transitionColor(colorGreen.H, colorGreen.S, 0.7, 2000);
+    uint32_t sleepCount = NativeHal::getLightSleepCount();
+    unsigned long sleepStart = NativeHal::getLightSleepTime();
+    device.run(1000);
+    TEST_ASSERT_TRUE(device.floower.isChangingColor());
+    TEST_ASSERT_GREATER_THAN(sleepCount + 40, NativeHal::getLightSleepCount()); // ~50 fps
+    TEST_ASSERT_UINT32_WITHIN(100, 900, NativeHal::getLightSleepTime() - sleepStart); // a frame takes a tick
+    TEST_ASSERT_UINT32_WITHIN(5, 50, device.floower.getPixelsFramesShown() + device.floower.getPixelsFramesSkipped());
+
+    // the petals need the CPU all the time
+    device.floower.setPetalsOpenLevel(50, 1000);
+    sleepCount = NativeHal::getLightSleepCount();
+    device.run(500);
+    TEST_ASSERT_TRUE(device.floower.arePetalsMoving());
+    TEST_ASSERT_EQUAL(sleepCount, NativeHal::getLightSleepCount());
+}
+
+void test_final_frame_shown_before_light_sleep(void) {
+    Device device(false);
+    device.run(HOMING_MS);
+    device.floower.update(); // animation clock catches up with the light sleep
+
+    // the last animation step may wait for its frame slot, it goes out before the CPU sleeps longer than a frame
+    device.floower.transitionColor(colorGreen.H, colorGreen.S, 0.7, 1000);
+    uint32_t framesAtSleep = 0;
+    NativeHal::simulate([&]() { // the Floower alone decides when to sleep, no behavior deadlines
+        device.floower.update();
+        unsigned long sleepTime = NativeHal::getLightSleepTime();
+        device.floower.lightSleep(1000);
+        bool slept = NativeHal::getLightSleepTime() - sleepTime > 1000 / PIXELS_DEFAULT_FRAME_RATE;
+        if (slept && framesAtSleep == 0 && !device.floower.isChangingColor()) {
+            framesAtSleep = device.floower.getPixelsFramesShown() + device.floower.getPixelsFramesSkipped();
+        }
+    }, 3000);
+    TEST_ASSERT_GREATER_THAN(40, framesAtSleep); // ~50 fps
+    TEST_ASSERT_EQUAL(framesAtSleep, device.floower.getPixelsFramesShown() + device.floower.getPixelsFramesSkipped());
+}
+
+void test_touch_wakes_from_light_sleep(void) {
+    Device device(false);
+    device.run(HOMING_MS);
+    TEST_ASSERT_GREATER_THAN(0, NativeHal::getLightSleepCount());
+    TEST_ASSERT_FALSE(device.floower.isLit());
+
+    // leaf touched while sleeping, the CPU wakes up right away and the touch is not lost
+    NativeHal::setTouchInput(TOUCH_SENSOR_PIN, 0);
+    unsigned long sleepStart = millis();
+    TEST_ASSERT_TRUE(device.floower.lightSleep(10000));
+    TEST_ASSERT_EQUAL(ESP_SLEEP_WAKEUP_TOUCHPAD, esp_sleep_get_wakeup_cause());
+    TEST_ASSERT_EQUAL(sleepStart, millis());
+    TEST_ASSERT_EQUAL(0, device.floower.getIdleDuration()); // touch in progress
+
+    device.run(50);
+    NativeHal::setTouchInput(TOUCH_SENSOR_PIN, 70);
+    device.run(500);
+    TEST_ASSERT_TRUE(device.floower.isLit());
+}
+
+void test_deep_sleep_deadline_with_light_sleep(void) {
+    Device device(false);
+    unsigned long setupTime = millis();
+    device.run(2 * HOUR_MS);
+    TEST_ASSERT_EQUAL(1, NativeHal::getDeepSleepCount());
+    TEST_ASSERT_UINT32_WITHIN(10, 60000, NativeHal::getDeepSleepTime() - setupTime);
+    TEST_ASSERT_GREATER_THAN(55000, NativeHal::getLightSleepTime());
+}
+
+void test_deep_sleep_after_light_sleep_wakes_on_touch_only(void) {
+    Device device(false);
+    device.run(2 * HOUR_MS);
+    TEST_ASSERT_GREATER_THAN(0, NativeHal::getLightSleepCount());
+    TEST_ASSERT_EQUAL(1, NativeHal::getDeepSleepCount());
+    TEST_ASSERT_NOT_EQUAL(ESP_SLEEP_WAKEUP_TIMER, esp_sleep_get_wakeup_cause()); // timer of the last light sleep disarmed
+}
+
+void test_touch_threshold_follows_drift(void) {
+    Device device(true);
+    device.run(HOMING_MS);
+
+    // humidity lowers the untouched reading under the calibrated threshold within 10 minutes
+    for (uint16_t value = 70; value >= 50; value--) {
+        NativeHal::setTouchInput(TOUCH_SENSOR_PIN, value);
+        device.run(30000);
+    }
+    TEST_ASSERT_FALSE(device.floower.isLit()); // no phantom touch
+    TEST_ASSERT_UINT16_WITHIN(1, 50, device.floower.getTouchBaseline());
+    TEST_ASSERT_UINT16_WITHIN(2, 45, NativeHal::getTouchThreshold(TOUCH_SENSOR_PIN));
+
+    // the leaf still works
+    NativeHal::setTouchInput(TOUCH_SENSOR_PIN, 10);
+    device.run(50);
+    NativeHal::setTouchInput(TOUCH_SENSOR_PIN, 50);
+    device.run(500);
+    TEST_ASSERT_TRUE(device.floower.isLit());
+}
+
+void test_double_tap_without_cooldown(void) {
+    Device device(true);
+    device.run(HOMING_MS);
+    std::vector<FloowerTouchEvent> events;
+    device.floower.enableTouch([&](const FloowerTouchEvent& event) { events.push_back(event); });
+
+    for (uint8_t i = 0; i < 2; i++) {
+        NativeHal::setTouchInput(TOUCH_SENSOR_PIN, 10);
+        device.run(100);
+        NativeHal::setTouchInput(TOUCH_SENSOR_PIN, 70);
+        device.run(150);
+    }
+    TEST_ASSERT_EQUAL(5, events.size());
+    TEST_ASSERT_EQUAL(TOUCH_DOUBLE_TAP, events[3]);
+    TEST_ASSERT_EQUAL(TOUCH_UP, events[4]);
+    TEST_ASSERT_UINT32_WITHIN(10, 100, device.floower.getTouchDuration()); // the idle loop runs every 10ms
+
+    TouchEdge timeline[TOUCH_TIMELINE_LENGTH];
+    TEST_ASSERT_EQUAL(4, device.floower.getTouchTimeline(timeline));
+    TEST_ASSERT_TRUE(timeline[0].touched);
+    TEST_ASSERT_UINT32_WITHIN(10, 250, timeline[2].time - timeline[0].time);
+}
+
+struct RecordingResponder : public CommandResponder {
+    uint16_t type = 0xFFFF;
+    uint16_t id = 0;
+
+    void sendResponse(const uint16_t type, const uint16_t id, const char *payload, const uint16_t payloadLength) {
+        this->type = type;
+        this->id = id;
+    }
+};
+
+void test_queued_commands_run_in_control_loop(void) {
+    Device device(true);
+    RecordingResponder responder;
+    const uint8_t show[] = {CHOREO_WAIT, 0xE8, 0x03};
+
+    // without the queue the command runs right away
+    TEST_ASSERT_TRUE(device.cmdProtocol.post(CMD_PLAY_CHOREOGRAPHY, 7, (const char *) show, sizeof(show), &responder));
+    TEST_ASSERT_TRUE(device.floower.isPlayingChoreography());
+    TEST_ASSERT_EQUAL(STATUS_OK, responder.type);
+    TEST_ASSERT_EQUAL(7, responder.id);
+    device.floower.stopChoreography();
+
+    // with the queue the connection only hands it over
+    device.cmdProtocol.enableQueue();
+    responder.type = 0xFFFF;
+    TEST_ASSERT_TRUE(device.cmdProtocol.post(CMD_PLAY_CHOREOGRAPHY, 8, (const char *) show, sizeof(show), &responder));
+    TEST_ASSERT_FALSE(device.floower.isPlayingChoreography());
+    TEST_ASSERT_EQUAL(0xFFFF, responder.type);
+
+    TEST_ASSERT_TRUE(device.cmdProtocol.waitForCommand(0));
+    device.cmdProtocol.process();
+    TEST_ASSERT_TRUE(device.floower.isPlayingChoreography());
+    TEST_ASSERT_EQUAL(STATUS_OK, responder.type);
+    TEST_ASSERT_EQUAL(8, responder.id);
+
+    // nothing left, waiting moves the clock
+    unsigned long waitStart = millis();
+    TEST_ASSERT_FALSE(device.cmdProtocol.waitForCommand(10));
+    TEST_ASSERT_UINT32_WITHIN(1, 10, millis() - waitStart);
+
+    // bounded queue
+    for (uint8_t i = 0; i < COMMAND_QUEUE_LENGTH; i++) {
+        TEST_ASSERT_TRUE(device.cmdProtocol.post(CMD_PLAY_CHOREOGRAPHY, i, (const char *) show, sizeof(show)));
+    }
+    TEST_ASSERT_FALSE(device.cmdProtocol.post(CMD_PLAY_CHOREOGRAPHY, 0, (const char *) show, sizeof(show)));
+    device.cmdProtocol.process();
+    TEST_ASSERT_FALSE(device.cmdProtocol.waitForCommand(0));
+}
+
+struct LockCheckingResponder : public CommandResponder {
+    SemaphoreHandle_t mutex;
+    bool unlocked = false;
+
+    void sendResponse(const uint16_t type, const uint16_t id, const char *payload, const uint16_t payloadLength) {
+        unlocked = xSemaphoreTake(mutex, 0) == pdTRUE;
+        if (unlocked) {
+            xSemaphoreGive(mutex);
+        }
+    }
+};
+
+void test_state_unlocked_while_responding(void) {
+    Device device(true);
+    LockCheckingResponder responder;
+    responder.mutex = xSemaphoreCreateMutex();
+    device.cmdProtocol.enableQueue(responder.mutex);
+    const uint8_t petals[] = {0x81, 0xA1, 'l', 0x32}; // { l: 50 }
+
+    TEST_ASSERT_TRUE(device.cmdProtocol.post(CMD_WRITE_PETALS, 1, (const char *) petals, sizeof(petals), &responder));
+    device.cmdProtocol.process();
+    TEST_ASSERT_EQUAL(50, device.floower.getPetalsOpenLevel());
+    TEST_ASSERT_TRUE(responder.unlocked);
+
+    // Bluetooth connection hands the config change over to the control task
+    device.config.setBluetoothAlwaysOn(false);
+    TEST_ASSERT_TRUE(device.cmdProtocol.post(PROTOCOL_BLUETOOTH_CONNECTED, 0, nullptr, 0));
+    TEST_ASSERT_FALSE(device.config.bluetoothAlwaysOn);
+    device.cmdProtocol.process();
+    TEST_ASSERT_TRUE(device.config.bluetoothAlwaysOn);
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(responder.mutex, 0));
+    vSemaphoreDelete(responder.mutex);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_deep_sleep_after_inactivity);
+    RUN_TEST(test_no_deep_sleep_when_usb_powered);
+    RUN_TEST(test_wifi_reconnect_interval);
+    RUN_TEST(test_color_transition_completes);
+    RUN_TEST(test_queued_commands_run_in_control_loop);
+    RUN_TEST(test_state_unlocked_while_responding);
+    RUN_TEST(test_light_sleep_while_lit_on_battery);
+    RUN_TEST(test_light_sleep_between_frames);
+    RUN_TEST(test_final_frame_shown_before_light_sleep);
+    RUN_TEST(test_touch_wakes_from_light_sleep);
+    RUN_TEST(test_deep_sleep_deadline_with_light_sleep);
+    RUN_TEST(test_deep_sleep_after_light_sleep_wakes_on_touch_only);
+    RUN_TEST(test_touch_threshold_follows_drift);
+    RUN_TEST(test_double_tap_without_cooldown);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <Arduino.h>
+#include <NativeHal.h>
+#include <unity.h>
+#include "connect/RemoteControl.h"
+#include "behavior/SmartPowerBehavior.h"
+
+#define BATTERY_ANALOG_PIN GPIO_NUM_36
+#define USB_ANALOG_PIN GPIO_NUM_39
+
+#define ADC_BATTERY_FULL 2300 // ~4.16V
+#define ADC_BATTERY_DEAD 1800 // ~3.26V
+#define ADC_USB_CONNECTED 2900
+
+struct Device {
+    Config config;
+    Floower floower;
+    CommandProtocol cmdProtocol;
+    BluetoothConnect bluetoothConnect;
+    WifiConnect wifiConnect;
+    RemoteControl remoteControl;
+    SmartPowerBehavior behavior;
+
+    Device() : config(1), floower(&config), cmdProtocol(&config, &floower),
+            bluetoothConnect(&floower, &config, &cmdProtocol), wifiConnect(&config, &cmdProtocol),
+            remoteControl(&bluetoothConnect, &wifiConnect, &cmdProtocol), behavior(&config, &floower, &remoteControl) {
+        config.begin();
+        config.hardwareCalibration(1000, 1000, 9, 1);
+        config.factorySettings();
+        config.setCalibrated();
+        config.load();
+        config.deepSleepEnabled = true;
+        floower.init();
+        floower.readPowerState();
+    }
+};
+
+void setUp(void) {
+    NativeHal::reset();
+}
+
+void tearDown(void) {
+}
+
+void test_power_state_on_battery(void) {
+    NativeHal::setAnalogInput(BATTERY_ANALOG_PIN, ADC_BATTERY_FULL);
+    NativeHal::setAnalogInput(USB_ANALOG_PIN, 0);
+    Device device;
+
+    PowerState powerState = device.floower.readPowerState();
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 4.16, powerState.batteryVoltage);
+    TEST_ASSERT_UINT8_WITHIN(5, 95, powerState.batteryLevel);
+    TEST_ASSERT_TRUE(powerState.switchedOn);
+    TEST_ASSERT_FALSE(powerState.usbPowered);
+    TEST_ASSERT_NOT_EQUAL(BATTERY_RUNTIME_UNKNOWN, powerState.batteryRuntime);
+}
+
+void test_runtime_follows_the_load(void) {
+    NativeHal::setAnalogInput(BATTERY_ANALOG_PIN, ADC_BATTERY_FULL);
+    NativeHal::setAnalogInput(USB_ANALOG_PIN, 0);
+    Device device;
+    device.floower.initPetals(true, false);
+    unsigned long watchDogTime = 0;
+    auto loop = [&]() {
+        device.floower.update();
+        if (millis() - watchDogTime >= 1000) {
+            watchDogTime = millis();
+            device.floower.readPowerState();
+        }
+    };
+
+    NativeHal::simulate(loop, 300000);
+    PowerState dark = device.floower.readPowerState();
+
+    device.floower.transitionColor(0, 0, 1, 100);
+    device.floower.setRadiosEnabled(true, false);
+    NativeHal::simulate(loop, 300000);
+    PowerState lit = device.floower.readPowerState();
+
+    TEST_ASSERT_TRUE(lit.batteryCurrent > dark.batteryCurrent + LOAD_WIFI_MA + 7 * LOAD_LED_CHANNEL_MA);
+    TEST_ASSERT_TRUE(lit.batteryRuntime < dark.batteryRuntime / 3);
+}
+
+void test_standby_when_usb_powered(void) {
+    NativeHal::setAnalogInput(BATTERY_ANALOG_PIN, ADC_BATTERY_FULL);
+    NativeHal::setAnalogInput(USB_ANALOG_PIN, ADC_USB_CONNECTED);
+    Device device;
+
+    device.behavior.setup(false);
+    TEST_ASSERT_TRUE(device.floower.arePetalsMoving()); // homing after power on
+    NativeHal::simulate([&]() { device.floower.update(); }, 1000);
+
+    TEST_ASSERT_TRUE(device.behavior.isIdle());
+    TEST_ASSERT_FALSE(device.floower.isLit());
+    TEST_ASSERT_EQUAL(0, device.floower.getPetalsOpenLevel());
+    TEST_ASSERT_EQUAL(device.floower.getTouchThreshold(), NativeHal::getTouchThreshold(GPIO_NUM_4));
+    TEST_ASSERT_EQUAL(70 - 5, NativeHal::getTouchThreshold(GPIO_NUM_4)); // seeded from the untouched reading
+}
+
+void test_low_battery_shuts_down(void) {
+    NativeHal::setAnalogInput(BATTERY_ANALOG_PIN, ADC_BATTERY_DEAD);
+    NativeHal::setAnalogNoise(BATTERY_ANALOG_PIN, 100);
+    NativeHal::setAnalogInput(USB_ANALOG_PIN, 0);
+    Device device;
+
+    unsigned long setupStarted = millis();
+    device.behavior.setup(false);
+    TEST_ASSERT_LESS_THAN(10, millis() - setupStarted); // decided without waiting
+
+    // blinking red and closing
+    TEST_ASSERT_TRUE(device.floower.isChangingColor());
+    TEST_ASSERT_EQUAL_FLOAT(colorRed.H, device.floower.getColor().H);
+    TEST_ASSERT_EQUAL(0, device.floower.getPetalsOpenLevel());
+    TEST_ASSERT_EQUAL(0, NativeHal::getDeepSleepCount());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_power_state_on_battery);
+    RUN_TEST(test_runtime_follows_the_load);
+    RUN_TEST(test_standby_when_usb_powered);
+    RUN_TEST(test_low_battery_shuts_down);
+    UNITY_END();
+
+    return 0;
+}
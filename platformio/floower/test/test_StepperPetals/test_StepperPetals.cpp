@@ -0,0 +1,235 @@
+#include <Arduino.h>
+#include <NativeHal.h>
+#include <SimulatedTMC2300.h>
+#include <unity.h>
+#include "hardware/Petals.h"
+
+#define TMC_EN_PIN GPIO_NUM_33
+#define TMC_STEP_PIN GPIO_NUM_18
+#define TMC_DIR_PIN GPIO_NUM_19
+#define TMC_OPEN_STEPS 30000
+#define MOTION_ACCELERATION 100000 // steps/s^2
+
+Config petalsConfig(1);
+
+// main loop busy with other work (LEDs, WiFi) for up to 30ms
+void busyLoop(Petals &petals) {
+    petals.update();
+    delay(random(0, 30));
+}
+
+// no StallGuard on host, homing after power on overshoots blindly
+void waitForHoming(Petals &petals) {
+    NativeHal::simulate([&]() {
+        if (petals.arePetalsMoving()) {
+            petals.update();
+        }
+    }, 1000);
+}
+
+// steps/s^2 of the steepest speed change within the first edges, speeds are averaged over 16 steps as the edges are in whole us
+double maxAcceleration(const std::vector<uint64_t> &edges, size_t count) {
+    double maxAcceleration = 0;
+    for (size_t i = 16; i + 16 < count; i++) {
+        double before = 16000000.0 / (edges[i] - edges[i - 16]);
+        double after = 16000000.0 / (edges[i + 16] - edges[i]);
+        maxAcceleration = _max(maxAcceleration, fabs(after - before) / ((edges[i + 16] - edges[i - 16]) / 2000000.0));
+    }
+    return maxAcceleration;
+}
+
+void setUp(void) {
+    NativeHal::reset();
+    petalsConfig.begin();
+    petalsConfig.hardwareCalibration(1000, 1000, 9, 1);
+    petalsConfig.factorySettings();
+    petalsConfig.load();
+}
+
+void tearDown(void) {
+}
+
+void test_step_timing_independent_of_loop_load(void) {
+    StepperPetals petals(&petalsConfig);
+    petals.init(true, false);
+    waitForHoming(petals);
+    NativeHal::recordRisingEdges(TMC_STEP_PIN);
+
+    uint64_t start = NativeHal::getClockMicros();
+    petals.setPetalsOpenLevel(100, 5000);
+    NativeHal::simulate([&]() { busyLoop(petals); }, 5100);
+
+    const std::vector<uint64_t> &edges = NativeHal::getRisingEdgeTimes(TMC_STEP_PIN);
+    TEST_ASSERT_EQUAL(TMC_OPEN_STEPS, edges.size());
+    TEST_ASSERT_UINT32_WITHIN(1000, 5000000, edges.back() - start);
+    // cruise in the middle of the movement runs at constant speed
+    uint64_t minInterval = UINT64_MAX, maxInterval = 0;
+    for (size_t i = TMC_OPEN_STEPS / 4; i < 3 * TMC_OPEN_STEPS / 4; i++) {
+        uint64_t interval = edges[i] - edges[i - 1];
+        minInterval = _min(minInterval, interval);
+        maxInterval = _max(maxInterval, interval);
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(1, maxInterval - minInterval);
+    TEST_ASSERT_LESS_THAN(166, maxInterval); // faster than 5s / 30000 steps to make up for the ramps
+    // accelerates from standstill
+    TEST_ASSERT_GREATER_THAN(5 * maxInterval, edges[1] - edges[0]);
+    TEST_ASSERT_FALSE(petals.arePetalsMoving());
+}
+
+void test_reverse_during_movement(void) {
+    StepperPetals petals(&petalsConfig);
+    petals.init(true, false);
+    waitForHoming(petals);
+    uint32_t homingSteps = NativeHal::getRisingEdges(TMC_STEP_PIN);
+    NativeHal::recordRisingEdges(TMC_STEP_PIN);
+
+    petals.setPetalsOpenLevel(100, 5000);
+    NativeHal::simulate([&]() { busyLoop(petals); }, 2500);
+    TEST_ASSERT_TRUE(petals.arePetalsMoving());
+    uint32_t openingSteps = NativeHal::getRisingEdgeTimes(TMC_STEP_PIN).size();
+
+    // brakes to standstill before turning around
+    petals.setPetalsOpenLevel(0, 2500);
+    uint32_t forwardSteps = 0;
+    NativeHal::simulate([&]() {
+        petals.update();
+        if (forwardSteps == 0 && NativeHal::getDigitalOutput(TMC_DIR_PIN) == HIGH) {
+            forwardSteps = NativeHal::getRisingEdges(TMC_STEP_PIN) - homingSteps;
+        }
+        delay(random(0, 30));
+    }, 3500);
+    TEST_ASSERT_FALSE(petals.arePetalsMoving());
+    TEST_ASSERT_EQUAL(0, petals.getCurrentPetalsOpenLevel());
+    TEST_ASSERT_GREATER_THAN(openingSteps, forwardSteps);
+    TEST_ASSERT_LESS_THAN(openingSteps + 2048, forwardSteps);
+    const std::vector<uint64_t> &edges = NativeHal::getRisingEdgeTimes(TMC_STEP_PIN);
+    TEST_ASSERT_EQUAL(2 * forwardSteps + 1000, edges.size()); // no StallGuard on host, homing overshoots blindly
+    TEST_ASSERT_LESS_OR_EQUAL(MOTION_ACCELERATION * 1.2, maxAcceleration(edges, 2 * forwardSteps)); // homing runs at constant speed
+}
+
+void test_retarget_continues_from_current_speed(void) {
+    StepperPetals petals(&petalsConfig);
+    petals.init(true, false);
+    waitForHoming(petals);
+    NativeHal::recordRisingEdges(TMC_STEP_PIN);
+
+    petals.setPetalsOpenLevel(100, 3000);
+    NativeHal::simulate([&]() { busyLoop(petals); }, 1500);
+    petals.setPetalsOpenLevel(70, 1000);
+    NativeHal::simulate([&]() { busyLoop(petals); }, 1500);
+
+    TEST_ASSERT_FALSE(petals.arePetalsMoving());
+    const std::vector<uint64_t> &edges = NativeHal::getRisingEdgeTimes(TMC_STEP_PIN);
+    TEST_ASSERT_EQUAL(TMC_OPEN_STEPS * 70 / 100, edges.size());
+    TEST_ASSERT_LESS_OR_EQUAL(MOTION_ACCELERATION * 1.2, maxAcceleration(edges, edges.size()));
+}
+
+void test_driver_disabled_when_idle(void) {
+    StepperPetals petals(&petalsConfig);
+    petals.init(true, false);
+    waitForHoming(petals);
+    uint32_t homingSteps = NativeHal::getRisingEdges(TMC_STEP_PIN);
+
+    petals.setPetalsOpenLevel(50, 2000);
+    TEST_ASSERT_EQUAL(HIGH, NativeHal::getDigitalOutput(TMC_EN_PIN));
+    NativeHal::simulate([&]() { busyLoop(petals); }, 2100);
+
+    TEST_ASSERT_FALSE(petals.arePetalsMoving());
+    TEST_ASSERT_EQUAL(LOW, NativeHal::getDigitalOutput(TMC_EN_PIN));
+    TEST_ASSERT_EQUAL(TMC_OPEN_STEPS / 2, NativeHal::getRisingEdges(TMC_STEP_PIN) - homingSteps);
+}
+
+void test_move_during_homing_starts_from_end_stop(void) {
+    SimulatedTMC2300 driver;
+    driver.setRegister(REG_SG_VALUE_ADDRESS, 300); // free running
+    Serial1.attach(&driver);
+    StepperPetals petals(&petalsConfig);
+    petals.init(true, false);
+    NativeHal::recordRisingEdges(TMC_STEP_PIN);
+
+    // touched while still searching for the end stop
+    NativeHal::simulate([&]() { busyLoop(petals); }, 200);
+    petals.setPetalsOpenLevel(50, 1000);
+    TEST_ASSERT_EQUAL(50, petals.getPetalsOpenLevel());
+
+    uint32_t homingSteps = 0;
+    NativeHal::simulate([&]() {
+        if (NativeHal::getRisingEdges(TMC_STEP_PIN) >= 3000) {
+            driver.setRegister(REG_SG_VALUE_ADDRESS, 20);
+        }
+        petals.update();
+        if (homingSteps == 0 && NativeHal::getDigitalOutput(TMC_DIR_PIN) == LOW) {
+            homingSteps = NativeHal::getRisingEdges(TMC_STEP_PIN); // opening after the stall
+        }
+        delay(random(0, 30));
+    }, 2000);
+    Serial1.attach(nullptr);
+
+    // homing kept closing until the stall, the movement counts from there
+    TEST_ASSERT_UINT32_WITHIN(200, 3200, homingSteps);
+    TEST_ASSERT_FALSE(petals.arePetalsMoving());
+    TEST_ASSERT_EQUAL(TMC_OPEN_STEPS / 2, NativeHal::getRisingEdges(TMC_STEP_PIN) - homingSteps);
+}
+
+void test_homing_stops_at_end_stop(void) {
+    SimulatedTMC2300 driver;
+    driver.setRegister(REG_SG_VALUE_ADDRESS, 300); // free running
+    Serial1.attach(&driver);
+    StepperPetals petals(&petalsConfig);
+    petals.init(true, false);
+    TEST_ASSERT_TRUE(petals.arePetalsMoving());
+
+    // petals hit the end stop after 2000 steps, load rises and SG_VALUE drops
+    NativeHal::simulate([&]() {
+        if (NativeHal::getRisingEdges(TMC_STEP_PIN) >= 2000) {
+            driver.setRegister(REG_SG_VALUE_ADDRESS, 20);
+        }
+        busyLoop(petals);
+    }, 1000);
+    Serial1.attach(nullptr);
+
+    TEST_ASSERT_FALSE(petals.arePetalsMoving());
+    TEST_ASSERT_EQUAL(0, petals.getCurrentPetalsOpenLevel());
+    TEST_ASSERT_UINT32_WITHIN(200, 2200, NativeHal::getRisingEdges(TMC_STEP_PIN)); // sampled from the busy main loop, stops within ~80ms
+    TEST_ASSERT_EQUAL(LOW, NativeHal::getDigitalOutput(TMC_EN_PIN));
+    // configuration reached the driver
+    TEST_ASSERT_EQUAL(40, driver.getRegister(REG_SGTHRS_ADDRESS));
+    TEST_ASSERT_EQUAL(3, (driver.getRegister(REG_CHOPCONF::address) >> 24) & 0x0F); // 32 microsteps
+}
+
+void test_configuration_restored_after_driver_reset(void) {
+    SimulatedTMC2300 driver;
+    Serial1.attach(&driver);
+    StepperPetals petals(&petalsConfig);
+    petals.init(false, false);
+    petals.setPetalsOpenLevel(100, 5000);
+    NativeHal::simulate([&]() { busyLoop(petals); }, 1000);
+    TEST_ASSERT_EQUAL(0, driver.getRegister(REG_GSTAT::address)); // power up flag cleared
+    uint32_t writes = driver.getWriteCount();
+
+    // brown out, registers are back at the reset defaults
+    driver.setRegister(REG_GSTAT::address, 0b101);
+    driver.setRegister(REG_SGTHRS_ADDRESS, 0);
+    driver.setRegister(REG_CHOPCONF::address, 0x13008001);
+    NativeHal::simulate([&]() { busyLoop(petals); }, 1000);
+    Serial1.attach(nullptr);
+
+    TEST_ASSERT_EQUAL(40, driver.getRegister(REG_SGTHRS_ADDRESS));
+    TEST_ASSERT_EQUAL(3, (driver.getRegister(REG_CHOPCONF::address) >> 24) & 0x0F); // 32 microsteps
+    TEST_ASSERT_EQUAL(0, driver.getRegister(REG_GSTAT::address));
+    TEST_ASSERT_EQUAL(writes + 5, driver.getWriteCount()); // configured once
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_step_timing_independent_of_loop_load);
+    RUN_TEST(test_reverse_during_movement);
+    RUN_TEST(test_retarget_continues_from_current_speed);
+    RUN_TEST(test_driver_disabled_when_idle);
+    RUN_TEST(test_homing_stops_at_end_stop);
+    RUN_TEST(test_move_during_homing_starts_from_end_stop);
+    RUN_TEST(test_configuration_restored_after_driver_reset);
+    UNITY_END();
+
+    return 0;
+}
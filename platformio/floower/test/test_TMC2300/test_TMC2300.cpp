@@ -0,0 +1,307 @@
+#include <Arduino.h>
+#include <NativeHal.h>
+#include <unity.h>
+#include <SimulatedTMC2300.h>
+#include <chrono>
+#include <tmc2300.h>
+
+#define DRIVER_ADDRESS 0
+
+SimulatedTMC2300 peer(DRIVER_ADDRESS);
+
+void setUp(void) {
+    NativeHal::reset();
+    peer = SimulatedTMC2300(DRIVER_ADDRESS);
+    Serial1.attach(&peer);
+}
+
+void tearDown(void) {
+    Serial1.attach(nullptr);
+}
+
+void test_read_in_background(void) {
+    TMC2300 driver(&Serial1, 0.13f, DRIVER_ADDRESS);
+    peer.setRegister(REG_SG_VALUE_ADDRESS, 0x1234);
+
+    bool done = false;
+    uint16_t result = 0;
+    uint64_t start = NativeHal::getClockMicros();
+    TEST_ASSERT_TRUE(driver.readSGValueAsync([&](bool success, uint16_t sgValue) {
+        TEST_ASSERT_TRUE(success);
+        result = sgValue;
+        done = true;
+    }));
+    TEST_ASSERT_FALSE(done);
+    TEST_ASSERT_TRUE(driver.isBusy());
+
+    while (!done) {
+        driver.update();
+    }
+    TEST_ASSERT_EQUAL(0x234, result); // 10 bits
+    TEST_ASSERT_FALSE(driver.isBusy());
+    TEST_ASSERT_LESS_THAN(400, NativeHal::getClockMicros() - start); // 12 bytes on the wire at 500kbaud
+}
+
+void test_no_reply_does_not_block(void) {
+    TMC2300 driver(&Serial1, 0.13f, DRIVER_ADDRESS);
+    peer.setDropRate(1);
+
+    bool done = false;
+    driver.readDrvStatusAsync([&](bool success, REG_DRV_STATUS drvStatus) {
+        TEST_ASSERT_FALSE(success);
+        done = true;
+    });
+
+    uint64_t start = NativeHal::getClockMicros();
+    uint64_t longestUpdate = 0;
+    while (!done) {
+        uint64_t updateStart = NativeHal::getClockMicros();
+        driver.update();
+        longestUpdate = _max(longestUpdate, NativeHal::getClockMicros() - updateStart);
+        delayMicroseconds(100); // rest of the main loop
+    }
+    TEST_ASSERT_LESS_THAN(50, longestUpdate);
+    TEST_ASSERT_UINT32_WITHIN(500, 10000, NativeHal::getClockMicros() - start); // 2 attempts, 5ms each
+    TEST_ASSERT_TRUE(driver.lastReadFailed());
+}
+
+void test_transactions_run_in_order(void) {
+    TMC2300 driver(&Serial1, 0.13f, DRIVER_ADDRESS);
+
+    std::vector<uint32_t> results;
+    driver.writeAsync(REG_GCONF::address, 0x40);
+    driver.readAsync(REG_GCONF::address, [&](bool success, uint32_t value) { results.push_back(value); });
+    driver.writeAsync(REG_GCONF::address, 0x50);
+    driver.readAsync(REG_GCONF::address, [&](bool success, uint32_t value) { results.push_back(value); });
+    while (driver.isBusy()) {
+        driver.update();
+    }
+    TEST_ASSERT_EQUAL(2, results.size());
+    TEST_ASSERT_EQUAL(0x40, results[0]);
+    TEST_ASSERT_EQUAL(0x50, results[1]);
+
+    // blocking calls wait for the queue
+    driver.readAsync(REG_DRV_STATUS::address, nullptr);
+    driver.readDrvStatusReg();
+    TEST_ASSERT_FALSE(driver.isBusy());
+}
+
+void test_queue_full(void) {
+    TMC2300 driver(&Serial1, 0.13f, DRIVER_ADDRESS);
+    uint8_t queued = 0;
+    while (driver.readAsync(REG_DRV_STATUS::address, nullptr)) {
+        queued++;
+    }
+    TEST_ASSERT_EQUAL(7, queued);
+    driver.update();
+    while (driver.isBusy()) {
+        driver.update();
+    }
+    TEST_ASSERT_TRUE(driver.readAsync(REG_DRV_STATUS::address, nullptr));
+}
+
+void test_configuration_cached(void) {
+    TMC2300 driver(&Serial1, 0.13f, DRIVER_ADDRESS);
+    
+    TEST_ASSERT_EQUAL_HEX32(0x13008001, driver.readChopconf().sr);
+    TEST_ASSERT_EQUAL_HEX32(0x13008001, driver.readChopconf().sr);
+    TEST_ASSERT_EQUAL(1, peer.getReadCount());
+
+    // status registers always go to the wire
+    driver.readDrvStatusReg();
+    driver.readDrvStatusReg();
+    TEST_ASSERT_EQUAL(3, peer.getReadCount());
+
+    // read-modify-write does not read again
+    REG_CHOPCONF chopconf = driver.readChopconf();
+    chopconf.setMicrosteps(32);
+    driver.writeChopconfReg(chopconf);
+    TEST_ASSERT_EQUAL(chopconf.sr, driver.readChopconf().sr);
+    TEST_ASSERT_EQUAL(3, peer.getReadCount());
+
+    // driver lost its configuration
+    driver.invalidateShadow();
+    TEST_ASSERT_EQUAL_HEX32(0x13008001, driver.readChopconf().sr);
+    TEST_ASSERT_EQUAL(4, peer.getReadCount());
+}
+
+void test_writes_batched(void) {
+    TMC2300 driver(&Serial1, 0.13f, DRIVER_ADDRESS);
+    REG_IHOLD_IRUN iholdIrun;
+    iholdIrun.sr = 0;
+    iholdIrun.irun = 31;
+    driver.writeIholdIrunReg(iholdIrun);
+    driver.writeTCoolThrs(0xFFFFF);
+    driver.writeSGThrs(40);
+    driver.writeSGThrs(50); // coalesced
+    TEST_ASSERT_TRUE(driver.isDirty());
+    TEST_ASSERT_EQUAL(0, peer.getWriteCount());
+
+    uint64_t start = NativeHal::getClockMicros();
+    driver.flush();
+    TEST_ASSERT_FALSE(driver.isDirty());
+    while (driver.isBusy()) {
+        driver.update();
+    }
+    TEST_ASSERT_EQUAL(3, peer.getWriteCount());
+    TEST_ASSERT_UINT32_WITHIN(100, 2000, NativeHal::getClockMicros() - start); // one bus idle time for the whole burst
+    TEST_ASSERT_EQUAL(iholdIrun.sr, peer.getRegister(REG_IHOLD_IRUN::address));
+    TEST_ASSERT_EQUAL(0xFFFFF, peer.getRegister(REG_TCOOLTHRS_ADDRESS));
+    TEST_ASSERT_EQUAL(50, peer.getRegister(REG_SGTHRS_ADDRESS));
+
+    // unchanged value is not sent again
+    driver.writeSGThrs(50);
+    TEST_ASSERT_FALSE(driver.isDirty());
+}
+
+void test_async_write_updates_cache(void) {
+    TMC2300 driver(&Serial1, 0.13f, DRIVER_ADDRESS);
+    driver.writeSGThrs(40);
+    TEST_ASSERT_TRUE(driver.writeAsync(REG_CHOPCONF::address, 0x10000053));
+    TEST_ASSERT_TRUE(driver.writeAsync(REG_SGTHRS_ADDRESS, 60)); // replaces the deferred write
+    TEST_ASSERT_FALSE(driver.isDirty());
+    while (driver.isBusy()) {
+        driver.update();
+    }
+
+    TEST_ASSERT_EQUAL_HEX32(0x10000053, driver.readChopconf().sr);
+    TEST_ASSERT_EQUAL(0, peer.getReadCount());
+    TEST_ASSERT_EQUAL(60, peer.getRegister(REG_SGTHRS_ADDRESS));
+    TEST_ASSERT_EQUAL(2, peer.getWriteCount());
+}
+
+void test_flush_continues_when_queue_full(void) {
+    TMC2300 driver(&Serial1, 0.13f, DRIVER_ADDRESS);
+    for (uint8_t i = 0; i < 6; i++) {
+        TEST_ASSERT_TRUE(driver.readAsync(REG_DRV_STATUS::address, nullptr));
+    }
+    driver.writeTCoolThrs(0xFFFFF);
+    driver.writeSGThrs(40);
+    driver.writeChopconfReg(REG_CHOPCONF{});
+
+    TEST_ASSERT_FALSE(driver.flush()); // single slot left
+    TEST_ASSERT_TRUE(driver.isDirty());
+    while (driver.isBusy()) {
+        driver.update();
+    }
+    TEST_ASSERT_FALSE(driver.isDirty());
+    TEST_ASSERT_EQUAL(3, peer.getWriteCount());
+    TEST_ASSERT_EQUAL(0xFFFFF, peer.getRegister(REG_TCOOLTHRS_ADDRESS));
+    TEST_ASSERT_EQUAL(40, peer.getRegister(REG_SGTHRS_ADDRESS));
+    TEST_ASSERT_EQUAL(0, peer.getRegister(REG_CHOPCONF::address));
+}
+
+void test_retries_on_unreliable_line(void) {
+    TMC2300 driver(&Serial1, 0.13f, DRIVER_ADDRESS);
+    peer.setRegister(REG_DRV_STATUS::address, 0x12345678);
+    peer.setDropRate(0.02);
+    peer.setCorruptionRate(0.05);
+
+    uint32_t succeeded = 0;
+    for (uint8_t i = 0; i < 100; i++) {
+        uint32_t value = driver.readDrvStatusReg().sr;
+        if (!driver.lastReadFailed()) {
+            TEST_ASSERT_EQUAL_HEX32(0x12345678, value); // corrupted reply is never accepted
+            succeeded++;
+        }
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(90, succeeded);
+    TEST_ASSERT_GREATER_THAN(100, peer.getReadCount()); // retried
+}
+
+void test_cost_of_blocking_read(void) {
+    TMC2300 driver(&Serial1, 0.13f, DRIVER_ADDRESS);
+
+    uint64_t start = NativeHal::getClockMicros();
+    driver.readDrvStatusReg();
+    uint64_t cleanCost = NativeHal::getClockMicros() - start;
+
+    peer.setCorruptionRate(1);
+    start = NativeHal::getClockMicros();
+    driver.readDrvStatusReg();
+    uint64_t corruptedCost = NativeHal::getClockMicros() - start;
+
+    peer.setCorruptionRate(0);
+    peer.setDropRate(1);
+    start = NativeHal::getClockMicros();
+    driver.readDrvStatusReg();
+    uint64_t lostCost = NativeHal::getClockMicros() - start;
+
+    printf("blocking read: %luus, corrupted reply %luus, no reply %luus\n", (unsigned long) cleanCost, (unsigned long) corruptedCost, (unsigned long) lostCost);
+    TEST_ASSERT_LESS_THAN(500, cleanCost);
+    TEST_ASSERT_LESS_THAN(1000, corruptedCost); // retried right away
+    TEST_ASSERT_UINT32_WITHIN(500, 10000, lostCost);
+}
+
+void test_peer_rejects_invalid_requests(void) {
+    uint8_t badCrc[] = {0x05, DRIVER_ADDRESS, REG_GCONF::address | 0x80, 0, 0, 0, 1, 0};
+    badCrc[7] = SimulatedTMC2300::calcCRC(badCrc, 7) ^ 1;
+    peer.write(badCrc, sizeof(badCrc));
+    TEST_ASSERT_EQUAL(1, peer.getRejectedCount());
+    TEST_ASSERT_EQUAL(0, peer.getRegister(REG_GCONF::address));
+
+    uint8_t otherAddress[] = {0x05, DRIVER_ADDRESS + 1, REG_GCONF::address, 0};
+    otherAddress[3] = SimulatedTMC2300::calcCRC(otherAddress, 3);
+    peer.write(otherAddress, sizeof(otherAddress));
+    NativeHal::advanceClock(1000);
+    TEST_ASSERT_EQUAL(12, peer.available()); // just the echo
+    TEST_ASSERT_EQUAL(0, peer.getReadCount());
+}
+
+void test_crc_table_matches_bitwise(void) {
+    // simulated driver keeps the original bit by bit algorithm
+    uint8_t datagram[7] = {0x05, 0xFF, 0x6F, 0, 0, 0, 0};
+    for (uint16_t i = 0; i < 256; i++) {
+        datagram[3] = i;
+        TEST_ASSERT_EQUAL_HEX8(SimulatedTMC2300::calcCRC(&datagram[3], 1), TMC2300::calcCRC(&datagram[3], 1));
+        for (uint8_t j = 0; j < 3; j++) {
+            datagram[4 + j] = random(0, 256);
+        }
+        TEST_ASSERT_EQUAL_HEX8(SimulatedTMC2300::calcCRC(datagram, 7), TMC2300::calcCRC(datagram, 7));
+        TEST_ASSERT_EQUAL_HEX8(SimulatedTMC2300::calcCRC(datagram, 3), TMC2300::calcCRC(datagram, 3));
+    }
+}
+
+void test_crc_benchmark(void) {
+    const uint32_t frames = 200000;
+    uint8_t datagram[8] = {0x05, 0xFF, 0x41, 0x00, 0x00, 0x01, 0x23, 0x00};
+    volatile uint8_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < frames; i++) {
+        datagram[6] = i;
+        sink = sink ^ SimulatedTMC2300::calcCRC(datagram, 7);
+    }
+    auto bitwise = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < frames; i++) {
+        datagram[6] = i;
+        sink = sink ^ TMC2300::calcCRC(datagram, 7);
+    }
+    auto table = std::chrono::steady_clock::now() - start;
+
+    double bitwiseNs = std::chrono::duration<double, std::nano>(bitwise).count() / frames;
+    double tableNs = std::chrono::duration<double, std::nano>(table).count() / frames;
+    printf("crc8 of 7 bytes: bitwise %.1fns, table %.1fns (%.1fx)\n", bitwiseNs, tableNs, bitwiseNs / tableNs);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_read_in_background);
+    RUN_TEST(test_no_reply_does_not_block);
+    RUN_TEST(test_transactions_run_in_order);
+    RUN_TEST(test_queue_full);
+    RUN_TEST(test_configuration_cached);
+    RUN_TEST(test_writes_batched);
+    RUN_TEST(test_async_write_updates_cache);
+    RUN_TEST(test_flush_continues_when_queue_full);
+    RUN_TEST(test_retries_on_unreliable_line);
+    RUN_TEST(test_cost_of_blocking_read);
+    RUN_TEST(test_peer_rejects_invalid_requests);
+    RUN_TEST(test_crc_table_matches_bitwise);
+    RUN_TEST(test_crc_benchmark);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "hardware/TouchBaseline.h"
+#include "NativeHal.h"
+
+void setUp(void) {
+    NativeHal::reset();
+}
+
+void tearDown(void) {
+}
+
+void test_seeded_threshold(void) {
+    TouchBaseline baseline;
+    baseline.reset(70);
+    TEST_ASSERT_EQUAL(70, baseline.getBaseline());
+    TEST_ASSERT_EQUAL(0, baseline.getNoise());
+    TEST_ASSERT_EQUAL(70 - TOUCH_MIN_MARGIN, baseline.getThreshold());
+}
+
+void test_follows_slow_drift(void) {
+    TouchBaseline baseline;
+    baseline.reset(70);
+
+    // humidity lowers the reading by 20 within 10 minutes, the fixed threshold would end up touched
+    bool changed = false;
+    for (uint16_t i = 0; i <= 600; i++) {
+        changed |= baseline.update(70 - i / 30);
+    }
+    TEST_ASSERT_TRUE(changed);
+    TEST_ASSERT_UINT16_WITHIN(1, 50, baseline.getBaseline());
+    TEST_ASSERT_UINT16_WITHIN(TOUCH_THRESHOLD_HYSTERESIS, baseline.getBaseline() - TOUCH_MIN_MARGIN, baseline.getThreshold());
+
+    // and back up
+    for (uint16_t i = 0; i <= 600; i++) {
+        baseline.update(50 + i / 30);
+    }
+    TEST_ASSERT_UINT16_WITHIN(1, 70, baseline.getBaseline());
+}
+
+void test_ignores_touch(void) {
+    TouchBaseline baseline;
+    baseline.reset(70);
+    for (uint8_t i = 0; i < TOUCH_STUCK_SAMPLES - 1; i++) {
+        TEST_ASSERT_FALSE(baseline.update(20));
+    }
+    TEST_ASSERT_EQUAL(70, baseline.getBaseline());
+    TEST_ASSERT_EQUAL(0, baseline.getNoise());
+
+    // released, the count starts over
+    baseline.update(70);
+    for (uint8_t i = 0; i < TOUCH_STUCK_SAMPLES - 1; i++) {
+        baseline.update(20);
+    }
+    TEST_ASSERT_EQUAL(70, baseline.getBaseline());
+}
+
+void test_recovers_from_stuck_reading(void) {
+    TouchBaseline baseline;
+    baseline.reset(70);
+
+    // the reading jumped down for good (the flower was moved), it is not a finger anymore
+    bool changed = false;
+    for (uint8_t i = 0; i < TOUCH_STUCK_SAMPLES; i++) {
+        changed = baseline.update(40);
+    }
+    TEST_ASSERT_TRUE(changed);
+    TEST_ASSERT_EQUAL(40, baseline.getBaseline());
+    TEST_ASSERT_EQUAL(40 - TOUCH_MIN_MARGIN, baseline.getThreshold());
+}
+
+void test_noise_widens_margin(void) {
+    TouchBaseline baseline;
+    baseline.reset(70);
+
+    // +-3 around the baseline would trigger the touch with the fixed margin of 5
+    for (uint16_t i = 0; i < 200; i++) {
+        baseline.update(i % 2 ? 73 : 67);
+    }
+    TEST_ASSERT_UINT16_WITHIN(1, 70, baseline.getBaseline());
+    TEST_ASSERT_UINT16_WITHIN(1, 3, baseline.getNoise());
+    TEST_ASSERT_UINT16_WITHIN(2, 70 - TOUCH_NOISE_FACTOR * 3, baseline.getThreshold());
+
+    // but never so wide that a finger would not get under it
+    for (uint16_t i = 0; i < 200; i++) {
+        baseline.update(i % 2 ? 79 : 61);
+    }
+    TEST_ASSERT_UINT16_WITHIN(1, baseline.getBaseline() - baseline.getBaseline() / TOUCH_MAX_MARGIN_DIVIDER, baseline.getThreshold());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_seeded_threshold);
+    RUN_TEST(test_follows_slow_drift);
+    RUN_TEST(test_ignores_touch);
+    RUN_TEST(test_recovers_from_stuck_reading);
+    RUN_TEST(test_noise_widens_margin);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <vector>
+#include "hardware/TouchGestures.h"
+#include "NativeHal.h"
+
+struct RecordedEvent {
+    FloowerTouchEvent event;
+    unsigned long duration;
+};
+
+Config config(1);
+TouchGestures gestures(&config);
+std::vector<RecordedEvent> events;
+
+void setUp(void) {
+    NativeHal::reset();
+    config = Config(1);
+    events.clear();
+    gestures.reset();
+    gestures.onGesture([](const FloowerTouchEvent& event) { events.push_back({event, gestures.getTouchDuration()}); });
+}
+
+void tearDown(void) {
+}
+
+void assertEvents(std::vector<FloowerTouchEvent> expected) {
+    TEST_ASSERT_EQUAL(expected.size(), events.size());
+    for (uint8_t i = 0; i < expected.size(); i++) {
+        TEST_ASSERT_EQUAL(expected[i], events[i].event);
+    }
+}
+
+void test_single_tap(void) {
+    const TouchEdge timeline[] = {{1000, true}, {1150, false}};
+    gestures.replay(timeline, 2, 3000);
+    assertEvents({TOUCH_DOWN, TOUCH_UP});
+    TEST_ASSERT_EQUAL(150, events[1].duration);
+    TEST_ASSERT_EQUAL(1, gestures.getTapCount());
+    TEST_ASSERT_FALSE(gestures.isTouching());
+}
+
+void test_double_and_triple_tap(void) {
+    // no cooldown, the second tap is reported right when it starts
+    const TouchEdge timeline[] = {{1000, true}, {1120, false}, {1300, true}, {1400, false}, {1600, true}, {1700, false}};
+    gestures.replay(timeline, 6, 3000);
+    assertEvents({TOUCH_DOWN, TOUCH_UP, TOUCH_DOWN, TOUCH_DOUBLE_TAP, TOUCH_UP, TOUCH_DOWN, TOUCH_TRIPLE_TAP, TOUCH_UP});
+    TEST_ASSERT_EQUAL(3, gestures.getTapCount());
+}
+
+void test_taps_too_slow_or_long(void) {
+    // gap longer than the multi tap time
+    const TouchEdge slow[] = {{1000, true}, {1100, false}, {1100 + DEFAULT_TOUCH_MULTI_TAP_TIME + 1, true}, {1500, false}};
+    gestures.replay(slow, 4, 3000);
+    assertEvents({TOUCH_DOWN, TOUCH_UP, TOUCH_DOWN, TOUCH_UP});
+
+    // first touch is not a tap
+    events.clear();
+    const TouchEdge press[] = {{1000, true}, {1000 + DEFAULT_TOUCH_TAP_TIME + 1, false}, {1500, true}, {1600, false}};
+    gestures.replay(press, 4, 3000);
+    assertEvents({TOUCH_DOWN, TOUCH_UP, TOUCH_DOWN, TOUCH_UP});
+}
+
+void test_hold_with_duration(void) {
+    const TouchEdge timeline[] = {{1000, true}, {7500, false}};
+    gestures.replay(timeline, 2, 9000);
+    assertEvents({TOUCH_DOWN, TOUCH_LONG, TOUCH_HOLD, TOUCH_UP});
+    TEST_ASSERT_UINT32_WITHIN(1, DEFAULT_TOUCH_LONG_TIME, events[1].duration);
+    TEST_ASSERT_UINT32_WITHIN(1, DEFAULT_TOUCH_HOLD_TIME, events[2].duration);
+    TEST_ASSERT_EQUAL(6500, events[3].duration);
+}
+
+void test_thresholds_from_config(void) {
+    config.touchLongTime = 500;
+    config.touchMultiTapTime = 600;
+    const TouchEdge timeline[] = {{1000, true}, {1100, false}, {1600, true}, {2200, false}};
+    gestures.replay(timeline, 4, 3000);
+    assertEvents({TOUCH_DOWN, TOUCH_UP, TOUCH_DOWN, TOUCH_DOUBLE_TAP, TOUCH_LONG, TOUCH_UP});
+}
+
+void test_fade_time_joins_interrupts(void) {
+    // touch interrupts with short gaps are one touch
+    for (unsigned long now = 1000; now < 1400; now++) {
+        unsigned long lastTouch = now < 1300 ? now - now % (DEFAULT_TOUCH_FADE_TIME - 10) : 1299;
+        gestures.update(now, lastTouch);
+    }
+    assertEvents({TOUCH_DOWN, TOUCH_UP});
+}
+
+void test_ignored_after_enable(void) {
+    gestures.ignoreUntil(1300);
+    for (unsigned long now = 1000; now < 1200; now++) {
+        gestures.update(now, now);
+    }
+    assertEvents({});
+    gestures.update(1300, 1300);
+    assertEvents({TOUCH_DOWN});
+}
+
+void test_recorded_timeline_replays(void) {
+    // recorded on the device, read out and replayed gives the same gestures
+    const TouchEdge recorded[] = {{500, true}, {2900, false}, {3100, true}, {3180, false}, {3300, true}, {3390, false}};
+    gestures.replay(recorded, 6, 5000);
+    std::vector<RecordedEvent> original = events;
+
+    TouchEdge timeline[TOUCH_TIMELINE_LENGTH];
+    uint8_t count = gestures.getTimeline(timeline);
+    TEST_ASSERT_EQUAL(6, count);
+    for (uint8_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL(recorded[i].time, timeline[i].time);
+        TEST_ASSERT_EQUAL(recorded[i].touched, timeline[i].touched);
+    }
+
+    events.clear();
+    gestures.replay(timeline, count, 5000);
+    TEST_ASSERT_EQUAL(original.size(), events.size());
+    for (uint8_t i = 0; i < events.size(); i++) {
+        TEST_ASSERT_EQUAL(original[i].event, events[i].event);
+        TEST_ASSERT_EQUAL(original[i].duration, events[i].duration);
+    }
+}
+
+void test_timeline_keeps_last_edges(void) {
+    std::vector<TouchEdge> taps;
+    for (uint8_t i = 0; i < TOUCH_TIMELINE_LENGTH; i++) {
+        taps.push_back({1000u + i * 1000, true});
+        taps.push_back({1000u + i * 1000 + 100, false});
+    }
+    gestures.replay(taps.data(), taps.size(), 1000 + TOUCH_TIMELINE_LENGTH * 1000);
+
+    TouchEdge timeline[TOUCH_TIMELINE_LENGTH];
+    TEST_ASSERT_EQUAL(TOUCH_TIMELINE_LENGTH, gestures.getTimeline(timeline));
+    TEST_ASSERT_EQUAL(taps[TOUCH_TIMELINE_LENGTH].time, timeline[0].time);
+    TEST_ASSERT_EQUAL(taps.back().time, timeline[TOUCH_TIMELINE_LENGTH - 1].time);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_single_tap);
+    RUN_TEST(test_double_and_triple_tap);
+    RUN_TEST(test_taps_too_slow_or_long);
+    RUN_TEST(test_hold_with_duration);
+    RUN_TEST(test_thresholds_from_config);
+    RUN_TEST(test_fade_time_joins_interrupts);
+    RUN_TEST(test_ignored_after_enable);
+    RUN_TEST(test_recorded_timeline_replays);
+    RUN_TEST(test_timeline_keeps_last_edges);
+    UNITY_END();
+
+    return 0;
+}